@@ -10,6 +10,9 @@
 
 int main (int argc, char* argv[]) {
     SystemInit();
+    /* 8 MHz crystal x9 -> 72 MHz; stay on HSI if the crystal does not start */
+    rcc::configure<clock_72mhz>();
+    systime::init();
 
     while (true) {
 
@@ -13,33 +13,53 @@ DC_MOTOR::DC_MOTOR(motor_cfg_t* cfg) :
 					m_cfg(cfg),
 					pin1(cfg->port, cfg->pins[0], GPIO_STATUS::OUTPUT_50MHz, GPIO_CONFIG::GP_PUSH_PULL),
 					pin2(cfg->port, cfg->pins[1], GPIO_STATUS::OUTPUT_50MHz, GPIO_CONFIG::GP_PUSH_PULL),
-					pwm(cfg->pwm_tim, 72-1, 1000-1, nullptr),
+					pwm(cfg->pwm_tim, timer::prescaler_for(cfg->pwm_tim, 1000000), 1000-1, nullptr),
+					enc(nullptr),
+					encA(nullptr),
+					encB(nullptr),
 					position(0){
+    this->pwm.pwm_init(this->m_cfg->pwm_channel);
+    if (cfg->enc_tim) {
+        /* hardware counts every edge; no interrupt per pulse */
+        enc = new encoder(cfg->enc_tim, cfg->max_count);
+        return;
+    }
 	pin_to_motor[this->m_cfg->pins[0]] = this;
 	pin_to_motor[this->m_cfg->pins[1]] = this;
-    this->pwm.pwm_init(this->m_cfg->pwm_channel);
     encA = new external_interrupt(cfg->port, cfg->pins[0], exti_trigger::RISING, encoder_callback);
     encB = new external_interrupt(cfg->port, cfg->pins[1], exti_trigger::RISING, encoder_callback);
 }
 
-void DC_MOTOR::move(motor_direction copy_direction) {
+/* BSRR word driving pin1/pin2 for a direction; both lines are on m_cfg->port */
+uint32_t DC_MOTOR::direction_bits(motor_direction copy_direction) {
 	switch (copy_direction) {
 		case motor_direction::forward:
-			this->pin1.set();
-			this->pin2.clear();
-			break;
+			return this->pin1.set_bits() | this->pin2.clear_bits();
 		case motor_direction::reverse:
-			this->pin1.clear();
-			this->pin2.set();
-			break;
+			return this->pin1.clear_bits() | this->pin2.set_bits();
 		case motor_direction::stop:
-			this->pin1.clear();
-			this->pin2.clear();
-			break;
 		default:
-			this->pin1.clear();
-			this->pin2.clear();
-			break;
+			return this->pin1.clear_bits() | this->pin2.clear_bits();
+	}
+}
+
+void DC_MOTOR::move(motor_direction copy_direction) {
+	this->pin1.port()->BSRR = this->direction_bits(copy_direction);
+}
+
+void DC_MOTOR::move_all(DC_MOTOR* const motors[], const motor_direction directions[], uint8_t count) {
+	GPIO_TypeDef* ports[3] = {nullptr};
+	uint32_t bsrr[3] = {0};
+	for(uint8_t i = 0; i < count; i++) {
+		if(!motors[i])
+			continue;
+		uint8_t p = static_cast<uint8_t>(motors[i]->m_cfg->port);
+		ports[p] = motors[i]->pin1.port();
+		bsrr[p] |= motors[i]->direction_bits(directions[i]);
+	}
+	for(uint8_t p = 0; p < 3; p++) {
+		if(ports[p])
+			ports[p]->BSRR = bsrr[p];
 	}
 }
 
@@ -53,10 +73,14 @@ void DC_MOTOR::stop() {
 }
 
 int32_t DC_MOTOR::get_position() {
+	if (this->enc)
+		return this->enc->position();
 	return this->position;
 }
 
 void DC_MOTOR::reset_position() {
+	if (this->enc)
+		this->enc->reset();
 	this->position = 0;
 }
 
@@ -71,18 +95,18 @@ void DC_MOTOR::encoder_callback(uint8_t pin) {
     }
 }
 
+/* rising A: B still low when turning forward */
 void DC_MOTOR::handle_encoderA() {
-    // Check state of B to know direction
-    if (gpio(m_cfg->port, m_cfg->pins[0], GPIO_STATUS::INPUT, GPIO_CONFIG::FLOATING).get())
-        position++;
-    else
+    if (gpio_regs(m_cfg->port)->IDR & (1U << m_cfg->pins[1]))
         position--;
+    else
+        position++;
 }
 
+/* rising B: A already high when turning forward */
 void DC_MOTOR::handle_encoderB() {
-    // Check state of A to know direction
-    if (gpio(m_cfg->port, m_cfg->pins[1], GPIO_STATUS::INPUT, GPIO_CONFIG::FLOATING).get())
-        position--;
-    else
+    if (gpio_regs(m_cfg->port)->IDR & (1U << m_cfg->pins[0]))
         position++;
+    else
+        position--;
 }
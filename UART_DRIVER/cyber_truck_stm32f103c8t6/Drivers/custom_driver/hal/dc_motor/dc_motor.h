@@ -19,14 +19,19 @@ struct motor_cfg_t {
 	uint8_t pins[2];
     TIM_TypeDef* pwm_tim;
     uint8_t pwm_channel;
-    TIM_TypeDef* enc_tim;
-    uint32_t max_count;
+    TIM_TypeDef* enc_tim;	/* encoder on this timer's CH1/CH2; nullptr counts by EXTI on pins */
+    uint32_t max_count;		/* encoder counter period, 0 for the full 16 bits */
 };
 
 class DC_MOTOR {
 public:
 	DC_MOTOR(motor_cfg_t* cfg);
 	void move(motor_direction copy_direction);
+	/*
+	 * Change several motors' direction lines together: one BSRR store per
+	 * GPIO port, so motors on the same port switch on the same cycle.
+	 */
+	static void move_all(DC_MOTOR* const motors[], const motor_direction directions[], uint8_t count);
     void set_speed(uint32_t duty_percent);
     void stop();
     int32_t get_position();
@@ -38,9 +43,11 @@ private:
 	gpio pin1;
 	gpio pin2;
     timer pwm;
+    encoder* enc;
     external_interrupt* encA;
     external_interrupt* encB;
     volatile int32_t position;
+    uint32_t direction_bits(motor_direction copy_direction);
     void handle_encoderA();
     void handle_encoderB();
 };
@@ -10,5 +10,7 @@
 
 #include "dc_motor/dc_motor.h"
 #include "ultrasonic/ultrasonic.h"
+#include "serial_link/serial_link.h"
+#include "robot_link/robot_link.h"
 
 #endif /* CUSTOM_DRIVER_HAL_HAL_DEFS_H_ */
@@ -0,0 +1,201 @@
+/*
+ * robot_link.cpp
+ *
+ *  Created on: Sep 10, 2025
+ *      Author: ziad
+ */
+
+#include "robot_link.h"
+
+robot_link::robot_link(usart_port* port, DC_MOTOR* motors[robot_protocol::motor_count], ultrasonic* sonar) :
+					port(port),
+					sonar(sonar),
+					telemetry_period_us(0),
+					last_telemetry_us(0),
+					telemetry_format(robot_protocol::format_fixed),
+					last_rx_us(0),
+					pending_baud(0),
+					trial_us(0),
+					trial_prev_baud(0),
+					trial_deadline_us(0),
+					trial_active(false) {
+	for(uint8_t i = 0; i < robot_protocol::motor_count; i++) {
+		this->motors[i] = motors[i];
+	}
+}
+
+void robot_link::poll() {
+	char c;
+	while(this->port->read_char(&c)) {
+		if(this->decoder.push(static_cast<uint8_t>(c)) == frame_codec::decode_status::frame) {
+			/* stamped by read_char() as it returned this delimiter: late by at
+			   most the loop latency, which the Pi's min-delay filter rejects */
+			this->last_rx_us = this->port->last_frame_end_us();
+			this->handle_message(this->decoder.data(), this->decoder.size(), this->last_rx_us);
+		}
+	}
+
+	uint32_t now_us = systime::now_us();
+	this->service_baud(now_us);
+
+	/* no telemetry while a rate switch is pending or on trial */
+	if(this->telemetry_period_us && !this->pending_baud && !this->trial_active &&
+	   static_cast<int32_t>(now_us - this->last_telemetry_us) >= static_cast<int32_t>(this->telemetry_period_us)) {
+		this->last_telemetry_us = now_us;
+		this->send_telemetry(now_us);
+	}
+}
+
+void robot_link::handle_message(const uint8_t* msg, size_t len, uint32_t frame_end_us) {
+	robot_protocol::motor_cmd cmd;
+	uint8_t reply[robot_protocol::max_message];
+	uint32_t tx_us, baud;
+
+	switch(msg[0]) {
+		case robot_protocol::cmd_motor:
+			if(!robot_protocol::decode_motor(msg, len, &cmd))
+				break;
+			if(cmd.motor == robot_protocol::all_motors) {
+				motor_direction dirs[robot_protocol::motor_count];
+				for(uint8_t i = 0; i < robot_protocol::motor_count; i++)
+					dirs[i] = static_cast<motor_direction>(cmd.dir);
+				DC_MOTOR::move_all(this->motors, dirs, robot_protocol::motor_count);
+			}
+			for(uint8_t i = 0; i < robot_protocol::motor_count; i++) {
+				if((cmd.motor == i || cmd.motor == robot_protocol::all_motors) && this->motors[i]) {
+					if(cmd.motor == i)
+						this->motors[i]->move(static_cast<motor_direction>(cmd.dir));
+					this->motors[i]->set_speed(cmd.duty);
+				}
+			}
+			break;
+		case robot_protocol::cmd_stop: {
+			/* brake all wheels at once rather than one after another */
+			motor_direction dirs[robot_protocol::motor_count];
+			for(uint8_t i = 0; i < robot_protocol::motor_count; i++)
+				dirs[i] = motor_direction::stop;
+			DC_MOTOR::move_all(this->motors, dirs, robot_protocol::motor_count);
+			for(uint8_t i = 0; i < robot_protocol::motor_count; i++) {
+				if(this->motors[i])
+					this->motors[i]->stop();
+			}
+			break;
+		}
+		case robot_protocol::cmd_telemetry_rate:
+			if(len >= robot_protocol::rate_size) {
+				uint16_t hz = robot_protocol::get_u16(msg + 1);
+				this->telemetry_period_us = hz ? 1000000UL / hz : 0;
+				if(!hz) {
+					this->telemetry_encoder.flush([this](const uint8_t* m, size_t n) { this->send_message(m, n); });
+				}
+			}
+			break;
+		case robot_protocol::cmd_telemetry_format:
+			if(len >= robot_protocol::format_size && msg[1] <= robot_protocol::format_compact) {
+				this->telemetry_encoder.flush([this](const uint8_t* m, size_t n) { this->send_message(m, n); });
+				this->telemetry_format = msg[1];
+				this->telemetry_encoder.configure(msg[2], robot_protocol::get_u16(msg + 3));
+			}
+			break;
+		case robot_protocol::cmd_ping:
+			if(len >= robot_protocol::ping_size) {
+				this->send_message(reply, robot_protocol::encode_token(reply, robot_protocol::msg_pong,
+				                                                        robot_protocol::get_u32(msg + 1)));
+			}
+			break;
+		case robot_protocol::cmd_time_sync:
+			if(len >= robot_protocol::time_sync_size) {
+				/* first reply byte leaves once everything already queued is out */
+				tx_us = systime::now_us() + this->port->tx_queued() * this->port->byte_time_us();
+				this->send_message(reply, robot_protocol::encode_time_sync_reply(reply, robot_protocol::get_u32(msg + 1),
+				                                                                 frame_end_us, tx_us));
+			}
+			break;
+		case robot_protocol::cmd_baud_propose:
+			if(len < robot_protocol::propose_size)
+				break;
+			baud = robot_protocol::get_u32(msg + 1);
+			if(this->port->brr_for(baud) == 0) {
+				this->send_message(reply, robot_protocol::encode_baud_ack(reply, baud, robot_protocol::baud_rejected));
+				break;
+			}
+			if(!this->trial_active)
+				this->trial_prev_baud = this->port->get_baud();
+			this->trial_us = robot_protocol::get_u16(msg + 5) * 1000UL;
+			this->pending_baud = baud;
+			this->send_message(reply, robot_protocol::encode_baud_ack(reply, baud, robot_protocol::baud_accepted));
+			break;
+		case robot_protocol::cmd_link_test:
+			memcpy(reply, msg, len);
+			reply[0] = robot_protocol::msg_link_test;
+			this->send_message(reply, len);
+			break;
+		case robot_protocol::cmd_baud_commit:
+			if(len < robot_protocol::commit_size)
+				break;
+			baud = robot_protocol::get_u32(msg + 1);
+			/* a repeated commit (the first ack got lost) is acked again */
+			if(baud == this->port->get_baud() && !this->pending_baud) {
+				this->trial_active = false;
+				this->send_message(reply, robot_protocol::encode_baud_ack(reply, baud, robot_protocol::baud_committed));
+			} else {
+				this->send_message(reply, robot_protocol::encode_baud_ack(reply, baud, robot_protocol::baud_rejected));
+			}
+			break;
+		default:
+			/* unknown message */
+			break;
+	}
+}
+
+/*
+ * Rate switching: apply an acked rate once its ack is fully out, revert an
+ * uncommitted trial, and fall back to the boot rate when the Pi has gone
+ * quiet (it does the same, so both ends meet there).
+ */
+void robot_link::service_baud(uint32_t now_us) {
+	if(this->pending_baud && this->port->tx_idle()) {
+		this->port->set_baud(this->pending_baud);
+		this->pending_baud = 0;
+		this->trial_active = true;
+		this->trial_deadline_us = now_us + this->trial_us;
+		this->last_rx_us = now_us;
+	}
+
+	if(this->trial_active && static_cast<int32_t>(now_us - this->trial_deadline_us) >= 0) {
+		this->port->set_baud(this->trial_prev_baud);
+		this->trial_active = false;
+		this->last_rx_us = now_us;
+	}
+
+	if(this->port->get_baud() != robot_protocol::safe_baud && !this->pending_baud &&
+	   now_us - this->last_rx_us >= robot_protocol::link_silence_ms * 1000UL) {
+		this->port->set_baud(robot_protocol::safe_baud);
+		this->trial_active = false;
+		this->last_rx_us = now_us;
+	}
+}
+
+void robot_link::send_message(const uint8_t* msg, size_t len) {
+	uint8_t wire[frame_codec::max_encoded_size(robot_protocol::max_message)];
+	size_t n = frame_codec::encode_frame(msg, len, wire, sizeof(wire));
+	if(n) {
+		this->port->submit(ByteSpan(wire, n));
+	}
+}
+
+void robot_link::send_telemetry(uint32_t now_us) {
+	robot_protocol::telemetry t;
+	t.timestamp_us = now_us;
+	for(uint8_t i = 0; i < robot_protocol::motor_count; i++) {
+		t.position[i] = this->motors[i] ? this->motors[i]->get_position() : 0;
+	}
+	t.distance_cm = this->sonar ? this->sonar->get_distance_cm() : 0.0f;
+
+	if(this->telemetry_format == robot_protocol::format_compact) {
+		this->telemetry_encoder.add(t, [this](const uint8_t* m, size_t n) { this->send_message(m, n); });
+		return;
+	}
+	uint8_t msg[robot_protocol::telemetry_size];
+	this->send_message(msg, robot_protocol::encode_telemetry(msg, t));
+}
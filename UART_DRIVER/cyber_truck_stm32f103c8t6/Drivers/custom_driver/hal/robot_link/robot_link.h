@@ -0,0 +1,57 @@
+/*
+ * robot_link.h
+ *
+ *  Created on: Sep 10, 2025
+ *      Author: ziad
+ */
+
+#ifndef CUSTOM_DRIVER_HAL_ROBOT_LINK_ROBOT_LINK_H_
+#define CUSTOM_DRIVER_HAL_ROBOT_LINK_ROBOT_LINK_H_
+
+#include "../dc_motor/dc_motor.h"
+#include "../ultrasonic/ultrasonic.h"
+#include "../../lib/robot_protocol.h"
+#include "../../lib/telemetry_codec.h"
+#include "../../mcal/systime/systime.h"
+
+/*
+ * Firmware side of robot_protocol.h: decodes command frames from the Pi,
+ * drives the motors and streams telemetry. raspi/project/tools/stm32_emulator
+ * implements the same behaviour for hardware-free testing.
+ *
+ * All timestamps are systime microseconds; call systime::init() first.
+ *
+ * Also the board end of baud negotiation (see robot_protocol.h): a proposed
+ * rate is tried after the ack has left, telemetry pauses meanwhile, and the
+ * old rate comes back unless the Pi commits before the trial runs out.
+ *
+ * Telemetry goes out as fixed 25 byte frames until the Pi selects the
+ * compact format (telemetry_codec.h) with cmd_telemetry_format.
+ */
+class robot_link {
+public:
+	robot_link(usart_port* port, DC_MOTOR* motors[robot_protocol::motor_count], ultrasonic* sonar);
+	void poll();
+private:
+	void handle_message(const uint8_t* msg, size_t len, uint32_t frame_end_us);
+	void send_message(const uint8_t* msg, size_t len);
+	void send_telemetry(uint32_t now_us);
+	void service_baud(uint32_t now_us);
+
+	usart_port* port;
+	DC_MOTOR* motors[robot_protocol::motor_count];
+	ultrasonic* sonar;
+	uint32_t telemetry_period_us;
+	uint32_t last_telemetry_us;
+	uint8_t telemetry_format;
+	telemetry_codec::encoder telemetry_encoder;
+	uint32_t last_rx_us;			/* last valid frame, for the silence fallback */
+	uint32_t pending_baud;			/* acked, switch once TX is idle; 0 = none */
+	uint32_t trial_us;
+	uint32_t trial_prev_baud;
+	uint32_t trial_deadline_us;
+	bool trial_active;
+	frame_codec::frame_decoder<robot_protocol::max_message> decoder;
+};
+
+#endif /* CUSTOM_DRIVER_HAL_ROBOT_LINK_ROBOT_LINK_H_ */
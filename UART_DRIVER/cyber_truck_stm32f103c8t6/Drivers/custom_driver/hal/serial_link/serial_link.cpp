@@ -0,0 +1,52 @@
+/*
+ * serial_link.cpp
+ *
+ *  Created on: Sep 9, 2025
+ *      Author: ziad
+ */
+
+#include "serial_link.h"
+
+serial_link::serial_link(usart_port* port, link_callback_t cb, const arq::config& cfg) :
+					port(port),
+					callback(cb),
+					engine(&serial_link::emit, &serial_link::deliver, this, cfg) {}
+
+bool serial_link::send(const uint8_t* payload, uint16_t len, uint32_t now_us) {
+	return this->engine.send(payload, len, now_us);
+}
+
+void serial_link::poll(uint32_t now_us) {
+	uint8_t chunk[32];
+	uint16_t n = 0;
+	char c;
+	while(this->port->read_char(&c)) {
+		chunk[n++] = static_cast<uint8_t>(c);
+		if(n == sizeof(chunk)) {
+			this->engine.on_rx(chunk, n, now_us);
+			n = 0;
+		}
+	}
+	if(n) {
+		this->engine.on_rx(chunk, n, now_us);
+	}
+	this->engine.poll(now_us);
+}
+
+const arq::stats& serial_link::get_stats() {
+	return this->engine.statistics();
+}
+
+// a frame that does not fit the TX buffer is skipped whole (submit() never
+// splits one); the retransmit timer sends it again
+void serial_link::emit(void* ctx, const uint8_t* bytes, size_t len) {
+	serial_link* self = static_cast<serial_link*>(ctx);
+	self->port->submit(ByteSpan(bytes, len));
+}
+
+void serial_link::deliver(void* ctx, const uint8_t* payload, size_t len) {
+	serial_link* self = static_cast<serial_link*>(ctx);
+	if(self->callback) {
+		self->callback(payload, static_cast<uint16_t>(len));
+	}
+}
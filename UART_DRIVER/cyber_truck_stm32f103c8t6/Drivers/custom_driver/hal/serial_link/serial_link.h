@@ -0,0 +1,42 @@
+/*
+ * serial_link.h
+ *
+ *  Created on: Sep 9, 2025
+ *      Author: ziad
+ */
+
+#ifndef CUSTOM_DRIVER_HAL_SERIAL_LINK_SERIAL_LINK_H_
+#define CUSTOM_DRIVER_HAL_SERIAL_LINK_SERIAL_LINK_H_
+
+#include "../../mcal/mcal_dfs.h"
+#include "../../lib/reliable_link.h"
+
+typedef void(*link_callback_t)(const uint8_t* payload, uint16_t len);
+
+/*
+ * Reliable message link to the raspi UARTLink over a USART.
+ * Call poll() from the main loop with a microsecond timestamp.
+ *
+ * Not used by robot_link, on purpose: motor commands and telemetry are
+ * latest-value-wins, and a retransmitted command is stale by the time it
+ * lands, while a lost frame holding back later ones would delay a STOP.
+ * This is for traffic that must arrive whole and in order (parameters,
+ * logs) and needs its own USART, e.g. usart<USART2Instance>, since both
+ * links parse every byte they read.
+ */
+class serial_link {
+public:
+	serial_link(usart_port* port, link_callback_t cb, const arq::config& cfg = arq::default_config);
+	bool send(const uint8_t* payload, uint16_t len, uint32_t now_us);
+	void poll(uint32_t now_us);
+	const arq::stats& get_stats();
+private:
+	static void emit(void* ctx, const uint8_t* bytes, size_t len);
+	static void deliver(void* ctx, const uint8_t* payload, size_t len);
+
+	usart_port* port;
+	link_callback_t callback;
+	arq::link<arq::link_window, arq::link_max_payload> engine;
+};
+
+#endif /* CUSTOM_DRIVER_HAL_SERIAL_LINK_SERIAL_LINK_H_ */
@@ -35,7 +35,7 @@ void ultrasonic::init() {
     if (timer == TIM4) RCC->APB1ENR |= RCC_APB1ENR_TIM4EN;
 
     // Configure timer for microsecond resolution
-    timer->PSC = 71;      // 72MHz / 72 = 1MHz (1µs tick)
+    timer->PSC = ::timer::prescaler_for(timer, 1000000);  // 1MHz (1µs tick) at any clock tree
     timer->ARR = 0xFFFF;  // Max count
     timer->CR1 |= TIM_CR1_CEN; // Enable timer
 }
@@ -47,8 +47,8 @@ void ultrasonic::trigger() {
     // Generate 10µs trigger pulse
     trig.set();
 
-    // 10µs delay (at 72MHz, ~720 cycles ≈ 10µs)
-    for (volatile int i = 0; i < 720; i++);
+    // 10µs delay, scaled to the core clock
+    delay::us(10);
 
     trig.clear();
 }
@@ -13,16 +13,19 @@
 #include "main.h"
 #include "stm32f103xb.h"
 
+/* busy waits scaled by SystemCoreClock (one loop per core MHz per us);
+   never shorter than asked, since a loop takes more than one cycle */
 namespace delay {
-	static inline void ms(volatile uint32_t ms) {
-		for(uint32_t i = 0; i < ms * 8000; i++) {
+	static inline void us(volatile uint32_t us) {
+		uint32_t loops = us * (SystemCoreClock / 1000000U);
+		for(uint32_t i = 0; i < loops; i++) {
 			__asm__("nop");
 		}
 	}
 
-	static inline void us(volatile uint32_t us) {
-		for(uint32_t i = 0; i < us * 8; i++) {
-			__asm__("nop");
+	static inline void ms(volatile uint32_t ms) {
+		for(uint32_t i = 0; i < ms; i++) {
+			us(1000);
 		}
 	}
 }
@@ -0,0 +1,481 @@
+/*
+ * frame_codec.h
+ *
+ *  Created on: Sep 8, 2025
+ *      Author: ziad
+ *
+ *  Binary framing shared by the STM32 firmware and the raspi client.
+ *
+ *  wire frame : COBS( payload | crc32 little-endian ) 0x00
+ *
+ *  The CRC is the one computed by the STM32F1 CRC unit: poly 0x04C11DB7,
+ *  init 0xFFFFFFFF, no reflection, no final xor, fed one 32-bit word at a
+ *  time (little-endian load). A trailing partial word is zero-padded.
+ *  The MCU can therefore check frames with mcal/crc, and every host
+ *  computes the same value in software (table / ARMv8 CRC32 / PCLMUL).
+ *
+ *  Header-only and free of allocation so it builds for the Cortex-M3
+ *  and for raspi/project alike.
+ */
+
+#ifndef CUSTOM_DRIVER_LIB_FRAME_CODEC_H_
+#define CUSTOM_DRIVER_LIB_FRAME_CODEC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* define FRAME_CODEC_NO_HW_CRC to force the portable table path */
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32) && !defined(FRAME_CODEC_NO_HW_CRC)
+#include <arm_acle.h>
+#define FRAME_CODEC_HAVE_ARMV8_CRC 1
+#endif
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(FRAME_CODEC_NO_HW_CRC)
+#include <immintrin.h>
+#define FRAME_CODEC_HAVE_PCLMUL 1
+#endif
+
+/* slicing-by-4 costs 4 KiB of tables, too much flash for the BluePill */
+#ifndef FRAME_CODEC_CRC_SLICES
+#if defined(__arm__) && !defined(__aarch64__)
+#define FRAME_CODEC_CRC_SLICES 1
+#else
+#define FRAME_CODEC_CRC_SLICES 4
+#endif
+#endif
+
+namespace frame_codec {
+
+	constexpr uint32_t crc32_poly = 0x04C11DB7;
+	constexpr uint32_t crc32_init = 0xFFFFFFFF;
+	constexpr size_t   crc_size   = 4;
+	constexpr uint8_t  delimiter  = 0x00;
+
+	/* worst case COBS output for n payload bytes, crc and delimiter included */
+	constexpr size_t max_encoded_size(size_t payload_len) {
+		return payload_len + crc_size + (payload_len + crc_size) / 254 + 2;
+	}
+
+	/* ------------------------------------------------------------------ */
+	/* CRC-32 (STM32F1 hardware compatible)                                */
+	/* ------------------------------------------------------------------ */
+
+	struct crc32_tables {
+		uint32_t t[FRAME_CODEC_CRC_SLICES][256];
+	};
+
+	constexpr crc32_tables make_crc32_tables() {
+		crc32_tables tables{};
+		for(uint32_t i = 0; i < 256; i++) {
+			uint32_t crc = i << 24;
+			for(int bit = 0; bit < 8; bit++)
+				crc = (crc & 0x80000000u) ? (crc << 1) ^ crc32_poly : (crc << 1);
+			tables.t[0][i] = crc;
+		}
+		for(int s = 1; s < FRAME_CODEC_CRC_SLICES; s++)
+			for(uint32_t i = 0; i < 256; i++) {
+				uint32_t prev = tables.t[s - 1][i];
+				tables.t[s][i] = (prev << 8) ^ tables.t[0][prev >> 24];
+			}
+		return tables;
+	}
+
+	/* x^n mod P, used for the PCLMUL folding constants */
+	constexpr uint32_t xpow_mod(uint32_t n) {
+		uint32_t r = 1;
+		for(uint32_t i = 0; i < n; i++)
+			r = (r & 0x80000000u) ? (r << 1) ^ crc32_poly : (r << 1);
+		return r;
+	}
+
+	/* one definition across translation units without C++17 inline variables */
+	template <typename T = void>
+	struct crc32_lut {
+		static constexpr crc32_tables value = make_crc32_tables();
+	};
+	template <typename T>
+	constexpr crc32_tables crc32_lut<T>::value;
+
+	static inline uint32_t load_le32(const uint8_t *p) {
+		return static_cast<uint32_t>(p[0]) |
+		       (static_cast<uint32_t>(p[1]) << 8) |
+		       (static_cast<uint32_t>(p[2]) << 16) |
+		       (static_cast<uint32_t>(p[3]) << 24);
+	}
+
+	static inline void store_le32(uint8_t *p, uint32_t v) {
+		p[0] = static_cast<uint8_t>(v);
+		p[1] = static_cast<uint8_t>(v >> 8);
+		p[2] = static_cast<uint8_t>(v >> 16);
+		p[3] = static_cast<uint8_t>(v >> 24);
+	}
+
+	/* what one write to CRC->DR does */
+	static inline uint32_t crc32_word_sw(uint32_t crc, uint32_t word) {
+		const crc32_tables &lut = crc32_lut<>::value;
+		crc ^= word;
+#if FRAME_CODEC_CRC_SLICES == 4
+		return lut.t[3][crc >> 24] ^ lut.t[2][(crc >> 16) & 0xFF] ^
+		       lut.t[1][(crc >> 8) & 0xFF] ^ lut.t[0][crc & 0xFF];
+#else
+		for(int i = 0; i < 4; i++)
+			crc = (crc << 8) ^ lut.t[0][crc >> 24];
+		return crc;
+#endif
+	}
+
+#ifdef FRAME_CODEC_HAVE_ARMV8_CRC
+	/*
+	 * CRC32W is the bit-reflected form of the same polynomial; reversing the
+	 * state and the data word on the way in and out yields the MSB-first CRC.
+	 */
+	static inline uint32_t crc32_word(uint32_t crc, uint32_t word) {
+		return __rbit(__crc32w(__rbit(crc), __rbit(word)));
+	}
+#else
+	static inline uint32_t crc32_word(uint32_t crc, uint32_t word) {
+		return crc32_word_sw(crc, word);
+	}
+#endif
+
+	static inline uint32_t crc32_words(uint32_t crc, const uint8_t *data, size_t words) {
+		for(size_t i = 0; i < words; i++)
+			crc = crc32_word(crc, load_le32(data + 4 * i));
+		return crc;
+	}
+
+#ifdef FRAME_CODEC_HAVE_PCLMUL
+	/*
+	 * Fold 64 bytes per iteration with carry-less multiplies. Sixteen input
+	 * bytes are four little-endian words that the CRC consumes first-word
+	 * first, so a 32-bit lane reversal turns them into one 128-bit
+	 * polynomial in natural bit order.
+	 */
+	__attribute__((target("pclmul,sse4.1")))
+	static inline __m128i crc32_fold(__m128i acc, __m128i k) {
+		return _mm_xor_si128(_mm_clmulepi64_si128(acc, k, 0x11),
+		                     _mm_clmulepi64_si128(acc, k, 0x00));
+	}
+
+	__attribute__((target("pclmul,sse4.1")))
+	static inline uint32_t crc32_words_pclmul(uint32_t crc, const uint8_t *data, size_t words) {
+		const __m128i k128 = _mm_set_epi64x(xpow_mod(128 + 64), xpow_mod(128));
+		const __m128i k512 = _mm_set_epi64x(xpow_mod(512 + 64), xpow_mod(512));
+
+		__m128i acc[4];
+		for(int i = 0; i < 4; i++)
+			acc[i] = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data) + i), 0x1B);
+		acc[0] = _mm_xor_si128(acc[0], _mm_set_epi32(static_cast<int>(crc), 0, 0, 0));
+		data += 64;
+		words -= 16;
+
+		while(words >= 16) {
+			for(int i = 0; i < 4; i++) {
+				__m128i next = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data) + i), 0x1B);
+				acc[i] = _mm_xor_si128(crc32_fold(acc[i], k512), next);
+			}
+			data += 64;
+			words -= 16;
+		}
+
+		__m128i x = acc[0];
+		for(int i = 1; i < 4; i++)
+			x = _mm_xor_si128(crc32_fold(x, k128), acc[i]);
+		while(words >= 4) {
+			__m128i next = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data)), 0x1B);
+			x = _mm_xor_si128(crc32_fold(x, k128), next);
+			data += 16;
+			words -= 4;
+		}
+
+		/* x * x^32 mod P: run the four remaining words through the table */
+		crc = 0;
+		crc = crc32_word_sw(crc, static_cast<uint32_t>(_mm_extract_epi32(x, 3)));
+		crc = crc32_word_sw(crc, static_cast<uint32_t>(_mm_extract_epi32(x, 2)));
+		crc = crc32_word_sw(crc, static_cast<uint32_t>(_mm_extract_epi32(x, 1)));
+		crc = crc32_word_sw(crc, static_cast<uint32_t>(_mm_extract_epi32(x, 0)));
+		return crc32_words(crc, data, words);
+	}
+
+	static inline bool have_pclmul() {
+		static const bool supported = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+		return supported;
+	}
+#endif
+
+	/* CRC over whole words, hardware accelerated when the host allows it */
+	static inline uint32_t crc32_update_words(uint32_t crc, const uint8_t *data, size_t words) {
+#ifdef FRAME_CODEC_HAVE_PCLMUL
+		if(words >= 32 && have_pclmul())
+			return crc32_words_pclmul(crc, data, words);
+#endif
+		return crc32_words(crc, data, words);
+	}
+
+	/* one-shot CRC of a buffer, trailing bytes zero-padded to a word */
+	static inline uint32_t crc32(const uint8_t *data, size_t len, uint32_t crc = crc32_init) {
+		size_t words = len / 4;
+		crc = crc32_update_words(crc, data, words);
+		size_t rest = len % 4;
+		if(rest) {
+			uint8_t tail[4] = {0, 0, 0, 0};
+			for(size_t i = 0; i < rest; i++)
+				tail[i] = data[words * 4 + i];
+			crc = crc32_word(crc, load_le32(tail));
+		}
+		return crc;
+	}
+
+	/* CRC over data arriving in arbitrary pieces, same result as crc32() */
+	class crc32_stream {
+	public:
+		crc32_stream() : crc(crc32_init), pending(0), pending_len(0) {}
+
+		void update(const uint8_t *data, size_t len) {
+			while(pending_len && len) {
+				pending |= static_cast<uint32_t>(*data++) << (8 * pending_len++);
+				len--;
+				if(pending_len == 4) {
+					crc = crc32_word(crc, pending);
+					pending = 0;
+					pending_len = 0;
+				}
+			}
+			size_t words = len / 4;
+			crc = crc32_update_words(crc, data, words);
+			data += words * 4;
+			len -= words * 4;
+			while(len--)
+				pending |= static_cast<uint32_t>(*data++) << (8 * pending_len++);
+		}
+
+		uint32_t value() const {
+			return pending_len ? crc32_word(crc, pending) : crc;
+		}
+
+		void reset() {
+			crc = crc32_init;
+			pending = 0;
+			pending_len = 0;
+		}
+
+	private:
+		uint32_t crc;
+		uint32_t pending;
+		uint8_t pending_len;
+	};
+
+	/* ------------------------------------------------------------------ */
+	/* COBS                                                                */
+	/* ------------------------------------------------------------------ */
+
+	/*
+	 * Streaming COBS encoder writing straight into the caller's buffer.
+	 * put()/write() may be called any number of times; finish() closes the
+	 * last block and appends the delimiter.
+	 */
+	class cobs_encoder {
+	public:
+		cobs_encoder(uint8_t *out, size_t capacity) :
+			out(out), capacity(capacity), code_pos(0), pos(1), code(1), overflow(capacity < 2) {}
+
+		bool put(uint8_t byte) {
+			if(overflow)
+				return false;
+			if(byte != 0) {
+				if(pos >= capacity) {
+					overflow = true;
+					return false;
+				}
+				out[pos++] = byte;
+				code++;
+				if(code != 0xFF)
+					return true;
+			}
+			/* close the current block: zero byte seen or 254 data bytes */
+			out[code_pos] = code;
+			if(pos >= capacity) {
+				overflow = true;
+				return false;
+			}
+			code_pos = pos++;
+			code = 1;
+			return true;
+		}
+
+		bool write(const uint8_t *data, size_t len) {
+			for(size_t i = 0; i < len; i++)
+				if(!put(data[i]))
+					return false;
+			return true;
+		}
+
+		/* @return encoded length including the delimiter, 0 on overflow */
+		size_t finish() {
+			if(overflow || pos >= capacity)
+				return 0;
+			out[code_pos] = code;
+			out[pos++] = delimiter;
+			return pos;
+		}
+
+	private:
+		uint8_t *out;
+		size_t capacity;
+		size_t code_pos;
+		size_t pos;
+		uint8_t code;
+		bool overflow;
+	};
+
+	/*
+	 * Decode one COBS block sequence (delimiter excluded) in place.
+	 * @return decoded length, or -1 if the encoding is malformed.
+	 */
+	static inline long cobs_decode_in_place(uint8_t *buf, size_t len) {
+		size_t in = 0, out = 0;
+		while(in < len) {
+			uint8_t code = buf[in++];
+			if(code == 0 || in + code - 1 > len)
+				return -1;
+			for(uint8_t i = 1; i < code; i++) {
+				if(buf[in] == 0)
+					return -1;
+				buf[out++] = buf[in++];
+			}
+			if(code != 0xFF && in < len)
+				buf[out++] = 0;
+		}
+		return static_cast<long>(out);
+	}
+
+	/*
+	 * Encode payload + crc as one delimited frame.
+	 * @return bytes written to out, 0 if capacity is too small.
+	 */
+	static inline size_t encode_frame(const uint8_t *payload, size_t len, uint8_t *out, size_t capacity) {
+		uint8_t crc_bytes[crc_size];
+		store_le32(crc_bytes, crc32(payload, len));
+		cobs_encoder enc(out, capacity);
+		if(!enc.write(payload, len) || !enc.write(crc_bytes, crc_size))
+			return 0;
+		return enc.finish();
+	}
+
+	/*
+	 * Check the crc of a decoded frame (payload | crc).
+	 * @return payload length, or -1 on a short frame or crc mismatch.
+	 */
+	static inline long check_frame(const uint8_t *frame, size_t len) {
+		if(len < crc_size)
+			return -1;
+		size_t payload_len = len - crc_size;
+		if(crc32(frame, payload_len) != load_le32(frame + payload_len))
+			return -1;
+		return static_cast<long>(payload_len);
+	}
+
+	enum class decode_status : uint8_t {
+		pending,    /* need more bytes */
+		frame,      /* data()/size() hold a verified payload */
+		crc_error,
+		malformed,
+		overflow
+	};
+
+	/*
+	 * Byte-at-a-time frame decoder for receive paths (ISR ring, read()
+	 * chunks). The payload is decoded straight into the internal buffer and
+	 * stays valid until the next push().
+	 */
+	template <size_t MaxFrame>
+	class frame_decoder {
+	public:
+		frame_decoder() : len(0), remaining(0), code(0xFF), started(false), overflowed(false), payload_len(0) {}
+
+		decode_status push(uint8_t byte) {
+			if(byte == delimiter)
+				return end_of_frame();
+			started = true;
+			if(overflowed)
+				return decode_status::pending;
+			if(remaining == 0) {
+				if(code != 0xFF && !append(0))
+					return decode_status::pending;
+				code = byte;
+				remaining = static_cast<uint8_t>(byte - 1);
+				return decode_status::pending;
+			}
+			append(byte);
+			remaining--;
+			return decode_status::pending;
+		}
+
+		/* feed a chunk; stops at the first completed or failed frame */
+		decode_status push(const uint8_t *data, size_t n, size_t *consumed) {
+			for(size_t i = 0; i < n; i++) {
+				decode_status st = push(data[i]);
+				if(st != decode_status::pending) {
+					*consumed = i + 1;
+					return st;
+				}
+			}
+			*consumed = n;
+			return decode_status::pending;
+		}
+
+		const uint8_t *data() const { return buf; }
+		size_t size() const { return payload_len; }
+
+		/* forget a half received frame (line rate change, resync) */
+		void reset() {
+			len = 0;
+			remaining = 0;
+			code = 0xFF;
+			started = false;
+			overflowed = false;
+		}
+
+	private:
+		bool append(uint8_t byte) {
+			if(len >= MaxFrame + crc_size) {
+				overflowed = true;
+				return false;
+			}
+			buf[len++] = byte;
+			return true;
+		}
+
+		decode_status end_of_frame() {
+			decode_status st;
+			if(overflowed)
+				st = decode_status::overflow;
+			else if(!started)
+				st = decode_status::pending;           /* idle delimiters */
+			else if(remaining != 0)
+				st = decode_status::malformed;         /* block cut short */
+			else {
+				long n = check_frame(buf, len);
+				payload_len = n < 0 ? 0 : static_cast<size_t>(n);
+				st = n < 0 ? decode_status::crc_error : decode_status::frame;
+			}
+			len = 0;
+			remaining = 0;
+			code = 0xFF;
+			started = false;
+			overflowed = false;
+			return st;
+		}
+
+		uint8_t buf[MaxFrame + crc_size];
+		size_t len;
+		uint8_t remaining;
+		uint8_t code;
+		bool started;
+		bool overflowed;
+		size_t payload_len;
+	};
+
+}
+
+#endif /* CUSTOM_DRIVER_LIB_FRAME_CODEC_H_ */
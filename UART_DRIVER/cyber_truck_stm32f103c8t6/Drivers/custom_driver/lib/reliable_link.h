@@ -0,0 +1,454 @@
+/*
+ * reliable_link.h
+ *
+ *  Created on: Sep 9, 2025
+ *      Author: ziad
+ *
+ *  Selective-repeat transport over frame_codec frames, shared by the
+ *  raspi UARTLink and the firmware serial_link.
+ *
+ *  frame payload : type | seq | ack | base | sack (LE32) | data
+ *
+ *  - seq   : 8-bit sequence number of a DATA frame
+ *  - ack   : next sequence number the sender of this frame expects
+ *  - base  : oldest sequence number the sender of this frame still holds;
+ *            a receiver behind it skips the frames given up on (resync)
+ *  - sack  : bit i set = (ack + 1 + i) already received out of order
+ *
+ *  Every frame carries the receiver state, so DATA piggybacks acks and a
+ *  lost ACK is repaired by the next frame in either direction. Timers use
+ *  a caller supplied microsecond clock (wrap-safe 32-bit arithmetic), no
+ *  allocation, so the same engine runs on the Cortex-M3 and on the Pi.
+ */
+
+#ifndef CUSTOM_DRIVER_LIB_RELIABLE_LINK_H_
+#define CUSTOM_DRIVER_LIB_RELIABLE_LINK_H_
+
+#include "frame_codec.h"
+
+namespace arq {
+
+	constexpr uint8_t frame_data = 0x01;
+	constexpr uint8_t frame_ack  = 0x02;
+	constexpr size_t  header_size = 8;
+	constexpr size_t  max_window = 32;     /* bounded by the sack bitmap */
+
+	/*
+	 * What both ends are built with. The receiver only accepts frames up
+	 * to this far ahead and this long, so the Pi and the board must agree;
+	 * the board's RAM sets the size.
+	 */
+	constexpr size_t  link_window = 8;
+	constexpr size_t  link_max_payload = 64;
+
+	struct config {
+		uint8_t  window;          /* frames in flight, <= template Window */
+		uint32_t min_rto_us;
+		uint32_t max_rto_us;
+		uint32_t initial_rto_us;
+		uint32_t ack_delay_us;    /* hold a bare ACK this long hoping to piggyback */
+		uint8_t  max_retries;     /* give up on a frame (and count it) after this */
+	};
+
+	/* tuned for 115200 baud: a 64 byte frame is ~6 ms on the wire */
+	constexpr config default_config = {8, 5000, 1000000, 100000, 2000, 16};
+
+	struct stats {
+		uint32_t frames_sent;
+		uint32_t retransmits;
+		uint32_t fast_retransmits;
+		uint32_t timeouts;
+		uint32_t dropped;         /* exceeded max_retries */
+		uint32_t skipped;         /* the peer dropped them: never delivered here */
+		uint32_t frames_received;
+		uint32_t duplicates;
+		uint32_t out_of_order;
+		uint32_t crc_errors;
+		uint32_t delivered;
+		uint32_t srtt_us;
+		uint32_t rto_us;
+	};
+
+	typedef void (*emit_fn)(void* ctx, const uint8_t* bytes, size_t len);
+	typedef void (*deliver_fn)(void* ctx, const uint8_t* payload, size_t len);
+
+	template <size_t Window, size_t MaxPayload>
+	class link {
+		static_assert(Window >= 1 && Window <= max_window, "window must fit the sack bitmap");
+		static_assert((Window & (Window - 1)) == 0, "window must divide the 8-bit sequence space");
+
+	public:
+		link(emit_fn emit, deliver_fn deliver, void* ctx, const config& cfg = default_config) :
+			emit(emit), deliver(deliver), ctx(ctx), cfg(cfg),
+			snd_una(0), snd_nxt(0), rcv_nxt(0), ack_pending(false), ack_due(0),
+			srtt(0), rttvar(0), rto(cfg.initial_rto_us), st() {
+			if(this->cfg.window == 0 || this->cfg.window > Window)
+				this->cfg.window = static_cast<uint8_t>(Window);
+			for(size_t i = 0; i < Window; i++) {
+				tx[i].used = false;
+				rx[i].used = false;
+			}
+			st.rto_us = rto;
+		}
+
+		/* frames the caller may still send() before the window closes */
+		size_t available() const {
+			return cfg.window - static_cast<uint8_t>(snd_nxt - snd_una);
+		}
+
+		/* @return false if the window is full or payload too large */
+		bool send(const uint8_t* payload, size_t len, uint32_t now_us) {
+			if(len > MaxPayload || available() == 0)
+				return false;
+			tx_slot& s = tx[snd_nxt % Window];
+			s.used = true;
+			s.acked = false;
+			s.retransmitted = false;
+			s.retries = 0;
+			s.seq = snd_nxt;
+			s.len = static_cast<uint16_t>(len);
+			for(size_t i = 0; i < len; i++)
+				s.data[i] = payload[i];
+			snd_nxt++;
+			transmit(s, now_us);
+			st.frames_sent++;
+			return true;
+		}
+
+		/* feed received bytes, any chunking */
+		void on_rx(const uint8_t* bytes, size_t len, uint32_t now_us) {
+			for(size_t i = 0; i < len; i++) {
+				frame_codec::decode_status r = decoder.push(bytes[i]);
+				if(r == frame_codec::decode_status::frame)
+					handle_frame(decoder.data(), decoder.size(), now_us);
+				else if(r == frame_codec::decode_status::crc_error ||
+				        r == frame_codec::decode_status::malformed)
+					st.crc_errors++;
+			}
+		}
+
+		/* run retransmit and delayed-ack timers */
+		void poll(uint32_t now_us) {
+			for(uint8_t seq = snd_una; seq != snd_nxt; seq++) {
+				tx_slot& s = tx[seq % Window];
+				if(!s.used || s.acked)
+					continue;
+				if(elapsed(s.sent_at, now_us) < static_cast<int32_t>(s.rto))
+					continue;
+				if(s.retries >= cfg.max_retries) {
+					/*
+					 * Give up on this frame so the sender is not wedged. Every
+					 * frame carries snd_una as base, so the peer skips it too;
+					 * send that now rather than with the next data.
+					 */
+					s.acked = true;
+					st.dropped++;
+					ack_pending = true;
+					ack_due = now_us;
+					continue;
+				}
+				st.timeouts++;
+				st.retransmits++;
+				s.rto = clamp_rto(s.rto * 2);
+				retransmit(s, now_us);
+			}
+			advance_una();
+			if(ack_pending && elapsed(ack_due, now_us) >= 0)
+				send_ack();
+		}
+
+		/* microseconds until poll() has work, for the caller's sleep */
+		uint32_t next_timeout_us(uint32_t now_us) const {
+			int32_t best = static_cast<int32_t>(cfg.max_rto_us);
+			for(uint8_t seq = snd_una; seq != snd_nxt; seq++) {
+				const tx_slot& s = tx[seq % Window];
+				if(!s.used || s.acked)
+					continue;
+				int32_t left = static_cast<int32_t>(s.rto) - elapsed(s.sent_at, now_us);
+				if(left < best)
+					best = left;
+			}
+			if(ack_pending) {
+				int32_t left = -elapsed(ack_due, now_us);
+				if(left < best)
+					best = left;
+			}
+			return best < 0 ? 0 : static_cast<uint32_t>(best);
+		}
+
+		size_t in_flight() const { return static_cast<uint8_t>(snd_nxt - snd_una); }
+		const stats& statistics() const { return st; }
+
+	private:
+		struct tx_slot {
+			bool used;
+			bool acked;
+			bool retransmitted;      /* Karn: no RTT sample from these */
+			uint8_t retries;
+			uint8_t seq;
+			uint16_t len;
+			uint32_t sent_at;
+			uint32_t rto;
+			uint8_t data[MaxPayload];
+		};
+
+		struct rx_slot {
+			bool used;
+			uint16_t len;
+			uint8_t data[MaxPayload];
+		};
+
+		static int32_t elapsed(uint32_t since, uint32_t now) {
+			return static_cast<int32_t>(now - since);
+		}
+
+		uint32_t clamp_rto(uint32_t v) const {
+			if(v < cfg.min_rto_us) return cfg.min_rto_us;
+			if(v > cfg.max_rto_us) return cfg.max_rto_us;
+			return v;
+		}
+
+		uint32_t sack_bits() const {
+			uint32_t bits = 0;
+			for(uint8_t i = 1; i < cfg.window; i++)
+				if(rx[static_cast<uint8_t>(rcv_nxt + i) % Window].used)
+					bits |= 1u << (i - 1);
+			return bits;
+		}
+
+		void put_header(uint8_t type, uint8_t seq) {
+			scratch[0] = type;
+			scratch[1] = seq;
+			scratch[2] = rcv_nxt;
+			scratch[3] = snd_una;
+			frame_codec::store_le32(scratch + 4, sack_bits());
+		}
+
+		void send_encoded(size_t len) {
+			size_t n = frame_codec::encode_frame(scratch, len, wire, sizeof(wire));
+			if(n)
+				emit(ctx, wire, n);
+			ack_pending = false;     /* every frame carries the current ack */
+		}
+
+		void transmit(tx_slot& s, uint32_t now_us) {
+			put_header(frame_data, s.seq);
+			for(size_t i = 0; i < s.len; i++)
+				scratch[header_size + i] = s.data[i];
+			s.sent_at = now_us;
+			if(!s.retransmitted)
+				s.rto = rto;
+			send_encoded(header_size + s.len);
+		}
+
+		void retransmit(tx_slot& s, uint32_t now_us) {
+			s.retransmitted = true;
+			s.retries++;
+			uint32_t keep = s.rto;
+			transmit(s, now_us);
+			s.rto = keep;
+		}
+
+		void send_ack() {
+			put_header(frame_ack, 0);
+			send_encoded(header_size);
+		}
+
+		void rtt_sample(uint32_t r) {
+			/* RFC 6298 */
+			if(srtt == 0) {
+				srtt = r;
+				rttvar = r / 2;
+			} else {
+				uint32_t err = srtt > r ? srtt - r : r - srtt;
+				rttvar = (3 * rttvar + err) / 4;
+				srtt = (7 * srtt + r) / 8;
+			}
+			/* a peer holding its ack adds up to ack_delay on top of the path */
+			uint32_t var = 4 * rttvar > cfg.ack_delay_us ? 4 * rttvar : cfg.ack_delay_us;
+			rto = clamp_rto(srtt + var);
+			st.srtt_us = srtt;
+			st.rto_us = rto;
+		}
+
+		/* @return true if s was newly acked and is a valid (Karn) RTT sample */
+		bool acknowledge(tx_slot& s) {
+			if(s.acked)
+				return false;
+			s.acked = true;
+			return !s.retransmitted;
+		}
+
+		void advance_una() {
+			while(snd_una != snd_nxt) {
+				tx_slot& s = tx[snd_una % Window];
+				if(s.used && !s.acked)
+					break;
+				s.used = false;
+				snd_una++;
+			}
+		}
+
+		void handle_ack(uint8_t ack, uint32_t sack, uint32_t now_us) {
+			/*
+			 * An ack behind snd_una comes from a peer that has not yet seen
+			 * our base move past frames we gave up on. Its sack bits beyond
+			 * snd_una still count.
+			 */
+			uint8_t behind = static_cast<uint8_t>(snd_una - ack);
+			if(behind != 0 && behind < 128) {
+				sack = behind < 32 ? sack >> behind : 0;
+				ack = snd_una;
+			}
+			/* ignore acks outside what we have sent */
+			uint8_t acked_count = static_cast<uint8_t>(ack - snd_una);
+			if(acked_count > static_cast<uint8_t>(snd_nxt - snd_una))
+				return;
+			/*
+			 * One RTT sample per ack frame, from the newest frame it covers:
+			 * a burst acked together would otherwise feed identical samples
+			 * and collapse rttvar.
+			 */
+			const tx_slot* sample = nullptr;
+			for(uint8_t seq = snd_una; seq != ack; seq++)
+				if(acknowledge(tx[seq % Window]))
+					sample = &tx[seq % Window];
+
+			uint8_t highest = ack;
+			bool any_sack = false;
+			for(uint8_t i = 0; i < 31; i++) {
+				if(!(sack & (1u << i)))
+					continue;
+				uint8_t seq = static_cast<uint8_t>(ack + 1 + i);
+				if(static_cast<uint8_t>(seq - snd_una) >= static_cast<uint8_t>(snd_nxt - snd_una))
+					break;
+				if(acknowledge(tx[seq % Window]))
+					sample = &tx[seq % Window];
+				highest = seq;
+				any_sack = true;
+			}
+
+			if(sample)
+				rtt_sample(static_cast<uint32_t>(elapsed(sample->sent_at, now_us)));
+
+			/*
+			 * Frames below a selectively acked one were most likely lost.
+			 * Resend just those holes, at most once per smoothed RTT.
+			 */
+			if(any_sack) {
+				uint32_t guard = srtt ? srtt : rto;
+				for(uint8_t seq = ack; seq != highest; seq++) {
+					tx_slot& s = tx[seq % Window];
+					if(s.used && !s.acked && elapsed(s.sent_at, now_us) >= static_cast<int32_t>(guard)) {
+						st.fast_retransmits++;
+						st.retransmits++;
+						retransmit(s, now_us);
+					}
+				}
+			}
+			advance_una();
+		}
+
+		void handle_data(uint8_t seq, const uint8_t* data, size_t len, uint32_t now_us) {
+			uint8_t offset = static_cast<uint8_t>(seq - rcv_nxt);
+			if(offset >= cfg.window || len > MaxPayload) {
+				/* old duplicate: our ack was lost, repeat it now */
+				st.duplicates++;
+				send_ack();
+				return;
+			}
+			rx_slot& slot = rx[seq % Window];
+			if(slot.used) {
+				st.duplicates++;
+			} else {
+				slot.used = true;
+				slot.len = static_cast<uint16_t>(len);
+				for(size_t i = 0; i < len; i++)
+					slot.data[i] = data[i];
+			}
+
+			if(offset != 0) {
+				/* hole before this frame: tell the sender right away */
+				st.out_of_order++;
+				send_ack();
+				return;
+			}
+
+			while(rx[rcv_nxt % Window].used) {
+				rx_slot& next = rx[rcv_nxt % Window];
+				next.used = false;
+				rcv_nxt++;
+				st.delivered++;
+				deliver(ctx, next.data, next.len);
+			}
+			if(!ack_pending) {
+				ack_pending = true;
+				ack_due = now_us + cfg.ack_delay_us;
+			}
+		}
+
+		/*
+		 * The peer gave up on frames below base: deliver what arrived past
+		 * the holes, in order, and expect base next.
+		 */
+		void rebase(uint8_t base) {
+			uint8_t offset = static_cast<uint8_t>(base - rcv_nxt);
+			if(offset == 0 || offset >= 128)
+				return;                  /* not ahead: nothing given up on, or a stale frame */
+			while(rcv_nxt != base) {
+				rx_slot& slot = rx[rcv_nxt % Window];
+				rcv_nxt++;
+				if(slot.used) {
+					slot.used = false;
+					st.delivered++;
+					deliver(ctx, slot.data, slot.len);
+				} else {
+					st.skipped++;
+				}
+			}
+			while(rx[rcv_nxt % Window].used) {
+				rx_slot& next = rx[rcv_nxt % Window];
+				next.used = false;
+				rcv_nxt++;
+				st.delivered++;
+				deliver(ctx, next.data, next.len);
+			}
+			send_ack();
+		}
+
+		void handle_frame(const uint8_t* frame, size_t len, uint32_t now_us) {
+			if(len < header_size)
+				return;
+			st.frames_received++;
+			handle_ack(frame[2], frame_codec::load_le32(frame + 4), now_us);
+			rebase(frame[3]);
+			if(frame[0] == frame_data)
+				handle_data(frame[1], frame + header_size, len - header_size, now_us);
+		}
+
+		emit_fn emit;
+		deliver_fn deliver;
+		void* ctx;
+		config cfg;
+
+		uint8_t snd_una;
+		uint8_t snd_nxt;
+		uint8_t rcv_nxt;
+		bool ack_pending;
+		uint32_t ack_due;
+
+		uint32_t srtt;
+		uint32_t rttvar;
+		uint32_t rto;
+		stats st;
+
+		tx_slot tx[Window];
+		rx_slot rx[Window];
+		frame_codec::frame_decoder<header_size + MaxPayload> decoder;
+		uint8_t scratch[header_size + MaxPayload];
+		uint8_t wire[frame_codec::max_encoded_size(header_size + MaxPayload)];
+	};
+
+}
+
+#endif /* CUSTOM_DRIVER_LIB_RELIABLE_LINK_H_ */
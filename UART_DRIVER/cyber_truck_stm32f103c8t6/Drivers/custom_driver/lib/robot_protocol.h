@@ -0,0 +1,251 @@
+/*
+ * robot_protocol.h
+ *
+ *  Created on: Sep 10, 2025
+ *      Author: ziad
+ *
+ *  Command / telemetry messages exchanged between the raspi client and
+ *  the motor board. Each message is one frame_codec payload (optionally
+ *  carried by reliable_link); byte 0 is the message id, all fields are
+ *  little-endian. Ids with bit 7 set travel MCU -> Pi.
+ */
+
+#ifndef CUSTOM_DRIVER_LIB_ROBOT_PROTOCOL_H_
+#define CUSTOM_DRIVER_LIB_ROBOT_PROTOCOL_H_
+
+#include "frame_codec.h"
+#include <string.h>
+
+namespace robot_protocol {
+
+	constexpr uint8_t motor_count = 4;
+	constexpr uint8_t all_motors  = 0xFF;
+
+	enum msg_id : uint8_t {
+		/* Pi -> MCU */
+		cmd_motor          = 0x10,   /* motor, direction, duty %           */
+		cmd_stop           = 0x11,   /* all motors off                      */
+		cmd_telemetry_rate = 0x12,   /* u16 Hz, 0 = off                     */
+		cmd_ping           = 0x13,   /* u32 token                           */
+		cmd_time_sync      = 0x14,   /* u32 token, 8 pad bytes              */
+		cmd_baud_propose   = 0x15,   /* u32 baud, u16 trial ms              */
+		cmd_link_test      = 0x16,   /* u16 seq, u8 pattern, fill bytes     */
+		cmd_baud_commit    = 0x17,   /* u32 baud                            */
+		cmd_telemetry_format = 0x18, /* u8 format, u8 batch, u16 keyframe   */
+
+		/* MCU -> Pi */
+		msg_telemetry      = 0x80,   /* see telemetry                       */
+		msg_telemetry_key  = 0x81,   /* telemetry_codec.h keyframe          */
+		msg_telemetry_delta = 0x82,  /* telemetry_codec.h delta batch       */
+		msg_pong           = 0x93,   /* u32 token echoed                    */
+		msg_time_sync      = 0x94,   /* u32 token, u32 rx us, u32 tx us     */
+		msg_baud_ack       = 0x95,   /* u32 baud, u8 baud_status            */
+		msg_link_test      = 0x96    /* cmd_link_test echoed                */
+	};
+
+	enum baud_status : uint8_t {
+		baud_accepted  = 0,          /* switching once the ack is on the wire */
+		baud_rejected  = 1,          /* rate not reachable from this clock    */
+		baud_committed = 2           /* sent at the new rate, trial over      */
+	};
+
+	enum link_pattern : uint8_t {
+		pattern_zeros      = 0,      /* every byte a COBS code byte          */
+		pattern_ones       = 1,      /* 0xFF: a single start-bit edge/byte   */
+		pattern_alternate  = 2,      /* 0x55: an edge on every bit           */
+		pattern_random     = 3,      /* xorshift seeded by seq               */
+		pattern_count      = 4
+	};
+
+	/* same order as motor_direction in dc_motor.h */
+	enum direction : uint8_t {
+		forward = 0,
+		reverse = 1,
+		stop    = 2
+	};
+
+	enum telemetry_format : uint8_t {
+		format_fixed   = 0,          /* msg_telemetry, one 25 byte frame/sample */
+		format_compact = 1           /* msg_telemetry_key / msg_telemetry_delta */
+	};
+
+	struct motor_cmd {
+		uint8_t motor;          /* 0..3 or all_motors */
+		uint8_t dir;
+		uint8_t duty;           /* 0..100 */
+	};
+
+	struct telemetry {
+		uint32_t timestamp_us;  /* MCU clock */
+		int32_t  position[motor_count];
+		float    distance_cm;   /* 0 = no echo */
+	};
+
+	constexpr size_t motor_cmd_size = 4;
+	constexpr size_t ping_size      = 5;
+	constexpr size_t rate_size      = 3;
+	constexpr size_t telemetry_size = 1 + 4 + 4 * motor_count + 4;
+	constexpr size_t time_sync_size = 1 + 4 + 4 + 4;
+	constexpr size_t propose_size   = 1 + 4 + 2;
+	constexpr size_t baud_ack_size  = 1 + 4 + 1;
+	constexpr size_t commit_size    = 1 + 4;
+	constexpr size_t link_test_size = telemetry_size;
+	constexpr size_t format_size    = 1 + 1 + 1 + 2;
+	constexpr size_t max_message    = 64;        /* compact telemetry batches */
+
+	/*
+	 * Baud negotiation. Both ends boot at safe_baud. The Pi proposes a rate;
+	 * the board acks at the old rate, switches once the ack has left and
+	 * reverts by itself unless a commit arrives at the new rate within the
+	 * trial. In between the Pi measures the error rate with link test echoes.
+	 * Either end that sees no valid frame for link_silence_ms drops back to
+	 * safe_baud, so a bad switch always converges.
+	 */
+	constexpr uint32_t safe_baud       = 115200;
+	constexpr uint32_t link_silence_ms = 3000;
+
+	static inline uint32_t get_u32(const uint8_t* p) { return frame_codec::load_le32(p); }
+	static inline void put_u32(uint8_t* p, uint32_t v) { frame_codec::store_le32(p, v); }
+	static inline uint16_t get_u16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+	static inline void put_u16(uint8_t* p, uint16_t v) { p[0] = static_cast<uint8_t>(v); p[1] = static_cast<uint8_t>(v >> 8); }
+
+	static inline size_t encode_motor(uint8_t* out, const motor_cmd& cmd) {
+		out[0] = cmd_motor;
+		out[1] = cmd.motor;
+		out[2] = cmd.dir;
+		out[3] = cmd.duty;
+		return motor_cmd_size;
+	}
+
+	static inline bool decode_motor(const uint8_t* in, size_t len, motor_cmd* cmd) {
+		if(len < motor_cmd_size || in[0] != cmd_motor)
+			return false;
+		cmd->motor = in[1];
+		cmd->dir = in[2];
+		cmd->duty = in[3];
+		return cmd->dir <= stop && cmd->duty <= 100 &&
+		       (cmd->motor < motor_count || cmd->motor == all_motors);
+	}
+
+	static inline size_t encode_stop(uint8_t* out) {
+		out[0] = cmd_stop;
+		return 1;
+	}
+
+	static inline size_t encode_telemetry_rate(uint8_t* out, uint16_t hz) {
+		out[0] = cmd_telemetry_rate;
+		put_u16(out + 1, hz);
+		return rate_size;
+	}
+
+	/* also forces a keyframe next: the Pi resends it after a lost frame */
+	static inline size_t encode_telemetry_format(uint8_t* out, uint8_t format, uint8_t batch, uint16_t keyframe_interval) {
+		out[0] = cmd_telemetry_format;
+		out[1] = format;
+		out[2] = batch;
+		put_u16(out + 3, keyframe_interval);
+		return format_size;
+	}
+
+	/* ping and pong share a layout, only the id differs */
+	static inline size_t encode_token(uint8_t* out, uint8_t id, uint32_t token) {
+		out[0] = id;
+		put_u32(out + 1, token);
+		return ping_size;
+	}
+
+	/*
+	 * Clock sync (NTP style). Request and reply are the same length so the
+	 * serialisation time of each leg is equal and cancels out of the offset.
+	 * rx_us: MCU time the request's closing delimiter arrived (USART ISR).
+	 * tx_us: MCU time the reply is expected to start on the wire.
+	 */
+	static inline size_t encode_time_sync_request(uint8_t* out, uint32_t token) {
+		out[0] = cmd_time_sync;
+		put_u32(out + 1, token);
+		memset(out + 5, 0, time_sync_size - 5);
+		return time_sync_size;
+	}
+
+	static inline size_t encode_time_sync_reply(uint8_t* out, uint32_t token, uint32_t rx_us, uint32_t tx_us) {
+		out[0] = msg_time_sync;
+		put_u32(out + 1, token);
+		put_u32(out + 5, rx_us);
+		put_u32(out + 9, tx_us);
+		return time_sync_size;
+	}
+
+	static inline bool decode_time_sync_reply(const uint8_t* in, size_t len, uint32_t* token, uint32_t* rx_us, uint32_t* tx_us) {
+		if(len < time_sync_size || in[0] != msg_time_sync)
+			return false;
+		*token = get_u32(in + 1);
+		*rx_us = get_u32(in + 5);
+		*tx_us = get_u32(in + 9);
+		return true;
+	}
+
+	static inline size_t encode_baud_propose(uint8_t* out, uint32_t baud, uint16_t trial_ms) {
+		out[0] = cmd_baud_propose;
+		put_u32(out + 1, baud);
+		put_u16(out + 5, trial_ms);
+		return propose_size;
+	}
+
+	static inline size_t encode_baud_ack(uint8_t* out, uint32_t baud, uint8_t status) {
+		out[0] = msg_baud_ack;
+		put_u32(out + 1, baud);
+		out[5] = status;
+		return baud_ack_size;
+	}
+
+	static inline size_t encode_baud_commit(uint8_t* out, uint32_t baud) {
+		out[0] = cmd_baud_commit;
+		put_u32(out + 1, baud);
+		return commit_size;
+	}
+
+	/* the board echoes the payload unchanged, only the id differs */
+	static inline size_t encode_link_test(uint8_t* out, uint16_t seq, uint8_t pattern) {
+		out[0] = cmd_link_test;
+		put_u16(out + 1, seq);
+		out[3] = pattern;
+		uint32_t x = 0x9E3779B9u ^ seq;
+		for(size_t i = 4; i < link_test_size; i++) {
+			switch(pattern) {
+				case pattern_zeros:     out[i] = 0x00; break;
+				case pattern_ones:      out[i] = 0xFF; break;
+				case pattern_alternate: out[i] = 0x55; break;
+				default:
+					x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+					out[i] = static_cast<uint8_t>(x);
+					break;
+			}
+		}
+		return link_test_size;
+	}
+
+	static inline size_t encode_telemetry(uint8_t* out, const telemetry& t) {
+		out[0] = msg_telemetry;
+		put_u32(out + 1, t.timestamp_us);
+		for(uint8_t i = 0; i < motor_count; i++)
+			put_u32(out + 5 + 4 * i, static_cast<uint32_t>(t.position[i]));
+		uint32_t bits;
+		memcpy(&bits, &t.distance_cm, sizeof(bits));
+		put_u32(out + 5 + 4 * motor_count, bits);
+		return telemetry_size;
+	}
+
+	static inline bool decode_telemetry(const uint8_t* in, size_t len, telemetry* t) {
+		if(len < telemetry_size || in[0] != msg_telemetry)
+			return false;
+		t->timestamp_us = get_u32(in + 1);
+		for(uint8_t i = 0; i < motor_count; i++)
+			t->position[i] = static_cast<int32_t>(get_u32(in + 5 + 4 * i));
+		uint32_t bits = get_u32(in + 5 + 4 * motor_count);
+		memcpy(&t->distance_cm, &bits, sizeof(bits));
+		return true;
+	}
+
+}
+
+#endif /* CUSTOM_DRIVER_LIB_ROBOT_PROTOCOL_H_ */
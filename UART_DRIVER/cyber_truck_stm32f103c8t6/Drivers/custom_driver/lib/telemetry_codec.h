@@ -0,0 +1,277 @@
+/*
+ * telemetry_codec.h
+ *
+ *  Created on: Sep 17, 2025
+ *      Author: ziad
+ *
+ *  Compact telemetry (robot_protocol::format_compact), shared by the
+ *  firmware robot_link, stm32_emu and robotd.
+ *
+ *  keyframe : msg_telemetry_key   | seq | ts (LE32) | zz pos[4] | dist
+ *  delta    : msg_telemetry_delta | seq | count | count x sample
+ *  sample   : zz (dt - prev dt) | zz dpos[4] | zz ddist
+ *
+ *  zz = zig-zag LEB128 varint, dist = distance in 0.1 mm (0 = no echo).
+ *  Timestamps are delta-of-delta coded, so a steady telemetry rate costs
+ *  one byte; positions and distance are plain deltas, one or two bytes
+ *  while the robot moves and one byte when it stands. A sample is ~6-10
+ *  bytes instead of 25, and batching several per frame also shares the
+ *  CRC/COBS/delimiter overhead, for 3-5x the samples per second.
+ *
+ *  seq counts frames. A gap (lost or dropped frame) makes the decoder
+ *  discard deltas until the next keyframe; the Pi shortens the wait by
+ *  resending cmd_telemetry_format, which forces one.
+ */
+
+#ifndef CUSTOM_DRIVER_LIB_TELEMETRY_CODEC_H_
+#define CUSTOM_DRIVER_LIB_TELEMETRY_CODEC_H_
+
+#include "robot_protocol.h"
+
+namespace telemetry_codec {
+
+	constexpr size_t max_varint   = 5;
+	constexpr size_t key_header   = 2;                              /* id, seq */
+	constexpr size_t delta_header = 3;                              /* id, seq, count */
+	constexpr size_t max_sample   = max_varint * (2 + robot_protocol::motor_count);
+	constexpr size_t max_key_size = key_header + 4 + max_varint * (1 + robot_protocol::motor_count);
+	constexpr size_t max_batch    = (robot_protocol::max_message - delta_header) / (2 + robot_protocol::motor_count);
+
+	static_assert(delta_header + max_sample <= robot_protocol::max_message, "one sample must fit a delta frame");
+	static_assert(max_key_size <= robot_protocol::max_message, "keyframe must fit a message");
+
+	static inline uint32_t zigzag(int32_t v) {
+		return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+	}
+
+	static inline int32_t unzigzag(uint32_t v) {
+		return static_cast<int32_t>((v >> 1) ^ (~(v & 1) + 1));
+	}
+
+	static inline size_t put_varint(uint8_t* out, uint32_t v) {
+		size_t n = 0;
+		while(v >= 0x80) {
+			out[n++] = static_cast<uint8_t>(v | 0x80);
+			v >>= 7;
+		}
+		out[n++] = static_cast<uint8_t>(v);
+		return n;
+	}
+
+	/* nullptr on a truncated or over-long varint */
+	static inline const uint8_t* get_varint(const uint8_t* in, const uint8_t* end, uint32_t* v) {
+		uint32_t result = 0;
+		for(unsigned shift = 0; shift < 35 && in < end; shift += 7) {
+			uint8_t b = *in++;
+			result |= static_cast<uint32_t>(b & 0x7F) << shift;
+			if(!(b & 0x80)) {
+				*v = result;
+				return in;
+			}
+		}
+		return nullptr;
+	}
+
+	static inline uint32_t quantize_distance(float cm) {
+		return cm > 0.0f ? static_cast<uint32_t>(cm * 100.0f + 0.5f) : 0;
+	}
+
+	/* what both ends remember between samples */
+	struct state {
+		uint32_t timestamp_us;
+		uint32_t dt_us;
+		int32_t  position[robot_protocol::motor_count];
+		uint32_t distance;
+	};
+
+	class encoder {
+	public:
+		encoder() : batch_limit(1), keyframe_interval(50), since_key(0), seq(0), key_due(true), len(0), count(0) {}
+
+		/* a new configuration always starts with a keyframe */
+		void configure(uint8_t batch, uint16_t keyframe) {
+			this->batch_limit = batch ? batch : 1;
+			this->keyframe_interval = keyframe ? keyframe : 1;
+			this->key_due = true;
+		}
+
+		void force_keyframe() { this->key_due = true; }
+
+		/*
+		 * Add one sample; send(msg, len) is called for every message that is
+		 * complete (a full batch, or a batch flushed ahead of a keyframe).
+		 */
+		template <typename Send>
+		void add(const robot_protocol::telemetry& t, Send send) {
+			uint32_t distance = quantize_distance(t.distance_cm);
+			if(this->key_due || this->since_key >= this->keyframe_interval) {
+				this->flush(send);
+				uint8_t msg[max_key_size];
+				size_t n = 0;
+				msg[n++] = robot_protocol::msg_telemetry_key;
+				msg[n++] = this->seq++;
+				robot_protocol::put_u32(msg + n, t.timestamp_us);
+				n += 4;
+				for(uint8_t i = 0; i < robot_protocol::motor_count; i++)
+					n += put_varint(msg + n, zigzag(t.position[i]));
+				n += put_varint(msg + n, distance);
+				this->remember(t, distance, 0);
+				this->key_due = false;
+				this->since_key = 1;
+				send(msg, n);
+				return;
+			}
+
+			if(this->len + max_sample > sizeof(this->buf))
+				this->flush(send);
+			if(this->count == 0) {
+				this->buf[0] = robot_protocol::msg_telemetry_delta;
+				this->len = delta_header;
+			}
+			uint32_t dt = t.timestamp_us - this->prev.timestamp_us;
+			this->len += put_varint(this->buf + this->len, zigzag(static_cast<int32_t>(dt - this->prev.dt_us)));
+			for(uint8_t i = 0; i < robot_protocol::motor_count; i++)
+				this->len += put_varint(this->buf + this->len,
+				                        zigzag(static_cast<int32_t>(static_cast<uint32_t>(t.position[i]) -
+				                                                    static_cast<uint32_t>(this->prev.position[i]))));
+			this->len += put_varint(this->buf + this->len, zigzag(static_cast<int32_t>(distance - this->prev.distance)));
+			this->remember(t, distance, dt);
+			this->count++;
+			this->since_key++;
+			if(this->count >= this->batch_limit)
+				this->flush(send);
+		}
+
+		/* send a partial batch now (telemetry stopping, rate change) */
+		template <typename Send>
+		void flush(Send send) {
+			if(this->count == 0)
+				return;
+			this->buf[1] = this->seq++;
+			this->buf[2] = this->count;
+			send(this->buf, this->len);
+			this->count = 0;
+			this->len = 0;
+		}
+
+	private:
+		void remember(const robot_protocol::telemetry& t, uint32_t distance, uint32_t dt) {
+			this->prev.timestamp_us = t.timestamp_us;
+			this->prev.dt_us = dt;
+			for(uint8_t i = 0; i < robot_protocol::motor_count; i++)
+				this->prev.position[i] = t.position[i];
+			this->prev.distance = distance;
+		}
+
+		uint8_t batch_limit;
+		uint16_t keyframe_interval;
+		uint16_t since_key;
+		uint8_t seq;
+		bool key_due;
+		state prev;
+		uint8_t buf[robot_protocol::max_message];
+		size_t len;
+		uint8_t count;
+	};
+
+	class decoder {
+	public:
+		decoder() : synced(false), expected_seq(0), gaps(0), malformed(0) {}
+
+		/*
+		 * Decode a msg_telemetry_key / msg_telemetry_delta message into up to
+		 * max samples. Returns the number decoded, 0 for deltas dropped while
+		 * waiting for a keyframe, -1 if msg is not compact telemetry.
+		 */
+		int decode(const uint8_t* msg, size_t len, robot_protocol::telemetry* out, size_t max) {
+			if(len < key_header || max == 0 ||
+			   (msg[0] != robot_protocol::msg_telemetry_key && msg[0] != robot_protocol::msg_telemetry_delta))
+				return -1;
+			const uint8_t* p = msg + 2;
+			const uint8_t* end = msg + len;
+			uint32_t v;
+
+			if(msg[0] == robot_protocol::msg_telemetry_key) {
+				if(len < key_header + 4)
+					return this->fail();
+				state s;
+				s.timestamp_us = robot_protocol::get_u32(p);
+				s.dt_us = 0;
+				p += 4;
+				for(uint8_t i = 0; i < robot_protocol::motor_count; i++) {
+					if(!(p = get_varint(p, end, &v)))
+						return this->fail();
+					s.position[i] = unzigzag(v);
+				}
+				if(!(p = get_varint(p, end, &s.distance)))
+					return this->fail();
+				this->prev = s;
+				this->synced = true;
+				this->expected_seq = static_cast<uint8_t>(msg[1] + 1);
+				this->emit(out[0]);
+				return 1;
+			}
+
+			if(len < delta_header)
+				return this->fail();
+			if(!this->synced || msg[1] != this->expected_seq) {
+				if(this->synced)
+					this->gaps++;
+				this->synced = false;
+				return 0;
+			}
+			this->expected_seq++;
+			size_t n = 0;
+			p = msg + delta_header;
+			for(uint8_t k = 0; k < msg[2]; k++) {
+				state s;
+				if(!(p = get_varint(p, end, &v)))
+					return this->fail();
+				s.dt_us = this->prev.dt_us + static_cast<uint32_t>(unzigzag(v));
+				s.timestamp_us = this->prev.timestamp_us + s.dt_us;
+				for(uint8_t i = 0; i < robot_protocol::motor_count; i++) {
+					if(!(p = get_varint(p, end, &v)))
+						return this->fail();
+					s.position[i] = static_cast<int32_t>(static_cast<uint32_t>(this->prev.position[i]) +
+					                                     static_cast<uint32_t>(unzigzag(v)));
+				}
+				if(!(p = get_varint(p, end, &v)))
+					return this->fail();
+				s.distance = this->prev.distance + static_cast<uint32_t>(unzigzag(v));
+				this->prev = s;
+				if(n < max)
+					this->emit(out[n++]);
+			}
+			return static_cast<int>(n);
+		}
+
+		/* deltas are being discarded until a keyframe arrives */
+		bool waiting_for_keyframe() const { return !this->synced; }
+		void reset() { this->synced = false; }
+		uint32_t gap_count() const { return this->gaps; }
+		uint32_t malformed_count() const { return this->malformed; }
+
+	private:
+		int fail() {
+			this->synced = false;
+			this->malformed++;
+			return 0;
+		}
+
+		void emit(robot_protocol::telemetry& t) const {
+			t.timestamp_us = this->prev.timestamp_us;
+			for(uint8_t i = 0; i < robot_protocol::motor_count; i++)
+				t.position[i] = this->prev.position[i];
+			t.distance_cm = this->prev.distance / 100.0f;
+		}
+
+		bool synced;
+		uint8_t expected_seq;
+		uint32_t gaps;
+		uint32_t malformed;
+		state prev;
+	};
+
+}
+
+#endif /* CUSTOM_DRIVER_LIB_TELEMETRY_CODEC_H_ */
@@ -0,0 +1,40 @@
+/*
+ * crc.cpp
+ *
+ *  Created on: Sep 8, 2025
+ *      Author: ziad
+ */
+
+#include "crc.h"
+
+crc_unit::crc_unit() {
+	this->enable_peripheral_clock(periphrales_bus::AHP, clock_crc);
+}
+
+uint32_t crc_unit::compute(const uint8_t* data, size_t len) {
+	CRC->CR = CRC_CR_RESET;
+
+	size_t words = len / 4;
+	for(size_t i = 0; i < words; i++) {
+		CRC->DR = frame_codec::load_le32(data + 4 * i);
+	}
+
+	size_t rest = len % 4;
+	if(rest) {
+		uint8_t tail[4] = {0, 0, 0, 0};
+		for(size_t i = 0; i < rest; i++) {
+			tail[i] = data[words * 4 + i];
+		}
+		CRC->DR = frame_codec::load_le32(tail);
+	}
+	return CRC->DR;
+}
+
+long crc_unit::check_frame(const uint8_t* frame, size_t len) {
+	if(len < frame_codec::crc_size)
+		return -1;
+	size_t payload_len = len - frame_codec::crc_size;
+	if(this->compute(frame, payload_len) != frame_codec::load_le32(frame + payload_len))
+		return -1;
+	return static_cast<long>(payload_len);
+}
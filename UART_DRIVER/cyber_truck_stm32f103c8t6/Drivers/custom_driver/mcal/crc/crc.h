@@ -0,0 +1,25 @@
+/*
+ * crc.h
+ *
+ *  Created on: Sep 8, 2025
+ *      Author: ziad
+ */
+
+#ifndef CUSTOM_DRIVER_MCAL_CRC_CRC_H_
+#define CUSTOM_DRIVER_MCAL_CRC_CRC_H_
+
+#include "../rcc/rcc.h"
+#include "../../lib/frame_codec.h"
+
+/*
+ * Hardware CRC unit. Produces the same value as frame_codec::crc32(),
+ * so received frames can be checked without the software tables.
+ */
+class crc_unit : public rcc {
+public:
+	crc_unit();
+	uint32_t compute(const uint8_t* data, size_t len);
+	long check_frame(const uint8_t* frame, size_t len);
+};
+
+#endif /* CUSTOM_DRIVER_MCAL_CRC_CRC_H_ */
@@ -0,0 +1,94 @@
+/*
+ * encoder.cpp
+ *
+ *  Created on: Sep 16, 2025
+ *      Author: ziad
+ */
+
+#include "encoder.h"
+
+encoder::encoder(TIM_TypeDef* tim, uint32_t max_count) :
+				instance(tim),
+				period((max_count == 0 || max_count > 0xFFFF) ? 0x10000 : max_count),
+				wrapped(0) {
+	GPIO_PORT port = GPIO_PORT::A;
+	uint8_t ch1 = 0;
+	IRQn_Type irq = TIM2_IRQn;
+	if (this->instance == TIM1) {
+		rcc::enable_peripheral_clock(periphrales_bus::APB2, clock_timer_1);
+		ch1 = 8; irq = TIM1_UP_IRQn;
+		encoder_objects[3] = this;
+	}
+	else if (this->instance == TIM2) {
+		rcc::enable_peripheral_clock(periphrales_bus::APB1, clock_timer_2);
+		ch1 = 0; irq = TIM2_IRQn;
+		encoder_objects[0] = this;
+	}
+	else if (this->instance == TIM3) {
+		rcc::enable_peripheral_clock(periphrales_bus::APB1, clock_timer_3);
+		ch1 = 6; irq = TIM3_IRQn;
+		encoder_objects[1] = this;
+	}
+	else if (this->instance == TIM4) {
+		rcc::enable_peripheral_clock(periphrales_bus::APB1, clock_timer_4);
+		port = GPIO_PORT::B; ch1 = 6; irq = TIM4_IRQn;
+		encoder_objects[2] = this;
+	}
+
+	/* open-collector encoders need the pull-ups */
+	gpio input_a(port, ch1, GPIO_STATUS::INPUT, GPIO_CONFIG::PULL_UP_DOWN);
+	gpio input_b(port, ch1 + 1, GPIO_STATUS::INPUT, GPIO_CONFIG::PULL_UP_DOWN);
+
+	instance->CR1 = 0;
+	instance->SMCR = (3 << TIM_SMCR_SMS_Pos);			// encoder mode 3: count both edges of TI1 and TI2
+	instance->CCMR1 = (1 << TIM_CCMR1_CC1S_Pos) | (ENCODER_INPUT_FILTER << TIM_CCMR1_IC1F_Pos) |
+	                  (1 << TIM_CCMR1_CC2S_Pos) | (ENCODER_INPUT_FILTER << TIM_CCMR1_IC2F_Pos);
+	instance->CCER = 0;									// rising polarity, no capture
+	instance->PSC = 0;
+	instance->ARR = this->period - 1;
+	instance->CR1 = TIM_CR1_URS;						// only over/underflow raise UIF
+	instance->EGR = TIM_EGR_UG;							// load PSC/ARR
+	instance->CNT = 0;
+	instance->SR = static_cast<uint32_t>(~TIM_SR_UIF);	// rc_w0: writing 1 leaves other flags alone
+	instance->DIER = TIM_DIER_UIE;
+	NVIC_EnableIRQ(irq);
+	instance->CR1 |= TIM_CR1_CEN;
+}
+
+/*
+ * Update event: the counter crossed the period boundary. Which way is told
+ * by where the count is now rather than by DIR, which may already have
+ * flipped if the shaft reversed right at the boundary.
+ */
+void encoder::handler() {
+	if (instance->SR & TIM_SR_UIF) {
+		instance->SR = static_cast<uint32_t>(~TIM_SR_UIF);
+		int32_t step = static_cast<int32_t>(this->period);
+		this->wrapped += instance->CNT < this->period / 2 ? step : -step;
+	}
+}
+
+int32_t encoder::position() {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	int32_t base = this->wrapped;
+	uint32_t count = instance->CNT;
+	/* wrapped but not yet handled (interrupts off, or we are a higher
+	   priority): account for it here, with a count read after the wrap */
+	if (instance->SR & TIM_SR_UIF) {
+		count = instance->CNT;
+		int32_t step = static_cast<int32_t>(this->period);
+		base += count < this->period / 2 ? step : -step;
+	}
+	__set_PRIMASK(primask);
+	return base + static_cast<int32_t>(count);
+}
+
+void encoder::reset() {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	instance->CNT = 0;
+	instance->SR = static_cast<uint32_t>(~TIM_SR_UIF);
+	this->wrapped = 0;
+	__set_PRIMASK(primask);
+}
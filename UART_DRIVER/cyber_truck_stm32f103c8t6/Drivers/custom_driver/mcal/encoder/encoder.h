@@ -0,0 +1,42 @@
+/*
+ * encoder.h
+ *
+ *  Created on: Sep 16, 2025
+ *      Author: ziad
+ */
+
+#ifndef CUSTOM_DRIVER_MCAL_ENCODER_ENCODER_H_
+#define CUSTOM_DRIVER_MCAL_ENCODER_ENCODER_H_
+
+#include "../gpio/gpio.h"
+
+/* ICxF: fCK_INT, N=8 - ignores glitches shorter than ~110 ns at 72 MHz */
+#define ENCODER_INPUT_FILTER 0x3
+
+/*
+ * Quadrature encoder on a timer's CH1/CH2 in encoder mode 3 (SMS=011):
+ * the timer counts every edge of both channels, up or down, with no CPU
+ * involvement. Only the counter wrapping costs an interrupt, which
+ * extends the 16-bit count to a signed 32-bit position.
+ *
+ * Inputs are the timer's fixed pins (no remap): TIM1 PA8/PA9,
+ * TIM2 PA0/PA1, TIM3 PA6/PA7, TIM4 PB6/PB7.
+ */
+class encoder {
+public:
+	/* max_count: counter period (edges per revolution); 0 uses the full 16 bits */
+	encoder(TIM_TypeDef* tim, uint32_t max_count);
+	/* edges since reset; consistent even if read just as the counter wraps */
+	int32_t position();
+	void reset();
+	void handler();
+private:
+	TIM_TypeDef* instance;
+	uint32_t period;
+	volatile int32_t wrapped;		/* sum of whole periods passed */
+};
+
+/* same mapping as timer_objects: TIM2, TIM3, TIM4, TIM1 */
+extern encoder* encoder_objects[4];
+
+#endif /* CUSTOM_DRIVER_MCAL_ENCODER_ENCODER_H_ */
@@ -10,6 +10,7 @@
 
 #include "../../lib/common.h"
 #include  "../rcc/rcc.h"
+#include <initializer_list>
 
 enum class GPIO_PORT : uint8_t {
 	A, B, C
@@ -35,18 +36,134 @@ enum class GPIO_CONFIG {
     AF_OPEN_DRAIN = 0b11
 };
 
-class gpio  : public rcc {
+/* GPIOA..C sit 0x400 apart on APB2, and their clock enables are adjacent bits */
+constexpr uint32_t gpio_base(GPIO_PORT port) {
+	return GPIOA_BASE + static_cast<uint32_t>(port) * 0x400U;
+}
+
+constexpr uint32_t gpio_clock(GPIO_PORT port) {
+	return clock_gpio_a + static_cast<uint32_t>(port);
+}
+
+inline GPIO_TypeDef* gpio_regs(GPIO_PORT port) {
+	return reinterpret_cast<GPIO_TypeDef*>(gpio_base(port));
+}
+
+/*
+ * A pin chosen at run time. The port registers and the pin mask are looked
+ * up once in the constructor, so set/clear/get are a single BSRR store or
+ * IDR load.
+ */
+class gpio {
 public:
 	gpio(GPIO_PORT port,uint32_t pin, GPIO_STATUS dir, GPIO_CONFIG cfg);
-	void set();
-	void clear();
-	bool get();
+	inline void set() { this->regs->BSRR = this->mask; }
+	inline void clear() { this->regs->BSRR = this->mask << 16; }
+	inline bool get() { return (this->regs->IDR & this->mask) != 0; }
+
+	/* for composing one BSRR write with other pins of the same port */
+	inline GPIO_TypeDef* port() const { return this->regs; }
+	inline uint32_t set_bits() const { return this->mask; }
+	inline uint32_t clear_bits() const { return this->mask << 16; }
 private:
 	GPIO_STATUS direction;
-	GPIO_PORT port_index;
-	uint32_t pin_index;
 	GPIO_CONFIG pin_cfg;
+	GPIO_TypeDef* regs;
+	uint32_t pin_index;
+	uint32_t mask;
 	void init();
 };
 
+/*
+ * A pin fixed at compile time, e.g.
+ *   using led = gpio_pin<GPIO_PORT::C, 13>;
+ *   led::init(); led::set();
+ * No object and no state: every call folds to one access at a constant
+ * address.
+ */
+template <GPIO_PORT Port, uint8_t Pin,
+          GPIO_STATUS Mode = GPIO_STATUS::OUTPUT_50MHz,
+          GPIO_CONFIG Cfg = GPIO_CONFIG::GP_PUSH_PULL>
+struct gpio_pin {
+	static_assert(Pin < 16, "a port has 16 pins");
+
+	static constexpr GPIO_PORT port = Port;
+	static constexpr uint8_t pin = Pin;
+	static constexpr uint32_t set_bits = 1UL << Pin;
+	static constexpr uint32_t clear_bits = 1UL << (Pin + 16);
+
+	static inline GPIO_TypeDef* regs() { return reinterpret_cast<GPIO_TypeDef*>(gpio_base(Port)); }
+
+	static void init() {
+		rcc::enable_peripheral_clock(periphrales_bus::APB2, gpio_clock(Port));
+		constexpr uint32_t shift = (Pin % 8) * 4;
+		constexpr uint32_t val = static_cast<uint32_t>(Mode) | (static_cast<uint32_t>(Cfg) << 2);
+		volatile uint32_t& cr = Pin < 8 ? regs()->CRL : regs()->CRH;
+		cr = (cr & ~(0xFUL << shift)) | (val << shift);
+		if(Mode == GPIO_STATUS::INPUT && Cfg == GPIO_CONFIG::PULL_UP_DOWN)
+			regs()->BSRR = set_bits;	// pull-up
+	}
+
+	static inline void set() { regs()->BSRR = set_bits; }
+	static inline void clear() { regs()->BSRR = clear_bits; }
+	static inline void write(bool level) { regs()->BSRR = set_bits << (level ? 0 : 16); }
+	static inline bool get() { return (regs()->IDR & set_bits) != 0; }
+};
+
+/*
+ * gpio_pin<>s of one port driven together: a single BSRR store sets and
+ * clears all of them on the same bus cycle, e.g.
+ *   using dirs = gpio_port_group<GPIO_PORT::B, in1, in2, in3, in4>;
+ *   dirs::write(0b0101);	// in1, in3 high; in2, in4 low
+ */
+template <GPIO_PORT Port, typename... Pins>
+struct gpio_port_group {
+private:
+	static constexpr bool same_port(std::initializer_list<GPIO_PORT> ports) {
+		for(GPIO_PORT p : ports) {
+			if(p != Port)
+				return false;
+		}
+		return true;
+	}
+
+	static constexpr uint32_t or_all(std::initializer_list<uint32_t> bits) {
+		uint32_t all = 0;
+		for(uint32_t b : bits)
+			all |= b;
+		return all;
+	}
+
+public:
+	static_assert(sizeof...(Pins) > 0 && sizeof...(Pins) <= 16, "one to sixteen pins");
+	static_assert(same_port({Pins::port...}), "every pin must be on the group's port");
+
+	static constexpr uint32_t mask = or_all({Pins::set_bits...});
+
+	static inline GPIO_TypeDef* regs() { return reinterpret_cast<GPIO_TypeDef*>(gpio_base(Port)); }
+
+	static void init() {
+		using expand = int[];
+		(void)expand{ (Pins::init(), 0)... };
+	}
+
+	/* bit n of levels drives the nth pin of the group */
+	static inline void write(uint32_t levels) {
+		constexpr uint32_t set[] = { Pins::set_bits... };
+		uint32_t bsrr = 0;
+		for(uint32_t i = 0; i < sizeof...(Pins); i++)
+			bsrr |= (levels & (1UL << i)) ? set[i] : set[i] << 16;
+		regs()->BSRR = bsrr;
+	}
+
+	/* raw port masks; pins outside the group are left alone */
+	static inline void set_clear(uint32_t set, uint32_t clear) {
+		regs()->BSRR = (set & mask) | ((clear & mask & ~set) << 16);
+	}
+
+	static inline void set_all() { regs()->BSRR = mask; }
+	static inline void clear_all() { regs()->BSRR = mask << 16; }
+	static inline uint32_t get() { return regs()->IDR & mask; }
+};
+
 #endif /* CUSTOM_DRIVER_MCAL_GPIO_GPIO_H_ */
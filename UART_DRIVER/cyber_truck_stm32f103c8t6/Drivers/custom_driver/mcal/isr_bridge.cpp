@@ -20,7 +20,21 @@ extern "C" void EXTI15_10_IRQHandler(void)  { for (int i=10; i<=15; ++i) if (ext
 // Fixed mapping: TIM2 -> [0], TIM3 -> [1], TIM4 -> [2], TIM1 -> [3] لو عايز
 timer* timer_objects[4] = {nullptr};
 
-extern "C" void TIM1_UP_IRQHandler(void) { if (timer_objects[3]) timer_objects[3]->handler(); }
-extern "C" void TIM2_IRQHandler(void)    { if (timer_objects[0]) timer_objects[0]->handler(); }
-extern "C" void TIM3_IRQHandler(void)    { if (timer_objects[1]) timer_objects[1]->handler(); }
-extern "C" void TIM4_IRQHandler(void)    { if (timer_objects[2]) timer_objects[2]->handler(); }
+/* a timer in encoder mode interrupts only to extend its count */
+encoder* encoder_objects[4] = {nullptr};
+
+extern "C" void TIM1_UP_IRQHandler(void) { if (encoder_objects[3]) encoder_objects[3]->handler(); else if (timer_objects[3]) timer_objects[3]->handler(); }
+extern "C" void TIM2_IRQHandler(void)    { if (encoder_objects[0]) encoder_objects[0]->handler(); else if (timer_objects[0]) timer_objects[0]->handler(); }
+extern "C" void TIM3_IRQHandler(void)    { if (encoder_objects[1]) encoder_objects[1]->handler(); else if (timer_objects[1]) timer_objects[1]->handler(); }
+extern "C" void TIM4_IRQHandler(void)    { if (encoder_objects[2]) encoder_objects[2]->handler(); else if (timer_objects[2]) timer_objects[2]->handler(); }
+
+/* USART1..3 -> usart_objects[0..2]; each port owns its DMA1 RX/TX channels */
+extern "C" void USART1_IRQHandler(void)        { if (usart_objects[0]) usart_objects[0]->usart_handler(); }
+extern "C" void USART2_IRQHandler(void)        { if (usart_objects[1]) usart_objects[1]->usart_handler(); }
+extern "C" void USART3_IRQHandler(void)        { if (usart_objects[2]) usart_objects[2]->usart_handler(); }
+extern "C" void DMA1_Channel5_IRQHandler(void) { if (usart_objects[0]) usart_objects[0]->rx_dma_handler(); }
+extern "C" void DMA1_Channel4_IRQHandler(void) { if (usart_objects[0]) usart_objects[0]->tx_dma_handler(); }
+extern "C" void DMA1_Channel6_IRQHandler(void) { if (usart_objects[1]) usart_objects[1]->rx_dma_handler(); }
+extern "C" void DMA1_Channel7_IRQHandler(void) { if (usart_objects[1]) usart_objects[1]->tx_dma_handler(); }
+extern "C" void DMA1_Channel3_IRQHandler(void) { if (usart_objects[2]) usart_objects[2]->rx_dma_handler(); }
+extern "C" void DMA1_Channel2_IRQHandler(void) { if (usart_objects[2]) usart_objects[2]->tx_dma_handler(); }
@@ -13,5 +13,8 @@
 #include "gpio/gpio.h"
 #include "exti/exti.h"
 #include "tim/tim.h"
+#include "encoder/encoder.h"
+#include "crc/crc.h"
+#include "systime/systime.h"
 
 #endif /* CUSTOM_DRIVER_MCAL_MCAL_DFS_H_ */
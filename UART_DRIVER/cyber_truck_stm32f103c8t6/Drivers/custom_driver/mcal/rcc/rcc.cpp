@@ -6,23 +6,78 @@
  */
 #include "rcc.h"
 
-rcc::rcc(rcc_clock_src src_clock) : clock_src(src_clock) {
-	switch (this->clock_src) {
-		case rcc_clock_src::HSE:
-			bit_math::set_bit(RCC->CR, 16);
-			break;
-		case rcc_clock_src::HSI:
-			bit_math::set_bit(RCC->CR, 0);
-			break;
-		case rcc_clock_src::PLL:
-			bit_math::set_bit(RCC->CR, 24);
-			break;
-		default:
-			/* error state */
-			break;
+/* HSE start-up is a few ms; give up well after that rather than hang */
+static constexpr uint32_t ready_timeout = 500000;
+
+static bool wait_for(volatile uint32_t& reg, uint32_t mask, uint32_t value) {
+	for(uint32_t i = 0; i < ready_timeout; i++) {
+		if((reg & mask) == value)
+			return true;
+	}
+	return false;
+}
+
+bool rcc::apply(const rcc_settings& s) {
+	bool hse = s.source == rcc_clock_src::HSE ||
+	           (s.source == rcc_clock_src::PLL && s.pll_input == rcc_pll_input::HSE);
+
+	/* run from HSI while the tree is rebuilt */
+	bit_math::set_bit(RCC->CR, 0);
+	if(!wait_for(RCC->CR, RCC_CR_HSIRDY, RCC_CR_HSIRDY))
+		return false;
+	RCC->CFGR &= ~RCC_CFGR_SW;
+	if(!wait_for(RCC->CFGR, RCC_CFGR_SWS, RCC_CFGR_SWS_HSI))
+		return false;
+	bit_math::clear_bit(RCC->CR, 24);	/* PLL is only configurable while off */
+	if(!wait_for(RCC->CR, RCC_CR_PLLRDY, 0))
+		return false;
+
+	if(hse) {
+		bit_math::set_bit(RCC->CR, 16);
+		if(!wait_for(RCC->CR, RCC_CR_HSERDY, RCC_CR_HSERDY))
+			return false;
+	}
+
+	/* wait states before the clock goes up; the prefetch buffer hides them
+	   on straight-line code */
+	FLASH->ACR = (FLASH->ACR & ~FLASH_ACR_LATENCY) | FLASH_ACR_PRFTBE | s.flash_latency;
+
+	/* everything but SW, then the PLL, then SW */
+	RCC->CFGR = s.cfgr & ~RCC_CFGR_SW;
+	if(s.source == rcc_clock_src::PLL) {
+		bit_math::set_bit(RCC->CR, 24);
+		if(!wait_for(RCC->CR, RCC_CR_PLLRDY, RCC_CR_PLLRDY))
+			return false;
+	}
+	RCC->CFGR = s.cfgr;
+	if(!wait_for(RCC->CFGR, RCC_CFGR_SWS, (s.cfgr & RCC_CFGR_SW) << 2))
+		return false;
+
+	SystemCoreClock = s.hclk;
+	return true;
+}
+
+uint32_t rcc::hclk() {
+	SystemCoreClockUpdate();
+	return SystemCoreClock;
+}
+
+uint32_t rcc::bus_clock(periphrales_bus bus) {
+	switch(bus) {
+	case periphrales_bus::APB1:
+		return hclk() >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos];
+	case periphrales_bus::APB2:
+		return hclk() >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE2) >> RCC_CFGR_PPRE2_Pos];
+	default:
+		return hclk();
 	}
 }
 
+uint32_t rcc::timer_clock(periphrales_bus bus) {
+	uint32_t pclk = bus_clock(bus);
+	return pclk == hclk() ? pclk : 2 * pclk;
+}
+
 void rcc::enable_peripheral_clock(periphrales_bus copy_bus, uint32_t copy_peripheral) {
 	switch(copy_bus) {
 	case periphrales_bus::APB1:
@@ -33,6 +33,10 @@ constexpr uint32_t clock_uart_3 = 18;
 constexpr uint32_t clock_uart_4 = 19;
 constexpr uint32_t clock_uart_5 = 20;
 
+/* AHB peripherals */
+constexpr uint32_t clock_dma_1 = 0;
+constexpr uint32_t clock_crc = 6;
+
 enum class periphrales_bus {
 	APB1, APB2, AHP
 };
@@ -41,12 +45,102 @@ enum class rcc_clock_src {
 	HSE, HSI, PLL
 };
 
+/* what feeds the PLL: the crystal, or the internal RC halved */
+enum class rcc_pll_input {
+	HSE, HSI_DIV2
+};
+
+/* prescaler encodings, 0xFF for a divider the hardware does not have */
+constexpr uint8_t rcc_ahb_bits(uint16_t div) {
+	return div == 1 ? 0x0 : div == 2 ? 0x8 : div == 4 ? 0x9 : div == 8 ? 0xA : div == 16 ? 0xB :
+	       div == 64 ? 0xC : div == 128 ? 0xD : div == 256 ? 0xE : div == 512 ? 0xF : 0xFF;
+}
+
+constexpr uint8_t rcc_apb_bits(uint8_t div) {
+	return div == 1 ? 0x0 : div == 2 ? 0x4 : div == 4 ? 0x5 : div == 8 ? 0x6 : div == 16 ? 0x7 : 0xFF;
+}
+
+/* the clock tree as register values, produced by clock_tree<> below */
+struct rcc_settings {
+	rcc_clock_src source;
+	rcc_pll_input pll_input;
+	uint32_t cfgr;			/* prescalers, PLL source and multiplier, SW */
+	uint32_t flash_latency;	/* wait states for SYSCLK */
+	uint32_t hclk;
+};
+
+/*
+ * A clock tree checked at compile time: PLL multiplier range, divider
+ * values, and the F103 limits (SYSCLK and PCLK2 72 MHz, PCLK1 36 MHz,
+ * ADC 14 MHz). Flash wait states follow from SYSCLK.
+ *
+ *   using clock_72mhz = clock_tree<rcc_clock_src::PLL, rcc_pll_input::HSE, 9, 1, 2, 1>;
+ *   rcc::configure<clock_72mhz>();
+ */
+template <rcc_clock_src Source, rcc_pll_input PllInput = rcc_pll_input::HSE, uint8_t PllMul = 2,
+          uint16_t AhbDiv = 1, uint8_t Apb1Div = 1, uint8_t Apb2Div = 1>
+struct clock_tree {
+	static constexpr uint32_t pll_in = PllInput == rcc_pll_input::HSE ? HSE_VALUE : HSI_VALUE / 2;
+	static constexpr uint32_t sysclk = Source == rcc_clock_src::PLL ? pll_in * PllMul :
+	                                   Source == rcc_clock_src::HSE ? HSE_VALUE : HSI_VALUE;
+	static constexpr uint32_t hclk = sysclk / AhbDiv;
+	static constexpr uint32_t pclk1 = hclk / Apb1Div;
+	static constexpr uint32_t pclk2 = hclk / Apb2Div;
+	static constexpr uint32_t adc_div = pclk2 / 2 <= 14000000 ? 2 : pclk2 / 4 <= 14000000 ? 4 :
+	                                    pclk2 / 6 <= 14000000 ? 6 : 8;
+
+	static_assert(Source != rcc_clock_src::PLL || (PllMul >= 2 && PllMul <= 16), "PLL multiplier is 2..16");
+	static_assert(rcc_ahb_bits(AhbDiv) != 0xFF, "AHB divider is 1, 2, 4 .. 512 (no 32)");
+	static_assert(rcc_apb_bits(Apb1Div) != 0xFF && rcc_apb_bits(Apb2Div) != 0xFF, "APB divider is 1, 2, 4, 8 or 16");
+	static_assert(sysclk <= 72000000, "SYSCLK above 72 MHz");
+	static_assert(pclk1 <= 36000000, "PCLK1 above 36 MHz, raise Apb1Div");
+	static_assert(pclk2 <= 72000000, "PCLK2 above 72 MHz");
+	static_assert(pclk2 / adc_div <= 14000000, "no ADC prescaler brings PCLK2 under 14 MHz");
+
+	static constexpr rcc_settings settings() {
+		return rcc_settings{
+			Source, PllInput,
+			(static_cast<uint32_t>(Source == rcc_clock_src::PLL ? PllMul - 2 : 0) << 18) |
+			(PllInput == rcc_pll_input::HSE ? (1UL << 16) : 0) |
+			(static_cast<uint32_t>(adc_div / 2 - 1) << 14) |
+			(static_cast<uint32_t>(rcc_apb_bits(Apb2Div)) << 11) |
+			(static_cast<uint32_t>(rcc_apb_bits(Apb1Div)) << 8) |
+			(static_cast<uint32_t>(rcc_ahb_bits(AhbDiv)) << 4) |
+			static_cast<uint32_t>(Source == rcc_clock_src::PLL ? 2 : Source == rcc_clock_src::HSE ? 1 : 0),
+			sysclk <= 24000000 ? 0UL : sysclk <= 48000000 ? 1UL : 2UL,
+			hclk
+		};
+	}
+};
+
+/* BluePill: 8 MHz crystal x9, APB1 halved to its 36 MHz limit */
+using clock_72mhz = clock_tree<rcc_clock_src::PLL, rcc_pll_input::HSE, 9, 1, 2, 1>;
+/* no crystal: HSI/2 x16 */
+using clock_64mhz_hsi = clock_tree<rcc_clock_src::PLL, rcc_pll_input::HSI_DIV2, 16, 1, 2, 1>;
+
+/*
+ * Clock gating for the drivers that derive from it, plus the one-time
+ * clock tree setup and frequency queries. Constructing a driver no longer
+ * touches the oscillators.
+ */
 class rcc {
-private:
-	rcc_clock_src clock_src;
 public:
-	rcc(rcc_clock_src src_clock);
-	void enable_peripheral_clock(periphrales_bus copy_bus, uint32_t copy_peripheral);
+	/* switch SYSCLK once at startup, before drivers compute prescalers or
+	   baud rates; false (still on HSI) if an oscillator or the PLL never
+	   became ready. systime::init() must run again afterwards. */
+	template <typename Tree>
+	static bool configure() {
+		return apply(Tree::settings());
+	}
+	static bool apply(const rcc_settings& s);
+
+	/* current frequencies, read back from RCC so they are right whoever set the clocks */
+	static uint32_t hclk();
+	static uint32_t bus_clock(periphrales_bus bus);
+	/* timers run at twice PCLK when their APB prescaler is not 1 */
+	static uint32_t timer_clock(periphrales_bus bus);
+
+	static void enable_peripheral_clock(periphrales_bus copy_bus, uint32_t copy_peripheral);
 };
 
 #endif /* CUSTOM_DRIVER_MCAL_RCC_RCC_H_ */
@@ -0,0 +1,44 @@
+/*
+ * systime.cpp
+ *
+ *  Created on: Sep 15, 2025
+ *      Author: ziad
+ */
+
+#include "systime.h"
+
+uint32_t systime::last_cycles = 0;
+uint32_t systime::us = 0;
+uint32_t systime::cycles_per_us = 8;
+
+void systime::init() {
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	cycles_per_us = SystemCoreClock / 1000000U;
+	if(cycles_per_us == 0)
+		cycles_per_us = 1;
+	last_cycles = 0;
+	__set_PRIMASK(primask);
+}
+
+/*
+ * Folds elapsed cycles into the microsecond count and keeps the remainder,
+ * so only a 32-bit divide (hardware UDIV) is needed and no time is lost.
+ * Safe from thread and interrupt context.
+ */
+uint32_t systime::now_us() {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	uint32_t now = DWT->CYCCNT;
+	uint32_t elapsed = now - last_cycles;
+	uint32_t whole = elapsed / cycles_per_us;
+	us += whole;
+	last_cycles += whole * cycles_per_us;
+	uint32_t result = us;
+	__set_PRIMASK(primask);
+	return result;
+}
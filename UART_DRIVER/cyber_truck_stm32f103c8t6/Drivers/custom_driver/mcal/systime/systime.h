@@ -0,0 +1,33 @@
+/*
+ * systime.h
+ *
+ *  Created on: Sep 15, 2025
+ *      Author: ziad
+ */
+
+#ifndef CUSTOM_DRIVER_MCAL_SYSTIME_SYSTIME_H_
+#define CUSTOM_DRIVER_MCAL_SYSTIME_SYSTIME_H_
+
+#include "../../lib/common.h"
+
+/*
+ * Free-running microsecond clock from the Cortex-M3 cycle counter (DWT).
+ * No timer or interrupt is used; CYCCNT wraps every 2^32 cycles (~60 s at
+ * 72 MHz), so now_us() must be called at least that often - robot_link's
+ * main loop and the USART ISR do. Timestamps in robot_protocol frames
+ * (telemetry, clock sync) all come from here.
+ *
+ * Call init() again after changing SystemCoreClock.
+ */
+class systime {
+public:
+	static void init();
+	static uint32_t now_us();
+	static inline uint32_t cycles() { return DWT->CYCCNT; }
+private:
+	static uint32_t last_cycles;
+	static uint32_t us;
+	static uint32_t cycles_per_us;
+};
+
+#endif /* CUSTOM_DRIVER_MCAL_SYSTIME_SYSTIME_H_ */
@@ -8,7 +8,7 @@
 #include "tim.h"
 
 timer::timer(TIM_TypeDef* tim, uint32_t prescaler, uint32_t arr, timer_callback_t cb)
-    : rcc(rcc_clock_src::HSE), instance(tim), callback(cb) {
+    : instance(tim), callback(cb) {
     // Enable clock
     if (this->instance == TIM1) {
 		this->enable_peripheral_clock(periphrales_bus::APB2, clock_timer_1);
@@ -29,6 +29,12 @@ timer::timer(TIM_TypeDef* tim, uint32_t prescaler, uint32_t arr, timer_callback_
     instance->DIER |= TIM_DIER_UIE;  // Enable update interrupt
 }
 
+uint32_t timer::prescaler_for(TIM_TypeDef* tim, uint32_t tick_hz) {
+    periphrales_bus bus = (tim == TIM1) ? periphrales_bus::APB2 : periphrales_bus::APB1;
+    uint32_t psc = rcc::timer_clock(bus) / tick_hz;
+    return psc == 0 ? 0 : psc - 1;
+}
+
 void timer::start() {
     instance->CR1 |= TIM_CR1_CEN;
 }
@@ -15,6 +15,8 @@ typedef void(*timer_callback_t)(void);
 class timer : public rcc{
 public:
     timer(TIM_TypeDef* tim, uint32_t prescaler, uint32_t arr, timer_callback_t cb);
+    /* PSC value for a counter tick of tick_hz at the current clock tree */
+    static uint32_t prescaler_for(TIM_TypeDef* tim, uint32_t tick_hz);
     void start();
     void stop();
     void pwm_init(uint8_t channel);
@@ -6,40 +6,304 @@
  */
 
 #include "uart.h"
+#include "../systime/systime.h"
 
-volatile char rxBuffer[RX_BUFFER_SIZE];
-volatile char txBuffer[TX_BUFFER_SIZE];
-volatile uint16_t rxHead = 0, rxTail = 0;
-volatile uint16_t txHead = 0, txTail = 0;
-volatile bool txBusy = false;
-
-extern "C" void USART1_IRQHandler(void)
-{
-	if(USART1->SR & (1<<5))
-	{
-		char receivedData = USART1->DR & 0xFF;
-
-		uint16_t nextHead = (rxHead + 1) % RX_BUFFER_SIZE;
-
-		if(nextHead != rxTail)
-		{
-			rxBuffer[rxHead] = receivedData;
-			rxHead = nextHead;
-		}
+usart_port* usart_objects[3] = {nullptr};
+
+/* addresses, not pointers, so the table is constant-initialized and safe
+   to use from constructors of other globals */
+static const usart_hw usart_table[3] = {
+	/* USART1: APB2, RX DMA1 ch5, TX ch4, PA9 / PA10 */
+	{ USART1_BASE, periphrales_bus::APB2, clock_uart_1,
+	  DMA1_Channel5_BASE, 16, DMA1_Channel4_BASE, 12,
+	  USART1_IRQn, DMA1_Channel5_IRQn, DMA1_Channel4_IRQn,
+	  GPIOA_BASE, clock_gpio_a, 9, 10 },
+	/* USART2: APB1, RX ch6, TX ch7, PA2 / PA3 */
+	{ USART2_BASE, periphrales_bus::APB1, clock_uart_2,
+	  DMA1_Channel6_BASE, 20, DMA1_Channel7_BASE, 24,
+	  USART2_IRQn, DMA1_Channel6_IRQn, DMA1_Channel7_IRQn,
+	  GPIOA_BASE, clock_gpio_a, 2, 3 },
+	/* USART3: APB1, RX ch3, TX ch2, PB10 / PB11 */
+	{ USART3_BASE, periphrales_bus::APB1, clock_uart_3,
+	  DMA1_Channel3_BASE, 8, DMA1_Channel2_BASE, 4,
+	  USART3_IRQn, DMA1_Channel3_IRQn, DMA1_Channel2_IRQn,
+	  GPIOB_BASE, clock_gpio_b, 10, 11 },
+};
+
+static uint8_t usart_index(UsartInstance instance) {
+	switch(instance) {
+		case USART2Instance: return 1;
+		case USART3Instance: return 2;
+		default:             return 0;
 	}
+}
+
+usart_port::usart_port(UsartInstance instance, volatile uint8_t* rx, uint16_t rx_size,
+                       volatile uint8_t* tx0, volatile uint8_t* tx1, uint16_t tx_size, uint32_t baud) :
+				hw(&usart_table[usart_index(instance)]),
+				regs(reinterpret_cast<USART_TypeDef*>(hw->regs)),
+				rx_dma(reinterpret_cast<DMA_Channel_TypeDef*>(hw->rx_dma)),
+				tx_dma(reinterpret_cast<DMA_Channel_TypeDef*>(hw->tx_dma)),
+				rx_buf(rx),
+				rx_mask(rx_size - 1),
+				rx_tail(0),
+				rx_seen(0),
+				tx_buf{tx0, tx1},
+				tx_size(tx_size),
+				tx_fill_index(0),
+				tx_fill_len(0),
+				tx_busy(false),
+				baud(BAUD),
+				frame_end_us(0),
+				overruns(0),
+				rx_dma_errors(0),
+				tx_dma_errors(0) {
+	usart_objects[usart_index(instance)] = this;
+
+	/* set bits, never assign: other drivers' clock enables live in the same registers */
+	this->enable_peripheral_clock(periphrales_bus::APB2, clock_afio);
+	this->enable_peripheral_clock(periphrales_bus::APB2, hw->gpio_clock);
+	this->enable_peripheral_clock(hw->bus, hw->clock);
+	this->enable_peripheral_clock(periphrales_bus::AHP, clock_dma_1);
+
+	this->configure_pin(hw->tx_pin, 0x0B);	/* AF push-pull, 50 MHz */
+	this->configure_pin(hw->rx_pin, 0x04);	/* floating input */
+
+	if(!this->set_baud(baud))
+		this->set_baud(BAUD);
+
+	/* received bytes go straight to the ring by DMA; the CPU only hears
+	   about line idle (IDLEIE) and half/full ring (DMA HT/TC) */
+	this->rx_dma_start();
+	this->regs->CR3 |= (1<<6) | (1<<7); // DMAR, DMAT
+
+	this->regs->CR1 = (1<<4);
+	this->regs->CR1 |= (1<<2) | (1<<3);
+	this->regs->CR1 |= (1<<13); // UE
+
+	NVIC_EnableIRQ(hw->tx_dma_irq);
+	NVIC_EnableIRQ(hw->rx_dma_irq);
+	NVIC_EnableIRQ(hw->usart_irq);
+}
+
+/* CRL/CRH read-modify-write, four bits per pin */
+void usart_port::configure_pin(uint8_t pin, uint32_t cnf_mode) {
+	GPIO_TypeDef* port = reinterpret_cast<GPIO_TypeDef*>(this->hw->gpio);
+	volatile uint32_t& cr = pin < 8 ? port->CRL : port->CRH;
+	uint32_t shift = (pin % 8) * 4;
+	cr = (cr & ~(0x0FUL << shift)) | (cnf_mode << shift);
+}
+
+uint32_t usart_port::pclk() {
+	return rcc::bus_clock(this->hw->bus);
+}
+
+/* BRR holds pclk/baud in 12.4 fixed point */
+uint32_t usart_port::brr_for(uint32_t baud) {
+	if(baud == 0)
+		return 0;
+	uint32_t clock = this->pclk();
+	uint32_t brr = (clock + baud / 2) / baud;
+	if(brr < 16 || brr > 0xFFFF)
+		return 0;
+	uint32_t actual = clock / brr;
+	uint32_t diff = actual > baud ? actual - baud : baud - actual;
+	if(diff * 1000ULL > static_cast<uint64_t>(baud) * BAUD_MAX_ERROR_PERMILLE)
+		return 0;
+	return brr;
+}
+
+bool usart_port::set_baud(uint32_t baud) {
+	uint32_t brr = this->brr_for(baud);
+	if(brr == 0)
+		return false;
+	this->regs->BRR = brr;
+	this->baud = baud;
+	return true;
+}
 
-	if(USART1->SR & (1<<7))
-	{
-		if(txHead != txTail)
-		{
-			USART1->DR = txBuffer[txTail];
-			txTail = (txTail + 1) % TX_BUFFER_SIZE;
-		}
-
-		else
-		{
-			USART1->CR1 &= ~(1<<7);
-			txBusy = false;
-		}
+uint32_t usart_port::get_baud() {
+	return this->baud;
+}
+
+uint32_t usart_port::byte_time_us() {
+	return (10UL * 1000000UL + this->baud / 2) / this->baud;
+}
+
+void usart_port::set_frame_size(FrameSize fsz) {
+	this->regs->CR1 |= (static_cast<uint32_t>(fsz) << 12);
+}
+
+uint32_t usart_port::last_frame_end_us() {
+	return this->frame_end_us;
+}
+
+uint32_t usart_port::rx_overrun_count() {
+	return this->overruns;
+}
+
+/* ---------------- RX ---------------- */
+
+/* where the RX DMA writes next; CNDTR counts down from the ring size */
+uint16_t usart_port::rx_write_index() {
+	return (this->rx_mask + 1 - this->rx_dma->CNDTR) & this->rx_mask;
+}
+
+bool usart_port::read_char(char* data) {
+	uint16_t tail = this->rx_tail;
+	uint16_t head = this->rx_write_index();
+	if(head == tail)
+		return false;
+	*data = static_cast<char>(this->rx_buf[tail]);
+	this->rx_tail = (tail + 1) & this->rx_mask;
+
+	/*
+	 * Stamp a delimiter when it is handed out, so the stamp always belongs
+	 * to the frame the caller is about to decode. Bytes already behind it
+	 * arrived later, so back those out; what is left can only be late,
+	 * never early, and a late t2 only lengthens the measured round trip.
+	 */
+	if(*data == 0) {
+		uint16_t behind = (head - tail - 1) & this->rx_mask;
+		this->frame_end_us = systime::now_us() - behind * this->byte_time_us();
 	}
+	return true;
+}
+
+bool usart_port::data_available() {
+	return this->rx_write_index() != this->rx_tail;
+}
+
+/*
+ * Peripheral to memory, 8 bit, circular over the ring, half and full
+ * transfer interrupts.
+ */
+void usart_port::rx_dma_start() {
+	this->rx_dma->CCR = 0;
+	DMA1->IFCR = (1UL << this->hw->rx_flags); // CGIFx
+	this->rx_dma->CPAR = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&this->regs->DR));
+	this->rx_dma->CMAR = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(this->rx_buf));
+	this->rx_dma->CNDTR = this->rx_mask + 1;
+	this->rx_seen = this->rx_tail = 0;
+	/* MINC | CIRC | priority high | TEIE | HTIE | TCIE | EN */
+	this->rx_dma->CCR = (1<<7) | (1<<5) | (2<<12) | (1<<3) | (1<<2) | (1<<1);
+	this->rx_dma->CCR |= (1<<0);
+}
+
+/* account for what the DMA wrote since the last RX interrupt */
+uint16_t usart_port::rx_advance() {
+	uint16_t pos = this->rx_write_index();
+	uint16_t written = (pos - this->rx_seen) & this->rx_mask;
+	uint16_t unread = (this->rx_seen - this->rx_tail) & this->rx_mask;
+	if(unread + written > this->rx_mask)
+		this->overruns++;
+	this->rx_seen = pos;
+	return pos;
+}
+
+void usart_port::rx_dma_handler() {
+	uint32_t isr = DMA1->ISR >> this->hw->rx_flags;
+	DMA1->IFCR = (1UL << this->hw->rx_flags); // HT, TC and TE together
+
+	/* a bus error disables the channel; start over rather than go deaf */
+	if(isr & (1<<3)) {
+		this->rx_dma_errors++;
+		this->rx_dma_start();
+		return;
+	}
+	this->rx_advance();
+}
+
+void usart_port::usart_handler() {
+	/* IDLE: one frame time of silence after a byte; SR then DR clears it */
+	if(this->regs->SR & (1<<4)) {
+		(void)this->regs->DR;
+		this->rx_advance();
+	}
+}
+
+/* ---------------- TX ---------------- */
+
+/*
+ * Memory to peripheral, 8 bit. Sends the fill buffer and makes the other
+ * one the fill buffer. Runs from submit() with this channel's interrupt
+ * masked, or from that interrupt.
+ */
+void usart_port::tx_dma_start() {
+	uint8_t index = this->tx_fill_index;
+	this->tx_dma->CCR = 0;
+	DMA1->IFCR = (1UL << this->hw->tx_flags);
+	this->tx_dma->CPAR = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&this->regs->DR));
+	this->tx_dma->CMAR = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(this->tx_buf[index]));
+	this->tx_dma->CNDTR = this->tx_fill_len;
+	this->tx_fill_index = index ^ 1;
+	this->tx_fill_len = 0;
+	this->tx_busy = true;
+	/* MINC | DIR (read memory) | priority medium | TEIE | TCIE | EN */
+	this->tx_dma->CCR = (1<<7) | (1<<4) | (1<<12) | (1<<3) | (1<<1);
+	this->tx_dma->CCR |= (1<<0);
+}
+
+bool usart_port::submit(ByteSpan bytes) {
+	if(bytes.size == 0)
+		return true;
+
+	/* only this channel's interrupt swaps buffers; masking it alone leaves
+	   the encoder EXTIs and RX running */
+	NVIC_DisableIRQ(this->hw->tx_dma_irq);
+	bool fits = this->tx_fill_len + bytes.size <= this->tx_size;
+	if(fits) {
+		volatile uint8_t* dst = this->tx_buf[this->tx_fill_index] + this->tx_fill_len;
+		for(uint16_t i = 0; i < bytes.size; i++)
+			dst[i] = bytes.data[i];
+		this->tx_fill_len += bytes.size;
+		if(!this->tx_busy)
+			this->tx_dma_start();
+	}
+	NVIC_EnableIRQ(this->hw->tx_dma_irq);
+	return fits;
+}
+
+bool usart_port::send_char(char data) {
+	uint8_t byte = static_cast<uint8_t>(data);
+	return this->submit(ByteSpan(&byte, 1));
+}
+
+bool usart_port::send_string(const char* str) {
+	size_t len = 0;
+	while(str[len])
+		len++;
+	return this->submit(ByteSpan(reinterpret_cast<const uint8_t*>(str), len));
+}
+
+void usart_port::tx_dma_handler() {
+	uint32_t isr = DMA1->ISR >> this->hw->tx_flags;
+	DMA1->IFCR = (1UL << this->hw->tx_flags); // TC and TE together
+
+	/* on a bus error the rest of that buffer is lost; the link layers
+	   above retransmit or resync on the next delimiter */
+	if(isr & (1<<3))
+		this->tx_dma_errors++;
+
+	this->tx_dma->CCR = 0;
+	if(this->tx_fill_len)
+		this->tx_dma_start();
+	else
+		this->tx_busy = false;
+}
+
+uint16_t usart_port::tx_free() {
+	return this->tx_size - this->tx_fill_len;
+}
+
+uint16_t usart_port::tx_queued() {
+	return (this->tx_busy ? this->tx_dma->CNDTR : 0) + this->tx_fill_len;
+}
+
+bool usart_port::is_transmission_complete() {
+	return !this->tx_busy && this->tx_fill_len == 0;
+}
+
+bool usart_port::tx_idle() {
+	return this->is_transmission_complete() && (this->regs->SR & (1<<6));
 }
@@ -10,15 +10,16 @@
 #define INC_UART_H_
 
 #include "../../lib/common.h"
+#include "../rcc/rcc.h"
 
 #define USART1_BASE_ADDR 	0x40013800
 #define USART2_BASE_ADDR 	0x40004400
 #define USART3_BASE_ADDR 	0x40004800
-#define FOSC       8000000
-#define BAUD 		115200
+#define BAUD 		115200		/* boot rate; robot_link may renegotiate it */
+#define BAUD_MAX_ERROR_PERMILLE 20	/* both ends' error adds up; 2% each is the limit */
 
-#define RX_BUFFER_SIZE 256
-#define TX_BUFFER_SIZE 256
+#define RX_BUFFER_SIZE 256		/* default ring, filled circularly by DMA */
+#define TX_BUFFER_SIZE 256		/* default size of each of the two TX DMA buffers */
 
 enum UsartInstance {
 	USART1Instance = USART1_BASE_ADDR,
@@ -31,116 +32,145 @@ enum FrameSize {
 	FrameSizeNine
 };
 
-extern volatile char rxBuffer[RX_BUFFER_SIZE];
-extern volatile char txBuffer[TX_BUFFER_SIZE];
-extern volatile uint16_t rxHead, rxTail;
-extern volatile uint16_t txHead, txTail;
-extern volatile bool txBusy;
+/* non-owning view of bytes to send (no std::span before C++20) */
+struct ByteSpan {
+	const uint8_t* data;
+	uint16_t size;
 
-class USART {
+	ByteSpan(const uint8_t* data, size_t size) : data(data), size(static_cast<uint16_t>(size)) {}
+	template <size_t N>
+	ByteSpan(const uint8_t (&array)[N]) : data(array), size(N) {}
+};
+
+/* what differs between USART1..3: clocks, DMA1 channels, IRQs, pins */
+struct usart_hw {
+	uint32_t regs;
+	periphrales_bus bus;
+	uint32_t clock;
+	uint32_t rx_dma;
+	uint8_t rx_flags;		/* channel's flag group in DMA1->ISR/IFCR */
+	uint32_t tx_dma;
+	uint8_t tx_flags;
+	IRQn_Type usart_irq;
+	IRQn_Type rx_dma_irq;
+	IRQn_Type tx_dma_irq;
+	uint32_t gpio;
+	uint32_t gpio_clock;
+	uint8_t tx_pin;
+	uint8_t rx_pin;
+};
+
+/*
+ * The part of a USART that does not depend on buffer sizes: registers,
+ * DMA, interrupt handlers. One copy of this code serves every port; the
+ * usart<> template below only adds the storage.
+ *
+ * RX: DMA circular into a power-of-two ring; readers take bytes up to the
+ * live DMA position, so no interrupt per byte. HT/TC/IDLE count overruns;
+ * read_char() timestamps frame ends.
+ * TX: DMA from two alternating buffers; submit() fills one while the other
+ * is sent, transfer-complete chains to the next.
+ */
+class usart_port : public rcc {
 public:
-	USART(UsartInstance usart) {
-		usartBase = usart;
-		if(usart == USART1Instance) {
-			Usart1Initialize();
-		}
-		else if(usart == USART2Instance) {
-
-		}
-	}
-
-	void Usart1Initialize() {
-		RCC->APB2ENR = (1<<0) | (1<<2) | (1<<14);
-
-		GPIOA->CRH = (0x0B<<4);
-		GPIOA->CRH |=(4<<8);
-
-		double usart_div = FOSC / (BAUD);
-		USART1->BRR = (uint32_t)usart_div;
-
-		USART1->CR1 = (1<<5) | (1<<7);
-
-		USART1->CR1 |= (1<<2) | (1<<3);
-		USART1->CR1 |= (1<<13); // UE
-
-		NVIC_EnableIRQ(USART1_IRQn);
-
-		rxHead = rxTail = 0;
-		txHead = txTail = 0;
-		txBusy = false;
-	}
-
-	void setFrameSize(FrameSize fsz) {
-		USART1->CR1 |= (static_cast<uint32_t>(fsz) << 12);
-	}
-
-	bool readChar(char* data) {
-		if(rxHead != rxTail) {
-			*data = rxBuffer[rxTail];
-			rxTail = (rxTail + 1) % RX_BUFFER_SIZE;
-			return true;
-		}
-		return false;
-	}
-
-	bool sendCharInterrupt(char data) {
-		uint16_t nextHead = (txHead + 1) % TX_BUFFER_SIZE;
-
-		if(nextHead != txTail) {
-			txBuffer[txHead] = data;
-			txHead = nextHead;
-
-			if(!txBusy) {
-				txBusy = true;
-				USART1->CR1 |= (1<<7);
-			}
-			return true;
-		}
-		return false;
-	}
-
-	bool sendStringInterrupt(const char* str) {
-		while(*str) {
-			if(!sendCharInterrupt(*str))
-				return false;
-			str++;
-		}
-		return true;
-	}
-
-	bool dataAvailable() {
-		return (rxHead != rxTail);
-	}
-
-	bool isTransmissionComplete() {
-		return !txBusy && (txHead == txTail);
-	}
-
-	char read() {
-		while(! (USART1->SR & (1<<5)));
-		return USART1->DR & 0x00FF;
-	}
-
-	void sendChar(char data) {
-		USART1->DR = data & 0xFF;
-		while(!(USART1->SR & (1<<7)));
-	}
-
-	void sendString(char *str) {
-		int i =0;
-		while(str[i] != '\0') {
-			sendChar(str[i++]);
-		}
-	}
-
-	void* operator new(size_t, UsartInstance usart) {
-		return reinterpret_cast<void*>(usart);
-	}
+	bool read_char(char* data);
+	bool data_available();
+
+	/*
+	 * Queue bytes without waiting. They go into the buffer not being sent,
+	 * all or nothing, so a frame is never split; false means they do not
+	 * fit until the current transfer ends.
+	 */
+	bool submit(ByteSpan bytes);
+	bool send_char(char data);
+	bool send_string(const char* str);
+
+	/* the most one submit() takes right now */
+	uint16_t tx_free();
+	/* bytes still to go out: the rest of the running transfer plus the next */
+	uint16_t tx_queued();
+	/* nothing queued and the last stop bit shifted out (TC) */
+	bool tx_idle();
+	bool is_transmission_complete();
+
+	/*
+	 * Change the line rate on the fly. Rates that land more than
+	 * BAUD_MAX_ERROR_PERMILLE off at this port's bus clock are refused.
+	 * Call only while the line is idle.
+	 */
+	bool set_baud(uint32_t baud);
+	uint32_t get_baud();
+	/* BRR value for a rate at this port's bus clock, 0 when it cannot be reached */
+	uint32_t brr_for(uint32_t baud);
+	/* the APB clock feeding this port, as rcc::bus_clock reports it */
+	uint32_t pclk();
+	/* 8N1: ten bit times per byte, rounded */
+	uint32_t byte_time_us();
+	void set_frame_size(FrameSize fsz);
+
+	/* systime read_char() returned the last 0x00 (frame_codec delimiter),
+	   less the bytes already received behind it */
+	uint32_t last_frame_end_us();
+	/* times the reader fell a whole ring behind the DMA */
+	uint32_t rx_overrun_count();
+
+	void usart_handler();
+	void rx_dma_handler();
+	void tx_dma_handler();
+
+protected:
+	usart_port(UsartInstance instance, volatile uint8_t* rx, uint16_t rx_size,
+	           volatile uint8_t* tx0, volatile uint8_t* tx1, uint16_t tx_size, uint32_t baud);
 
 private:
-	UsartInstance usartBase;
+	const usart_hw* hw;
+	USART_TypeDef* regs;
+	DMA_Channel_TypeDef* rx_dma;
+	DMA_Channel_TypeDef* tx_dma;
+
+	volatile uint8_t* rx_buf;
+	uint16_t rx_mask;
+	volatile uint16_t rx_tail;
+	volatile uint16_t rx_seen;		/* DMA position at the last RX interrupt */
+
+	volatile uint8_t* tx_buf[2];
+	uint16_t tx_size;
+	volatile uint8_t tx_fill_index;
+	volatile uint16_t tx_fill_len;
+	volatile bool tx_busy;
+
+	volatile uint32_t baud;
+	volatile uint32_t frame_end_us;
+	volatile uint32_t overruns;
+	volatile uint32_t rx_dma_errors;
+	volatile uint32_t tx_dma_errors;
+
+	uint16_t rx_write_index();
+	uint16_t rx_advance();
+	void rx_dma_start();
+	void tx_dma_start();
+	void configure_pin(uint8_t pin, uint32_t cnf_mode);
+};
+
+/*
+ * One USART with its own rings, e.g.
+ *   usart<USART1Instance> pi_link;
+ *   usart<USART2Instance, 64, 128> console;
+ * Sizes are powers of two so ring indices wrap with a mask.
+ */
+template <UsartInstance Instance, uint16_t RxSize = RX_BUFFER_SIZE, uint16_t TxSize = TX_BUFFER_SIZE>
+class usart : public usart_port {
+	static_assert(RxSize >= 16 && (RxSize & (RxSize - 1)) == 0, "RxSize must be a power of two");
+	static_assert(TxSize >= 16 && (TxSize & (TxSize - 1)) == 0, "TxSize must be a power of two");
+public:
+	explicit usart(uint32_t baud = BAUD) :
+			usart_port(Instance, rx_ring, RxSize, tx_buffers[0], tx_buffers[1], TxSize, baud) {}
+private:
+	volatile uint8_t rx_ring[RxSize];
+	volatile uint8_t tx_buffers[2][TxSize];
 };
 
-extern "C" void USART1_IRQHandler(void);
+/* USART1..3 -> [0]..[2], for the handlers in isr_bridge.cpp */
+extern usart_port* usart_objects[3];
 
 #endif /* INC_UART_H_ */
@@ -37,8 +37,14 @@ static struct serdev_device_driver serdev_echo_driver = {
 static size_t serdev_echo_recv(struct serdev_device *serdev,
                                const unsigned char *buffer,
                                size_t size) {
-    printk("serdev_echo - Received %zu bytes with \"%s\"\n", size, buffer);
-    return serdev_device_write_buf(serdev, buffer, size);
+    /* buffer is raw bytes, not a string; a printk per chunk also caps
+     * the echo rate, so only log the size and only when debugging */
+    int written;
+
+    pr_debug("serdev_echo - Received %zu bytes\n", size);
+    written = serdev_device_write_buf(serdev, buffer, size);
+    /* what was not taken stays with the tty layer and comes back */
+    return written < 0 ? 0 : written;
 }
 
 
@@ -0,0 +1,115 @@
+/**
+ * @file baud_negotiator.hpp
+ * @author Ziad Fathy
+ * @brief Pi end of the robot_protocol baud negotiation.
+ * @version 0.1
+ * @date 2025-09-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef BAUD_NEGOTIATOR_H_
+#define BAUD_NEGOTIATOR_H_
+
+/* --------- Includes --------- */
+#include "port_manager.hpp"
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/* --------- Types --------- */
+struct BaudNegotiatorConfig {
+    long     maxBaud;            // highest candidate tried
+    uint16_t trialMs;            // board reverts unless committed by then
+    uint32_t ackTimeoutMs;       // per propose / commit / echo
+    unsigned retries;            // proposes before giving up (x ackTimeout > link_silence_ms)
+    unsigned testFrames;         // link test echoes per candidate
+    unsigned testWindow;         // echoes in flight
+    double   maxTestErrorRatio;  // lost or corrupt test frames to accept a rate
+    uint32_t monitorMs;          // error rate window once settled
+    double   maxErrorRatio;      // settled error rate that steps the rate down
+    uint32_t keepaliveMs;        // echo interval above safe_baud
+};
+
+constexpr BaudNegotiatorConfig DEFAULT_BAUD_NEGOTIATOR_CONFIG = {
+    2000000, 2000, 500, 8, 100, 4, 0.01, 2000, 0.02, 1000
+};
+
+/* --------- Class --------- */
+/**
+ * @brief steps the link up from robot_protocol::safe_baud to the highest
+ *        candidate that passes a link test, and back down when it degrades.
+ *
+ * Per step: propose (old rate) -> ack -> both switch -> testFrames echoes of
+ * worst-case patterns (runs of COBS code bytes, 0xFF, 0x55, random) ->
+ * commit at the new rate. A failed test is not committed; the board reverts
+ * when its trial ends and the Pi follows. The first rate that fails caps the
+ * climb. Settled, every monitorMs window whose CRC error ratio exceeds
+ * maxErrorRatio drops one candidate, and a silent link falls back to
+ * safe_baud on both ends.
+ *
+ * While busy() the link may be between rates: the owner must hold other
+ * traffic.
+ */
+class BaudNegotiator {
+    public:
+        using SendFn    = std::function<bool(const uint8_t *msg, size_t len)>;
+        using SetBaudFn = std::function<bool(long baud)>;
+
+        BaudNegotiator(SendFn send, SetBaudFn setBaud,
+                       const BaudNegotiatorConfig &cfg = DEFAULT_BAUD_NEGOTIATOR_CONFIG);
+        void start(uint64_t nowNs);
+        void stop();
+        bool onFrame(const uint8_t *msg, size_t len, uint64_t nowNs);
+        void poll(uint64_t nowNs, const PortStats &stats);
+        bool busy() const;
+        long baud() const;
+        const char *stateName() const;
+    private:
+        enum class State { Disabled, Proposing, Testing, Committing, Reverting, Settled };
+
+        void propose(size_t index, uint64_t nowNs);
+        void proposeNext(uint64_t nowNs);
+        void beginTest(uint64_t nowNs);
+        void pumpTest(uint64_t nowNs);
+        void finishTest(uint64_t nowNs);
+        void settle();
+        void fallBack(uint64_t nowNs);
+        bool switchTo(size_t index);
+
+        SendFn send;
+        SetBaudFn setBaud;
+        BaudNegotiatorConfig cfg;
+        std::vector<long> candidates;
+        std::vector<bool> rejected;
+
+        State state;
+        size_t current;              // index the link is committed at
+        size_t target;               // index being tried
+        size_t ceiling;              // highest index still worth trying
+        bool stepUp;
+        unsigned attempts;
+        uint64_t deadlineNs;
+        uint64_t trialEndNs;
+        uint64_t lastRxNs;
+
+        /* link test */
+        uint16_t testBase;
+        unsigned sent;
+        unsigned echoed;
+        unsigned corrupt;
+        bool errorBaseValid;
+        uint64_t errorBase;
+        uint64_t lastErrors;
+        uint64_t lastProgressNs;
+
+        /* settled monitoring */
+        uint64_t windowStartNs;
+        uint64_t windowFrames;
+        uint64_t windowErrors;
+        uint64_t nextKeepaliveNs;
+        uint16_t keepaliveSeq;
+};
+
+#endif
@@ -0,0 +1,415 @@
+/**
+ * @file binlog.hpp
+ * @author Ziad Fathy
+ * @brief binary logging: the calling thread stores a format-site id, a
+ *        tick count and the raw arguments; formatting happens offline
+ *        (tools/binlog_decode).
+ * @version 0.1
+ * @date 2025-09-19
+ *
+ * @copyright Copyright (c) 2025
+ *
+ *   BinLog::open("/var/log/robot/robotd.blog", BINLOG_LEVEL_DEBUG);
+ *   BINLOG_DEBUG("board rx type %u len %zu", payload[0], len);
+ *   BinLog::close();
+ *
+ * Each thread writes into its own single-producer ring, so a log call is a
+ * few stores and one release, no lock, no syscall and no formatting. One
+ * background thread drains the rings into the file. A full ring drops the
+ * entry (and counts it) rather than stall the caller.
+ *
+ * Format strings are checked by the compiler like printf. Arguments may be
+ * integers, floating point, C strings (copied, at most BINLOG_MAX_STRING
+ * bytes) and pointers; '*' widths are supported, %n is not.
+ */
+
+#ifndef BINLOG_H_
+#define BINLOG_H_
+
+/* --------- Includes --------- */
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+/* --------- Layout --------- */
+/*
+ * file   : BinLogFileHeader | records
+ * record : BinLogRecordHeader | body of length bytes
+ *   SITE    : BinLogSiteRecord | file | format | one type code per argument
+ *   CLOCK   : BinLogClockRecord, ties ticks to CLOCK_MONOTONIC / REALTIME
+ *   ENTRIES : BinLogEntriesRecord | packed entries, as drained from one thread
+ *   DROPPED : BinLogDroppedRecord, running count for one thread
+ * entry  : in a thread ring, BinLogEntry | raw arguments, padded to 8 bytes;
+ *          in the file, varint site | zigzag varint ticks since the previous
+ *          entry (or baseTicks) | packed arguments
+ *
+ * The background thread does the packing: integers and pointers become
+ * varints (zigzag for signed types), strings a varint length and the bytes,
+ * doubles stay 8 raw bytes.
+ *
+ * A site record always precedes the first entry that uses it. Entries of
+ * one thread are in order; across threads only the ticks order them.
+ */
+constexpr uint32_t BINLOG_MAGIC        = 0x474C4E42;     // "BNLG"
+constexpr uint32_t BINLOG_VERSION      = 1;
+constexpr size_t   BINLOG_MAX_STRING   = 512;
+constexpr size_t   BINLOG_MAX_ENTRY    = 4096;
+constexpr uint32_t BINLOG_BUFFER_SIZE  = 1u << 18;       // per thread, power of two
+
+enum BinLogLevel : uint8_t {
+    BINLOG_LEVEL_DEBUG = 0,
+    BINLOG_LEVEL_INFO,
+    BINLOG_LEVEL_WARN,
+    BINLOG_LEVEL_ERROR,
+    BINLOG_LEVEL_OFF
+};
+
+enum BinLogRecordType : uint32_t {
+    BINLOG_RECORD_SITE    = 1,
+    BINLOG_RECORD_CLOCK   = 2,
+    BINLOG_RECORD_ENTRIES = 3,
+    BINLOG_RECORD_DROPPED = 4,
+};
+
+/* argument type codes */
+constexpr char BINLOG_ARG_I32     = 'i';     // int and anything narrower
+constexpr char BINLOG_ARG_U32     = 'u';
+constexpr char BINLOG_ARG_I64     = 'I';
+constexpr char BINLOG_ARG_U64     = 'U';
+constexpr char BINLOG_ARG_DOUBLE  = 'd';
+constexpr char BINLOG_ARG_STRING  = 's';     // ring: uint16_t length | bytes
+constexpr char BINLOG_ARG_POINTER = 'p';
+
+struct BinLogFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t ticksPerSecond;       // 0 = derive it from the clock records
+    uint64_t createdRealtimeNs;
+    uint64_t createdMonotonicNs;
+};
+
+struct BinLogRecordHeader {
+    uint32_t type;
+    uint32_t length;
+};
+
+struct BinLogSiteRecord {
+    uint32_t id;
+    uint32_t line;
+    uint8_t  level;
+    uint8_t  argCount;
+    uint16_t fileLength;
+    uint16_t formatLength;
+    uint16_t reserved;
+};
+
+struct BinLogClockRecord {
+    uint64_t ticks;
+    uint64_t monotonicNs;
+    uint64_t realtimeNs;
+};
+
+struct BinLogEntriesRecord {
+    uint32_t threadId;
+    uint32_t count;
+    uint64_t baseTicks;            // the first entry's delta is from this
+};
+
+struct BinLogDroppedRecord {
+    uint32_t threadId;
+    uint32_t reserved;
+    uint64_t count;
+};
+
+/* size comes first: in a thread ring, size 0 marks padding up to the end */
+struct BinLogEntry {
+    uint16_t size;                 // header + arguments + padding
+    uint16_t reserved;
+    uint32_t site;
+    uint64_t ticks;
+};
+
+static_assert(sizeof(BinLogEntry) == 16, "entry header layout");
+static_assert(sizeof(BinLogSiteRecord) == 16, "site record layout");
+
+struct BinLogStats {
+    uint64_t entries;
+    uint64_t bytes;
+    uint64_t dropped;
+    uint32_t threads;
+    uint32_t sites;
+};
+
+/* --------- Packing --------- */
+static inline uint8_t *binlog_put_varint(uint8_t *p, uint64_t v) {
+    while(v >= 0x80) {
+        *p++ = static_cast<uint8_t>(v) | 0x80;
+        v >>= 7;
+    }
+    *p++ = static_cast<uint8_t>(v);
+    return p;
+}
+
+/* @return past the varint, or nullptr if it runs past end */
+static inline const uint8_t *binlog_get_varint(const uint8_t *p, const uint8_t *end, uint64_t &v) {
+    v = 0;
+    for(unsigned shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t b = *p++;
+        v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if(!(b & 0x80))
+            return p;
+    }
+    return nullptr;
+}
+
+static inline uint64_t binlog_zigzag(int64_t v) {
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+static inline int64_t binlog_unzigzag(uint64_t v) {
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+/* --------- Classes --------- */
+/**
+ * @brief one log statement; a constant-initialised static at the call site,
+ *        registered (given an id) the first time it logs.
+ *
+ */
+struct BinLogSite {
+    const char *file;
+    const char *format;
+    uint32_t line;
+    uint8_t level;
+    std::atomic<uint32_t> id;
+
+    constexpr BinLogSite(uint8_t level, const char *file, uint32_t line, const char *format) :
+                file(file), format(format), line(line), level(level), id(0) {}
+};
+
+/**
+ * @brief per-thread staging ring: the owning thread reserves and commits,
+ *        the background thread drains.
+ *
+ */
+class BinLogBuffer {
+    public:
+        explicit BinLogBuffer(uint32_t threadId);
+
+        /* producer side, owning thread only */
+        inline uint8_t *reserve(size_t size);
+        inline void commit(size_t size);
+        inline void drop();
+
+        /* consumer side, background thread only */
+        size_t drain(std::string &out);
+        uint64_t droppedCount() const;
+        uint32_t threadId() const;
+        bool empty() const;
+
+        std::atomic<bool> retired;     // owning thread has exited
+        uint64_t reportedDropped;      // consumer: last count written to the file
+    private:
+        alignas(64) std::atomic<uint64_t> head;     // bytes committed
+        uint64_t pendingHead;                       // producer: start of the reserved entry
+        uint64_t cachedTail;                        // producer: last tail seen
+        std::atomic<uint64_t> dropped;
+        alignas(64) std::atomic<uint64_t> tail;     // bytes drained
+        uint32_t thread;
+        alignas(64) uint8_t storage[BINLOG_BUFFER_SIZE];
+};
+
+class BinLog {
+    public:
+        static void open(const std::string &path, BinLogLevel level = BINLOG_LEVEL_INFO);
+        static void close();
+        static void setLevel(BinLogLevel level);
+        static BinLogStats stats();
+
+        static inline bool enabled(uint8_t level) {
+            return level >= threshold.load(std::memory_order_relaxed);
+        }
+
+        static inline uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+            return __rdtsc();
+#elif defined(__aarch64__)
+            uint64_t v;
+            asm volatile("mrs %0, cntvct_el0" : "=r"(v));
+            return v;
+#else
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+        }
+
+        template<typename... Args>
+        static void write(BinLogSite &site, const Args &... args);
+
+    private:
+        template<typename T>
+        static constexpr char argType();
+        template<typename T>
+        static inline size_t argSize(const T &v);
+        template<typename T>
+        static inline void putArg(uint8_t *&p, const T &v);
+
+        static uint32_t registerSite(BinLogSite &site, const char *argTypes);
+        static BinLogBuffer *attachThread();
+
+        static inline std::atomic<uint8_t> threshold{BINLOG_LEVEL_OFF};
+        static inline thread_local BinLogBuffer *local = nullptr;
+};
+
+/* --------- Inline --------- */
+inline uint8_t *BinLogBuffer::reserve(size_t size) {
+    uint64_t h = this->head.load(std::memory_order_relaxed);
+    size_t offset = h & (BINLOG_BUFFER_SIZE - 1);
+    size_t pad = offset + size > BINLOG_BUFFER_SIZE ? BINLOG_BUFFER_SIZE - offset : 0;
+    if(h + pad + size - this->cachedTail > BINLOG_BUFFER_SIZE) {
+        this->cachedTail = this->tail.load(std::memory_order_acquire);
+        if(h + pad + size - this->cachedTail > BINLOG_BUFFER_SIZE)
+            return nullptr;
+    }
+    if(pad > 0) {
+        uint16_t marker = 0;
+        memcpy(this->storage + offset, &marker, sizeof(marker));
+        h += pad;
+    }
+    this->pendingHead = h;
+    return this->storage + (h & (BINLOG_BUFFER_SIZE - 1));
+}
+
+inline void BinLogBuffer::commit(size_t size) {
+    this->head.store(this->pendingHead + size, std::memory_order_release);
+}
+
+inline void BinLogBuffer::drop() {
+    this->dropped.store(this->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+template<typename T>
+constexpr char BinLog::argType() {
+    using D = std::decay_t<T>;
+    static_assert(std::is_arithmetic<D>::value || std::is_pointer<D>::value || std::is_enum<D>::value,
+                  "BINLOG arguments must be numbers, C strings or pointers");
+    if constexpr(std::is_same<D, char *>::value || std::is_same<D, const char *>::value)
+        return BINLOG_ARG_STRING;
+    else if constexpr(std::is_pointer<D>::value)
+        return BINLOG_ARG_POINTER;
+    else if constexpr(std::is_floating_point<D>::value)
+        return BINLOG_ARG_DOUBLE;
+    else if constexpr(sizeof(D) > 4)
+        return std::is_signed<D>::value ? BINLOG_ARG_I64 : BINLOG_ARG_U64;
+    else
+        return std::is_signed<D>::value || sizeof(D) < 4 ? BINLOG_ARG_I32 : BINLOG_ARG_U32;
+}
+
+template<typename T>
+inline size_t BinLog::argSize(const T &v) {
+    constexpr char type = argType<T>();
+    if constexpr(type == BINLOG_ARG_STRING) {
+        const char *s = v;
+        return sizeof(uint16_t) + (s != nullptr ? strnlen(s, BINLOG_MAX_STRING) : 0);
+    }
+    else if constexpr(type == BINLOG_ARG_I32 || type == BINLOG_ARG_U32)
+        return 4;
+    else
+        return 8;
+}
+
+template<typename T>
+inline void BinLog::putArg(uint8_t *&p, const T &v) {
+    constexpr char type = argType<T>();
+    if constexpr(type == BINLOG_ARG_STRING) {
+        const char *s = v;
+        uint16_t n = s != nullptr ? static_cast<uint16_t>(strnlen(s, BINLOG_MAX_STRING)) : 0;
+        memcpy(p, &n, sizeof(n));
+        if(n > 0)
+            memcpy(p + sizeof(n), s, n);
+        p += sizeof(n) + n;
+    } else if constexpr(type == BINLOG_ARG_POINTER) {
+        uint64_t x = reinterpret_cast<uintptr_t>(v);
+        memcpy(p, &x, 8);
+        p += 8;
+    } else if constexpr(type == BINLOG_ARG_DOUBLE) {
+        double x = v;
+        memcpy(p, &x, 8);
+        p += 8;
+    } else if constexpr(type == BINLOG_ARG_I32 || type == BINLOG_ARG_U32) {
+        uint32_t x = static_cast<uint32_t>(v);
+        memcpy(p, &x, 4);
+        p += 4;
+    } else {
+        uint64_t x = static_cast<uint64_t>(v);
+        memcpy(p, &x, 8);
+        p += 8;
+    }
+}
+
+/**
+ * @brief record one entry for site; called through the BINLOG_* macros,
+ *        which have already checked the level.
+ *
+ */
+template<typename... Args>
+void BinLog::write(BinLogSite &site, const Args &... args) {
+    static constexpr char types[] = { argType<Args>()..., '\0' };
+    uint32_t id = site.id.load(std::memory_order_relaxed);
+    if(id == 0)
+        id = registerSite(site, types);
+
+    size_t size = (sizeof(BinLogEntry) + (argSize(args) + ... + 0) + 7) & ~static_cast<size_t>(7);
+    BinLogBuffer *buf = local != nullptr ? local : attachThread();
+    if(buf == nullptr)
+        return;
+    if(size > BINLOG_MAX_ENTRY) {
+        buf->drop();
+        return;
+    }
+    uint8_t *p = buf->reserve(size);
+    if(p == nullptr) {
+        buf->drop();
+        return;
+    }
+    BinLogEntry e;
+    e.size = static_cast<uint16_t>(size);
+    e.reserved = 0;
+    e.site = id;
+    e.ticks = ticks();
+    memcpy(p, &e, sizeof(e));
+    uint8_t *a = p + sizeof(e);
+    (putArg(a, args), ...);
+    (void)a;
+    buf->commit(size);
+}
+
+/* compile-time printf checking only, never called */
+static inline void binlog_check_format(const char *, ...) __attribute__((format(printf, 1, 2)));
+static inline void binlog_check_format(const char *, ...) {}
+
+#define BINLOG(level, format, ...)                                                          \
+    do {                                                                                    \
+        if(BinLog::enabled(level)) {                                                        \
+            static BinLogSite binlogSite_(level, __FILE__, __LINE__, format);               \
+            if(false)                                                                       \
+                binlog_check_format(format, ##__VA_ARGS__);                                 \
+            BinLog::write(binlogSite_, ##__VA_ARGS__);                                      \
+        }                                                                                   \
+    } while(0)
+
+#define BINLOG_DEBUG(...) BINLOG(BINLOG_LEVEL_DEBUG, __VA_ARGS__)
+#define BINLOG_INFO(...)  BINLOG(BINLOG_LEVEL_INFO, __VA_ARGS__)
+#define BINLOG_WARN(...)  BINLOG(BINLOG_LEVEL_WARN, __VA_ARGS__)
+#define BINLOG_ERROR(...) BINLOG(BINLOG_LEVEL_ERROR, __VA_ARGS__)
+
+#endif
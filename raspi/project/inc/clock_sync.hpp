@@ -0,0 +1,94 @@
+/**
+ * @file clock_sync.hpp
+ * @author Ziad Fathy
+ * @brief maps board (systime) microseconds onto the Pi's CLOCK_MONOTONIC.
+ * @version 0.1
+ * @date 2025-09-15
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef CLOCK_SYNC_H_
+#define CLOCK_SYNC_H_
+
+/* --------- Includes --------- */
+#include <cstddef>
+#include <cstdint>
+
+/* --------- Types --------- */
+struct ClockSyncStats {
+    uint64_t requests;
+    uint64_t replies;
+    uint64_t timeouts;       // replies that never came (or came > 1 s late)
+    uint64_t resets;         // board clock went backwards (reboot)
+    int64_t  lastDelayNs;    // round trip minus board processing time
+    int64_t  minDelayNs;     // best round trip in the window
+};
+
+/* --------- Class --------- */
+/**
+ * @brief NTP-style exchange (robot_protocol cmd_time_sync) plus a filter.
+ *
+ * Each exchange gives t1 (Pi send), t2 (board rx), t3 (board tx), t4 (Pi
+ * rx). Round trips inflated by queueing are useless, so a refit keeps only
+ * the quickest quarter of the last WINDOW exchanges and least-squares fits
+ * host = a + b * mcu through their midpoints: a is the offset, b - 1 the
+ * drift. errorBoundNs() is half the best round trip (worst-case path
+ * asymmetry) plus the fit residual.
+ *
+ * The caller owns the timing: send makeRequest() as close to the wire as
+ * possible, feed replies to onReply() as soon as they are decoded, and ask
+ * again every pollIntervalMs().
+ */
+class ClockSync {
+    public:
+        static constexpr size_t WINDOW = 64;
+
+        ClockSync();
+        size_t makeRequest(uint8_t *out, uint64_t nowNs);
+        bool onReply(const uint8_t *msg, size_t len, uint64_t nowNs);
+        void reset();
+        bool synced() const;
+        uint64_t toMonotonicNs(uint32_t mcuUs) const;
+        int64_t offsetNs() const;
+        double driftPpm() const;
+        uint64_t errorBoundNs() const;
+        uint32_t pollIntervalMs() const;
+        ClockSyncStats stats() const;
+        static uint64_t monotonicNs();
+    private:
+        struct Pending {
+            uint32_t token;
+            uint64_t t1Ns;
+        };
+
+        struct Sample {
+            double mcuMidUs;        // unwrapped board time at the exchange midpoint
+            double hostMidNs;
+            int64_t delayNs;
+        };
+
+        uint64_t unwrap(uint32_t mcuUs) const;
+        void refit();
+
+        static constexpr size_t MAX_PENDING = 8;
+        Pending pending[MAX_PENDING];
+        uint32_t nextToken;
+
+        Sample window[WINDOW];
+        size_t count;
+        size_t next;
+
+        uint64_t lastMcuUs;         // 64-bit extension of the board clock
+        bool haveMcu;
+
+        bool valid;
+        double refMcuUs;
+        double refHostNs;
+        double slope;               // host ns per board ns
+        double residualNs;
+        ClockSyncStats counters;
+};
+
+#endif
@@ -0,0 +1,127 @@
+/**
+ * @file periodic_executor.hpp
+ * @author Ziad Fathy
+ * @brief fixed-rate loop on a timerfd: absolute deadlines, optional
+ *        SCHED_FIFO / CPU pinning, jitter, overrun and per-stage timing.
+ * @version 0.1
+ * @date 2025-09-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef PERIODIC_EXECUTOR_H_
+#define PERIODIC_EXECUTOR_H_
+
+/* --------- Includes --------- */
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+/* --------- Types --------- */
+struct PeriodicExecutorConfig {
+    uint32_t rateHz;             // ticks per second, 1 .. 10000
+    int      priority;           // SCHED_FIFO priority 1..99, 0 = stay SCHED_OTHER
+    int      cpu;                // pin the loop thread to this CPU, -1 = any
+    bool     lockMemory;         // mlockall() when running SCHED_FIFO
+};
+
+constexpr PeriodicExecutorConfig DEFAULT_PERIODIC_EXECUTOR_CONFIG = {
+    100, 0, -1, true
+};
+
+/* what a stage knows about the tick it runs in */
+struct TickInfo {
+    uint64_t index;              // ticks since start, counting missed ones
+    uint64_t deadlineNs;         // CLOCK_MONOTONIC release time of this tick
+    uint64_t wakeNs;             // when the loop actually woke
+    uint64_t periodNs;
+    uint64_t missed;             // periods skipped right before this tick
+};
+
+struct PeriodicExecutorStats {
+    uint64_t ticks;              // ticks run
+    uint64_t missed;             // periods skipped because a tick ran long
+    uint64_t overruns;           // ticks that finished after the next deadline
+    uint64_t maxJitterNs;        // worst wake-up latency
+    uint64_t maxTickNs;          // worst time from deadline to end of the last stage
+};
+
+/**
+ * @brief log-linear latency histogram: 8 sub-buckets per power of two, so
+ *        any percentile is within 12.5 %. No allocation when recording.
+ *
+ */
+class LatencyHistogram {
+    public:
+        static constexpr unsigned SUB_BITS = 3;
+        static constexpr unsigned BUCKETS = (64 - SUB_BITS + 1) << SUB_BITS;
+
+        LatencyHistogram();
+        void record(uint64_t ns);
+        void reset();
+        uint64_t count() const;
+        uint64_t min() const;
+        uint64_t max() const;
+        double mean() const;
+        uint64_t percentile(double p) const;
+    private:
+        static unsigned bucketOf(uint64_t ns);
+        static uint64_t bucketTop(unsigned bucket);
+
+        uint64_t counts[BUCKETS];
+        uint64_t total;
+        uint64_t sumNs;
+        uint64_t minNs;
+        uint64_t maxNs;
+};
+
+/* --------- Class --------- */
+/**
+ * @brief runs its stages in order once per period.
+ *
+ * The timerfd is armed with an absolute first deadline and an interval, so
+ * the kernel keeps the grid: a late tick does not push later ones back. If
+ * a tick runs past one or more whole periods those are skipped, not run
+ * back to back, and counted as missed; the next tick starts on the grid.
+ *
+ * run() is meant for the thread that owns the loop; stop() may be called
+ * from anywhere, a signal handler included.
+ */
+class PeriodicExecutor {
+    public:
+        using StageFn = std::function<void(const TickInfo &tick)>;
+
+        explicit PeriodicExecutor(const PeriodicExecutorConfig &cfg = DEFAULT_PERIODIC_EXECUTOR_CONFIG);
+        void addStage(const std::string &name, StageFn fn);
+        void run(uint64_t maxTicks = 0);
+        void stop();
+        uint64_t periodNs() const;
+        PeriodicExecutorStats stats() const;
+        const LatencyHistogram &jitter() const;
+        const LatencyHistogram &stageTime(size_t stage) const;
+        void printReport(FILE *out) const;
+        ~PeriodicExecutor();
+    private:
+        struct Stage {
+            std::string name;
+            StageFn fn;
+            LatencyHistogram time;
+        };
+
+        void applySchedulingPolicy();
+
+        PeriodicExecutorConfig cfg;
+        uint64_t period;
+        int timerFd;
+        std::vector<Stage> stages;
+        std::atomic<bool> stopRequested;
+        PeriodicExecutorStats counters;
+        LatencyHistogram wakeJitter;
+        LatencyHistogram tickTime;
+};
+
+#endif
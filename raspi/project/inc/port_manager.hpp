@@ -0,0 +1,127 @@
+/**
+ * @file port_manager.hpp
+ * @author Ziad Fathy
+ * @brief several framed UART links served from one epoll loop.
+ * @version 0.1
+ * @date 2025-09-12
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef PORT_MANAGER_H_
+#define PORT_MANAGER_H_
+
+/* --------- Includes --------- */
+#include "transport.hpp"
+#include "usart.hpp"
+#include "frame_codec.h"
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+/* --------- Types --------- */
+struct PortManagerConfig {
+    size_t   rxQuantum;      // bytes read from one port per turn
+    size_t   txQuantum;      // bytes written to one port per turn
+    size_t   txQueueLimit;   // queued bytes per port before send() refuses
+    uint32_t minBackoffMs;   // first reconnect delay
+    uint32_t maxBackoffMs;   // reconnect delay ceiling
+    uint32_t connectTimeoutMs;   // in-flight TCP connect before it counts as a failure
+};
+
+constexpr PortManagerConfig DEFAULT_PORT_MANAGER_CONFIG = {1024, 1024, 16384, 100, 5000, 3000};
+
+struct PortStats {
+    bool     connected;
+    uint64_t bytesRx;
+    uint64_t bytesTx;
+    uint64_t framesRx;
+    uint64_t framesTx;
+    uint64_t crcErrors;
+    uint64_t malformed;      // bad COBS or oversize frames
+    uint64_t rxTruncated;    // datagrams too long for the read buffer, dropped by the backend
+    uint64_t txDropped;      // refused by send() or flushed on disconnect
+    uint64_t reconnects;     // successful opens after the first
+    uint64_t connectFailures;
+    size_t   txQueuedBytes;
+    uint32_t backoffMs;      // current reconnect delay
+};
+
+/* --------- Class --------- */
+/**
+ * @brief owns N links (ttys, ptys, /dev/rpi4_uart*, sockets, CAN) and moves frame_codec
+ *        frames in and out of all of them from one thread.
+ *
+ * Fairness: every ready port gets at most rxQuantum/txQuantum bytes per
+ * turn; anything left over keeps the fd level-triggered ready and epoll puts
+ * it at the back of its ready list, so a chatty board cannot starve the
+ * others. A port that errors or hangs up is closed, its queued frames are
+ * dropped (stale motor commands must not fire after a reconnect) and it is
+ * reopened with exponential backoff plus jitter. Socket connects run
+ * non-blocking inside the loop, so a dead TCP peer never stalls the others.
+ */
+class UARTPortManager {
+    public:
+        using PortId  = size_t;
+        using FrameFn = std::function<void(PortId port, const uint8_t *payload, size_t len)>;
+        using StateFn = std::function<void(PortId port, bool connected)>;
+
+        static constexpr size_t MAX_FRAME = 512;
+
+        UARTPortManager(FrameFn onFrame, StateFn onState = nullptr,
+                        const PortManagerConfig &cfg = DEFAULT_PORT_MANAGER_CONFIG);
+        PortId addPort(const std::string &uri);
+        PortId addPort(const std::string &device, speed_t baud);
+        PortId addPort(std::unique_ptr<Transport> link);
+        bool send(PortId port, const uint8_t *payload, size_t len);
+        size_t broadcast(const uint8_t *payload, size_t len);
+        void run(int maxWaitMs);
+        int getFd() const;
+        size_t portCount() const;
+        const std::string &device(PortId port) const;
+        PortStats stats(PortId port) const;
+        bool setBaud(PortId port, long baud);
+        ~UARTPortManager();
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Port {
+            explicit Port(std::unique_ptr<Transport> link);
+
+            std::unique_ptr<Transport> link;
+            std::string device;
+            bool connected;
+            bool connecting;                 // startOpen() pending, waiting for EPOLLOUT
+            bool everConnected;
+            bool writeArmed;
+            frame_codec::frame_decoder<MAX_FRAME> decoder;
+            std::deque<std::string> txFrames;
+            size_t txOffset;                 // sent bytes of txFrames.front()
+            unsigned failures;               // consecutive, drives the backoff
+            Clock::time_point retryAt;       // or the connect deadline while connecting
+            PortStats counters;
+        };
+
+        void connect(PortId id);
+        void finishConnect(PortId id);
+        void abortConnect(PortId id);
+        void markConnected(PortId id);
+        void disconnect(PortId id);
+        void scheduleRetry(Port &port);
+        void serviceRead(PortId id);
+        void serviceWrite(PortId id);
+        void updateInterest(PortId id);
+
+        FrameFn onFrame;
+        StateFn onState;
+        PortManagerConfig cfg;
+        int epollFd;
+        std::vector<std::unique_ptr<Port>> ports;
+        std::minstd_rand jitter;
+};
+
+#endif
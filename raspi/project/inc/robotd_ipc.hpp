@@ -0,0 +1,65 @@
+/**
+ * @file robotd_ipc.hpp
+ * @author Ziad Fathy
+ * @brief local client API of robotd (the daemon that owns the serial port).
+ * @version 0.1
+ * @date 2025-09-14
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef ROBOTD_IPC_H_
+#define ROBOTD_IPC_H_
+
+/* --------- Includes --------- */
+#include "telemetry_ring.hpp"
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+/* --------- Protocol --------- */
+/*
+ * One SOCK_SEQPACKET message per request / reply, byte 0 is the op:
+ *
+ *   ATTACH   -> ATTACH {status, slotCount, mapSize} + SCM_RIGHTS ring memfd
+ *   COMMAND  robot_protocol message  -> RESULT {status}
+ *   EVENT    robotd -> every client: non-telemetry board messages (pong, ...)
+ *
+ * Telemetry never goes through the socket; readers map the ring.
+ */
+constexpr const char *ROBOTD_DEFAULT_SOCKET = "/run/robotd.sock";
+constexpr size_t ROBOTD_MAX_MESSAGE = 512;
+
+enum RobotdOp : uint8_t {
+    ROBOTD_ATTACH  = 1,
+    ROBOTD_COMMAND = 2,
+    ROBOTD_RESULT  = 3,
+    ROBOTD_EVENT   = 4
+};
+
+enum RobotdStatus : uint8_t {
+    ROBOTD_OK         = 0,
+    ROBOTD_PORT_DOWN  = 1,
+    ROBOTD_QUEUE_FULL = 2,
+    ROBOTD_BAD_REQUEST = 3
+};
+
+/* --------- Class --------- */
+class RobotdClient {
+    public:
+        explicit RobotdClient(const std::string &socketPath = ROBOTD_DEFAULT_SOCKET);
+        std::unique_ptr<TelemetryRingReader> attach();
+        RobotdStatus command(const uint8_t *msg, size_t len);
+        bool nextEvent(std::vector<uint8_t> &msg, int timeoutMs);
+        int getFd() const;
+        ~RobotdClient();
+    private:
+        ssize_t receive(uint8_t *buf, size_t len, int *passedFd, int timeoutMs);
+        int fd;
+        std::deque<std::vector<uint8_t>> events;
+};
+
+#endif
@@ -0,0 +1,115 @@
+/**
+ * @file socket_transport.hpp
+ * @author Ziad Fathy
+ * @brief TCP, Unix, UDP and SocketCAN backends of the Transport interface.
+ * @version 0.1
+ * @date 2025-09-13
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef SOCKET_TRANSPORT_H_
+#define SOCKET_TRANSPORT_H_
+
+/* --------- Includes --------- */
+#include "transport.hpp"
+#include <sys/socket.h>
+#include <vector>
+
+/* --------- Types --------- */
+/* one getaddrinfo() result, kept so reconnects never touch the resolver */
+struct InetAddress {
+    int family;
+    int type;
+    int protocol;
+    socklen_t len;
+    struct sockaddr_storage addr;
+};
+
+/* --------- Classes --------- */
+/**
+ * @brief common fd handling; stream sockets use it as is (writev-style
+ *        sendmsg, recv with EOF reported as an error).
+ *
+ */
+class SocketTransport : public Transport {
+    public:
+        void closePort() override;
+        int getFd() const override;
+        size_t readInto(uint8_t *buf, size_t len) override;
+        ssize_t writeVector(const struct iovec *iov, int iovcnt) override;
+        ~SocketTransport() override;
+    protected:
+        SocketTransport();
+        int fd;
+};
+
+/**
+ * @brief TCP peer, resolved once at construction; startOpen() connects
+ *        without blocking and moves on to the next address after a failure.
+ *
+ */
+class TcpTransport : public SocketTransport {
+    public:
+        TcpTransport(const std::string &host, const std::string &port);
+        void openPort() override;
+        bool startOpen() override;
+        void finishOpen() override;
+        std::string describe() const override;
+    private:
+        std::string host;
+        std::string port;
+        std::vector<InetAddress> addresses;
+        size_t next;             // address the current / next attempt uses
+};
+
+class UnixTransport : public SocketTransport {
+    public:
+        explicit UnixTransport(const std::string &path);
+        void openPort() override;
+        std::string describe() const override;
+    private:
+        std::string path;
+};
+
+/**
+ * @brief UDP or Unix datagram peer: each frame is one datagram, batched
+ *        with sendmmsg()/recvmmsg().
+ *
+ */
+class DatagramTransport : public SocketTransport {
+    public:
+        DatagramTransport(bool unixDomain, const std::string &hostOrPath, const std::string &port = "");
+        void openPort() override;
+        size_t readInto(uint8_t *buf, size_t len) override;
+        ssize_t writeVector(const struct iovec *iov, int iovcnt) override;
+        std::string describe() const override;
+        uint64_t truncatedInput() const override;
+    private:
+        bool unixDomain;
+        uint64_t truncated;      // datagrams larger than their recvmmsg() slot
+        std::string host;        // or socket path
+        std::string port;
+        std::vector<InetAddress> addresses;     // udp only
+};
+
+/**
+ * @brief the frame_codec stream cut into classic 8-byte CAN frames on one
+ *        identifier each way; bursts go out with sendmmsg().
+ *
+ */
+class CanTransport : public SocketTransport {
+    public:
+        CanTransport(const std::string &ifname, uint32_t txId, uint32_t rxId);
+        void openPort() override;
+        size_t readInto(uint8_t *buf, size_t len) override;
+        ssize_t writeVector(const struct iovec *iov, int iovcnt) override;
+        std::string describe() const override;
+    private:
+        std::string ifname;
+        uint32_t txId;
+        uint32_t rxId;
+};
+
+#endif
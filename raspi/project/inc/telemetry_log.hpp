@@ -0,0 +1,196 @@
+/**
+ * @file telemetry_log.hpp
+ * @author Ziad Fathy
+ * @brief append-only, memory-mapped log of board link traffic: chunked,
+ *        CRC checked, time indexed.
+ * @version 0.1
+ * @date 2025-09-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef TELEMETRY_LOG_H_
+#define TELEMETRY_LOG_H_
+
+/* --------- Includes --------- */
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/* --------- Layout --------- */
+/*
+ * file   : TelemetryLogFileHeader, padded to TELEMETRY_LOG_HEADER_SIZE
+ *          chunk 0, chunk 1, ... each chunkSize bytes
+ * chunk  : TelemetryLogChunkHeader | records
+ * record : TelemetryLogRecord | payload, padded to 8 bytes
+ *
+ * A chunk is open while it is being written and sealed once full: sealing
+ * records its time range, a sparse time index and a CRC of the record area.
+ * Index times and lastTimeNs are running maxima over the whole log, so they
+ * never decrease and a seek can binary search them even where concurrent
+ * writers committed records slightly out of time order.
+ * An open chunk (the live one, or the last one after a crash) is read up to
+ * its first uncommitted record.
+ */
+constexpr uint32_t TELEMETRY_LOG_MAGIC        = 0x474C4252;     // "RBLG"
+constexpr uint32_t TELEMETRY_LOG_CHUNK_MAGIC  = 0x4B484352;     // "RCHK"
+constexpr uint32_t TELEMETRY_LOG_VERSION      = 1;
+constexpr size_t   TELEMETRY_LOG_HEADER_SIZE  = 4096;           // keeps chunks page aligned
+constexpr size_t   TELEMETRY_LOG_INDEX_SIZE   = 64;
+constexpr uint32_t TELEMETRY_LOG_DEFAULT_CHUNK = 1u << 20;
+
+enum TelemetryLogChunkState : uint32_t {
+    TELEMETRY_LOG_CHUNK_OPEN   = 1,
+    TELEMETRY_LOG_CHUNK_SEALED = 2,
+};
+
+/* record types */
+constexpr uint8_t TELEMETRY_LOG_BOARD_RX = 1;   // robot_protocol message from the board
+constexpr uint8_t TELEMETRY_LOG_BOARD_TX = 2;   // robot_protocol message to the board
+
+constexpr uint32_t TELEMETRY_LOG_COMMITTED = 0x544D4352;         // "RCMT"
+
+struct TelemetryLogFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t chunkSize;
+    uint32_t reserved;
+    uint64_t createdRealtimeNs;    // CLOCK_REALTIME when the log was created,
+    uint64_t createdMonotonicNs;   // and the same instant on CLOCK_MONOTONIC
+};
+
+struct TelemetryLogIndexEntry {
+    uint64_t timeNs;               // latest record time up to and including this one
+    uint32_t offset;               // into the record area
+    uint32_t record;
+};
+
+struct alignas(64) TelemetryLogChunkHeader {
+    uint32_t magic;
+    std::atomic<uint32_t> state;
+    uint64_t sequence;             // chunk number from the start of the log
+    /* valid once sealed */
+    uint64_t firstTimeNs;          // earliest record in this chunk
+    uint64_t lastTimeNs;           // latest record in this or any earlier chunk
+    uint32_t usedBytes;
+    uint32_t records;
+    uint32_t crc;                  // frame_codec::crc32 over usedBytes of records
+    uint32_t indexCount;
+    TelemetryLogIndexEntry index[TELEMETRY_LOG_INDEX_SIZE];
+    /* writer cursors */
+    alignas(64) std::atomic<uint64_t> reserved;
+    std::atomic<uint64_t> committed;
+};
+
+/* the writer stamps timeNs before it reserves, so concurrent writers may
+ * commit records a little out of time order */
+struct TelemetryLogRecord {
+    uint64_t timeNs;               // CLOCK_MONOTONIC
+    uint16_t length;               // payload bytes
+    uint8_t  type;                 // TELEMETRY_LOG_BOARD_RX, ...
+    uint8_t  reserved;
+    std::atomic<uint32_t> commit;  // TELEMETRY_LOG_COMMITTED once the payload is in
+};
+
+static_assert(sizeof(TelemetryLogRecord) == 16, "record header layout");
+static_assert(sizeof(TelemetryLogFileHeader) <= TELEMETRY_LOG_HEADER_SIZE, "file header too large");
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "log atomics must be address-free");
+
+struct TelemetryLogEntry {
+    uint64_t timeNs;
+    uint8_t type;
+    uint16_t length;
+    const uint8_t *payload;        // valid while the reader lives
+};
+
+/* --------- Classes --------- */
+/**
+ * @brief appends records from any number of threads; append() reserves with
+ *        one fetch_add on the open chunk and never blocks unless it is the
+ *        one that filled the chunk.
+ *
+ */
+class TelemetryLogWriter {
+    public:
+        explicit TelemetryLogWriter(const std::string &path, uint32_t chunkSize = TELEMETRY_LOG_DEFAULT_CHUNK);
+        bool append(uint8_t type, const uint8_t *payload, size_t len, uint64_t timeNs);
+        uint64_t records() const;
+        uint64_t dropped() const;
+        uint64_t chunks() const;
+        ~TelemetryLogWriter();
+    private:
+        struct Chunk {
+            TelemetryLogChunkHeader *header;
+            uint8_t *records;
+            uint64_t sequence;
+        };
+
+        Chunk *mapChunk(uint64_t sequence);
+        void unmapChunk(Chunk *chunk);
+        void activate(Chunk *chunk);
+        void roll(Chunk *full, uint64_t usedBytes);
+        void seal(Chunk *chunk, uint64_t usedBytes);
+        void releaseRetired();
+
+        int fd;
+        uint32_t chunkSize;
+        uint32_t capacity;             // record bytes per chunk
+        std::atomic<Chunk *> current;
+        std::atomic<uint32_t> inFlight;
+        std::atomic<uint64_t> recordCount;
+        std::atomic<uint64_t> droppedCount;
+        std::atomic<bool> stopped;     // the next chunk could not be allocated (disk full)
+        std::mutex rollLock;           // slow path only: one chunk turnover at a time
+        Chunk *spare;                  // next chunk, mapped ahead of time
+        std::vector<Chunk *> retired;  // sealed, unmapped once no append can still see them
+        uint64_t sealedMaxNs;          // latest time in any sealed chunk
+};
+
+/**
+ * @brief sequential reads and O(log n) seeks by time over a log file; may
+ *        be opened while the writer is still appending.
+ *
+ */
+class TelemetryLogReader {
+    public:
+        explicit TelemetryLogReader(const std::string &path);
+        bool next(TelemetryLogEntry &out);
+        bool seek(uint64_t timeNs);
+        void rewind();
+        bool refresh();
+        uint64_t firstTimeNs() const;
+        uint64_t lastTimeNs() const;
+        size_t chunkCount() const;
+        uint64_t corruptChunks() const;
+        const TelemetryLogFileHeader &fileHeader() const;
+        ~TelemetryLogReader();
+    private:
+        const TelemetryLogChunkHeader *chunk(size_t i) const;
+        const uint8_t *recordArea(size_t i) const;
+        bool valid(size_t i) const;
+        bool sealed(size_t i) const;
+        bool usable(size_t i);
+        size_t validCount() const;
+        const TelemetryLogRecord *recordAt(size_t i, uint64_t offset) const;
+        uint64_t chunkFirstTime(size_t i) const;
+        uint64_t chunkLastTime(size_t i) const;
+        void mapFile();
+
+        int fd;
+        size_t size;
+        const uint8_t *map;
+        uint32_t chunkSize;
+        uint32_t capacity;
+        size_t count;                  // whole chunks mapped
+        size_t chunkIndex;             // cursor
+        uint64_t offset;
+        std::vector<uint8_t> checked;  // per chunk: 0 unknown, 1 good, 2 corrupt
+        uint64_t corrupt;
+};
+
+#endif
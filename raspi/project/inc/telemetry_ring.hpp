@@ -0,0 +1,97 @@
+/**
+ * @file telemetry_ring.hpp
+ * @author Ziad Fathy
+ * @brief shared-memory telemetry ring: one writer (robotd), any number of
+ *        readers, no locks and no syscalls on the read path.
+ * @version 0.1
+ * @date 2025-09-14
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef TELEMETRY_RING_H_
+#define TELEMETRY_RING_H_
+
+/* --------- Includes --------- */
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/* --------- Layout --------- */
+constexpr uint32_t TELEMETRY_RING_MAGIC   = 0x31544252;     // "RBT1"
+constexpr uint32_t TELEMETRY_RING_VERSION = 1;
+
+struct TelemetrySample {
+    uint64_t hostTimeNs;       // CLOCK_MONOTONIC of the sample (see flags)
+    uint32_t mcuTimeUs;        // board clock from the telemetry frame
+    int32_t  position[4];      // encoder counts
+    float    distanceCm;       // 0 = no echo
+    uint32_t flags;            // TELEMETRY_TIME_SYNCED, ...
+};
+
+/* hostTimeNs is mcuTimeUs mapped through ClockSync; otherwise it is the
+ * (later, jittery) time robotd decoded the frame */
+constexpr uint32_t TELEMETRY_TIME_SYNCED = 1u << 0;
+
+/*
+ * Per-slot seqlock. Entry i lives in slot i % slotCount; its sequence is
+ * 2i+1 while the writer copies it in and 2i+2 once complete, so a reader
+ * can tell "not yet written", "complete" and "overwritten by a later lap"
+ * from one load.
+ */
+struct alignas(64) TelemetrySlot {
+    std::atomic<uint64_t> seq;
+    TelemetrySample sample;
+};
+
+struct alignas(64) TelemetryRingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;        // power of two
+    uint32_t slotSize;         // sizeof(TelemetrySlot) of the writer
+    alignas(64) std::atomic<uint64_t> head;     // entries published so far
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring atomics must be address-free");
+
+/* --------- Classes --------- */
+/**
+ * @brief creates the ring in a sealed memfd; hand getFd() to readers.
+ *
+ */
+class TelemetryRingWriter {
+    public:
+        explicit TelemetryRingWriter(uint32_t slotCount);
+        void publish(const TelemetrySample &sample);
+        int getFd() const;
+        int openReadOnlyFd() const;
+        size_t mapSize() const;
+        uint32_t slotCount() const;
+        ~TelemetryRingWriter();
+    private:
+        int fd;
+        size_t size;
+        TelemetryRingHeader *header;
+        TelemetrySlot *slots;
+        uint64_t mask;
+};
+
+class TelemetryRingReader {
+    public:
+        explicit TelemetryRingReader(int fd);
+        bool next(TelemetrySample &out);
+        bool latest(TelemetrySample &out);
+        uint64_t lost() const;
+        uint64_t published() const;
+        ~TelemetryRingReader();
+    private:
+        size_t size;
+        const TelemetryRingHeader *header;
+        const TelemetrySlot *slots;
+        uint64_t mask;
+        uint64_t cursor;
+        uint64_t lostCount;
+};
+
+#endif
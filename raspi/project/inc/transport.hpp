@@ -0,0 +1,64 @@
+/**
+ * @file transport.hpp
+ * @author Ziad Fathy
+ * @brief byte-stream link to a motor board, independent of what carries it.
+ * @version 0.1
+ * @date 2025-09-13
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef TRANSPORT_H_
+#define TRANSPORT_H_
+
+/* --------- Includes --------- */
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/* --------- Class --------- */
+/**
+ * @brief what UARTTxQueue, UARTLink and UARTPortManager talk to.
+ *
+ * Every backend moves the same frame_codec byte stream; fromUri() picks one:
+ *
+ *   /dev/serial0                         serial, 115200
+ *   serial:///dev/ttyUSB0?baud=921600    serial (UART class)
+ *   pty:///tmp/ttySTM32                  stm32_emu or any pty, no baud
+ *   tcp://bridge.local:5000              remote serial bridge, writev
+ *   unix:///run/robot/board0.sock        local stream socket, writev
+ *   udp://10.0.0.7:5001                  one frame per datagram, sendmmsg
+ *   unixgram:///run/robot/sim.sock       same over a Unix datagram socket
+ *   can://can0?tx=0x120&rx=0x121         8-byte CAN frames, sendmmsg bursts
+ *
+ * writeVector() takes one iovec per frame where it matters: datagram
+ * backends never split an iovec across datagrams and report only whole
+ * iovecs as sent.
+ *
+ * Event loops open links with startOpen(); when it returns false the
+ * connection is still in flight and finishOpen() completes it once the fd
+ * polls writable.
+ */
+class Transport {
+    public:
+        virtual void openPort() = 0;
+        virtual bool startOpen();
+        virtual void finishOpen();
+        virtual void closePort() = 0;
+        virtual int getFd() const = 0;
+        virtual void setNonBlocking(bool enable);
+        virtual size_t readInto(uint8_t *buf, size_t len) = 0;
+        virtual ssize_t writeVector(const struct iovec *iov, int iovcnt) = 0;
+        virtual std::string describe() const = 0;
+        virtual bool setBaud(long baud);
+        virtual uint64_t truncatedInput() const;
+        void writeFrame(const uint8_t *payload, size_t len);
+        static std::unique_ptr<Transport> fromUri(const std::string &uri);
+        virtual ~Transport() = default;
+};
+
+#endif
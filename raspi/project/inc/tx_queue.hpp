@@ -0,0 +1,99 @@
+/**
+ * @file tx_queue.hpp
+ * @author Ziad Fathy
+ * @brief multi-producer transmit queue drained by a single writev() writer.
+ * @version 0.1
+ * @date 2025-09-08
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef TX_QUEUE_H_
+#define TX_QUEUE_H_
+
+/* --------- Includes --------- */
+#include "transport.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+/* --------- Types --------- */
+/**
+ * @brief transmit classes, drained strictly in this order.
+ *
+ * Control is reserved for safety traffic (STOP) and always leads the
+ * next writev(), Bulk only fills whatever room is left in the batch.
+ */
+enum class TxPriority : uint8_t {
+    Control = 0,
+    Command,
+    Bulk
+};
+
+constexpr size_t TX_PRIORITY_COUNT = 3;
+/* longest sleep for POLLOUT when a non-blocking port is full, before writev() is retried */
+constexpr int TX_POLL_TIMEOUT_MS = 100;
+
+struct TxQueueStats {
+    size_t   depth;          // frames queued right now
+    size_t   maxDepth;       // high-water mark since start
+    uint64_t framesSent;
+    uint64_t bytesSent;
+    uint64_t writevCalls;
+    uint64_t writeErrors;
+    uint64_t totalWaitNs;    // submit() -> handed to writev()
+    uint64_t maxWaitNs;
+};
+
+/* --------- Class --------- */
+class UARTTxQueue {
+    public:
+        UARTTxQueue(Transport &link, size_t maxBatch = 64, size_t maxBatchBytes = 1024);
+        void start();
+        void stop();
+        void submit(std::string frame, TxPriority prio = TxPriority::Command);
+        TxQueueStats stats() const;
+        ~UARTTxQueue();
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Node {
+            std::atomic<Node*> next;
+            std::string data;
+            Clock::time_point enqueued;
+        };
+
+        /* Vyukov intrusive MPSC queue: producers swap head, the writer owns tail. */
+        struct Lane {
+            std::atomic<Node*> head;
+            Node *tail;
+            Node stub;
+        };
+
+        void push(Lane &lane, Node *node);
+        Node *pop(Lane &lane);
+        void writerLoop();
+        size_t collect(Node **nodes, struct iovec *iov);
+        void flush(Node **nodes, struct iovec *iov, size_t count);
+
+        Transport &link;
+        size_t maxBatch;
+        size_t maxBatchBytes;
+        Lane lanes[TX_PRIORITY_COUNT];
+        int wakeFd;
+        std::thread writer;
+        std::atomic<bool> running;
+
+        std::atomic<size_t>   depth;
+        std::atomic<size_t>   maxDepth;
+        std::atomic<uint64_t> framesSent;
+        std::atomic<uint64_t> bytesSent;
+        std::atomic<uint64_t> writevCalls;
+        std::atomic<uint64_t> writeErrors;
+        std::atomic<uint64_t> totalWaitNs;
+        std::atomic<uint64_t> maxWaitNs;
+};
+
+#endif
@@ -0,0 +1,46 @@
+/**
+ * @file uart_link.hpp
+ * @author Ziad Fathy
+ * @brief reliable, windowed message transport on top of the UART class.
+ * @version 0.1
+ * @date 2025-09-09
+ * 
+ * @copyright Copyright (c) 2025
+ * 
+ */
+
+#ifndef UART_LINK_H_
+#define UART_LINK_H_
+
+/* --------- Includes --------- */
+#include "transport.hpp"
+#include "reliable_link.h"
+#include <functional>
+
+/* --------- Class --------- */
+class UARTLink {
+    public:
+        /* fixed by reliable_link.h so the board end is built the same */
+        static constexpr size_t MAX_WINDOW  = arq::link_window;
+        static constexpr size_t MAX_PAYLOAD = arq::link_max_payload;
+        static constexpr size_t READ_CHUNK  = 256;
+
+        using DeliverFn = std::function<void(const uint8_t *payload, size_t len)>;
+
+        UARTLink(Transport &link, DeliverFn onDeliver, const arq::config &cfg = arq::default_config);
+        bool send(const uint8_t *payload, size_t len);
+        bool send(const std::string &payload);
+        void service(int maxWaitMs);
+        size_t inFlight() const;
+        const arq::stats &stats() const;
+        static uint32_t nowUs();
+    private:
+        static void emitFrame(void *ctx, const uint8_t *bytes, size_t len);
+        static void deliverPayload(void *ctx, const uint8_t *payload, size_t len);
+
+        Transport &link;
+        DeliverFn onDeliver;
+        arq::link<MAX_WINDOW, MAX_PAYLOAD> engine;
+};
+
+#endif
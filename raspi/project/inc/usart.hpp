@@ -19,14 +19,24 @@
 #include <termios.h>
 #include <string>
 #include <stdexcept>
+#include <sys/uio.h>
+#include <cstdint>
+#include "transport.hpp"
 
 /* --------- Class --------- */
-class UART{
+class UART : public Transport {
     public:
         UART(const std::string &dev, speed_t buad);
-        void openPort();
+        void openPort() override;
+        void closePort() override;
         void writeData(std::string data);
+        ssize_t writeVector(const struct iovec *iov, int iovcnt) override;
         std::string readData(size_t maxLen = 256);
+        size_t readInto(uint8_t *buf, size_t len) override;
+        int getFd() const override;
+        std::string describe() const override;
+        bool setBaud(long baud) override;
+        static speed_t speedFor(long baud);
         ~UART();
     private:
         int fd;
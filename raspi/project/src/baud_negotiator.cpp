@@ -0,0 +1,370 @@
+/**
+ * @file baud_negotiator.cpp
+ * @author Ziad Fathy
+ * @brief Pi end of the robot_protocol baud negotiation.
+ * @version 0.1
+ * @date 2025-09-16
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "../inc/baud_negotiator.hpp"
+#include "robot_protocol.h"
+#include <algorithm>
+#include <cstring>
+
+/* rates both a Pi PL011 and termios can do; the board rejects what its
+   clock cannot reach */
+static const long CANDIDATES[] = {
+    115200, 230400, 460800, 500000, 921600, 1000000, 1500000, 2000000
+};
+
+static constexpr uint64_t MS = 1000000ULL;
+static constexpr uint64_t MIN_MONITOR_FRAMES = 20;
+
+/**
+ * @brief Construct a new BaudNegotiator object
+ *
+ * @param send    queue a robot_protocol message on the link.
+ * @param setBaud change the local line rate (UARTPortManager::setBaud).
+ */
+BaudNegotiator::BaudNegotiator(SendFn send, SetBaudFn setBaud, const BaudNegotiatorConfig &cfg) :
+            send(send),
+            setBaud(setBaud),
+            cfg(cfg),
+            state(State::Disabled),
+            current(0),
+            target(0),
+            ceiling(0),
+            stepUp(true),
+            attempts(0),
+            deadlineNs(0),
+            trialEndNs(0),
+            lastRxNs(0),
+            testBase(0),
+            sent(0),
+            echoed(0),
+            corrupt(0),
+            errorBaseValid(false),
+            errorBase(0),
+            lastErrors(0),
+            lastProgressNs(0),
+            windowStartNs(0),
+            windowFrames(0),
+            windowErrors(0),
+            nextKeepaliveNs(0),
+            keepaliveSeq(0) {
+    for(long b : CANDIDATES)
+        if(b >= static_cast<long>(robot_protocol::safe_baud) && b <= cfg.maxBaud)
+            this->candidates.push_back(b);
+    if(this->candidates.empty() || this->candidates[0] != static_cast<long>(robot_protocol::safe_baud))
+        this->candidates.insert(this->candidates.begin(), robot_protocol::safe_baud);
+}
+
+/**
+ * @brief (re)start from safe_baud; call whenever the link (re)connects.
+ *
+ */
+void BaudNegotiator::start(uint64_t nowNs) {
+    this->rejected.assign(this->candidates.size(), false);
+    this->current = 0;
+    this->ceiling = this->candidates.size() - 1;
+    this->stepUp = true;
+    this->lastRxNs = nowNs;
+    if(!this->setBaud(this->candidates[0])) {
+        this->state = State::Disabled;             // sockets, CAN: nothing to negotiate
+        return;
+    }
+    this->proposeNext(nowNs);
+}
+
+void BaudNegotiator::stop() {
+    this->state = State::Disabled;
+}
+
+/**
+ * @brief feed every decoded board message.
+ *
+ * @return true if it was negotiation traffic (ack, link test echo).
+ */
+bool BaudNegotiator::onFrame(const uint8_t *msg, size_t len, uint64_t nowNs) {
+    this->lastRxNs = nowNs;
+    if(len == 0)
+        return false;
+
+    if(msg[0] == robot_protocol::msg_baud_ack && len >= robot_protocol::baud_ack_size) {
+        long baud = robot_protocol::get_u32(msg + 1);
+        uint8_t status = msg[5];
+        if(baud != this->candidates[this->target])
+            return true;
+        if(this->state == State::Proposing) {
+            if(status == robot_protocol::baud_accepted) {
+                /* the board switches as soon as this ack is out */
+                this->trialEndNs = nowNs + this->cfg.trialMs * MS;
+                if(this->switchTo(this->target))
+                    this->beginTest(nowNs);
+                else
+                    this->fallBack(nowNs);
+            } else {
+                this->rejected[this->target] = true;
+                this->proposeNext(nowNs);
+            }
+        } else if(this->state == State::Committing && status == robot_protocol::baud_committed) {
+            this->current = this->target;
+            if(this->stepUp)
+                this->proposeNext(nowNs);
+            else
+                this->settle();
+        }
+        return true;
+    }
+
+    if(msg[0] == robot_protocol::msg_link_test && len >= robot_protocol::link_test_size) {
+        if(this->state != State::Testing)
+            return true;
+        uint16_t seq = robot_protocol::get_u16(msg + 1);
+        uint16_t index = static_cast<uint16_t>(seq - this->testBase);
+        if(index >= this->sent)
+            return true;
+        uint8_t expected[robot_protocol::link_test_size];
+        robot_protocol::encode_link_test(expected, seq, msg[3]);
+        if(msg[3] == index % robot_protocol::pattern_count &&
+           memcmp(expected + 1, msg + 1, robot_protocol::link_test_size - 1) == 0)
+            this->echoed++;
+        else
+            this->corrupt++;
+        this->lastProgressNs = nowNs;
+        this->pumpTest(nowNs);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief timeouts, test pacing and error-rate monitoring; call every loop.
+ *
+ */
+void BaudNegotiator::poll(uint64_t nowNs, const PortStats &stats) {
+    uint64_t errors = stats.crcErrors + stats.malformed;
+    uint64_t newErrors = errors - this->lastErrors;
+    this->lastErrors = errors;
+
+    switch(this->state) {
+        case State::Disabled:
+            break;
+
+        case State::Proposing:
+            if(nowNs < this->deadlineNs)
+                break;
+            if(this->attempts < this->cfg.retries)
+                this->propose(this->target, nowNs);
+            else if(this->current == 0)
+                this->settle();                 // a board that does not negotiate
+            else
+                this->fallBack(nowNs);          // the link itself is gone
+            break;
+
+        case State::Testing:
+            if(!this->errorBaseValid) {
+                this->errorBase = errors;
+                this->errorBaseValid = true;
+            }
+            if(this->sent >= this->cfg.testFrames && this->echoed + this->corrupt >= this->sent)
+                this->finishTest(nowNs);
+            else if(nowNs - this->lastProgressNs > this->cfg.ackTimeoutMs * MS || nowNs >= this->trialEndNs)
+                this->finishTest(nowNs);
+            break;
+
+        case State::Committing:
+            if(nowNs < this->deadlineNs)
+                break;
+            if(this->attempts < this->cfg.retries && nowNs < this->trialEndNs) {
+                uint8_t msg[robot_protocol::commit_size];
+                this->send(msg, robot_protocol::encode_baud_commit(msg, this->candidates[this->target]));
+                this->attempts++;
+                this->deadlineNs = nowNs + this->cfg.ackTimeoutMs * MS;
+            } else {
+                this->state = State::Reverting;
+                this->deadlineNs = this->trialEndNs;
+            }
+            break;
+
+        case State::Reverting:
+            /* the board's trial is over: it is back at the committed rate */
+            if(nowNs < this->deadlineNs + 50 * MS)
+                break;
+            if(!this->switchTo(this->current)) {
+                this->fallBack(nowNs);
+                break;
+            }
+            if(this->stepUp) {
+                this->ceiling = this->target - 1;
+                this->settle();
+            } else {
+                this->rejected[this->target] = true;
+                this->proposeNext(nowNs);
+            }
+            break;
+
+        case State::Settled:
+            if(this->current == 0)
+                break;
+            if(nowNs - this->lastRxNs > robot_protocol::link_silence_ms * MS) {
+                this->fallBack(nowNs);
+                break;
+            }
+            if(nowNs >= this->nextKeepaliveNs) {
+                uint8_t msg[robot_protocol::link_test_size];
+                this->send(msg, robot_protocol::encode_link_test(msg, this->keepaliveSeq++, robot_protocol::pattern_random));
+                this->nextKeepaliveNs = nowNs + this->cfg.keepaliveMs * MS;
+            }
+            this->windowErrors += newErrors;
+            if(nowNs - this->windowStartNs < this->cfg.monitorMs * MS)
+                break;
+            {
+                uint64_t frames = stats.framesRx - this->windowFrames;
+                uint64_t total = frames + this->windowErrors;
+                bool degraded = total >= MIN_MONITOR_FRAMES &&
+                                this->windowErrors > this->cfg.maxErrorRatio * total;
+                this->windowStartNs = nowNs;
+                this->windowFrames = stats.framesRx;
+                this->windowErrors = 0;
+                if(degraded) {
+                    this->ceiling = this->current - 1;
+                    this->stepUp = false;
+                    this->proposeNext(nowNs);
+                }
+            }
+            break;
+    }
+    if(this->state != State::Settled) {
+        this->windowStartNs = nowNs;
+        this->windowFrames = stats.framesRx;
+        this->windowErrors = 0;
+    }
+}
+
+/**
+ * @brief the link may be between rates; hold every other frame.
+ *
+ */
+bool BaudNegotiator::busy() const {
+    return this->state != State::Disabled && this->state != State::Settled;
+}
+
+long BaudNegotiator::baud() const {
+    return this->candidates[this->current];
+}
+
+const char *BaudNegotiator::stateName() const {
+    switch(this->state) {
+        case State::Disabled:   return "disabled";
+        case State::Proposing:  return "proposing";
+        case State::Testing:    return "testing";
+        case State::Committing: return "committing";
+        case State::Reverting:  return "reverting";
+        default:                return "settled";
+    }
+}
+
+void BaudNegotiator::propose(size_t index, uint64_t nowNs) {
+    uint8_t msg[robot_protocol::propose_size];
+    this->target = index;
+    this->send(msg, robot_protocol::encode_baud_propose(msg, this->candidates[index], this->cfg.trialMs));
+    this->attempts++;
+    this->deadlineNs = nowNs + this->cfg.ackTimeoutMs * MS;
+    this->state = State::Proposing;
+}
+
+/**
+ * @brief next untried candidate in the current direction, or settle.
+ *
+ */
+void BaudNegotiator::proposeNext(uint64_t nowNs) {
+    this->attempts = 0;
+    if(this->stepUp) {
+        for(size_t i = this->current + 1; i <= this->ceiling && i < this->candidates.size(); i++) {
+            if(!this->rejected[i]) {
+                this->propose(i, nowNs);
+                return;
+            }
+        }
+    } else {
+        for(size_t i = std::min(this->ceiling + 1, this->current); i-- > 0; ) {
+            if(!this->rejected[i]) {
+                this->propose(i, nowNs);
+                return;
+            }
+        }
+    }
+    this->settle();
+}
+
+void BaudNegotiator::beginTest(uint64_t nowNs) {
+    this->state = State::Testing;
+    this->testBase = static_cast<uint16_t>(this->testBase + this->sent + 1);
+    this->sent = 0;
+    this->echoed = 0;
+    this->corrupt = 0;
+    this->errorBaseValid = false;
+    this->lastProgressNs = nowNs;
+    this->pumpTest(nowNs);
+}
+
+/**
+ * @brief keep testWindow echoes in flight until testFrames are out.
+ *
+ */
+void BaudNegotiator::pumpTest(uint64_t nowNs) {
+    while(this->sent < this->cfg.testFrames && this->sent - this->echoed - this->corrupt < this->cfg.testWindow) {
+        uint8_t msg[robot_protocol::link_test_size];
+        uint16_t seq = static_cast<uint16_t>(this->testBase + this->sent);
+        uint8_t pattern = static_cast<uint8_t>(this->sent % robot_protocol::pattern_count);
+        if(!this->send(msg, robot_protocol::encode_link_test(msg, seq, pattern)))
+            break;
+        this->sent++;
+        this->lastProgressNs = nowNs;
+    }
+}
+
+void BaudNegotiator::finishTest(uint64_t nowNs) {
+    uint64_t errors = (this->sent - this->echoed) + (this->errorBaseValid ? this->lastErrors - this->errorBase : 0);
+    bool passed = this->sent > 0 && errors <= this->cfg.maxTestErrorRatio * this->cfg.testFrames;
+    if(passed && nowNs < this->trialEndNs) {
+        uint8_t msg[robot_protocol::commit_size];
+        this->send(msg, robot_protocol::encode_baud_commit(msg, this->candidates[this->target]));
+        this->attempts = 1;
+        this->deadlineNs = nowNs + this->cfg.ackTimeoutMs * MS;
+        this->state = State::Committing;
+    } else {
+        this->state = State::Reverting;
+        this->deadlineNs = this->trialEndNs;
+    }
+}
+
+void BaudNegotiator::settle() {
+    this->state = State::Settled;
+    this->nextKeepaliveNs = 0;
+}
+
+/**
+ * @brief the link went quiet or the local rate cannot be set: meet the
+ *        board at safe_baud and climb again; a rate that cannot carry the
+ *        link fails its test again.
+ *
+ */
+void BaudNegotiator::fallBack(uint64_t nowNs) {
+    this->current = 0;
+    this->stepUp = true;
+    this->lastRxNs = nowNs;
+    if(!this->switchTo(0)) {
+        this->state = State::Disabled;
+        return;
+    }
+    this->proposeNext(nowNs);
+}
+
+bool BaudNegotiator::switchTo(size_t index) {
+    return this->setBaud(this->candidates[index]);
+}
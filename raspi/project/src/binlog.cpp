@@ -0,0 +1,451 @@
+/**
+ * @file binlog.cpp
+ * @author Ziad Fathy
+ * @brief binary logging: site registry, per-thread rings and the
+ *        background thread that drains them to the file.
+ * @version 0.1
+ * @date 2025-09-19
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "../inc/binlog.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <chrono>
+#include <fcntl.h>
+#include <mutex>
+#include <stdexcept>
+#include <sys/syscall.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+/* the drainer sleeps this long once every ring is empty */
+static constexpr auto DRAIN_IDLE = std::chrono::milliseconds(1);
+/* clock records: one soon after open to calibrate the ticks, then one a second */
+static constexpr uint64_t FIRST_CLOCK_NS = 10000000ULL;
+static constexpr uint64_t CLOCK_INTERVAL_NS = 1000000000ULL;
+
+struct BinLogState {
+    std::mutex lock;                        // everything below but the counters
+    std::vector<BinLogSite *> sites;        // id - 1 -> site
+    std::vector<const char *> siteTypes;
+    std::vector<BinLogBuffer *> buffers;
+    size_t sitesWritten = 0;                // already in the file
+    uint64_t retiredDropped = 0;
+    BinLogLevel level = BINLOG_LEVEL_INFO;
+    int fd = -1;
+    bool writeFailed = false;
+    std::thread drainer;
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> entries{0};
+    std::atomic<uint64_t> bytes{0};
+    uint64_t nextClockNs = 0;
+};
+
+static BinLogState state;
+
+static uint64_t clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t ticks_per_second() {
+#if defined(__x86_64__) || defined(__i386__)
+    return 0;       // TSC rate is not exposed; the decoder fits it to the clock records
+#elif defined(__aarch64__)
+    uint64_t f;
+    asm volatile("mrs %0, cntfrq_el0" : "=r"(f));
+    return f;
+#else
+    return 1000000000ULL;
+#endif
+}
+
+template<typename T>
+static void append_pod(std::string &out, const T &v) {
+    out.append(reinterpret_cast<const char *>(&v), sizeof(v));
+}
+
+static void append_record_header(std::string &out, uint32_t type, size_t length) {
+    BinLogRecordHeader h = { type, static_cast<uint32_t>(length) };
+    append_pod(out, h);
+}
+
+static void append_clock(std::string &out) {
+    BinLogClockRecord c;
+    c.ticks = BinLog::ticks();
+    c.monotonicNs = clock_ns(CLOCK_MONOTONIC);
+    c.realtimeNs = clock_ns(CLOCK_REALTIME);
+    append_record_header(out, BINLOG_RECORD_CLOCK, sizeof(c));
+    append_pod(out, c);
+}
+
+static void append_site(std::string &out, uint32_t id, const BinLogSite *site, const char *types) {
+    BinLogSiteRecord r{};
+    size_t fileLen = std::min<size_t>(strlen(site->file), UINT16_MAX);
+    size_t formatLen = std::min<size_t>(strlen(site->format), UINT16_MAX);
+    r.id = id;
+    r.line = site->line;
+    r.level = site->level;
+    r.argCount = static_cast<uint8_t>(strlen(types));
+    r.fileLength = static_cast<uint16_t>(fileLen);
+    r.formatLength = static_cast<uint16_t>(formatLen);
+    append_record_header(out, BINLOG_RECORD_SITE, sizeof(r) + fileLen + formatLen + r.argCount);
+    append_pod(out, r);
+    out.append(site->file, fileLen);
+    out.append(site->format, formatLen);
+    out.append(types, r.argCount);
+}
+
+static void write_out(const std::string &out) {
+    const char *p = out.data();
+    size_t left = out.size();
+    while(left > 0 && !state.writeFailed) {
+        ssize_t n = write(state.fd, p, left);
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n <= 0) {
+            /* keep draining so callers never see a full ring, but stop writing */
+            state.writeFailed = true;
+            break;
+        }
+        p += n;
+        left -= n;
+        state.bytes.fetch_add(n, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief pack the raw entries drained from one ring into an ENTRIES
+ *        record (see Layout in binlog.hpp).
+ *
+ */
+static void append_entries(std::string &out, uint32_t threadId, const std::string &raw,
+                           const std::vector<const char *> &types) {
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(raw.data());
+    const uint8_t *end = p + raw.size();
+    BinLogEntriesRecord r = { threadId, 0, 0 };
+    memcpy(&r.baseTicks, p + offsetof(BinLogEntry, ticks), sizeof(r.baseTicks));
+    size_t start = out.size();
+    append_record_header(out, BINLOG_RECORD_ENTRIES, 0);
+    append_pod(out, r);
+
+    /* varints grow 4 byte values to 5 and 8 byte ones to 10 at worst */
+    uint8_t packed[BINLOG_MAX_ENTRY * 2];
+    uint64_t prev = r.baseTicks;
+    while(p < end) {
+        BinLogEntry e;
+        memcpy(&e, p, sizeof(e));
+        uint8_t *q = binlog_put_varint(packed, e.site);
+        q = binlog_put_varint(q, binlog_zigzag(static_cast<int64_t>(e.ticks - prev)));
+        prev = e.ticks;
+
+        const uint8_t *a = p + sizeof(e);
+        for(const char *t = types[e.site - 1]; *t; t++) {
+            uint32_t v32;
+            uint64_t v64;
+            uint16_t n;
+            switch(*t) {
+                case BINLOG_ARG_I32:
+                    memcpy(&v32, a, 4);
+                    q = binlog_put_varint(q, binlog_zigzag(static_cast<int32_t>(v32)));
+                    a += 4;
+                    break;
+                case BINLOG_ARG_U32:
+                    memcpy(&v32, a, 4);
+                    q = binlog_put_varint(q, v32);
+                    a += 4;
+                    break;
+                case BINLOG_ARG_I64:
+                    memcpy(&v64, a, 8);
+                    q = binlog_put_varint(q, binlog_zigzag(static_cast<int64_t>(v64)));
+                    a += 8;
+                    break;
+                case BINLOG_ARG_STRING:
+                    memcpy(&n, a, 2);
+                    q = binlog_put_varint(q, n);
+                    memcpy(q, a + 2, n);
+                    q += n;
+                    a += 2 + n;
+                    break;
+                case BINLOG_ARG_DOUBLE:
+                    memcpy(q, a, 8);
+                    q += 8;
+                    a += 8;
+                    break;
+                default:
+                    memcpy(&v64, a, 8);
+                    q = binlog_put_varint(q, v64);
+                    a += 8;
+                    break;
+            }
+        }
+        out.append(reinterpret_cast<const char *>(packed), q - packed);
+        r.count++;
+        p += e.size;
+    }
+
+    BinLogRecordHeader h = { BINLOG_RECORD_ENTRIES, static_cast<uint32_t>(out.size() - start - sizeof(h)) };
+    memcpy(&out[start], &h, sizeof(h));
+    memcpy(&out[start + sizeof(h)], &r, sizeof(r));
+}
+
+/**
+ * @brief one pass over every ring. Entries are drained before the registry
+ *        is read, so any site they use is already registered and its record
+ *        goes out ahead of them.
+ *
+ * @return true if anything was drained.
+ */
+static bool drain_once(std::string &out, std::vector<std::string> &raw) {
+    std::vector<BinLogBuffer *> buffers;
+    {
+        std::lock_guard<std::mutex> guard(state.lock);
+        buffers = state.buffers;
+    }
+
+    if(raw.size() < buffers.size())
+        raw.resize(buffers.size());
+    size_t drained = 0;
+    std::vector<BinLogBuffer *> gone;
+    for(size_t i = 0; i < buffers.size(); i++) {
+        bool exited = buffers[i]->retired.load(std::memory_order_acquire);
+        raw[i].clear();
+        drained += buffers[i]->drain(raw[i]);
+        if(exited && buffers[i]->empty())
+            gone.push_back(buffers[i]);
+    }
+
+    out.clear();
+    std::vector<const char *> types;
+    {
+        std::lock_guard<std::mutex> guard(state.lock);
+        for(; state.sitesWritten < state.sites.size(); state.sitesWritten++)
+            append_site(out, state.sitesWritten + 1, state.sites[state.sitesWritten], state.siteTypes[state.sitesWritten]);
+        types = state.siteTypes;
+    }
+
+    for(size_t i = 0; i < buffers.size(); i++) {
+        BinLogBuffer *buf = buffers[i];
+        if(!raw[i].empty())
+            append_entries(out, buf->threadId(), raw[i], types);
+        uint64_t dropped = buf->droppedCount();
+        if(dropped != buf->reportedDropped) {
+            BinLogDroppedRecord d = { buf->threadId(), 0, dropped };
+            append_record_header(out, BINLOG_RECORD_DROPPED, sizeof(d));
+            append_pod(out, d);
+            buf->reportedDropped = dropped;
+        }
+    }
+
+    if(!gone.empty()) {
+        std::lock_guard<std::mutex> guard(state.lock);
+        for(BinLogBuffer *buf : gone) {
+            state.retiredDropped += buf->droppedCount();
+            state.buffers.erase(std::find(state.buffers.begin(), state.buffers.end(), buf));
+            delete buf;
+        }
+    }
+
+    uint64_t now = clock_ns(CLOCK_MONOTONIC);
+    if(now >= state.nextClockNs) {
+        append_clock(out);
+        state.nextClockNs = now + CLOCK_INTERVAL_NS;
+    }
+    if(!out.empty())
+        write_out(out);
+    state.entries.fetch_add(drained, std::memory_order_relaxed);
+    return drained > 0;
+}
+
+static void drainer_loop() {
+    std::string out;
+    std::vector<std::string> raw;
+    while(state.running.load(std::memory_order_acquire)) {
+        if(!drain_once(out, raw))
+            std::this_thread::sleep_for(DRAIN_IDLE);
+    }
+}
+
+/* marks the calling thread's ring retired when the thread exits */
+struct BinLogThreadExit {
+    BinLogBuffer *buffer = nullptr;
+    ~BinLogThreadExit() {
+        if(this->buffer != nullptr)
+            this->buffer->retired.store(true, std::memory_order_release);
+    }
+};
+
+/**
+ * @brief Construct a new BinLogBuffer object
+ *
+ */
+BinLogBuffer::BinLogBuffer(uint32_t threadId) :
+            retired(false),
+            reportedDropped(0),
+            head(0),
+            pendingHead(0),
+            cachedTail(0),
+            dropped(0),
+            tail(0),
+            thread(threadId) {
+}
+
+/**
+ * @brief append every committed entry to out, without the ring padding.
+ *
+ * @return number of entries.
+ */
+size_t BinLogBuffer::drain(std::string &out) {
+    uint64_t h = this->head.load(std::memory_order_acquire);
+    uint64_t t = this->tail.load(std::memory_order_relaxed);
+    size_t count = 0;
+    while(t < h) {
+        size_t offset = t & (BINLOG_BUFFER_SIZE - 1);
+        uint16_t size;
+        memcpy(&size, this->storage + offset, sizeof(size));
+        if(size == 0) {
+            t += BINLOG_BUFFER_SIZE - offset;
+            continue;
+        }
+        out.append(reinterpret_cast<const char *>(this->storage + offset), size);
+        t += size;
+        count++;
+    }
+    this->tail.store(t, std::memory_order_release);
+    return count;
+}
+
+uint64_t BinLogBuffer::droppedCount() const {
+    return this->dropped.load(std::memory_order_relaxed);
+}
+
+uint32_t BinLogBuffer::threadId() const {
+    return this->thread;
+}
+
+bool BinLogBuffer::empty() const {
+    return this->tail.load(std::memory_order_relaxed) == this->head.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief start logging to path (replaced if it exists) at level and above.
+ *
+ */
+void BinLog::open(const std::string &path, BinLogLevel level) {
+    std::lock_guard<std::mutex> guard(state.lock);
+    if(state.fd >= 0)
+        throw std::logic_error("binary log already open");
+    state.fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(state.fd < 0)
+        throw std::runtime_error("cannot create " + path);
+
+    BinLogFileHeader h{};
+    h.magic = BINLOG_MAGIC;
+    h.version = BINLOG_VERSION;
+    h.ticksPerSecond = ticks_per_second();
+    h.createdRealtimeNs = clock_ns(CLOCK_REALTIME);
+    h.createdMonotonicNs = clock_ns(CLOCK_MONOTONIC);
+    std::string out;
+    append_pod(out, h);
+    append_clock(out);
+    state.writeFailed = false;
+    state.sitesWritten = 0;
+    state.entries.store(0);
+    state.bytes.store(0);
+    write_out(out);
+    if(state.writeFailed) {
+        ::close(state.fd);
+        state.fd = -1;
+        throw std::runtime_error("cannot write " + path);
+    }
+
+    state.nextClockNs = h.createdMonotonicNs + FIRST_CLOCK_NS;
+    state.running.store(true, std::memory_order_release);
+    state.drainer = std::thread(drainer_loop);
+    state.level = level;
+    threshold.store(level, std::memory_order_relaxed);
+}
+
+/**
+ * @brief stop logging, write out whatever the rings still hold and close
+ *        the file. Rings of live threads are kept for the next open().
+ *
+ */
+void BinLog::close() {
+    {
+        std::lock_guard<std::mutex> guard(state.lock);
+        if(state.fd < 0)
+            return;
+        threshold.store(BINLOG_LEVEL_OFF, std::memory_order_relaxed);
+    }
+    state.running.store(false, std::memory_order_release);
+    state.drainer.join();
+
+    std::string out;
+    std::vector<std::string> raw;
+    state.nextClockNs = 0;
+    drain_once(out, raw);
+
+    std::lock_guard<std::mutex> guard(state.lock);
+    ::close(state.fd);
+    state.fd = -1;
+}
+
+void BinLog::setLevel(BinLogLevel level) {
+    std::lock_guard<std::mutex> guard(state.lock);
+    state.level = level;
+    if(state.fd >= 0)
+        threshold.store(level, std::memory_order_relaxed);
+}
+
+BinLogStats BinLog::stats() {
+    std::lock_guard<std::mutex> guard(state.lock);
+    BinLogStats s{};
+    s.entries = state.entries.load(std::memory_order_relaxed);
+    s.bytes = state.bytes.load(std::memory_order_relaxed);
+    s.dropped = state.retiredDropped;
+    for(const BinLogBuffer *buf : state.buffers)
+        s.dropped += buf->droppedCount();
+    s.threads = static_cast<uint32_t>(state.buffers.size());
+    s.sites = static_cast<uint32_t>(state.sites.size());
+    return s;
+}
+
+/**
+ * @brief give site its id; slow path, once per log statement.
+ *
+ */
+uint32_t BinLog::registerSite(BinLogSite &site, const char *argTypes) {
+    std::lock_guard<std::mutex> guard(state.lock);
+    uint32_t id = site.id.load(std::memory_order_relaxed);
+    if(id != 0)
+        return id;
+    state.sites.push_back(&site);
+    state.siteTypes.push_back(argTypes);
+    id = static_cast<uint32_t>(state.sites.size());
+    site.id.store(id, std::memory_order_relaxed);
+    return id;
+}
+
+/**
+ * @brief create the calling thread's ring; slow path, once per thread.
+ *
+ */
+BinLogBuffer *BinLog::attachThread() {
+    static thread_local BinLogThreadExit exitHook;
+    BinLogBuffer *buf = new BinLogBuffer(static_cast<uint32_t>(syscall(SYS_gettid)));
+    {
+        std::lock_guard<std::mutex> guard(state.lock);
+        state.buffers.push_back(buf);
+    }
+    exitHook.buffer = buf;
+    local = buf;
+    return buf;
+}
@@ -0,0 +1,257 @@
+/**
+ * @file clock_sync.cpp
+ * @author Ziad Fathy
+ * @brief maps board (systime) microseconds onto the Pi's CLOCK_MONOTONIC.
+ * @version 0.1
+ * @date 2025-09-15
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "../inc/clock_sync.hpp"
+#include "robot_protocol.h"
+#include <algorithm>
+#include <cmath>
+#include <time.h>
+
+static constexpr uint64_t REPLY_TIMEOUT_NS = 1000000000ULL;
+static constexpr size_t   MIN_SAMPLES      = 4;
+static constexpr double   MIN_DRIFT_SPAN_US = 1e6;     // fit drift only over >= 1 s
+
+/**
+ * @brief Construct a new ClockSync object
+ *
+ */
+ClockSync::ClockSync() : nextToken(1) {
+    this->reset();
+    this->counters = ClockSyncStats{};
+    this->counters.minDelayNs = -1;
+    this->counters.lastDelayNs = -1;
+}
+
+/**
+ * @brief forget everything learnt; call after the board reconnects (its
+ *        clock restarts at 0 on reset).
+ *
+ */
+void ClockSync::reset() {
+    for(Pending &p : this->pending)
+        p.token = 0;
+    this->count = 0;
+    this->next = 0;
+    this->lastMcuUs = 0;
+    this->haveMcu = false;
+    this->valid = false;
+    this->refMcuUs = 0.0;
+    this->refHostNs = 0.0;
+    this->slope = 1.0;
+    this->residualNs = 0.0;
+}
+
+/**
+ * @brief build a cmd_time_sync message and remember when it left.
+ *
+ * @param out   at least robot_protocol::time_sync_size bytes.
+ * @param nowNs CLOCK_MONOTONIC right before the write.
+ * @return size_t message length.
+ */
+size_t ClockSync::makeRequest(uint8_t *out, uint64_t nowNs) {
+    /* reuse the oldest slot; anything that old has timed out */
+    Pending *slot = &this->pending[0];
+    for(Pending &p : this->pending) {
+        if(p.token != 0 && nowNs - p.t1Ns > REPLY_TIMEOUT_NS) {
+            p.token = 0;
+            this->counters.timeouts++;
+        }
+        if(p.token == 0 || p.t1Ns < slot->t1Ns)
+            slot = &p;
+        if(p.token == 0)
+            break;
+    }
+    if(slot->token != 0)
+        this->counters.timeouts++;
+
+    uint32_t token = this->nextToken++;
+    if(this->nextToken == 0)
+        this->nextToken = 1;
+    slot->token = token;
+    slot->t1Ns = nowNs;
+    this->counters.requests++;
+    return robot_protocol::encode_time_sync_request(out, token);
+}
+
+/**
+ * @brief feed a board message; anything but a matching msg_time_sync is
+ *        ignored.
+ *
+ * @param nowNs CLOCK_MONOTONIC when the reply was read.
+ * @return true if it was one of our replies.
+ */
+bool ClockSync::onReply(const uint8_t *msg, size_t len, uint64_t nowNs) {
+    uint32_t token, rxUs, txUs;
+    if(!robot_protocol::decode_time_sync_reply(msg, len, &token, &rxUs, &txUs))
+        return false;
+    Pending *match = nullptr;
+    for(Pending &p : this->pending)
+        if(p.token != 0 && p.token == token)
+            match = &p;
+    if(match == nullptr)
+        return false;
+    uint64_t t1 = match->t1Ns;
+    match->token = 0;
+    this->counters.replies++;
+
+    /* a board clock that jumped back more than a few ms was reset */
+    if(this->haveMcu && static_cast<int32_t>(rxUs - static_cast<uint32_t>(this->lastMcuUs)) < -10000) {
+        this->reset();
+        this->counters.resets++;
+    }
+    uint64_t t2 = this->unwrap(rxUs);
+    uint64_t t3 = t2 + static_cast<uint32_t>(txUs - rxUs);
+    if(!this->haveMcu || t3 > this->lastMcuUs)
+        this->lastMcuUs = t3;
+    this->haveMcu = true;
+
+    int64_t delay = static_cast<int64_t>(nowNs - t1) - static_cast<int64_t>((t3 - t2) * 1000);
+    this->counters.lastDelayNs = delay;
+    if(delay < 0)
+        return true;                        // impossible ordering, drop it
+
+    Sample &s = this->window[this->next];
+    s.mcuMidUs = (static_cast<double>(t2) + static_cast<double>(t3)) / 2.0;
+    s.hostMidNs = static_cast<double>(t1) + static_cast<double>(nowNs - t1) / 2.0;
+    s.delayNs = delay;
+    this->next = (this->next + 1) % WINDOW;
+    if(this->count < WINDOW)
+        this->count++;
+    this->refit();
+    return true;
+}
+
+bool ClockSync::synced() const {
+    return this->valid;
+}
+
+/**
+ * @brief board timestamp (telemetry etc.) on the host's CLOCK_MONOTONIC.
+ *
+ * @param mcuUs board systime, within ~35 minutes of the last exchange.
+ * @return uint64_t 0 until synced().
+ */
+uint64_t ClockSync::toMonotonicNs(uint32_t mcuUs) const {
+    if(!this->valid)
+        return 0;
+    double mcu = static_cast<double>(this->unwrap(mcuUs));
+    double host = this->refHostNs + (mcu - this->refMcuUs) * 1000.0 * this->slope;
+    return host > 0.0 ? static_cast<uint64_t>(host + 0.5) : 0;
+}
+
+/**
+ * @brief host minus board time at the reference point, in ns.
+ *
+ */
+int64_t ClockSync::offsetNs() const {
+    return static_cast<int64_t>(this->refHostNs - this->refMcuUs * 1000.0);
+}
+
+/**
+ * @brief how much faster the host clock runs than the board's, in ppm.
+ *
+ */
+double ClockSync::driftPpm() const {
+    return (this->slope - 1.0) * 1e6;
+}
+
+uint64_t ClockSync::errorBoundNs() const {
+    if(!this->valid)
+        return UINT64_MAX;
+    return static_cast<uint64_t>(this->counters.minDelayNs / 2 + this->residualNs);
+}
+
+/**
+ * @brief ask fast until the filter converges, then once a second.
+ *
+ */
+uint32_t ClockSync::pollIntervalMs() const {
+    return this->count < 32 ? 100 : 1000;
+}
+
+ClockSyncStats ClockSync::stats() const {
+    return this->counters;
+}
+
+uint64_t ClockSync::monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief extend a 32-bit board time using the last one seen (wrap safe).
+ *
+ */
+uint64_t ClockSync::unwrap(uint32_t mcuUs) const {
+    if(!this->haveMcu)
+        return mcuUs;
+    int32_t delta = static_cast<int32_t>(mcuUs - static_cast<uint32_t>(this->lastMcuUs));
+    return static_cast<uint64_t>(static_cast<int64_t>(this->lastMcuUs) + delta);
+}
+
+void ClockSync::refit() {
+    if(this->count < MIN_SAMPLES)
+        return;
+
+    /* the quickest quarter of the window (at least MIN_SAMPLES) */
+    int64_t delays[WINDOW];
+    for(size_t i = 0; i < this->count; i++)
+        delays[i] = this->window[i].delayNs;
+    size_t keep = std::max(MIN_SAMPLES, this->count / 4);
+    std::nth_element(delays, delays + keep - 1, delays + this->count);
+    int64_t cutoff = delays[keep - 1];
+    this->counters.minDelayNs = *std::min_element(delays, delays + this->count);
+
+    double sumX = 0.0, sumY = 0.0;
+    size_t n = 0;
+    for(size_t i = 0; i < this->count; i++) {
+        if(this->window[i].delayNs > cutoff)
+            continue;
+        sumX += this->window[i].mcuMidUs;
+        sumY += this->window[i].hostMidNs;
+        n++;
+    }
+    double meanX = sumX / n;
+    double meanY = sumY / n;
+
+    double sxx = 0.0, sxy = 0.0;
+    double minX = INFINITY, maxX = -INFINITY;
+    for(size_t i = 0; i < this->count; i++) {
+        const Sample &s = this->window[i];
+        if(s.delayNs > cutoff)
+            continue;
+        double dx = s.mcuMidUs - meanX;
+        sxx += dx * dx;
+        sxy += dx * (s.hostMidNs - meanY);
+        minX = std::min(minX, s.mcuMidUs);
+        maxX = std::max(maxX, s.mcuMidUs);
+    }
+    /* too short a baseline for a drift estimate: keep the previous one */
+    double slope = this->slope;
+    if(maxX - minX >= MIN_DRIFT_SPAN_US && sxx > 0.0)
+        slope = sxy / sxx / 1000.0;
+
+    double ss = 0.0;
+    for(size_t i = 0; i < this->count; i++) {
+        const Sample &s = this->window[i];
+        if(s.delayNs > cutoff)
+            continue;
+        double r = s.hostMidNs - (meanY + (s.mcuMidUs - meanX) * 1000.0 * slope);
+        ss += r * r;
+    }
+
+    this->refMcuUs = meanX;
+    this->refHostNs = meanY;
+    this->slope = slope;
+    this->residualNs = std::sqrt(ss / n);
+    this->valid = true;
+}
@@ -0,0 +1,269 @@
+/**
+ * @file periodic_executor.cpp
+ * @author Ziad Fathy
+ * @brief fixed-rate loop on a timerfd: absolute deadlines, optional
+ *        SCHED_FIFO / CPU pinning, jitter, overrun and per-stage timing.
+ * @version 0.1
+ * @date 2025-09-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "../inc/periodic_executor.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+static uint64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static struct timespec to_timespec(uint64_t ns) {
+    struct timespec ts = { static_cast<time_t>(ns / 1000000000ULL), static_cast<long>(ns % 1000000000ULL) };
+    return ts;
+}
+
+/**
+ * @brief Construct a new LatencyHistogram object
+ *
+ */
+LatencyHistogram::LatencyHistogram() {
+    this->reset();
+}
+
+void LatencyHistogram::record(uint64_t ns) {
+    this->counts[bucketOf(ns)]++;
+    this->total++;
+    this->sumNs += ns;
+    this->minNs = std::min(this->minNs, ns);
+    this->maxNs = std::max(this->maxNs, ns);
+}
+
+void LatencyHistogram::reset() {
+    memset(this->counts, 0, sizeof(this->counts));
+    this->total = 0;
+    this->sumNs = 0;
+    this->minNs = UINT64_MAX;
+    this->maxNs = 0;
+}
+
+uint64_t LatencyHistogram::count() const {
+    return this->total;
+}
+
+uint64_t LatencyHistogram::min() const {
+    return this->total ? this->minNs : 0;
+}
+
+uint64_t LatencyHistogram::max() const {
+    return this->maxNs;
+}
+
+double LatencyHistogram::mean() const {
+    return this->total ? static_cast<double>(this->sumNs) / this->total : 0.0;
+}
+
+/**
+ * @brief upper edge of the bucket holding the p-th percentile (0..100),
+ *        clamped to the largest value recorded.
+ *
+ */
+uint64_t LatencyHistogram::percentile(double p) const {
+    if(this->total == 0)
+        return 0;
+    uint64_t rank = static_cast<uint64_t>(p / 100.0 * this->total);
+    if(rank >= this->total)
+        rank = this->total - 1;
+    uint64_t seen = 0;
+    for(unsigned b = 0; b < BUCKETS; b++) {
+        seen += this->counts[b];
+        if(seen > rank)
+            return std::min(bucketTop(b), this->maxNs);
+    }
+    return this->maxNs;
+}
+
+unsigned LatencyHistogram::bucketOf(uint64_t ns) {
+    if(ns < (1u << SUB_BITS))
+        return static_cast<unsigned>(ns);
+    unsigned exp = 63 - __builtin_clzll(ns);
+    unsigned sub = static_cast<unsigned>(ns >> (exp - SUB_BITS)) & ((1u << SUB_BITS) - 1);
+    return ((exp - SUB_BITS + 1) << SUB_BITS) + sub;
+}
+
+uint64_t LatencyHistogram::bucketTop(unsigned bucket) {
+    if(bucket < (1u << SUB_BITS))
+        return bucket;
+    unsigned shift = (bucket >> SUB_BITS) - 1;
+    uint64_t sub = bucket & ((1u << SUB_BITS) - 1);
+    return (((1ULL << SUB_BITS) + sub + 1) << shift) - 1;
+}
+
+/**
+ * @brief Construct a new PeriodicExecutor object; the timer is created here
+ *        and armed by run().
+ *
+ */
+PeriodicExecutor::PeriodicExecutor(const PeriodicExecutorConfig &cfg) :
+            cfg(cfg),
+            period(0),
+            timerFd(-1),
+            stopRequested(false),
+            counters{} {
+    if(cfg.rateHz == 0 || cfg.rateHz > 10000)
+        throw std::invalid_argument("loop rate must be 1 .. 10000 Hz");
+    if(cfg.priority < 0 || cfg.priority > 99)
+        throw std::invalid_argument("SCHED_FIFO priority must be 1 .. 99");
+    this->period = 1000000000ULL / cfg.rateHz;
+    this->timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if(this->timerFd < 0)
+        throw std::runtime_error("timerfd_create failed");
+}
+
+/**
+ * @brief append a stage; stages run in the order they were added.
+ *
+ */
+void PeriodicExecutor::addStage(const std::string &name, StageFn fn) {
+    this->stages.push_back(Stage{ name, std::move(fn), LatencyHistogram() });
+}
+
+/**
+ * @brief run until stop() or maxTicks ticks (0 = no limit) on the calling
+ *        thread, after applying the configured scheduling policy to it.
+ *
+ */
+void PeriodicExecutor::run(uint64_t maxTicks) {
+    this->applySchedulingPolicy();
+
+    uint64_t start = monotonic_ns() + this->period;
+    struct itimerspec its{};
+    its.it_value = to_timespec(start);
+    its.it_interval = to_timespec(this->period);
+    if(timerfd_settime(this->timerFd, TFD_TIMER_ABSTIME, &its, nullptr) != 0)
+        throw std::runtime_error("timerfd_settime failed");
+
+    uint64_t elapsed = 0;          // periods since start, run or missed
+    while(!this->stopRequested.load(std::memory_order_relaxed) &&
+          (maxTicks == 0 || this->counters.ticks < maxTicks)) {
+        uint64_t expirations;
+        ssize_t n = read(this->timerFd, &expirations, sizeof(expirations));
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n != sizeof(expirations))
+            throw std::runtime_error("timerfd read failed");
+        uint64_t wake = monotonic_ns();
+
+        elapsed += expirations;
+        TickInfo tick;
+        tick.index = elapsed - 1;
+        tick.deadlineNs = start + tick.index * this->period;
+        tick.wakeNs = wake;
+        tick.periodNs = this->period;
+        tick.missed = expirations - 1;
+
+        uint64_t jitter = wake - tick.deadlineNs;
+        this->wakeJitter.record(jitter);
+        this->counters.maxJitterNs = std::max(this->counters.maxJitterNs, jitter);
+        this->counters.missed += tick.missed;
+
+        uint64_t t = wake;
+        for(Stage &s : this->stages) {
+            s.fn(tick);
+            uint64_t done = monotonic_ns();
+            s.time.record(done - t);
+            t = done;
+        }
+        uint64_t busy = t - tick.deadlineNs;
+        this->tickTime.record(busy);
+        this->counters.maxTickNs = std::max(this->counters.maxTickNs, busy);
+        if(busy > this->period)
+            this->counters.overruns++;
+        this->counters.ticks++;
+    }
+
+    its = {};
+    timerfd_settime(this->timerFd, 0, &its, nullptr);
+}
+
+/**
+ * @brief ask run() to return after the current tick; async-signal-safe.
+ *
+ */
+void PeriodicExecutor::stop() {
+    this->stopRequested.store(true, std::memory_order_relaxed);
+}
+
+uint64_t PeriodicExecutor::periodNs() const {
+    return this->period;
+}
+
+PeriodicExecutorStats PeriodicExecutor::stats() const {
+    return this->counters;
+}
+
+const LatencyHistogram &PeriodicExecutor::jitter() const {
+    return this->wakeJitter;
+}
+
+const LatencyHistogram &PeriodicExecutor::stageTime(size_t stage) const {
+    return this->stages.at(stage).time;
+}
+
+static void print_histogram(FILE *out, const char *name, const LatencyHistogram &h) {
+    fprintf(out, "  %-12s mean %8.1f  p50 %8.1f  p99 %8.1f  p99.9 %8.1f  max %8.1f us\n", name,
+            h.mean() / 1e3, h.percentile(50) / 1e3, h.percentile(99) / 1e3, h.percentile(99.9) / 1e3, h.max() / 1e3);
+}
+
+void PeriodicExecutor::printReport(FILE *out) const {
+    fprintf(out, "%llu ticks at %u Hz: %llu periods missed, %llu overruns\n",
+            (unsigned long long)this->counters.ticks, this->cfg.rateHz,
+            (unsigned long long)this->counters.missed, (unsigned long long)this->counters.overruns);
+    print_histogram(out, "wake jitter", this->wakeJitter);
+    for(const Stage &s : this->stages)
+        print_histogram(out, s.name.c_str(), s.time);
+    print_histogram(out, "deadline-end", this->tickTime);
+}
+
+/**
+ * @brief Destroy the PeriodicExecutor object
+ *
+ */
+PeriodicExecutor::~PeriodicExecutor() {
+    if(this->timerFd >= 0)
+        close(this->timerFd);
+}
+
+/**
+ * @brief pin and/or switch the calling thread to SCHED_FIFO as configured.
+ *        Asked for and not granted is an error, not a silent downgrade.
+ *
+ */
+void PeriodicExecutor::applySchedulingPolicy() {
+    if(this->cfg.cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(this->cfg.cpu, &set);
+        if(pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+            throw std::runtime_error("cannot pin the loop to CPU " + std::to_string(this->cfg.cpu));
+    }
+    if(this->cfg.priority > 0) {
+        struct sched_param sp{};
+        sp.sched_priority = this->cfg.priority;
+        if(pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp) != 0)
+            throw std::runtime_error("SCHED_FIFO needs root or CAP_SYS_NICE");
+        /* a page fault in the loop costs more than the whole tick budget */
+        if(this->cfg.lockMemory && mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+            throw std::runtime_error("mlockall failed (RLIMIT_MEMLOCK?)");
+    }
+}
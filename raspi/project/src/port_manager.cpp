@@ -0,0 +1,423 @@
+/**
+ * @file port_manager.cpp
+ * @author Ziad Fathy
+ * @brief several framed UART links served from one epoll loop.
+ * @version 0.1
+ * @date 2025-09-12
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "../inc/port_manager.hpp"
+#include <algorithm>
+#include <sys/epoll.h>
+
+static constexpr size_t TX_IOV_MAX = 16;
+/* one read always holds the largest frame, so a datagram backend never has to cut one */
+static constexpr size_t RX_READ_MIN = frame_codec::max_encoded_size(UARTPortManager::MAX_FRAME);
+static constexpr size_t RX_BUFFER = 1024;
+static_assert(RX_BUFFER >= RX_READ_MIN, "read buffer must hold a whole frame");
+
+UARTPortManager::Port::Port(std::unique_ptr<Transport> link) :
+            link(std::move(link)),
+            device(this->link->describe()),
+            connected(false),
+            connecting(false),
+            everConnected(false),
+            writeArmed(false),
+            txOffset(0),
+            failures(0),
+            retryAt(Clock::now()),
+            counters{} {}
+
+/**
+ * @brief Construct a new UARTPortManager object
+ *
+ * @param onFrame called with every valid frame, from inside run().
+ * @param onState optional, called on every connect / disconnect.
+ * @param cfg     scheduling quanta, queue limit, backoff range and connect timeout.
+ */
+UARTPortManager::UARTPortManager(FrameFn onFrame, StateFn onState, const PortManagerConfig &cfg) :
+            onFrame(std::move(onFrame)),
+            onState(std::move(onState)),
+            cfg(cfg),
+            epollFd(-1),
+            jitter(static_cast<unsigned>(Clock::now().time_since_epoch().count())) {
+    this->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if(this->epollFd < 0)
+        throw std::runtime_error("epoll_create1 failed");
+}
+
+/**
+ * @brief register a link by URI (see Transport::fromUri).
+ *
+ */
+UARTPortManager::PortId UARTPortManager::addPort(const std::string &uri) {
+    return this->addPort(Transport::fromUri(uri));
+}
+
+UARTPortManager::PortId UARTPortManager::addPort(const std::string &device, speed_t baud) {
+    return this->addPort(std::unique_ptr<Transport>(new UART(device, baud)));
+}
+
+/**
+ * @brief register a link and try to open it right away; a link that is
+ *        not there yet is simply retried from run().
+ *
+ * @return PortId index used by every other call.
+ */
+UARTPortManager::PortId UARTPortManager::addPort(std::unique_ptr<Transport> link) {
+    this->ports.emplace_back(new Port(std::move(link)));
+    PortId id = this->ports.size() - 1;
+    this->connect(id);
+    return id;
+}
+
+/**
+ * @brief queue one payload as a frame on a port.
+ *
+ * @return false when the port is down or its queue is full.
+ */
+bool UARTPortManager::send(PortId id, const uint8_t *payload, size_t len) {
+    Port &port = *this->ports.at(id);
+    size_t queued = port.counters.txQueuedBytes;
+    if(!port.connected || len > MAX_FRAME ||
+       queued + frame_codec::max_encoded_size(len) > this->cfg.txQueueLimit) {
+        port.counters.txDropped++;
+        return false;
+    }
+    std::string frame(frame_codec::max_encoded_size(len), '\0');
+    frame.resize(frame_codec::encode_frame(payload, len,
+                                           reinterpret_cast<uint8_t *>(&frame[0]), frame.size()));
+    port.counters.txQueuedBytes += frame.size();
+    port.txFrames.push_back(std::move(frame));
+    this->updateInterest(id);
+    return true;
+}
+
+/**
+ * @brief queue the same payload on every connected port.
+ *
+ * @return size_t ports that accepted it.
+ */
+size_t UARTPortManager::broadcast(const uint8_t *payload, size_t len) {
+    size_t accepted = 0;
+    for(PortId id = 0; id < this->ports.size(); id++)
+        if(this->ports[id]->connected && this->send(id, payload, len))
+            accepted++;
+    return accepted;
+}
+
+/**
+ * @brief one loop turn: due reconnects, then whatever epoll reports.
+ *
+ * @param maxWaitMs upper bound on blocking, shortened by pending retries.
+ */
+void UARTPortManager::run(int maxWaitMs) {
+    Clock::time_point now = Clock::now();
+    int timeout = maxWaitMs;
+    for(PortId id = 0; id < this->ports.size(); id++) {
+        Port &port = *this->ports[id];
+        if(port.connected)
+            continue;
+        if(port.retryAt <= now) {
+            if(port.connecting)
+                this->abortConnect(id);             // timed out, schedules the retry
+            else
+                this->connect(id);
+        }
+        if(!port.connected) {
+            auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(port.retryAt - now).count() + 1;
+            timeout = timeout < 0 ? static_cast<int>(wait) : std::min<int>(timeout, wait);
+        }
+    }
+
+    struct epoll_event events[32];
+    int n = epoll_wait(this->epollFd, events, 32, timeout);
+    for(int i = 0; i < n; i++) {
+        PortId id = events[i].data.u64;
+        if(this->ports[id]->connecting) {
+            this->finishConnect(id);                // EPOLLOUT, or ERR/HUP on refusal
+            continue;
+        }
+        if(!this->ports[id]->connected)
+            continue;                                   // dropped earlier this turn
+        if(events[i].events & EPOLLIN)
+            this->serviceRead(id);
+        if(this->ports[id]->connected && (events[i].events & EPOLLOUT))
+            this->serviceWrite(id);
+        if(this->ports[id]->connected && (events[i].events & (EPOLLHUP | EPOLLERR)))
+            this->disconnect(id);
+    }
+}
+
+/**
+ * @brief the manager's epoll descriptor; it polls readable whenever run(0)
+ *        has work, so the manager can sit inside another event loop.
+ *
+ * @return int
+ */
+int UARTPortManager::getFd() const {
+    return this->epollFd;
+}
+
+size_t UARTPortManager::portCount() const {
+    return this->ports.size();
+}
+
+const std::string &UARTPortManager::device(PortId id) const {
+    return this->ports.at(id)->device;
+}
+
+PortStats UARTPortManager::stats(PortId id) const {
+    return this->ports.at(id)->counters;
+}
+
+/**
+ * @brief change a connected port's line rate; a half received frame is
+ *        dropped with the old rate.
+ *
+ * @return false when the port is down or its backend has no line rate.
+ */
+bool UARTPortManager::setBaud(PortId id, long baud) {
+    Port &port = *this->ports.at(id);
+    if(!port.connected || !port.link->setBaud(baud))
+        return false;
+    port.decoder.reset();
+    return true;
+}
+
+/**
+ * @brief open a port; a socket connect still in flight is parked on
+ *        EPOLLOUT with a deadline in retryAt.
+ *
+ */
+void UARTPortManager::connect(PortId id) {
+    Port &port = *this->ports[id];
+    bool open;
+    try {
+        open = port.link->startOpen();
+        port.link->setNonBlocking(true);
+        if(open)
+            tcflush(port.link->getFd(), TCIOFLUSH);
+    } catch(const std::runtime_error &) {
+        port.link->closePort();
+        port.counters.connectFailures++;
+        this->scheduleRetry(port);
+        return;
+    }
+
+    struct epoll_event ev{};
+    ev.events = open ? EPOLLIN : EPOLLOUT;
+    ev.data.u64 = id;
+    if(epoll_ctl(this->epollFd, EPOLL_CTL_ADD, port.link->getFd(), &ev) != 0) {
+        port.link->closePort();
+        port.counters.connectFailures++;
+        this->scheduleRetry(port);
+        return;
+    }
+    if(!open) {
+        port.connecting = true;
+        port.retryAt = Clock::now() + std::chrono::milliseconds(this->cfg.connectTimeoutMs);
+        return;
+    }
+    this->markConnected(id);
+}
+
+/**
+ * @brief a pending connect polled writable: SO_ERROR decides.
+ *
+ */
+void UARTPortManager::finishConnect(PortId id) {
+    Port &port = *this->ports[id];
+    try {
+        port.link->finishOpen();
+    } catch(const std::runtime_error &) {
+        this->abortConnect(id);
+        return;
+    }
+    struct epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = id;
+    epoll_ctl(this->epollFd, EPOLL_CTL_MOD, port.link->getFd(), &ev);
+    port.connecting = false;
+    this->markConnected(id);
+}
+
+void UARTPortManager::abortConnect(PortId id) {
+    Port &port = *this->ports[id];
+    epoll_ctl(this->epollFd, EPOLL_CTL_DEL, port.link->getFd(), nullptr);
+    port.link->closePort();
+    port.connecting = false;
+    port.counters.connectFailures++;
+    this->scheduleRetry(port);
+}
+
+void UARTPortManager::markConnected(PortId id) {
+    Port &port = *this->ports[id];
+    if(port.everConnected)
+        port.counters.reconnects++;
+    port.everConnected = true;
+    port.connected = true;
+    port.writeArmed = false;
+    port.decoder = frame_codec::frame_decoder<MAX_FRAME>();
+    port.counters.connected = true;
+    if(this->onState)
+        this->onState(id, true);
+}
+
+void UARTPortManager::disconnect(PortId id) {
+    Port &port = *this->ports[id];
+    epoll_ctl(this->epollFd, EPOLL_CTL_DEL, port.link->getFd(), nullptr);
+    port.link->closePort();
+    port.connected = false;
+    port.counters.connected = false;
+    port.counters.txDropped += port.txFrames.size();
+    port.txFrames.clear();
+    port.txOffset = 0;
+    port.counters.txQueuedBytes = 0;
+    this->scheduleRetry(port);
+    if(this->onState)
+        this->onState(id, false);
+}
+
+/**
+ * @brief min * 2^failures capped at max, then +-25 % so a fleet of boards
+ *        behind one hub does not retry in lockstep.
+ *
+ */
+void UARTPortManager::scheduleRetry(Port &port) {
+    uint64_t delay = this->cfg.minBackoffMs;
+    for(unsigned i = 0; i < port.failures && delay < this->cfg.maxBackoffMs; i++)
+        delay *= 2;
+    delay = std::min<uint64_t>(delay, this->cfg.maxBackoffMs);
+    port.failures++;
+    port.counters.backoffMs = static_cast<uint32_t>(delay);
+    uint64_t spread = delay / 2;
+    if(spread > 0)
+        delay = delay - delay / 4 + this->jitter() % spread;
+    port.retryAt = Clock::now() + std::chrono::milliseconds(delay);
+}
+
+void UARTPortManager::serviceRead(PortId id) {
+    Port &port = *this->ports[id];
+    uint8_t buf[RX_BUFFER];
+    size_t budget = this->cfg.rxQuantum;
+    while(budget > 0) {
+        size_t n;
+        try {
+            n = port.link->readInto(buf, std::max(std::min(budget, sizeof(buf)), RX_READ_MIN));
+        } catch(const std::runtime_error &) {
+            this->disconnect(id);
+            return;
+        }
+        port.counters.rxTruncated = port.link->truncatedInput();
+        if(n == 0)
+            break;
+        budget -= std::min(budget, n);
+        port.counters.bytesRx += n;
+
+        const uint8_t *p = buf;
+        while(n > 0) {
+            size_t used = 0;
+            frame_codec::decode_status st = port.decoder.push(p, n, &used);
+            p += used;
+            n -= used;
+            switch(st) {
+                case frame_codec::decode_status::frame:
+                    port.counters.framesRx++;
+                    port.failures = 0;          // proof of life resets the backoff
+                    if(this->onFrame)
+                        this->onFrame(id, port.decoder.data(), port.decoder.size());
+                    if(!port.connected)         // callback may have sent into a dead port
+                        return;
+                    break;
+                case frame_codec::decode_status::crc_error:
+                    port.counters.crcErrors++;
+                    break;
+                case frame_codec::decode_status::malformed:
+                case frame_codec::decode_status::overflow:
+                    port.counters.malformed++;
+                    break;
+                case frame_codec::decode_status::pending:
+                    break;
+            }
+        }
+    }
+}
+
+void UARTPortManager::serviceWrite(PortId id) {
+    Port &port = *this->ports[id];
+    size_t budget = this->cfg.txQuantum;
+    while(budget > 0 && !port.txFrames.empty()) {
+        struct iovec iov[TX_IOV_MAX];
+        int cnt = 0;
+        size_t planned = 0;
+        for(auto it = port.txFrames.begin(); it != port.txFrames.end() && cnt < (int)TX_IOV_MAX && planned < budget; ++it) {
+            size_t skip = cnt == 0 ? port.txOffset : 0;
+            iov[cnt].iov_base = const_cast<char *>(it->data()) + skip;
+            iov[cnt].iov_len = it->size() - skip;    // whole frames: datagram links keep boundaries
+            planned += iov[cnt].iov_len;
+            cnt++;
+        }
+
+        ssize_t n;
+        try {
+            n = port.link->writeVector(iov, cnt);
+        } catch(const std::runtime_error &) {
+            this->disconnect(id);
+            return;
+        }
+        if(n == 0)
+            break;
+        budget -= std::min<size_t>(budget, n);
+        port.counters.bytesTx += n;
+        port.counters.txQueuedBytes -= n;
+
+        size_t left = n;
+        while(left > 0) {
+            size_t rest = port.txFrames.front().size() - port.txOffset;
+            if(left < rest) {
+                port.txOffset += left;
+                break;
+            }
+            left -= rest;
+            port.txFrames.pop_front();
+            port.txOffset = 0;
+            port.counters.framesTx++;
+        }
+        if(static_cast<size_t>(n) < planned)
+            break;                          // driver buffer full, wait for EPOLLOUT
+    }
+    this->updateInterest(id);
+}
+
+/**
+ * @brief ask for EPOLLOUT only while frames are queued.
+ *
+ */
+void UARTPortManager::updateInterest(PortId id) {
+    Port &port = *this->ports[id];
+    bool want = !port.txFrames.empty();
+    if(!port.connected || want == port.writeArmed)
+        return;
+    struct epoll_event ev{};
+    uint32_t events = EPOLLIN;
+    if(want)
+        events |= EPOLLOUT;
+    ev.events = events;
+    ev.data.u64 = id;
+    epoll_ctl(this->epollFd, EPOLL_CTL_MOD, port.link->getFd(), &ev);
+    port.writeArmed = want;
+}
+
+/**
+ * @brief Destroy the UARTPortManager object
+ *
+ */
+UARTPortManager::~UARTPortManager() {
+    this->ports.clear();
+    if(this->epollFd >= 0)
+        close(this->epollFd);
+}
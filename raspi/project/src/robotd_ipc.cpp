@@ -0,0 +1,180 @@
+/**
+ * @file robotd_ipc.cpp
+ * @author Ziad Fathy
+ * @brief local client API of robotd (the daemon that owns the serial port).
+ * @version 0.1
+ * @date 2025-09-14
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "../inc/robotd_ipc.hpp"
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * @brief Construct a new RobotdClient object and connect to the daemon.
+ *
+ * @param socketPath robotd -s argument.
+ */
+RobotdClient::RobotdClient(const std::string &socketPath) : fd(-1) {
+    struct sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if(socketPath.size() >= sizeof(addr.sun_path))
+        throw std::invalid_argument("socket path too long");
+    memcpy(addr.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    this->fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if(this->fd < 0)
+        throw std::runtime_error("socket failed");
+    if(connect(this->fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0) {
+        close(this->fd);
+        throw std::runtime_error("cannot connect to robotd at " + socketPath);
+    }
+}
+
+/**
+ * @brief map the daemon's telemetry ring (memfd passed with SCM_RIGHTS).
+ *
+ * @return std::unique_ptr<TelemetryRingReader> independent of this client
+ *         once returned.
+ */
+std::unique_ptr<TelemetryRingReader> RobotdClient::attach() {
+    uint8_t req = ROBOTD_ATTACH;
+    if(send(this->fd, &req, 1, MSG_NOSIGNAL) != 1)
+        throw std::runtime_error("robotd attach failed");
+
+    uint8_t reply[ROBOTD_MAX_MESSAGE];
+    for(;;) {
+        int ringFd = -1;
+        ssize_t n = this->receive(reply, sizeof(reply), &ringFd, 1000);
+        if(n < 0)
+            throw std::runtime_error("robotd did not answer");
+        if(reply[0] == ROBOTD_EVENT) {
+            this->events.emplace_back(reply + 1, reply + n);
+            continue;
+        }
+        if(reply[0] != ROBOTD_ATTACH || n < 2 || reply[1] != ROBOTD_OK || ringFd < 0) {
+            if(ringFd >= 0)
+                close(ringFd);
+            throw std::runtime_error("robotd refused attach");
+        }
+        std::unique_ptr<TelemetryRingReader> reader;
+        try {
+            reader.reset(new TelemetryRingReader(ringFd));
+        } catch(...) {
+            close(ringFd);
+            throw;
+        }
+        close(ringFd);
+        return reader;
+    }
+}
+
+/**
+ * @brief forward one robot_protocol message to the board.
+ *
+ * @return RobotdStatus whether robotd queued it on the port.
+ */
+RobotdStatus RobotdClient::command(const uint8_t *msg, size_t len) {
+    uint8_t req[ROBOTD_MAX_MESSAGE];
+    if(len + 1 > sizeof(req))
+        return ROBOTD_BAD_REQUEST;
+    req[0] = ROBOTD_COMMAND;
+    memcpy(req + 1, msg, len);
+    if(send(this->fd, req, len + 1, MSG_NOSIGNAL) != static_cast<ssize_t>(len + 1))
+        throw std::runtime_error("robotd connection lost");
+
+    uint8_t reply[ROBOTD_MAX_MESSAGE];
+    for(;;) {
+        ssize_t n = this->receive(reply, sizeof(reply), nullptr, 1000);
+        if(n < 0)
+            throw std::runtime_error("robotd did not answer");
+        if(reply[0] == ROBOTD_EVENT) {
+            this->events.emplace_back(reply + 1, reply + n);
+            continue;
+        }
+        if(reply[0] == ROBOTD_RESULT && n >= 2)
+            return static_cast<RobotdStatus>(reply[1]);
+    }
+}
+
+/**
+ * @brief next board message robotd fanned out (pong, ...).
+ *
+ * @param timeoutMs -1 blocks.
+ * @return false on timeout.
+ */
+bool RobotdClient::nextEvent(std::vector<uint8_t> &msg, int timeoutMs) {
+    uint8_t buf[ROBOTD_MAX_MESSAGE];
+    while(this->events.empty()) {
+        ssize_t n = this->receive(buf, sizeof(buf), nullptr, timeoutMs);
+        if(n < 0)
+            return false;
+        if(buf[0] == ROBOTD_EVENT)
+            this->events.emplace_back(buf + 1, buf + n);
+    }
+    msg = std::move(this->events.front());
+    this->events.pop_front();
+    return true;
+}
+
+int RobotdClient::getFd() const {
+    return this->fd;
+}
+
+/**
+ * @brief one message, plus a passed descriptor if the caller wants one.
+ *
+ * @return ssize_t length, -1 on timeout; throws when robotd went away.
+ */
+ssize_t RobotdClient::receive(uint8_t *buf, size_t len, int *passedFd, int timeoutMs) {
+    struct pollfd pfd = { this->fd, POLLIN, 0 };
+    if(poll(&pfd, 1, timeoutMs) <= 0)
+        return -1;
+
+    struct iovec iov = { buf, len };
+    union {
+        struct cmsghdr align;
+        char data[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data;
+    msg.msg_controllen = sizeof(control.data);
+
+    ssize_t n;
+    do {
+        n = recvmsg(this->fd, &msg, MSG_CMSG_CLOEXEC);
+    } while(n < 0 && errno == EINTR);
+    if(n <= 0)
+        throw std::runtime_error("robotd connection lost");
+
+    for(struct cmsghdr *c = CMSG_FIRSTHDR(&msg); c != nullptr; c = CMSG_NXTHDR(&msg, c)) {
+        if(c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS) {
+            int received;
+            memcpy(&received, CMSG_DATA(c), sizeof(received));
+            if(passedFd != nullptr)
+                *passedFd = received;
+            else
+                close(received);
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief Destroy the RobotdClient object
+ *
+ */
+RobotdClient::~RobotdClient() {
+    if(this->fd >= 0)
+        close(this->fd);
+}
@@ -0,0 +1,453 @@
+/**
+ * @file socket_transport.cpp
+ * @author Ziad Fathy
+ * @brief TCP, Unix, UDP and SocketCAN backends of the Transport interface.
+ * @version 0.1
+ * @date 2025-09-13
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "../inc/socket_transport.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static constexpr size_t DGRAM_SLOT  = 1024;    // > max_encoded_size(MAX_FRAME)
+static constexpr unsigned DGRAM_BATCH = 16;
+static constexpr unsigned CAN_BATCH   = 64;
+static constexpr int CONNECT_TIMEOUT_MS = 3000;   // per address, blocking openPort() only
+
+static bool would_block(int err) {
+    return err == EAGAIN || err == EWOULDBLOCK;
+}
+
+/**
+ * @brief resolve a TCP or UDP peer; done once per transport so a reconnect
+ *        never waits on the resolver.
+ *
+ */
+static std::vector<InetAddress> resolve_inet(const std::string &host, const std::string &port, int type) {
+    struct addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = type;
+    struct addrinfo *res = nullptr;
+    if(getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0)
+        throw std::runtime_error("cannot resolve " + host);
+    std::vector<InetAddress> out;
+    for(struct addrinfo *ai = res; ai != nullptr; ai = ai->ai_next) {
+        InetAddress a{};
+        a.family = ai->ai_family;
+        a.type = ai->ai_socktype;
+        a.protocol = ai->ai_protocol;
+        a.len = ai->ai_addrlen;
+        memcpy(&a.addr, ai->ai_addr, ai->ai_addrlen);
+        out.push_back(a);
+    }
+    freeaddrinfo(res);
+    return out;
+}
+
+static struct sockaddr_un unix_address(const std::string &path) {
+    struct sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if(path.size() >= sizeof(addr.sun_path))
+        throw std::invalid_argument("socket path too long");
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return addr;
+}
+
+/* --------- SocketTransport --------- */
+SocketTransport::SocketTransport() : fd(-1) {}
+
+void SocketTransport::closePort() {
+    if(this->fd >= 0)
+        close(this->fd);
+    this->fd = -1;
+}
+
+int SocketTransport::getFd() const {
+    return this->fd;
+}
+
+/**
+ * @brief stream read; an orderly shutdown by the peer counts as a failure
+ *        so event loops reconnect.
+ *
+ */
+size_t SocketTransport::readInto(uint8_t *buf, size_t len) {
+    ssize_t n;
+    do {
+        n = recv(this->fd, buf, len, 0);
+    } while(n < 0 && errno == EINTR);
+    if(n < 0 && would_block(errno))
+        return 0;
+    if(n == 0)
+        throw std::runtime_error("connection closed");
+    if(n < 0)
+        throw std::runtime_error("socket read failed");
+    return static_cast<size_t>(n);
+}
+
+ssize_t SocketTransport::writeVector(const struct iovec *iov, int iovcnt) {
+    struct msghdr msg{};
+    msg.msg_iov = const_cast<struct iovec *>(iov);
+    msg.msg_iovlen = iovcnt;
+    ssize_t n;
+    do {
+        n = sendmsg(this->fd, &msg, MSG_NOSIGNAL);
+    } while(n < 0 && errno == EINTR);
+    if(n < 0 && would_block(errno))
+        return 0;
+    if(n < 0)
+        throw std::runtime_error("socket write failed");
+    return n;
+}
+
+SocketTransport::~SocketTransport() {
+    this->closePort();
+}
+
+/* --------- TcpTransport --------- */
+TcpTransport::TcpTransport(const std::string &host, const std::string &port) :
+            host(host),
+            port(port),
+            addresses(resolve_inet(host, port, SOCK_STREAM)),
+            next(0) {}
+
+/**
+ * @brief blocking open for single-link tools: startOpen() with a bounded
+ *        wait per address.
+ *
+ */
+void TcpTransport::openPort() {
+    for(size_t tried = 1; ; tried++) {
+        try {
+            if(!this->startOpen()) {
+                struct pollfd pfd = {this->fd, POLLOUT, 0};
+                int r;
+                do {
+                    r = poll(&pfd, 1, CONNECT_TIMEOUT_MS);
+                } while(r < 0 && errno == EINTR);
+                if(r <= 0) {
+                    this->next = (this->next + 1) % this->addresses.size();
+                    throw std::runtime_error("connect to " + this->host + ":" + this->port + " timed out");
+                }
+                this->finishOpen();
+            }
+            this->setNonBlocking(false);
+            return;
+        } catch(const std::runtime_error &) {
+            this->closePort();
+            if(tried >= this->addresses.size())
+                throw;
+        }
+    }
+}
+
+/**
+ * @brief non-blocking connect, starting at the address after the last one
+ *        that failed.
+ *
+ * @return false: EINPROGRESS, finishOpen() once the fd polls writable.
+ */
+bool TcpTransport::startOpen() {
+    this->closePort();
+    for(size_t tried = 0; tried < this->addresses.size();
+        tried++, this->next = (this->next + 1) % this->addresses.size()) {
+        const InetAddress &a = this->addresses[this->next];
+        this->fd = socket(a.family, a.type | SOCK_NONBLOCK | SOCK_CLOEXEC, a.protocol);
+        if(this->fd < 0)
+            continue;
+        if(connect(this->fd, reinterpret_cast<const struct sockaddr *>(&a.addr), a.len) == 0) {
+            this->finishOpen();
+            return true;
+        }
+        if(errno == EINPROGRESS)
+            return false;
+        this->closePort();
+    }
+    throw std::runtime_error("cannot connect to " + this->host + ":" + this->port);
+}
+
+void TcpTransport::finishOpen() {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if(getsockopt(this->fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0 || err != 0) {
+        this->next = (this->next + 1) % this->addresses.size();
+        throw std::runtime_error("cannot connect to " + this->host + ":" + this->port);
+    }
+    /* frames are small and latency bound, never wait for Nagle */
+    int one = 1;
+    setsockopt(this->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+std::string TcpTransport::describe() const {
+    return "tcp://" + this->host + ":" + this->port;
+}
+
+/* --------- UnixTransport --------- */
+UnixTransport::UnixTransport(const std::string &path) : path(path) {}
+
+void UnixTransport::openPort() {
+    this->closePort();
+    struct sockaddr_un addr = unix_address(this->path);
+    this->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(this->fd < 0)
+        throw std::runtime_error("socket failed");
+    if(connect(this->fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0) {
+        this->closePort();
+        throw std::runtime_error("cannot connect to " + this->path);
+    }
+}
+
+std::string UnixTransport::describe() const {
+    return "unix://" + this->path;
+}
+
+/* --------- DatagramTransport --------- */
+DatagramTransport::DatagramTransport(bool unixDomain, const std::string &hostOrPath, const std::string &port) :
+            unixDomain(unixDomain),
+            truncated(0),
+            host(hostOrPath),
+            port(port),
+            addresses(unixDomain ? std::vector<InetAddress>() : resolve_inet(hostOrPath, port, SOCK_DGRAM)) {}
+
+void DatagramTransport::openPort() {
+    this->closePort();
+    if(!this->unixDomain) {
+        for(const InetAddress &a : this->addresses) {
+            this->fd = socket(a.family, a.type | SOCK_CLOEXEC, a.protocol);
+            if(this->fd >= 0 && connect(this->fd, reinterpret_cast<const struct sockaddr *>(&a.addr), a.len) == 0)
+                return;
+            this->closePort();
+        }
+        throw std::runtime_error("cannot connect to " + this->host + ":" + this->port);
+    }
+    struct sockaddr_un addr = unix_address(this->host);
+    this->fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if(this->fd < 0)
+        throw std::runtime_error("socket failed");
+    /* autobind an abstract address so the peer has somewhere to reply */
+    sa_family_t family = AF_UNIX;
+    if(bind(this->fd, reinterpret_cast<struct sockaddr *>(&family), sizeof(family)) != 0 ||
+       connect(this->fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0) {
+        this->closePort();
+        throw std::runtime_error("cannot connect to " + this->host);
+    }
+}
+
+/**
+ * @brief pull several datagrams with one recvmmsg() and pack them back to
+ *        back; the frame decoder downstream only sees a byte stream.
+ *
+ */
+size_t DatagramTransport::readInto(uint8_t *buf, size_t len) {
+    unsigned slots = static_cast<unsigned>(std::min<size_t>(DGRAM_BATCH, std::max<size_t>(len / DGRAM_SLOT, 1)));
+    size_t slot = len / slots;
+    struct mmsghdr msgs[DGRAM_BATCH];
+    struct iovec iov[DGRAM_BATCH];
+    memset(msgs, 0, sizeof(msgs));
+    for(unsigned i = 0; i < slots; i++) {
+        iov[i].iov_base = buf + i * slot;
+        iov[i].iov_len = slot;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int n;
+    do {
+        n = recvmmsg(this->fd, msgs, slots, MSG_WAITFORONE, nullptr);
+    } while(n < 0 && errno == EINTR);
+    if(n < 0 && would_block(errno))
+        return 0;
+    if(n < 0)
+        throw std::runtime_error("socket read failed");
+
+    size_t out = 0;
+    for(int i = 0; i < n; i++) {
+        if(msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+            this->truncated++;                  // the rest of it is gone; never pass on half a frame
+            continue;
+        }
+        memmove(buf + out, iov[i].iov_base, msgs[i].msg_len);
+        out += msgs[i].msg_len;
+    }
+    return out;
+}
+
+/**
+ * @brief one datagram per iovec, all of them in one sendmmsg().
+ *
+ * @return ssize_t bytes of the datagrams that went out (never a fraction
+ *                 of one).
+ */
+ssize_t DatagramTransport::writeVector(const struct iovec *iov, int iovcnt) {
+    struct mmsghdr msgs[DGRAM_BATCH];
+    unsigned count = static_cast<unsigned>(std::min<int>(iovcnt, DGRAM_BATCH));
+    memset(msgs, 0, sizeof(msgs));
+    for(unsigned i = 0; i < count; i++) {
+        msgs[i].msg_hdr.msg_iov = const_cast<struct iovec *>(&iov[i]);
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    int n;
+    do {
+        n = sendmmsg(this->fd, msgs, count, MSG_NOSIGNAL);
+    } while(n < 0 && errno == EINTR);
+    if(n < 0 && would_block(errno))
+        return 0;
+    if(n < 0)
+        throw std::runtime_error("socket write failed");
+    ssize_t bytes = 0;
+    for(int i = 0; i < n; i++)
+        bytes += iov[i].iov_len;
+    return bytes;
+}
+
+uint64_t DatagramTransport::truncatedInput() const {
+    return this->truncated;
+}
+
+std::string DatagramTransport::describe() const {
+    return this->unixDomain ? "unixgram://" + this->host : "udp://" + this->host + ":" + this->port;
+}
+
+/* --------- CanTransport --------- */
+CanTransport::CanTransport(const std::string &ifname, uint32_t txId, uint32_t rxId) :
+            ifname(ifname),
+            txId(txId > CAN_SFF_MASK ? (txId & CAN_EFF_MASK) | CAN_EFF_FLAG : txId),
+            rxId(rxId > CAN_SFF_MASK ? (rxId & CAN_EFF_MASK) | CAN_EFF_FLAG : rxId) {}
+
+void CanTransport::openPort() {
+    this->closePort();
+    unsigned index = if_nametoindex(this->ifname.c_str());
+    if(index == 0)
+        throw std::runtime_error("no CAN interface " + this->ifname);
+    this->fd = socket(PF_CAN, SOCK_RAW | SOCK_CLOEXEC, CAN_RAW);
+    if(this->fd < 0)
+        throw std::runtime_error("CAN socket failed");
+
+    /* only our board's identifier reaches this socket */
+    struct can_filter filter;
+    filter.can_id = this->rxId;
+    filter.can_mask = (this->rxId & CAN_EFF_FLAG) ? (CAN_EFF_FLAG | CAN_EFF_MASK) : (CAN_EFF_FLAG | CAN_SFF_MASK);
+    setsockopt(this->fd, SOL_CAN_RAW, CAN_RAW_FILTER, &filter, sizeof(filter));
+
+    struct sockaddr_can addr{};
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = static_cast<int>(index);
+    if(bind(this->fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0) {
+        this->closePort();
+        throw std::runtime_error("cannot bind " + this->ifname);
+    }
+}
+
+size_t CanTransport::readInto(uint8_t *buf, size_t len) {
+    if(len < CAN_MAX_DLEN)
+        throw std::invalid_argument("CAN read buffer smaller than one frame");
+    unsigned count = static_cast<unsigned>(std::min<size_t>(CAN_BATCH, len / CAN_MAX_DLEN));
+    struct can_frame frames[CAN_BATCH];
+    struct iovec iov[CAN_BATCH];
+    struct mmsghdr msgs[CAN_BATCH];
+    memset(msgs, 0, sizeof(msgs));
+    for(unsigned i = 0; i < count; i++) {
+        iov[i].iov_base = &frames[i];
+        iov[i].iov_len = sizeof(frames[i]);
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int n;
+    do {
+        n = recvmmsg(this->fd, msgs, count, MSG_WAITFORONE, nullptr);
+    } while(n < 0 && errno == EINTR);
+    if(n < 0 && would_block(errno))
+        return 0;
+    if(n < 0)
+        throw std::runtime_error("CAN read failed");
+
+    size_t out = 0;
+    for(int i = 0; i < n; i++) {
+        if(frames[i].can_id & (CAN_RTR_FLAG | CAN_ERR_FLAG))
+            continue;
+        size_t dlc = std::min<size_t>(frames[i].can_dlc, CAN_MAX_DLEN);
+        memcpy(buf + out, frames[i].data, dlc);
+        out += dlc;
+    }
+    return out;
+}
+
+/**
+ * @brief pack the iovecs into full 8-byte frames and send them as one burst.
+ *
+ * @return ssize_t bytes carried by the frames the kernel took; a full
+ *                 device queue (ENOBUFS) just ends the burst early.
+ */
+ssize_t CanTransport::writeVector(const struct iovec *iov, int iovcnt) {
+    struct can_frame frames[CAN_BATCH];
+    unsigned count = 0;
+    size_t total = 0;
+    for(int i = 0; i < iovcnt && count < CAN_BATCH; i++) {
+        const uint8_t *p = static_cast<const uint8_t *>(iov[i].iov_base);
+        size_t left = iov[i].iov_len;
+        while(left > 0) {
+            if(count == 0 || frames[count - 1].can_dlc == CAN_MAX_DLEN) {
+                if(count == CAN_BATCH)
+                    break;
+                memset(&frames[count], 0, sizeof(frames[count]));
+                frames[count].can_id = this->txId;
+                count++;
+            }
+            struct can_frame &f = frames[count - 1];
+            size_t take = std::min<size_t>(left, CAN_MAX_DLEN - f.can_dlc);
+            memcpy(f.data + f.can_dlc, p, take);
+            f.can_dlc += take;
+            p += take;
+            left -= take;
+            total += take;
+        }
+    }
+
+    struct iovec fiov[CAN_BATCH];
+    struct mmsghdr msgs[CAN_BATCH];
+    memset(msgs, 0, sizeof(msgs));
+    for(unsigned i = 0; i < count; i++) {
+        fiov[i].iov_base = &frames[i];
+        fiov[i].iov_len = sizeof(frames[i]);
+        msgs[i].msg_hdr.msg_iov = &fiov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    int n;
+    do {
+        n = sendmmsg(this->fd, msgs, count, 0);
+    } while(n < 0 && errno == EINTR);
+    if(n < 0 && (would_block(errno) || errno == ENOBUFS))
+        return 0;
+    if(n < 0)
+        throw std::runtime_error("CAN write failed");
+    if(static_cast<unsigned>(n) == count)
+        return total;
+    ssize_t bytes = 0;
+    for(int i = 0; i < n; i++)
+        bytes += frames[i].can_dlc;
+    return bytes;
+}
+
+std::string CanTransport::describe() const {
+    char ids[48];
+    snprintf(ids, sizeof(ids), "?tx=0x%X&rx=0x%X", this->txId & CAN_EFF_MASK, this->rxId & CAN_EFF_MASK);
+    return "can://" + this->ifname + ids;
+}
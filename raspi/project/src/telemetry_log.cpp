@@ -0,0 +1,557 @@
+/**
+ * @file telemetry_log.cpp
+ * @author Ziad Fathy
+ * @brief append-only, memory-mapped log of board link traffic: chunked,
+ *        CRC checked, time indexed.
+ * @version 0.1
+ * @date 2025-09-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "../inc/telemetry_log.hpp"
+#include "frame_codec.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+
+static constexpr uint32_t MIN_CHUNK_SIZE = 64 * 1024;
+
+static inline uint64_t record_size(size_t payloadLen) {
+    return (sizeof(TelemetryLogRecord) + payloadLen + 7) & ~static_cast<uint64_t>(7);
+}
+
+static uint64_t clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief Construct a new TelemetryLogWriter object; an existing file at
+ *        path is replaced.
+ *
+ * @param chunkSize a multiple of the page size, at least 64 KiB. Larger
+ *                  chunks mean fewer turnovers, smaller ones less lost to a
+ *                  crash and a finer seek.
+ */
+TelemetryLogWriter::TelemetryLogWriter(const std::string &path, uint32_t chunkSize) :
+            fd(-1),
+            chunkSize(chunkSize),
+            capacity(chunkSize - sizeof(TelemetryLogChunkHeader)),
+            current(nullptr),
+            inFlight(0),
+            recordCount(0),
+            droppedCount(0),
+            stopped(false),
+            spare(nullptr),
+            sealedMaxNs(0) {
+    long page = sysconf(_SC_PAGESIZE);
+    if(chunkSize < MIN_CHUNK_SIZE || chunkSize % page != 0)
+        throw std::invalid_argument("log chunk size must be a multiple of the page size, >= 64 KiB");
+
+    this->fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(this->fd < 0)
+        throw std::runtime_error("cannot create " + path);
+
+    TelemetryLogFileHeader h{};
+    h.magic = TELEMETRY_LOG_MAGIC;
+    h.version = TELEMETRY_LOG_VERSION;
+    h.chunkSize = chunkSize;
+    h.createdRealtimeNs = clock_ns(CLOCK_REALTIME);
+    h.createdMonotonicNs = clock_ns(CLOCK_MONOTONIC);
+    if(ftruncate(this->fd, TELEMETRY_LOG_HEADER_SIZE) != 0 ||
+       pwrite(this->fd, &h, sizeof(h), 0) != static_cast<ssize_t>(sizeof(h))) {
+        close(this->fd);
+        throw std::runtime_error("cannot write " + path);
+    }
+
+    Chunk *first = this->mapChunk(0);
+    if(first == nullptr) {
+        close(this->fd);
+        throw std::runtime_error("cannot allocate the first log chunk");
+    }
+    this->activate(first);
+    this->spare = this->mapChunk(1);
+}
+
+/**
+ * @brief append one record stamped timeNs; safe from any thread.
+ *
+ * @return false if the record is too large or the log is out of space.
+ */
+bool TelemetryLogWriter::append(uint8_t type, const uint8_t *payload, size_t len, uint64_t timeNs) {
+    uint64_t need = record_size(len);
+    if(len > UINT16_MAX || need > this->capacity || this->stopped.load(std::memory_order_relaxed)) {
+        this->droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    /* counted in flight from before we can see a chunk until we are done with it */
+    this->inFlight.fetch_add(1);
+    bool ok = false;
+    for(;;) {
+        Chunk *c = this->current.load();
+        uint64_t off = c->header->reserved.fetch_add(need, std::memory_order_relaxed);
+        if(off + need <= this->capacity) {
+            TelemetryLogRecord *r = reinterpret_cast<TelemetryLogRecord *>(c->records + off);
+            r->timeNs = timeNs;
+            r->length = static_cast<uint16_t>(len);
+            r->type = type;
+            r->reserved = 0;
+            memcpy(reinterpret_cast<uint8_t *>(r + 1), payload, len);
+            r->commit.store(TELEMETRY_LOG_COMMITTED, std::memory_order_release);
+            c->header->committed.fetch_add(need, std::memory_order_release);
+            this->recordCount.fetch_add(1, std::memory_order_relaxed);
+            ok = true;
+            break;
+        }
+        /* exactly one reservation straddles (or starts at) the end: it turns
+           the chunk over, later ones wait for the next chunk */
+        if(off <= this->capacity)
+            this->roll(c, off);
+        else
+            while(this->current.load() == c && !this->stopped.load())
+                std::this_thread::yield();
+        if(this->stopped.load())
+            break;
+    }
+    this->inFlight.fetch_sub(1);
+    if(!ok)
+        this->droppedCount.fetch_add(1, std::memory_order_relaxed);
+    return ok;
+}
+
+uint64_t TelemetryLogWriter::records() const {
+    return this->recordCount.load(std::memory_order_relaxed);
+}
+
+uint64_t TelemetryLogWriter::dropped() const {
+    return this->droppedCount.load(std::memory_order_relaxed);
+}
+
+uint64_t TelemetryLogWriter::chunks() const {
+    return this->current.load()->sequence + 1;
+}
+
+/**
+ * @brief Destroy the TelemetryLogWriter object: seal the open chunk and
+ *        drop the spare, leaving a file of sealed chunks only.
+ *
+ */
+TelemetryLogWriter::~TelemetryLogWriter() {
+    Chunk *c = this->current.load();
+    uint64_t end = c->sequence + 1;
+    if(!this->stopped.load()) {
+        uint64_t used = c->header->committed.load(std::memory_order_acquire);
+        this->seal(c, used);
+        if(used == 0 && c->sequence > 0)
+            end = c->sequence;
+    }
+    this->unmapChunk(c);
+    if(this->spare != nullptr)
+        this->unmapChunk(this->spare);
+    for(Chunk *r : this->retired)
+        this->unmapChunk(r);
+    if(ftruncate(this->fd, TELEMETRY_LOG_HEADER_SIZE + end * this->chunkSize) != 0)
+        perror("telemetry log truncate");
+    close(this->fd);
+}
+
+/**
+ * @brief allocate (not just extend: a sparse file would SIGBUS on a full
+ *        disk) and map one chunk.
+ *
+ * @return nullptr if the space is not there.
+ */
+TelemetryLogWriter::Chunk *TelemetryLogWriter::mapChunk(uint64_t sequence) {
+    off_t off = TELEMETRY_LOG_HEADER_SIZE + sequence * this->chunkSize;
+    if(posix_fallocate(this->fd, off, this->chunkSize) != 0)
+        return nullptr;
+    void *map = mmap(nullptr, this->chunkSize, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, off);
+    if(map == MAP_FAILED)
+        return nullptr;
+    Chunk *c = new Chunk;
+    c->header = static_cast<TelemetryLogChunkHeader *>(map);
+    c->records = static_cast<uint8_t *>(map) + sizeof(TelemetryLogChunkHeader);
+    c->sequence = sequence;
+    return c;
+}
+
+void TelemetryLogWriter::unmapChunk(Chunk *chunk) {
+    munmap(chunk->header, this->chunkSize);
+    delete chunk;
+}
+
+void TelemetryLogWriter::activate(Chunk *chunk) {
+    TelemetryLogChunkHeader *h = chunk->header;
+    h->magic = TELEMETRY_LOG_CHUNK_MAGIC;
+    h->sequence = chunk->sequence;
+    h->reserved.store(0, std::memory_order_relaxed);
+    h->committed.store(0, std::memory_order_relaxed);
+    h->state.store(TELEMETRY_LOG_CHUNK_OPEN, std::memory_order_release);
+    this->current.store(chunk);
+}
+
+/**
+ * @brief the slow path: publish the spare chunk so other writers carry on,
+ *        then seal the full one and map a new spare.
+ *
+ */
+void TelemetryLogWriter::roll(Chunk *full, uint64_t usedBytes) {
+    std::lock_guard<std::mutex> lock(this->rollLock);
+    Chunk *next = this->spare;
+    this->spare = nullptr;
+    if(next == nullptr)
+        next = this->mapChunk(full->sequence + 1);
+    if(next == nullptr) {
+        this->seal(full, usedBytes);
+        this->stopped.store(true);
+        return;
+    }
+    this->activate(next);
+    this->seal(full, usedBytes);
+    this->retired.push_back(full);
+    this->releaseRetired();
+    this->spare = this->mapChunk(next->sequence + 1);
+}
+
+/**
+ * @brief wait for the reservations below usedBytes to commit, then record
+ *        the time range, index and CRC, and mark the chunk sealed.
+ *
+ */
+void TelemetryLogWriter::seal(Chunk *chunk, uint64_t usedBytes) {
+    TelemetryLogChunkHeader *h = chunk->header;
+    while(h->committed.load(std::memory_order_acquire) < usedBytes)
+        std::this_thread::yield();
+
+    uint64_t step = this->capacity / TELEMETRY_LOG_INDEX_SIZE;
+    uint64_t nextMark = 0;
+    uint64_t first = 0, last = this->sealedMaxNs;
+    uint32_t n = 0;
+    uint32_t indexed = 0;
+    for(uint64_t off = 0; off < usedBytes; n++) {
+        const TelemetryLogRecord *r = reinterpret_cast<const TelemetryLogRecord *>(chunk->records + off);
+        first = n == 0 ? r->timeNs : std::min(first, r->timeNs);
+        last = std::max(last, r->timeNs);
+        if(off >= nextMark && indexed < TELEMETRY_LOG_INDEX_SIZE) {
+            h->index[indexed].timeNs = last;
+            h->index[indexed].offset = static_cast<uint32_t>(off);
+            h->index[indexed].record = n;
+            indexed++;
+            nextMark = (off / step + 1) * step;
+        }
+        off += record_size(r->length);
+    }
+    h->firstTimeNs = first;
+    h->lastTimeNs = last;
+    h->usedBytes = static_cast<uint32_t>(usedBytes);
+    h->records = n;
+    h->indexCount = indexed;
+    h->crc = frame_codec::crc32(chunk->records, usedBytes);
+    this->sealedMaxNs = last;
+    h->state.store(TELEMETRY_LOG_CHUNK_SEALED, std::memory_order_release);
+    msync(h, this->chunkSize, MS_ASYNC);
+}
+
+/**
+ * @brief unmap sealed chunks once this turnover is the only append in
+ *        flight: anyone else may still hold a pointer to one of them.
+ *
+ */
+void TelemetryLogWriter::releaseRetired() {
+    if(this->inFlight.load() != 1)
+        return;
+    for(Chunk *r : this->retired)
+        this->unmapChunk(r);
+    this->retired.clear();
+}
+
+/**
+ * @brief Construct a new TelemetryLogReader object
+ *
+ */
+TelemetryLogReader::TelemetryLogReader(const std::string &path) :
+            fd(-1),
+            size(0),
+            map(nullptr),
+            chunkSize(0),
+            capacity(0),
+            count(0),
+            chunkIndex(0),
+            offset(0),
+            corrupt(0) {
+    this->fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(this->fd < 0)
+        throw std::runtime_error("cannot open " + path);
+    try {
+        this->mapFile();
+    } catch(...) {
+        close(this->fd);
+        throw;
+    }
+    const TelemetryLogFileHeader &h = this->fileHeader();
+    if(h.magic != TELEMETRY_LOG_MAGIC || h.version != TELEMETRY_LOG_VERSION ||
+       h.chunkSize < MIN_CHUNK_SIZE || h.chunkSize % 4096 != 0) {
+        munmap(const_cast<uint8_t *>(this->map), this->size);
+        close(this->fd);
+        throw std::runtime_error(path + " is not a telemetry log");
+    }
+    this->chunkSize = h.chunkSize;
+    this->capacity = h.chunkSize - sizeof(TelemetryLogChunkHeader);
+    this->count = (this->size - TELEMETRY_LOG_HEADER_SIZE) / this->chunkSize;
+    this->checked.assign(this->count, 0);
+}
+
+/**
+ * @brief next record in file order.
+ *
+ * @return false at the end of the log, or where the writer is now.
+ */
+bool TelemetryLogReader::next(TelemetryLogEntry &out) {
+    while(this->chunkIndex < this->count && this->valid(this->chunkIndex)) {
+        if(this->usable(this->chunkIndex)) {
+            const TelemetryLogRecord *r = this->recordAt(this->chunkIndex, this->offset);
+            if(r != nullptr) {
+                out.timeNs = r->timeNs;
+                out.type = r->type;
+                out.length = r->length;
+                out.payload = reinterpret_cast<const uint8_t *>(r + 1);
+                this->offset += record_size(r->length);
+                return true;
+            }
+            /* an open chunk with a successor was abandoned by a crash */
+            if(!this->sealed(this->chunkIndex) &&
+               !(this->chunkIndex + 1 < this->count && this->valid(this->chunkIndex + 1)))
+                return false;
+        }
+        this->chunkIndex++;
+        this->offset = 0;
+    }
+    return false;
+}
+
+/**
+ * @brief position the cursor at the first record (in file order) at or
+ *        after timeNs: binary search over chunks, then over the chunk's
+ *        index, then a scan of at most 1/TELEMETRY_LOG_INDEX_SIZE of a chunk.
+ *
+ * @return false if nothing in the log is that recent.
+ */
+bool TelemetryLogReader::seek(uint64_t timeNs) {
+    /* first chunk holding anything that recent; nothing before it does */
+    size_t lo = 0, hi = this->validCount();
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if(this->chunkLastTime(mid) < timeNs)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    this->chunkIndex = lo;
+    this->offset = 0;
+
+    if(this->chunkIndex < this->count && this->valid(this->chunkIndex) &&
+       this->sealed(this->chunkIndex) && this->usable(this->chunkIndex)) {
+        const TelemetryLogChunkHeader *h = this->chunk(this->chunkIndex);
+        uint32_t entries = std::min<uint32_t>(h->indexCount, TELEMETRY_LOG_INDEX_SIZE);
+        const TelemetryLogIndexEntry *e = std::lower_bound(h->index, h->index + entries, timeNs,
+            [](const TelemetryLogIndexEntry &x, uint64_t t) { return x.timeNs < t; });
+        if(e != h->index)
+            this->offset = (e - 1)->offset;
+    }
+
+    TelemetryLogEntry entry;
+    for(;;) {
+        size_t ci = this->chunkIndex;
+        uint64_t off = this->offset;
+        if(!this->next(entry))
+            return false;
+        if(entry.timeNs >= timeNs) {
+            this->chunkIndex = ci;
+            this->offset = off;
+            return true;
+        }
+    }
+}
+
+void TelemetryLogReader::rewind() {
+    this->chunkIndex = 0;
+    this->offset = 0;
+}
+
+/**
+ * @brief pick up chunks the writer added since the file was mapped.
+ *        Entries returned earlier are invalidated if it grew.
+ *
+ * @return true if there is more to read.
+ */
+bool TelemetryLogReader::refresh() {
+    struct stat st;
+    if(fstat(this->fd, &st) != 0 || static_cast<size_t>(st.st_size) <= this->size)
+        return false;
+    munmap(const_cast<uint8_t *>(this->map), this->size);
+    this->map = nullptr;
+    this->mapFile();
+    this->count = (this->size - TELEMETRY_LOG_HEADER_SIZE) / this->chunkSize;
+    this->checked.resize(this->count, 0);
+    return true;
+}
+
+uint64_t TelemetryLogReader::firstTimeNs() const {
+    size_t n = this->validCount();
+    for(size_t i = 0; i < n; i++) {
+        uint64_t t = this->chunkFirstTime(i);
+        if(t != UINT64_MAX)
+            return t;
+    }
+    return 0;
+}
+
+uint64_t TelemetryLogReader::lastTimeNs() const {
+    size_t n = this->validCount();
+    return n > 0 ? this->chunkLastTime(n - 1) : 0;
+}
+
+size_t TelemetryLogReader::chunkCount() const {
+    return this->validCount();
+}
+
+/**
+ * @brief sealed chunks whose CRC did not match, counted as they are visited;
+ *        their records are skipped.
+ *
+ */
+uint64_t TelemetryLogReader::corruptChunks() const {
+    return this->corrupt;
+}
+
+const TelemetryLogFileHeader &TelemetryLogReader::fileHeader() const {
+    return *reinterpret_cast<const TelemetryLogFileHeader *>(this->map);
+}
+
+/**
+ * @brief Destroy the TelemetryLogReader object
+ *
+ */
+TelemetryLogReader::~TelemetryLogReader() {
+    if(this->map != nullptr)
+        munmap(const_cast<uint8_t *>(this->map), this->size);
+    if(this->fd >= 0)
+        close(this->fd);
+}
+
+const TelemetryLogChunkHeader *TelemetryLogReader::chunk(size_t i) const {
+    return reinterpret_cast<const TelemetryLogChunkHeader *>(this->map + TELEMETRY_LOG_HEADER_SIZE + i * this->chunkSize);
+}
+
+const uint8_t *TelemetryLogReader::recordArea(size_t i) const {
+    return reinterpret_cast<const uint8_t *>(this->chunk(i)) + sizeof(TelemetryLogChunkHeader);
+}
+
+/**
+ * @brief chunk i has been written to (the spare after the last one has not).
+ *
+ */
+bool TelemetryLogReader::valid(size_t i) const {
+    const TelemetryLogChunkHeader *h = this->chunk(i);
+    uint32_t state = h->state.load(std::memory_order_acquire);
+    return (state == TELEMETRY_LOG_CHUNK_OPEN || state == TELEMETRY_LOG_CHUNK_SEALED) &&
+           h->magic == TELEMETRY_LOG_CHUNK_MAGIC && h->sequence == i;
+}
+
+bool TelemetryLogReader::sealed(size_t i) const {
+    return this->chunk(i)->state.load(std::memory_order_acquire) == TELEMETRY_LOG_CHUNK_SEALED;
+}
+
+/**
+ * @brief open chunks are trusted record by record; sealed ones must match
+ *        their CRC, checked once on first use.
+ *
+ */
+bool TelemetryLogReader::usable(size_t i) {
+    if(!this->sealed(i))
+        return true;
+    if(this->checked[i] == 0) {
+        const TelemetryLogChunkHeader *h = this->chunk(i);
+        bool ok = h->usedBytes <= this->capacity &&
+                  h->indexCount <= TELEMETRY_LOG_INDEX_SIZE &&
+                  frame_codec::crc32(this->recordArea(i), h->usedBytes) == h->crc;
+        this->checked[i] = ok ? 1 : 2;
+        if(!ok)
+            this->corrupt++;
+    }
+    return this->checked[i] == 1;
+}
+
+/**
+ * @brief chunks are activated in order, so the written ones are a prefix.
+ *
+ */
+size_t TelemetryLogReader::validCount() const {
+    size_t lo = 0, hi = this->count;
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if(this->valid(mid))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+const TelemetryLogRecord *TelemetryLogReader::recordAt(size_t i, uint64_t offset) const {
+    bool isSealed = this->sealed(i);
+    uint64_t limit = isSealed ? this->chunk(i)->usedBytes : this->capacity;
+    if(offset + sizeof(TelemetryLogRecord) > limit)
+        return nullptr;
+    const TelemetryLogRecord *r = reinterpret_cast<const TelemetryLogRecord *>(this->recordArea(i) + offset);
+    if(r->commit.load(std::memory_order_acquire) != TELEMETRY_LOG_COMMITTED ||
+       offset + record_size(r->length) > limit)
+        return nullptr;
+    return r;
+}
+
+/**
+ * @brief time of the chunk's first record, UINT64_MAX if it has none.
+ *
+ */
+uint64_t TelemetryLogReader::chunkFirstTime(size_t i) const {
+    const TelemetryLogChunkHeader *h = this->chunk(i);
+    if(this->sealed(i))
+        return h->records > 0 ? h->firstTimeNs : UINT64_MAX;
+    const TelemetryLogRecord *r = this->recordAt(i, 0);
+    return r != nullptr ? r->timeNs : UINT64_MAX;
+}
+
+/**
+ * @brief latest record time in chunks 0..i, 0 if there is none.
+ *
+ */
+uint64_t TelemetryLogReader::chunkLastTime(size_t i) const {
+    if(this->sealed(i))
+        return this->chunk(i)->lastTimeNs;
+    uint64_t last = i > 0 && this->sealed(i - 1) ? this->chunk(i - 1)->lastTimeNs : 0;
+    for(uint64_t off = 0; const TelemetryLogRecord *r = this->recordAt(i, off); off += record_size(r->length))
+        last = std::max(last, r->timeNs);
+    return last;
+}
+
+void TelemetryLogReader::mapFile() {
+    struct stat st;
+    if(fstat(this->fd, &st) != 0 || static_cast<size_t>(st.st_size) < TELEMETRY_LOG_HEADER_SIZE)
+        throw std::runtime_error("not a telemetry log");
+    this->size = st.st_size;
+    void *m = mmap(nullptr, this->size, PROT_READ, MAP_SHARED, this->fd, 0);
+    if(m == MAP_FAILED)
+        throw std::runtime_error("mmap failed");
+    this->map = static_cast<const uint8_t *>(m);
+}
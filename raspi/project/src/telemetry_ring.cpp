@@ -0,0 +1,206 @@
+/**
+ * @file telemetry_ring.cpp
+ * @author Ziad Fathy
+ * @brief shared-memory telemetry ring: one writer (robotd), any number of
+ *        readers, no locks and no syscalls on the read path.
+ * @version 0.1
+ * @date 2025-09-14
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "../inc/telemetry_ring.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Construct a new TelemetryRingWriter object
+ *
+ * @param slotCount rounded up to a power of two.
+ */
+TelemetryRingWriter::TelemetryRingWriter(uint32_t slotCount) :
+            fd(-1),
+            size(0),
+            header(nullptr),
+            slots(nullptr),
+            mask(0) {
+    uint32_t count = 1;
+    while(count < slotCount)
+        count <<= 1;
+    this->mask = count - 1;
+    this->size = sizeof(TelemetryRingHeader) + count * sizeof(TelemetrySlot);
+
+    this->fd = memfd_create("robotd-telemetry", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if(this->fd < 0)
+        throw std::runtime_error("memfd_create failed");
+    if(ftruncate(this->fd, this->size) != 0)
+        throw std::runtime_error("ftruncate failed");
+    /* readers map the whole file; nobody may shrink it under them */
+    fcntl(this->fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+
+    void *map = mmap(nullptr, this->size, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+    if(map == MAP_FAILED)
+        throw std::runtime_error("mmap failed");
+    this->header = static_cast<TelemetryRingHeader *>(map);
+    this->slots = reinterpret_cast<TelemetrySlot *>(static_cast<uint8_t *>(map) + sizeof(TelemetryRingHeader));
+
+    /* the file is zero filled: seq 0 reads as "never written" everywhere */
+    this->header->slotCount = count;
+    this->header->slotSize = sizeof(TelemetrySlot);
+    this->header->version = TELEMETRY_RING_VERSION;
+    this->header->head.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    this->header->magic = TELEMETRY_RING_MAGIC;
+}
+
+/**
+ * @brief wait-free publish; readers that fall a full lap behind lose the
+ *        oldest entries, they never slow the writer down.
+ *
+ */
+void TelemetryRingWriter::publish(const TelemetrySample &sample) {
+    uint64_t i = this->header->head.load(std::memory_order_relaxed);
+    TelemetrySlot &slot = this->slots[i & this->mask];
+    slot.seq.store(2 * i + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&slot.sample, &sample, sizeof(sample));
+    slot.seq.store(2 * i + 2, std::memory_order_release);
+    this->header->head.store(i + 1, std::memory_order_release);
+}
+
+int TelemetryRingWriter::getFd() const {
+    return this->fd;
+}
+
+/**
+ * @brief a second, read-only open file description of the memfd, so the
+ *        fd given to clients cannot be mapped writable.
+ *
+ * @return int caller owns it.
+ */
+int TelemetryRingWriter::openReadOnlyFd() const {
+    std::string path = "/proc/self/fd/" + std::to_string(this->fd);
+    return open(path.c_str(), O_RDONLY | O_CLOEXEC);
+}
+
+size_t TelemetryRingWriter::mapSize() const {
+    return this->size;
+}
+
+uint32_t TelemetryRingWriter::slotCount() const {
+    return static_cast<uint32_t>(this->mask + 1);
+}
+
+/**
+ * @brief Destroy the TelemetryRingWriter object
+ *
+ */
+TelemetryRingWriter::~TelemetryRingWriter() {
+    if(this->header != nullptr)
+        munmap(this->header, this->size);
+    if(this->fd >= 0)
+        close(this->fd);
+}
+
+/**
+ * @brief Construct a new TelemetryRingReader object
+ *
+ * @param fd ring memfd (received from robotd); the reader keeps only the
+ *           mapping, the caller may close fd afterwards.
+ */
+TelemetryRingReader::TelemetryRingReader(int fd) :
+            size(0),
+            header(nullptr),
+            slots(nullptr),
+            mask(0),
+            cursor(0),
+            lostCount(0) {
+    struct stat st;
+    if(fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(TelemetryRingHeader))
+        throw std::runtime_error("not a telemetry ring");
+    this->size = st.st_size;
+    void *map = mmap(nullptr, this->size, PROT_READ, MAP_SHARED, fd, 0);
+    if(map == MAP_FAILED)
+        throw std::runtime_error("mmap failed");
+    this->header = static_cast<const TelemetryRingHeader *>(map);
+    this->slots = reinterpret_cast<const TelemetrySlot *>(static_cast<const uint8_t *>(map) + sizeof(TelemetryRingHeader));
+
+    uint32_t count = this->header->slotCount;
+    if(this->header->magic != TELEMETRY_RING_MAGIC || this->header->version != TELEMETRY_RING_VERSION ||
+       this->header->slotSize != sizeof(TelemetrySlot) || count == 0 || (count & (count - 1)) != 0 ||
+       sizeof(TelemetryRingHeader) + count * sizeof(TelemetrySlot) > this->size) {
+        munmap(map, this->size);
+        throw std::runtime_error("telemetry ring layout mismatch");
+    }
+    this->mask = count - 1;
+    this->cursor = this->header->head.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief next unread sample, oldest first.
+ *
+ * @return false when the reader has caught up with the writer.
+ */
+bool TelemetryRingReader::next(TelemetrySample &out) {
+    for(;;) {
+        uint64_t head = this->header->head.load(std::memory_order_acquire);
+        if(this->cursor >= head)
+            return false;
+        if(head - this->cursor > this->mask + 1) {
+            this->lostCount += head - this->cursor - (this->mask + 1);
+            this->cursor = head - (this->mask + 1);
+        }
+
+        const TelemetrySlot &slot = this->slots[this->cursor & this->mask];
+        uint64_t want = 2 * this->cursor + 2;
+        uint64_t s1 = slot.seq.load(std::memory_order_acquire);
+        if(s1 == want) {
+            memcpy(&out, &slot.sample, sizeof(out));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(slot.seq.load(std::memory_order_relaxed) == want) {
+                this->cursor++;
+                return true;
+            }
+        }
+        /* head said published, so anything else means a later lap took it */
+        this->lostCount++;
+        this->cursor++;
+    }
+}
+
+/**
+ * @brief skip to the newest sample (for UIs that only want "now").
+ *
+ */
+bool TelemetryRingReader::latest(TelemetrySample &out) {
+    uint64_t head = this->header->head.load(std::memory_order_acquire);
+    if(head == 0)
+        return false;
+    if(this->cursor < head - 1)
+        this->cursor = head - 1;
+    return this->next(out);
+}
+
+uint64_t TelemetryRingReader::lost() const {
+    return this->lostCount;
+}
+
+uint64_t TelemetryRingReader::published() const {
+    return this->header->head.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Destroy the TelemetryRingReader object
+ *
+ */
+TelemetryRingReader::~TelemetryRingReader() {
+    if(this->header != nullptr)
+        munmap(const_cast<TelemetryRingHeader *>(this->header), this->size);
+}
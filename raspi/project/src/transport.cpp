@@ -0,0 +1,173 @@
+/**
+ * @file transport.cpp
+ * @author Ziad Fathy
+ * @brief Transport helpers and the URI factory.
+ * @version 0.1
+ * @date 2025-09-13
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "../inc/transport.hpp"
+#include "../inc/socket_transport.hpp"
+#include "../inc/usart.hpp"
+#include "frame_codec.h"
+#include <cstdlib>
+#include <map>
+#include <poll.h>
+#include <vector>
+
+/**
+ * @brief switch the descriptor between blocking and O_NONBLOCK, for event
+ *        loops that must never stall on one link.
+ *
+ * @param enable
+ */
+void Transport::setNonBlocking(bool enable) {
+    int flags = fcntl(this->getFd(), F_GETFL);
+    if(flags < 0)
+        throw std::runtime_error("fcntl failed");
+    flags = enable ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    if(fcntl(this->getFd(), F_SETFL, flags) < 0)
+        throw std::runtime_error("fcntl failed");
+}
+
+/**
+ * @brief open without blocking on a peer; backends whose open is immediate
+ *        just call openPort().
+ *
+ * @return false: still connecting, wait for POLLOUT then call finishOpen().
+ */
+bool Transport::startOpen() {
+    this->openPort();
+    return true;
+}
+
+/**
+ * @brief complete a startOpen() that returned false; throws if the
+ *        connection failed.
+ *
+ */
+void Transport::finishOpen() {}
+
+/**
+ * @brief change the line rate of an open link.
+ *
+ * @return false: this backend has no line rate (sockets, CAN).
+ */
+bool Transport::setBaud(long) {
+    return false;
+}
+
+/**
+ * @brief input units (datagrams) dropped because they were longer than the
+ *        readInto() buffer; stream backends never truncate.
+ *
+ */
+uint64_t Transport::truncatedInput() const {
+    return 0;
+}
+
+/**
+ * @brief send payload as one COBS/CRC-32 frame (see frame_codec.h); blocks
+ *        until it is all out, also on a non-blocking link.
+ *
+ * @param payload binary data, zeros allowed.
+ * @param len     payload length.
+ */
+void Transport::writeFrame(const uint8_t *payload, size_t len) {
+    std::vector<uint8_t> out(frame_codec::max_encoded_size(len));
+    size_t n = frame_codec::encode_frame(payload, len, out.data(), out.size());
+    struct iovec iov;
+    size_t sent = 0;
+    while(sent < n) {
+        iov.iov_base = out.data() + sent;
+        iov.iov_len = n - sent;
+        ssize_t w = this->writeVector(&iov, 1);
+        if(w == 0) {
+            /* non-blocking link with a full buffer: wait for room instead of spinning */
+            struct pollfd pfd = {this->getFd(), POLLOUT, 0};
+            (void)::poll(&pfd, 1, -1);
+            continue;
+        }
+        sent += w;
+    }
+}
+
+/**
+ * @brief split "host:port" / "[v6]:port".
+ *
+ */
+static void split_host_port(const std::string &authority, std::string &host, std::string &port) {
+    size_t colon;
+    if(!authority.empty() && authority[0] == '[') {
+        size_t close = authority.find(']');
+        if(close == std::string::npos)
+            throw std::invalid_argument("bad address " + authority);
+        host = authority.substr(1, close - 1);
+        colon = authority.find(':', close);
+    } else {
+        colon = authority.rfind(':');
+        host = authority.substr(0, colon);
+    }
+    if(colon == std::string::npos || colon + 1 == authority.size())
+        throw std::invalid_argument("missing port in " + authority);
+    port = authority.substr(colon + 1);
+}
+
+/**
+ * @brief build (but do not open) the backend a URI names.
+ *
+ * @param uri see transport.hpp; a bare path means a 115200 serial port.
+ * @return std::unique_ptr<Transport>
+ */
+std::unique_ptr<Transport> Transport::fromUri(const std::string &uri) {
+    if(!uri.empty() && uri[0] == '/')
+        return std::unique_ptr<Transport>(new UART(uri, B115200));
+
+    size_t sep = uri.find("://");
+    if(sep == std::string::npos)
+        throw std::invalid_argument("not a transport URI: " + uri);
+    std::string scheme = uri.substr(0, sep);
+    std::string rest = uri.substr(sep + 3);
+
+    std::map<std::string, std::string> query;
+    size_t q = rest.find('?');
+    if(q != std::string::npos) {
+        std::string params = rest.substr(q + 1);
+        rest.resize(q);
+        size_t start = 0;
+        while(start < params.size()) {
+            size_t amp = params.find('&', start);
+            std::string kv = params.substr(start, amp == std::string::npos ? std::string::npos : amp - start);
+            size_t eq = kv.find('=');
+            query[kv.substr(0, eq)] = eq == std::string::npos ? "" : kv.substr(eq + 1);
+            start = amp == std::string::npos ? params.size() : amp + 1;
+        }
+    }
+
+    std::string host, port;
+    if(scheme == "serial" || scheme == "pty") {
+        long baud = query.count("baud") ? strtol(query["baud"].c_str(), nullptr, 10) : 115200;
+        return std::unique_ptr<Transport>(new UART(rest, UART::speedFor(baud)));
+    }
+    if(scheme == "tcp") {
+        split_host_port(rest, host, port);
+        return std::unique_ptr<Transport>(new TcpTransport(host, port));
+    }
+    if(scheme == "unix")
+        return std::unique_ptr<Transport>(new UnixTransport(rest));
+    if(scheme == "udp") {
+        split_host_port(rest, host, port);
+        return std::unique_ptr<Transport>(new DatagramTransport(false, host, port));
+    }
+    if(scheme == "unixgram")
+        return std::unique_ptr<Transport>(new DatagramTransport(true, rest));
+    if(scheme == "can") {
+        uint32_t tx = query.count("tx") ? strtoul(query["tx"].c_str(), nullptr, 0) : 0x120;
+        uint32_t rx = query.count("rx") ? strtoul(query["rx"].c_str(), nullptr, 0) : tx + 1;
+        return std::unique_ptr<Transport>(new CanTransport(rest, tx, rx));
+    }
+    throw std::invalid_argument("unknown transport scheme " + scheme);
+}
@@ -0,0 +1,265 @@
+/**
+ * @file tx_queue.cpp
+ * @author Ziad Fathy
+ * @brief multi-producer transmit queue drained by a single writev() writer.
+ * @version 0.1
+ * @date 2025-09-08
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "../inc/tx_queue.hpp"
+#include <algorithm>
+#include <climits>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * @brief Construct a new UARTTxQueue object
+ *
+ * @param link          opened transport the writer thread sends on.
+ * @param maxBatch      max frames coalesced into one writev().
+ * @param maxBatchBytes soft cap on bytes per writev(), keeps bulk traffic
+ *                      from sitting in the tty buffer ahead of a STOP.
+ */
+UARTTxQueue::UARTTxQueue(Transport &link, size_t maxBatch, size_t maxBatchBytes) :
+            link(link),
+            maxBatch(std::min<size_t>(std::max<size_t>(maxBatch, 1), IOV_MAX)),
+            maxBatchBytes(maxBatchBytes),
+            wakeFd(-1),
+            running(false),
+            depth(0),
+            maxDepth(0),
+            framesSent(0),
+            bytesSent(0),
+            writevCalls(0),
+            writeErrors(0),
+            totalWaitNs(0),
+            maxWaitNs(0) {
+    for(Lane &lane : this->lanes) {
+        lane.stub.next.store(nullptr, std::memory_order_relaxed);
+        lane.head.store(&lane.stub, std::memory_order_relaxed);
+        lane.tail = &lane.stub;
+    }
+    this->wakeFd = eventfd(0, EFD_CLOEXEC);
+    if(this->wakeFd < 0)
+        throw std::runtime_error("eventfd failed");
+}
+
+/**
+ * @brief start the writer thread.
+ *
+ */
+void UARTTxQueue::start() {
+    if(this->running.exchange(true))
+        return;
+    this->writer = std::thread(&UARTTxQueue::writerLoop, this);
+}
+
+/**
+ * @brief flush everything already submitted, then join the writer.
+ *
+ */
+void UARTTxQueue::stop() {
+    if(!this->running.exchange(false))
+        return;
+    uint64_t one = 1;
+    (void)::write(this->wakeFd, &one, sizeof(one));
+    this->writer.join();
+}
+
+/**
+ * @brief queue a frame; never blocks and never takes a lock.
+ *
+ * @param frame bytes to send as one unit (never split across other frames).
+ * @param prio  transmit class.
+ */
+void UARTTxQueue::submit(std::string frame, TxPriority prio) {
+    Node *node = new Node;
+    node->data = std::move(frame);
+    node->enqueued = Clock::now();
+
+    /* count before publishing: once pushed, the writer may pop and
+       fetch_sub it at once, and depth must never go below zero */
+    size_t before = this->depth.fetch_add(1, std::memory_order_acq_rel);
+    size_t seen = this->maxDepth.load(std::memory_order_relaxed);
+    while(before + 1 > seen &&
+          !this->maxDepth.compare_exchange_weak(seen, before + 1, std::memory_order_relaxed));
+
+    this->push(this->lanes[static_cast<size_t>(prio)], node);
+
+    /* only the producer that finds the queue empty has to wake the writer */
+    if(before == 0) {
+        uint64_t one = 1;
+        (void)::write(this->wakeFd, &one, sizeof(one));
+    }
+}
+
+/**
+ * @brief snapshot of the queue counters.
+ *
+ * @return TxQueueStats
+ */
+TxQueueStats UARTTxQueue::stats() const {
+    TxQueueStats s{};
+    s.depth       = this->depth.load(std::memory_order_relaxed);
+    s.maxDepth    = this->maxDepth.load(std::memory_order_relaxed);
+    s.framesSent  = this->framesSent.load(std::memory_order_relaxed);
+    s.bytesSent   = this->bytesSent.load(std::memory_order_relaxed);
+    s.writevCalls = this->writevCalls.load(std::memory_order_relaxed);
+    s.writeErrors = this->writeErrors.load(std::memory_order_relaxed);
+    s.totalWaitNs = this->totalWaitNs.load(std::memory_order_relaxed);
+    s.maxWaitNs   = this->maxWaitNs.load(std::memory_order_relaxed);
+    return s;
+}
+
+void UARTTxQueue::push(Lane &lane, Node *node) {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    Node *prev = lane.head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+}
+
+/**
+ * @brief pop one node, or nullptr if the lane is empty or a producer is
+ *        between its exchange and its link (the caller simply retries).
+ *
+ */
+UARTTxQueue::Node *UARTTxQueue::pop(Lane &lane) {
+    Node *tail = lane.tail;
+    Node *next = tail->next.load(std::memory_order_acquire);
+    if(tail == &lane.stub) {
+        if(next == nullptr)
+            return nullptr;
+        lane.tail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if(next != nullptr) {
+        lane.tail = next;
+        return tail;
+    }
+    if(tail != lane.head.load(std::memory_order_acquire))
+        return nullptr;
+    this->push(lane, &lane.stub);
+    next = tail->next.load(std::memory_order_acquire);
+    if(next != nullptr) {
+        lane.tail = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief fill one batch, highest priority lane first.
+ *
+ * @return size_t frames placed in nodes/iov.
+ */
+size_t UARTTxQueue::collect(Node **nodes, struct iovec *iov) {
+    size_t count = 0;
+    size_t bytes = 0;
+    for(Lane &lane : this->lanes) {
+        while(count < this->maxBatch && (count == 0 || bytes < this->maxBatchBytes)) {
+            Node *node = this->pop(lane);
+            if(node == nullptr)
+                break;
+            nodes[count] = node;
+            iov[count].iov_base = const_cast<char *>(node->data.data());
+            iov[count].iov_len = node->data.size();
+            bytes += node->data.size();
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief send one batch, finishing partial writes, then release the nodes.
+ *
+ */
+void UARTTxQueue::flush(Node **nodes, struct iovec *iov, size_t count) {
+    Clock::time_point now = Clock::now();
+    uint64_t waitSum = 0;
+    uint64_t waitMax = 0;
+    size_t bytes = 0;
+    for(size_t i = 0; i < count; i++) {
+        uint64_t w = std::chrono::duration_cast<std::chrono::nanoseconds>(now - nodes[i]->enqueued).count();
+        waitSum += w;
+        waitMax = std::max(waitMax, w);
+        bytes += iov[i].iov_len;
+    }
+
+    struct iovec *cur = iov;
+    size_t left = count;
+    try {
+        while(left > 0) {
+            ssize_t n = this->link.writeVector(cur, static_cast<int>(left));
+            this->writevCalls.fetch_add(1, std::memory_order_relaxed);
+            if(n == 0) {
+                /* non-blocking port with a full driver buffer: sleep until it drains */
+                struct pollfd pfd = {this->link.getFd(), POLLOUT, 0};
+                (void)::poll(&pfd, 1, TX_POLL_TIMEOUT_MS);
+                continue;
+            }
+            while(left > 0 && static_cast<size_t>(n) >= cur->iov_len) {
+                n -= cur->iov_len;
+                cur++;
+                left--;
+            }
+            if(left > 0) {
+                cur->iov_base = static_cast<char *>(cur->iov_base) + n;
+                cur->iov_len -= n;
+            }
+        }
+        this->framesSent.fetch_add(count, std::memory_order_relaxed);
+        this->bytesSent.fetch_add(bytes, std::memory_order_relaxed);
+    } catch(const std::runtime_error &) {
+        this->writeErrors.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    this->totalWaitNs.fetch_add(waitSum, std::memory_order_relaxed);
+    if(waitMax > this->maxWaitNs.load(std::memory_order_relaxed))
+        this->maxWaitNs.store(waitMax, std::memory_order_relaxed);
+
+    for(size_t i = 0; i < count; i++)
+        delete nodes[i];
+    this->depth.fetch_sub(count, std::memory_order_acq_rel);
+}
+
+void UARTTxQueue::writerLoop() {
+    std::vector<Node *> nodes(this->maxBatch);
+    std::vector<struct iovec> iov(this->maxBatch);
+
+    for(;;) {
+        while(this->depth.load(std::memory_order_acquire) > 0) {
+            size_t count = this->collect(nodes.data(), iov.data());
+            if(count == 0) {
+                /* a producer is mid-push, its link lands within a few instructions */
+                std::this_thread::yield();
+                continue;
+            }
+            this->flush(nodes.data(), iov.data(), count);
+        }
+        if(!this->running.load(std::memory_order_acquire))
+            break;
+        uint64_t value;
+        (void)::read(this->wakeFd, &value, sizeof(value));
+    }
+}
+
+/**
+ * @brief Destroy the UARTTxQueue object
+ *
+ */
+UARTTxQueue::~UARTTxQueue() {
+    this->stop();
+    for(Lane &lane : this->lanes) {
+        Node *node;
+        while((node = this->pop(lane)) != nullptr)
+            delete node;
+    }
+    if(this->wakeFd >= 0)
+        close(this->wakeFd);
+}
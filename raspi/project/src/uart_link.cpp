@@ -0,0 +1,94 @@
+/**
+ * @file uart_link.cpp
+ * @author Ziad Fathy
+ * @brief reliable, windowed message transport on top of the UART class.
+ * @version 0.1
+ * @date 2025-09-09
+ * 
+ * @copyright Copyright (c) 2025
+ * 
+ */
+
+#include "../inc/uart_link.hpp"
+#include <poll.h>
+#include <time.h>
+
+/**
+ * @brief Construct a new UARTLink object
+ * 
+ * @param link      opened transport (serial, pty, socket...).
+ * @param onDeliver called in order, once per payload, from service().
+ * @param cfg       window and timer settings; keep the window equal to the
+ *                  firmware's so the peer never has to drop frames.
+ */
+UARTLink::UARTLink(Transport &link, DeliverFn onDeliver, const arq::config &cfg) :
+            link(link),
+            onDeliver(std::move(onDeliver)),
+            engine(&UARTLink::emitFrame, &UARTLink::deliverPayload, this, cfg) {}
+
+/**
+ * @brief queue a payload; it is on the wire before this returns.
+ * 
+ * @return false when the window is full (call service() and retry) or
+ *         the payload exceeds MAX_PAYLOAD.
+ */
+bool UARTLink::send(const uint8_t *payload, size_t len) {
+    return this->engine.send(payload, len, nowUs());
+}
+
+bool UARTLink::send(const std::string &payload) {
+    return this->send(reinterpret_cast<const uint8_t *>(payload.data()), payload.size());
+}
+
+/**
+ * @brief wait for input or the next timer (at most maxWaitMs), then process
+ *        received bytes, acks and retransmissions.
+ * 
+ * @param maxWaitMs 0 to only handle what is already pending.
+ */
+void UARTLink::service(int maxWaitMs) {
+    uint32_t now = nowUs();
+    int timerMs = static_cast<int>((this->engine.next_timeout_us(now) + 999) / 1000);
+    struct pollfd pfd = { this->link.getFd(), POLLIN, 0 };
+    int wait = maxWaitMs < timerMs ? maxWaitMs : timerMs;
+
+    if(::poll(&pfd, 1, wait) > 0 && (pfd.revents & POLLIN)) {
+        uint8_t chunk[READ_CHUNK];
+        size_t n = this->link.readInto(chunk, sizeof(chunk));
+        this->engine.on_rx(chunk, n, nowUs());
+    }
+    this->engine.poll(nowUs());
+}
+
+size_t UARTLink::inFlight() const {
+    return this->engine.in_flight();
+}
+
+const arq::stats &UARTLink::stats() const {
+    return this->engine.statistics();
+}
+
+/**
+ * @brief CLOCK_MONOTONIC in microseconds, truncated; the engine only uses
+ *        wrap-safe differences.
+ */
+uint32_t UARTLink::nowUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint32_t>(ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+}
+
+void UARTLink::emitFrame(void *ctx, const uint8_t *bytes, size_t len) {
+    UARTLink *self = static_cast<UARTLink *>(ctx);
+    size_t sent = 0;
+    while(sent < len) {
+        struct iovec iov = { const_cast<uint8_t *>(bytes) + sent, len - sent };
+        sent += self->link.writeVector(&iov, 1);
+    }
+}
+
+void UARTLink::deliverPayload(void *ctx, const uint8_t *payload, size_t len) {
+    UARTLink *self = static_cast<UARTLink *>(ctx);
+    if(self->onDeliver)
+        self->onDeliver(payload, len);
+}
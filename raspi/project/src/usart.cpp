@@ -10,6 +10,7 @@
  */
 
 #include "../inc/usart.hpp"
+#include <cerrno>
 
 /**
  * @brief Construct a new UART::UART object
@@ -29,7 +30,7 @@ UART::UART(const std::string &dev, speed_t buad) :
 void UART::openPort() {
     this->fd = open(this->device.c_str(), O_RDWR | O_NOCTTY | O_SYNC);
     if(this->fd < 0 )
-        std::runtime_error("Cannot open UART device");
+        throw std::runtime_error("Cannot open UART device");
     termios tty{};
     if(tcgetattr(this->fd, &tty) != 0)
         throw std::runtime_error("tcgetattr faild");
@@ -54,6 +55,16 @@ void UART::openPort() {
         throw std::runtime_error("tcsetattr failed");
 }
 
+/**
+ * @brief close the port; openPort() may be called again afterwards.
+ * 
+ */
+void UART::closePort() {
+    if(this->fd >= 0)
+        close(this->fd);
+    this->fd = -1;
+}
+
 /**
  * @brief 
  * 
@@ -66,6 +77,27 @@ void UART::writeData(std::string data) {
     }
 }
 
+/**
+ * @brief write several buffers with a single writev() call.
+ * 
+ * @param iov    buffers to send, in order.
+ * @param iovcnt number of entries in iov.
+ * @return ssize_t bytes accepted by the driver (may be a partial write,
+ *                 0 when a non-blocking port has no room).
+ */
+ssize_t UART::writeVector(const struct iovec *iov, int iovcnt) {
+    ssize_t n;
+    do {
+        n = ::writev(this->fd, iov, iovcnt);
+    } while(n < 0 && errno == EINTR);
+    if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return 0;
+    if(n < 0) {
+        throw std::runtime_error("UART writev failed");
+    }
+    return n;
+}
+
 /**
  * @brief 
  * 
@@ -80,6 +112,95 @@ std::string UART::readData(size_t maxLen) {
     return std::string(buf, n);
 }
 
+/**
+ * @brief read whatever is pending into a caller buffer.
+ * 
+ * Unlike readData() this tells "nothing yet" apart from a dead port:
+ * a hung up or unplugged device throws.
+ * 
+ * @param buf 
+ * @param len 
+ * @return size_t bytes read, 0 when nothing is available.
+ */
+size_t UART::readInto(uint8_t *buf, size_t len) {
+    ssize_t n;
+    do {
+        n = ::read(this->fd, buf, len);
+    } while(n < 0 && errno == EINTR);
+    if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return 0;
+    if(n < 0)
+        throw std::runtime_error("UART read failed");
+    return static_cast<size_t>(n);
+}
+
+/**
+ * @brief switch the open port to another rate (baud negotiation).
+ * 
+ * Waits for queued output to leave at the old rate first and drops input
+ * that arrived during the switch, which can only be garbage.
+ * 
+ * @param baud 
+ * @return true 
+ */
+bool UART::setBaud(long baud) {
+    speed_t speed = UART::speedFor(baud);
+    termios tty{};
+    if(this->fd < 0 || tcgetattr(this->fd, &tty) != 0)
+        return false;
+    tcdrain(this->fd);
+    cfsetospeed(&tty, speed);
+    cfsetispeed(&tty, speed);
+    if(tcsetattr(this->fd, TCSANOW, &tty) != 0)
+        return false;
+    tcflush(this->fd, TCIFLUSH);
+    this->buadRate = speed;
+    return true;
+}
+
+/**
+ * @brief termios constant for a numeric rate.
+ * 
+ * @param baud 
+ * @return speed_t throws std::invalid_argument for rates termios lacks.
+ */
+speed_t UART::speedFor(long baud) {
+    switch(baud) {
+        case 9600:    return B9600;
+        case 19200:   return B19200;
+        case 38400:   return B38400;
+        case 57600:   return B57600;
+        case 115200:  return B115200;
+        case 230400:  return B230400;
+        case 460800:  return B460800;
+        case 500000:  return B500000;
+        case 576000:  return B576000;
+        case 921600:  return B921600;
+        case 1000000: return B1000000;
+        case 1500000: return B1500000;
+        case 2000000: return B2000000;
+        default:      throw std::invalid_argument("unsupported baud rate");
+    }
+}
+
+/**
+ * @brief descriptor of the opened port, for poll()/epoll users.
+ * 
+ * @return int -1 when the port is not open.
+ */
+int UART::getFd() const {
+    return this->fd;
+}
+
+/**
+ * @brief device path, for logs and stats.
+ * 
+ * @return std::string 
+ */
+std::string UART::describe() const {
+    return this->device;
+}
+
 /**
  * @brief Destroy the UART::UART object
  * 
@@ -0,0 +1,48 @@
+/**
+ * @file check.hpp
+ * @author Ziad Fathy
+ * @brief minimal assertion helpers for the host tests of the shared lib/
+ *        codecs; each test is a plain executable run by ctest.
+ * @version 0.1
+ * @date 2025-09-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef CHECK_HPP_
+#define CHECK_HPP_
+
+#include <cstdio>
+
+static int checkFailures = 0;
+
+/* keep going after a failure so one run reports everything that broke */
+#define CHECK(cond) \
+    do { \
+        if(!(cond)) { \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            checkFailures++; \
+        } \
+    } while(0)
+
+#define CHECK_EQ(a, b) \
+    do { \
+        unsigned long long va_ = static_cast<unsigned long long>(a); \
+        unsigned long long vb_ = static_cast<unsigned long long>(b); \
+        if(va_ != vb_) { \
+            std::fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: 0x%llx != 0x%llx\n", \
+                         __FILE__, __LINE__, #a, #b, va_, vb_); \
+            checkFailures++; \
+        } \
+    } while(0)
+
+static inline int checkResult(const char *name) {
+    if(checkFailures)
+        std::fprintf(stderr, "%s: %d check(s) failed\n", name, checkFailures);
+    else
+        std::printf("%s: ok\n", name);
+    return checkFailures ? 1 : 0;
+}
+
+#endif
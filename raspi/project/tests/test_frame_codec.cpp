@@ -0,0 +1,140 @@
+/**
+ * @file test_frame_codec.cpp
+ * @author Ziad Fathy
+ * @brief frame_codec.h: CRC against the STM32 CRC unit, COBS/CRC round
+ *        trips and rejection of damaged frames.
+ * @version 0.1
+ * @date 2025-09-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "check.hpp"
+#include "frame_codec.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+static constexpr size_t MAX_PAYLOAD = 600;
+
+/* bit-at-a-time reference of what the F103 CRC unit computes per word */
+static uint32_t referenceCrc(const uint8_t *data, size_t len) {
+    uint32_t crc = frame_codec::crc32_init;
+    for(size_t i = 0; i < len; i += 4) {
+        uint8_t word[4] = {0, 0, 0, 0};
+        for(size_t k = 0; k < 4 && i + k < len; k++)
+            word[k] = data[i + k];
+        crc ^= frame_codec::load_le32(word);
+        for(int bit = 0; bit < 32; bit++)
+            crc = (crc & 0x80000000u) ? (crc << 1) ^ frame_codec::crc32_poly : (crc << 1);
+    }
+    return crc;
+}
+
+static void testCrc(std::mt19937 &rng) {
+    /* RM0008 / AN4187: CRC->DR = 0x12345678 after reset reads back 0xDF8A8A2B */
+    const uint8_t word[4] = {0x78, 0x56, 0x34, 0x12};
+    CHECK_EQ(frame_codec::crc32(word, 4), 0xDF8A8A2Bu);
+
+    /* every length around the word / PCLMUL block boundaries, one shot and streamed */
+    std::vector<uint8_t> data(1100);
+    for(auto &b : data)
+        b = static_cast<uint8_t>(rng());
+    for(size_t len = 0; len <= data.size(); len += (len < 300 ? 1 : 37)) {
+        uint32_t want = referenceCrc(data.data(), len);
+        CHECK_EQ(frame_codec::crc32(data.data(), len), want);
+
+        frame_codec::crc32_stream stream;
+        size_t at = 0;
+        while(at < len) {
+            size_t piece = std::min<size_t>(len - at, 1 + rng() % 150);
+            stream.update(data.data() + at, piece);
+            at += piece;
+        }
+        CHECK_EQ(stream.value(), want);
+    }
+}
+
+/* push a whole wire frame; only the delimiter may complete it */
+static frame_codec::decode_status feed(frame_codec::frame_decoder<MAX_PAYLOAD> &dec,
+                                       const uint8_t *wire, size_t n) {
+    for(size_t i = 0; i + 1 < n; i++) {
+        if(dec.push(wire[i]) != frame_codec::decode_status::pending)
+            return frame_codec::decode_status::malformed;
+    }
+    return dec.push(wire[n - 1]);
+}
+
+static void testRoundTrip(std::mt19937 &rng) {
+    frame_codec::frame_decoder<MAX_PAYLOAD> dec;
+    uint8_t wire[frame_codec::max_encoded_size(MAX_PAYLOAD)];
+
+    for(size_t len = 0; len <= MAX_PAYLOAD; len++) {
+        std::vector<uint8_t> payload(len);
+        /* zero-free runs longer than a COBS block, then dense zeros, then random */
+        for(size_t i = 0; i < len; i++) {
+            if(len % 3 == 0)
+                payload[i] = static_cast<uint8_t>(1 + i % 255);
+            else if(len % 3 == 1)
+                payload[i] = (i % 2) ? 0 : static_cast<uint8_t>(rng());
+            else
+                payload[i] = static_cast<uint8_t>(rng());
+        }
+
+        size_t n = frame_codec::encode_frame(payload.data(), len, wire, sizeof(wire));
+        CHECK(n > 0 && n <= frame_codec::max_encoded_size(len));
+        for(size_t i = 0; i + 1 < n; i++)
+            CHECK(wire[i] != frame_codec::delimiter);
+        CHECK_EQ(wire[n - 1], frame_codec::delimiter);
+
+        CHECK(feed(dec, wire, n) == frame_codec::decode_status::frame);
+        CHECK_EQ(dec.size(), len);
+        CHECK(std::equal(payload.begin(), payload.end(), dec.data()));
+
+        /* one too small: nothing written rather than a truncated frame */
+        CHECK_EQ(frame_codec::encode_frame(payload.data(), len, wire, n - 1), 0);
+    }
+}
+
+static void testDamage(std::mt19937 &rng) {
+    frame_codec::frame_decoder<MAX_PAYLOAD> dec;
+    uint8_t payload[64];
+    uint8_t wire[frame_codec::max_encoded_size(MAX_PAYLOAD + 1)];
+    for(auto &b : payload)
+        b = static_cast<uint8_t>(rng() | 1);
+
+    size_t n = frame_codec::encode_frame(payload, sizeof(payload), wire, sizeof(wire));
+    /* any single non-zero byte change is caught, as bad COBS or bad CRC */
+    for(size_t i = 0; i + 1 < n; i++) {
+        uint8_t saved = wire[i];
+        wire[i] = static_cast<uint8_t>(saved ^ (1 + rng() % 255));
+        if(wire[i] == 0)
+            wire[i] = static_cast<uint8_t>(saved ^ 0x80);
+        frame_codec::decode_status st = feed(dec, wire, n);
+        CHECK(st == frame_codec::decode_status::crc_error || st == frame_codec::decode_status::malformed);
+        wire[i] = saved;
+        dec.reset();
+    }
+    CHECK(feed(dec, wire, n) == frame_codec::decode_status::frame);
+
+    /* a frame cut short by a delimiter is malformed, and the next one still decodes */
+    CHECK(feed(dec, wire, 3) != frame_codec::decode_status::frame);
+    dec.push(frame_codec::delimiter);
+    CHECK(feed(dec, wire, n) == frame_codec::decode_status::frame);
+
+    /* longer than the decoder holds */
+    std::vector<uint8_t> big(MAX_PAYLOAD + 1, 0x55);
+    n = frame_codec::encode_frame(big.data(), big.size(), wire, sizeof(wire));
+    CHECK(feed(dec, wire, n) == frame_codec::decode_status::overflow);
+    n = frame_codec::encode_frame(payload, sizeof(payload), wire, sizeof(wire));
+    CHECK(feed(dec, wire, n) == frame_codec::decode_status::frame);
+}
+
+int main() {
+    std::mt19937 rng(1234);
+    testCrc(rng);
+    testRoundTrip(rng);
+    testDamage(rng);
+    return checkResult("test_frame_codec");
+}
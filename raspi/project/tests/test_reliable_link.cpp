@@ -0,0 +1,194 @@
+/**
+ * @file test_reliable_link.cpp
+ * @author Ziad Fathy
+ * @brief reliable_link.h: two engines wired back to back through a lossy
+ *        in-memory line, on a simulated clock.
+ * @version 0.1
+ * @date 2025-09-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "check.hpp"
+#include "reliable_link.h"
+#include <functional>
+#include <random>
+#include <vector>
+
+using Frame = std::vector<uint8_t>;
+using DropFn = std::function<bool(const uint8_t *payload, size_t len)>;
+
+/* simulated time steps; starts just before the 32-bit microsecond wrap */
+static constexpr uint32_t STEP_US = 500;
+static constexpr uint32_t START_US = 0xFFFFFFFFu - 2000000u;
+
+struct Endpoint {
+    Endpoint() : engine(&Endpoint::emit, &Endpoint::deliver, this) {}
+
+    static void emit(void *ctx, const uint8_t *bytes, size_t len) {
+        static_cast<Endpoint *>(ctx)->wire.emplace_back(bytes, bytes + len);
+    }
+
+    static void deliver(void *ctx, const uint8_t *payload, size_t len) {
+        Endpoint *self = static_cast<Endpoint *>(ctx);
+        uint32_t id = frame_codec::load_le32(payload);
+        /* payload length and filler are derived from the id */
+        bool intact = len == 4 + id % (arq::link_max_payload - 3);
+        for(size_t i = 4; i < len; i++)
+            intact = intact && payload[i] == static_cast<uint8_t>(id + i);
+        if(!intact)
+            self->corrupt++;
+        self->received.push_back(id);
+    }
+
+    bool sendId(uint32_t id, uint32_t now) {
+        uint8_t payload[arq::link_max_payload];
+        size_t len = 4 + id % (arq::link_max_payload - 3);
+        frame_codec::store_le32(payload, id);
+        for(size_t i = 4; i < len; i++)
+            payload[i] = static_cast<uint8_t>(id + i);
+        return this->engine.send(payload, len, now);
+    }
+
+    arq::link<arq::link_window, arq::link_max_payload> engine;
+    std::vector<Frame> wire;           /* emitted, not yet carried to the peer */
+    std::vector<uint32_t> received;
+    uint32_t corrupt = 0;
+};
+
+/* carry one direction: decode each frame only to let the drop filter see it */
+static void carry(Endpoint &from, Endpoint &to, const DropFn &drop, uint32_t now) {
+    std::vector<Frame> frames;
+    frames.swap(from.wire);
+    for(const Frame &f : frames) {
+        frame_codec::frame_decoder<arq::header_size + arq::link_max_payload> dec;
+        size_t used;
+        if(dec.push(f.data(), f.size(), &used) == frame_codec::decode_status::frame &&
+           drop && drop(dec.data(), dec.size()))
+            continue;
+        to.engine.on_rx(f.data(), f.size(), now);
+    }
+}
+
+/*
+ * Send ids [0, count) from a to b and from b to a, stepping the clock until
+ * both sides have nothing in flight or maxSteps pass.
+ */
+static uint32_t run(Endpoint &a, Endpoint &b, uint32_t count, const DropFn &dropAB,
+                    const DropFn &dropBA, uint32_t now, uint32_t maxSteps = 200000) {
+    uint32_t nextA = 0, nextB = 0;
+    for(uint32_t step = 0; step < maxSteps; step++) {
+        while(nextA < count && a.sendId(nextA, now))
+            nextA++;
+        while(nextB < count && b.sendId(nextB, now))
+            nextB++;
+        carry(a, b, dropAB, now);
+        carry(b, a, dropBA, now);
+        now += STEP_US;
+        a.engine.poll(now);
+        b.engine.poll(now);
+        if(nextA == count && nextB == count && a.engine.in_flight() == 0 && b.engine.in_flight() == 0 &&
+           a.wire.empty() && b.wire.empty())
+            break;
+    }
+    CHECK_EQ(nextA, count);
+    CHECK_EQ(nextB, count);
+    return now;
+}
+
+static bool inOrder(const std::vector<uint32_t> &ids) {
+    for(size_t i = 1; i < ids.size(); i++)
+        if(ids[i] <= ids[i - 1])
+            return false;
+    return true;
+}
+
+static void testClean() {
+    Endpoint a, b;
+    run(a, b, 1000, nullptr, nullptr, START_US);
+    CHECK_EQ(a.received.size(), 1000);
+    CHECK_EQ(b.received.size(), 1000);
+    CHECK(inOrder(a.received) && inOrder(b.received));
+    CHECK_EQ(a.corrupt + b.corrupt, 0);
+    CHECK_EQ(a.engine.statistics().retransmits + b.engine.statistics().retransmits, 0);
+}
+
+static void testRandomLoss() {
+    std::mt19937 rng(99);
+    auto lossy = [&rng](const uint8_t *, size_t) { return rng() % 5 == 0; };
+    Endpoint a, b;
+    run(a, b, 1000, lossy, lossy, START_US);
+    /* 20% loss is far from max_retries: everything arrives, once, in order */
+    CHECK_EQ(a.received.size(), 1000);
+    CHECK_EQ(b.received.size(), 1000);
+    CHECK(inOrder(a.received) && inOrder(b.received));
+    CHECK_EQ(a.engine.statistics().dropped + b.engine.statistics().dropped, 0);
+    CHECK(a.engine.statistics().retransmits > 0);
+}
+
+/* one data frame that never gets through must not wedge the link */
+static void testGiveUpAndResync() {
+    const uint32_t victim = 37;
+    auto dropVictim = [victim](const uint8_t *payload, size_t len) {
+        return payload[0] == arq::frame_data && len >= arq::header_size + 4 &&
+               frame_codec::load_le32(payload + arq::header_size) == victim;
+    };
+    Endpoint a, b;
+    uint32_t now = run(a, b, 300, dropVictim, nullptr, START_US);
+
+    CHECK_EQ(a.engine.statistics().dropped, 1);
+    CHECK(a.engine.statistics().retransmits >= arq::default_config.max_retries);
+    CHECK_EQ(b.engine.statistics().skipped, 1);
+    /* b got everything else, in order, including what followed the lost frame */
+    CHECK_EQ(b.received.size(), 299);
+    CHECK(inOrder(b.received));
+    for(uint32_t id : b.received)
+        CHECK(id != victim);
+    /* the other direction was never held up */
+    CHECK_EQ(a.received.size(), 300);
+    CHECK(inOrder(a.received));
+
+    /* and traffic keeps flowing both ways afterwards, with no further drops */
+    a.received.clear();
+    b.received.clear();
+    run(a, b, 100, nullptr, nullptr, now);
+    CHECK_EQ(a.received.size(), 100);
+    CHECK_EQ(b.received.size(), 100);
+    CHECK_EQ(a.engine.statistics().dropped, 1);
+    CHECK_EQ(b.engine.statistics().skipped, 1);
+}
+
+/* the peer's acks (not the data) are lost: the frame was delivered, so nothing is skipped */
+static void testGiveUpAfterLostAcks() {
+    Endpoint a, b;
+    bool blackout = false;
+    auto dropAcks = [&blackout](const uint8_t *, size_t) { return blackout; };
+    uint32_t now = START_US;
+    CHECK(a.sendId(5, now));
+    blackout = true;
+    for(int i = 0; i < 100000 && a.engine.statistics().dropped == 0; i++) {
+        carry(a, b, nullptr, now);
+        carry(b, a, dropAcks, now);
+        now += STEP_US;
+        a.engine.poll(now);
+        b.engine.poll(now);
+    }
+    CHECK_EQ(a.engine.statistics().dropped, 1);
+    CHECK(b.received.size() == 1 && b.received[0] == 5);
+    blackout = false;
+    a.received.clear();
+    b.received.clear();
+    run(a, b, 50, nullptr, nullptr, now);
+    CHECK_EQ(b.engine.statistics().skipped, 0);
+    CHECK_EQ(b.received.size(), 50);
+    CHECK_EQ(a.received.size(), 50);
+}
+
+int main() {
+    testClean();
+    testRandomLoss();
+    testGiveUpAndResync();
+    testGiveUpAfterLostAcks();
+    return checkResult("test_reliable_link");
+}
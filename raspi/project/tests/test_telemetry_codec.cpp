@@ -0,0 +1,157 @@
+/**
+ * @file test_telemetry_codec.cpp
+ * @author Ziad Fathy
+ * @brief telemetry_codec.h: keyframe/delta round trips, recovery after a
+ *        sequence gap and malformed input.
+ * @version 0.1
+ * @date 2025-09-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "check.hpp"
+#include "telemetry_codec.h"
+#include <climits>
+#include <random>
+#include <vector>
+
+using Message = std::vector<uint8_t>;
+
+static std::vector<robot_protocol::telemetry> makeSamples(std::mt19937 &rng, size_t count) {
+    std::vector<robot_protocol::telemetry> samples(count);
+    /* start near the 32-bit timestamp wrap, with jitter on a 10 ms period */
+    uint32_t ts = 0xFFFFFFFFu - 100000u;
+    int32_t pos[robot_protocol::motor_count] = {0, -5, 1000, INT32_MAX - 50};
+    for(size_t k = 0; k < count; k++) {
+        ts += 10000 + rng() % 200;
+        for(uint8_t i = 0; i < robot_protocol::motor_count; i++) {
+            /* wraps past INT32_MAX on motor 3; an occasional large jump elsewhere */
+            int32_t step = (k % 17 == 0) ? static_cast<int32_t>(rng() % 2000000) - 1000000
+                                         : static_cast<int32_t>(rng() % 41) - 20;
+            pos[i] = static_cast<int32_t>(static_cast<uint32_t>(pos[i]) + static_cast<uint32_t>(step));
+            samples[k].position[i] = pos[i];
+        }
+        samples[k].timestamp_us = ts;
+        samples[k].distance_cm = (k % 5 == 0) ? 0.0f : 10.0f + (rng() % 30000) / 100.0f;
+    }
+    return samples;
+}
+
+static std::vector<Message> encodeAll(const std::vector<robot_protocol::telemetry> &samples,
+                                      uint8_t batch, uint16_t keyframe) {
+    telemetry_codec::encoder enc;
+    enc.configure(batch, keyframe);
+    std::vector<Message> out;
+    auto send = [&out](const uint8_t *m, size_t n) { out.emplace_back(m, m + n); };
+    for(const auto &t : samples)
+        enc.add(t, send);
+    enc.flush(send);
+    return out;
+}
+
+static bool sameSample(const robot_protocol::telemetry &a, const robot_protocol::telemetry &b) {
+    if(a.timestamp_us != b.timestamp_us)
+        return false;
+    for(uint8_t i = 0; i < robot_protocol::motor_count; i++)
+        if(a.position[i] != b.position[i])
+            return false;
+    return telemetry_codec::quantize_distance(a.distance_cm) == telemetry_codec::quantize_distance(b.distance_cm);
+}
+
+static void testRoundTrip(std::mt19937 &rng) {
+    std::vector<robot_protocol::telemetry> samples = makeSamples(rng, 500);
+    std::vector<Message> msgs = encodeAll(samples, 4, 50);
+
+    telemetry_codec::decoder dec;
+    robot_protocol::telemetry out[telemetry_codec::max_batch];
+    size_t next = 0;
+    for(const Message &m : msgs) {
+        CHECK(m.size() <= robot_protocol::max_message);
+        int n = dec.decode(m.data(), m.size(), out, telemetry_codec::max_batch);
+        CHECK(n > 0);
+        for(int i = 0; i < n && next < samples.size(); i++)
+            CHECK(sameSample(out[i], samples[next++]));
+    }
+    CHECK_EQ(next, samples.size());
+    CHECK_EQ(dec.gap_count(), 0);
+    CHECK_EQ(dec.malformed_count(), 0);
+}
+
+static void testSequenceGap(std::mt19937 &rng) {
+    std::vector<robot_protocol::telemetry> samples = makeSamples(rng, 200);
+    const uint8_t batch = 3;
+    const uint16_t keyframe = 30;
+    std::vector<Message> msgs = encodeAll(samples, batch, keyframe);
+
+    /* lose the second delta after the first keyframe */
+    CHECK(msgs[0][0] == robot_protocol::msg_telemetry_key);
+    size_t lost = 2;
+    CHECK(msgs[lost][0] == robot_protocol::msg_telemetry_delta);
+
+    telemetry_codec::decoder dec;
+    robot_protocol::telemetry out[telemetry_codec::max_batch];
+    size_t next = 0;
+    bool resynced = false;
+    for(size_t k = 0; k < msgs.size(); k++) {
+        const Message &m = msgs[k];
+        size_t samplesIn = m[0] == robot_protocol::msg_telemetry_key ? 1 : m[2];
+        if(k == lost) {
+            next += samplesIn;
+            continue;
+        }
+        int n = dec.decode(m.data(), m.size(), out, telemetry_codec::max_batch);
+        if(k > lost && !resynced) {
+            if(m[0] == robot_protocol::msg_telemetry_delta) {
+                /* nothing delivered from deltas built on the lost one */
+                CHECK_EQ(n, 0);
+                CHECK(dec.waiting_for_keyframe());
+                next += samplesIn;
+                continue;
+            }
+            resynced = true;
+        }
+        CHECK_EQ(n, samplesIn);
+        for(int i = 0; i < n; i++)
+            CHECK(sameSample(out[i], samples[next++]));
+    }
+    CHECK(resynced);
+    CHECK_EQ(next, samples.size());
+    CHECK_EQ(dec.gap_count(), 1);
+}
+
+static void testMalformed(std::mt19937 &rng) {
+    std::vector<robot_protocol::telemetry> samples = makeSamples(rng, 20);
+    std::vector<Message> msgs = encodeAll(samples, 4, 100);
+    telemetry_codec::decoder dec;
+    robot_protocol::telemetry out[telemetry_codec::max_batch];
+
+    /* not compact telemetry at all */
+    const uint8_t other[] = {robot_protocol::msg_telemetry, 0, 0};
+    CHECK_EQ(dec.decode(other, sizeof(other), out, telemetry_codec::max_batch), -1);
+
+    /* every truncation of a keyframe and of a delta is refused without reading past the end */
+    for(size_t len = 2; len < msgs[0].size(); len++) {
+        Message cut(msgs[0].begin(), msgs[0].begin() + len);
+        CHECK_EQ(dec.decode(cut.data(), cut.size(), out, telemetry_codec::max_batch), 0);
+        CHECK(dec.waiting_for_keyframe());
+    }
+    CHECK_EQ(dec.decode(msgs[0].data(), msgs[0].size(), out, telemetry_codec::max_batch), 1);
+    Message cut(msgs[1].begin(), msgs[1].end() - 1);
+    CHECK_EQ(dec.decode(cut.data(), cut.size(), out, telemetry_codec::max_batch), 0);
+    CHECK(dec.waiting_for_keyframe());
+    CHECK(dec.malformed_count() > 0);
+
+    /* a varint that never ends */
+    const uint8_t endless[] = {robot_protocol::msg_telemetry_key, 0, 1, 2, 3, 4,
+                               0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01};
+    CHECK_EQ(dec.decode(endless, sizeof(endless), out, telemetry_codec::max_batch), 0);
+}
+
+int main() {
+    std::mt19937 rng(4321);
+    testRoundTrip(rng);
+    testSequenceGap(rng);
+    testMalformed(rng);
+    return checkResult("test_telemetry_codec");
+}
@@ -0,0 +1,465 @@
+/**
+ * @file binlog_decode.cpp
+ * @author Ziad Fathy
+ * @brief formats a binary log (binlog.hpp) back into text.
+ * @version 0.1
+ * @date 2025-09-19
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Ticks are mapped to CLOCK_MONOTONIC by interpolating between the clock
+ * records the writer drops in once a second. Entries of all threads are
+ * merged into one timeline unless -u is given.
+ *
+ *   binlog_decode robotd.blog
+ *   binlog_decode -w -s -m warn robotd.blog     wall clock, source lines, warnings up
+ *   binlog_decode -i robotd.blog                per statement counts
+ */
+
+#include "binlog.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+/* --------- Config --------- */
+struct DecodeConfig {
+    std::string path;
+    bool wallClock = false;         // print CLOCK_REALTIME instead of time since creation
+    bool sourceLines = false;
+    bool unsorted = false;
+    bool infoOnly = false;
+    uint8_t minLevel = BINLOG_LEVEL_DEBUG;
+};
+
+static const char *LEVEL_NAMES[] = { "DEBUG", "INFO ", "WARN ", "ERROR" };
+
+struct DecodedSite {
+    uint8_t level = 0;
+    uint32_t line = 0;
+    std::string file;
+    std::string format;
+    std::string types;
+    uint64_t count = 0;
+};
+
+struct DecodedEntry {
+    uint64_t ticks;
+    uint32_t threadId;
+    uint32_t site;
+    const uint8_t *args;        // packed arguments, inside the mapping
+    const uint8_t *end;
+};
+
+/**
+ * @brief read one packed argument of the given type code.
+ *
+ * @return past it, or nullptr if it runs past end.
+ */
+static const uint8_t *unpack_arg(char type, const uint8_t *p, const uint8_t *end, uint64_t &value, std::string &str) {
+    if(type == BINLOG_ARG_DOUBLE) {
+        if(end - p < 8)
+            return nullptr;
+        memcpy(&value, p, 8);
+        return p + 8;
+    }
+    p = binlog_get_varint(p, end, value);
+    if(p == nullptr)
+        return nullptr;
+    if(type == BINLOG_ARG_I32 || type == BINLOG_ARG_I64)
+        value = static_cast<uint64_t>(binlog_unzigzag(value));
+    if(type == BINLOG_ARG_STRING) {
+        if(static_cast<uint64_t>(end - p) < value)
+            return nullptr;
+        str.assign(reinterpret_cast<const char *>(p), value);
+        return p + value;
+    }
+    return p;
+}
+
+/* --------- Class --------- */
+class BinLogDecoder {
+    public:
+        explicit BinLogDecoder(const DecodeConfig &cfg);
+        void run();
+        ~BinLogDecoder();
+    private:
+        bool parse(bool print, bool collect);
+        void print(const DecodedEntry &e);
+        void printInfo() const;
+        std::string format(const DecodedSite &site, const uint8_t *args, const uint8_t *end) const;
+        uint64_t toMonotonicNs(uint64_t ticks) const;
+        uint64_t toRealtimeNs(uint64_t ticks) const;
+
+        DecodeConfig cfg;
+        int fd;
+        size_t size;
+        const uint8_t *map;
+        BinLogFileHeader header;
+        std::map<uint32_t, DecodedSite> sites;
+        std::vector<BinLogClockRecord> clocks;
+        std::vector<DecodedEntry> entries;
+        std::map<uint32_t, uint64_t> dropped;
+        uint64_t truncatedBytes = 0;
+};
+
+/**
+ * @brief Construct a new BinLogDecoder object: map the file, check the header.
+ *
+ */
+BinLogDecoder::BinLogDecoder(const DecodeConfig &cfg) :
+            cfg(cfg),
+            fd(-1),
+            size(0),
+            map(nullptr) {
+    this->fd = open(cfg.path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if(this->fd < 0 || fstat(this->fd, &st) != 0)
+        throw std::runtime_error("cannot open " + cfg.path);
+    this->size = st.st_size;
+    if(this->size < sizeof(BinLogFileHeader))
+        throw std::runtime_error(cfg.path + " is not a binary log");
+    void *p = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, this->fd, 0);
+    if(p == MAP_FAILED)
+        throw std::runtime_error("cannot map " + cfg.path);
+    this->map = static_cast<const uint8_t *>(p);
+    memcpy(&this->header, this->map, sizeof(this->header));
+    if(this->header.magic != BINLOG_MAGIC || this->header.version != BINLOG_VERSION)
+        throw std::runtime_error(cfg.path + " is not a binary log (or a newer version)");
+}
+
+void BinLogDecoder::run() {
+    /* clock records come after the entries they cover: always collect them first */
+    bool streaming = this->cfg.unsorted && !this->cfg.infoOnly;
+    if(streaming) {
+        this->parse(false, false);
+        for(auto &s : this->sites)
+            s.second.count = 0;
+    }
+    this->parse(streaming, !streaming && !this->cfg.infoOnly);
+    if(this->cfg.infoOnly) {
+        this->printInfo();
+        return;
+    }
+    if(!streaming) {
+        std::stable_sort(this->entries.begin(), this->entries.end(),
+                         [](const DecodedEntry &a, const DecodedEntry &b) { return a.ticks < b.ticks; });
+        for(const DecodedEntry &e : this->entries)
+            this->print(e);
+    }
+    for(const auto &d : this->dropped)
+        fprintf(stderr, "binlog_decode: thread %u dropped %llu entries\n", d.first, (unsigned long long)d.second);
+    if(this->truncatedBytes > 0)
+        fprintf(stderr, "binlog_decode: last %llu bytes truncated\n", (unsigned long long)this->truncatedBytes);
+}
+
+/**
+ * @brief walk the records; entries are printed right away if print and
+ *        kept for sorting if collect.
+ *
+ * @return false if the file ends in a partial record (writer still running
+ *         or killed).
+ */
+bool BinLogDecoder::parse(bool print, bool collect) {
+    size_t pos = sizeof(BinLogFileHeader);
+    while(pos + sizeof(BinLogRecordHeader) <= this->size) {
+        BinLogRecordHeader h;
+        memcpy(&h, this->map + pos, sizeof(h));
+        const uint8_t *body = this->map + pos + sizeof(h);
+        if(pos + sizeof(h) + h.length > this->size)
+            break;
+        pos += sizeof(h) + h.length;
+
+        if(h.type == BINLOG_RECORD_SITE && h.length >= sizeof(BinLogSiteRecord)) {
+            BinLogSiteRecord r;
+            memcpy(&r, body, sizeof(r));
+            if(sizeof(r) + r.fileLength + r.formatLength + r.argCount > h.length)
+                continue;
+            DecodedSite &s = this->sites[r.id];
+            const char *text = reinterpret_cast<const char *>(body + sizeof(r));
+            s.level = r.level;
+            s.line = r.line;
+            s.file.assign(text, r.fileLength);
+            s.format.assign(text + r.fileLength, r.formatLength);
+            s.types.assign(text + r.fileLength + r.formatLength, r.argCount);
+        } else if(h.type == BINLOG_RECORD_CLOCK && h.length >= sizeof(BinLogClockRecord)) {
+            BinLogClockRecord c;
+            memcpy(&c, body, sizeof(c));
+            if(this->clocks.empty() || c.ticks > this->clocks.back().ticks)
+                this->clocks.push_back(c);
+        } else if(h.type == BINLOG_RECORD_ENTRIES && h.length >= sizeof(BinLogEntriesRecord)) {
+            BinLogEntriesRecord r;
+            memcpy(&r, body, sizeof(r));
+            const uint8_t *p = body + sizeof(r);
+            const uint8_t *end = body + h.length;
+            uint64_t ticks = r.baseTicks;
+            while(p != nullptr && p < end) {
+                uint64_t id, delta;
+                if((p = binlog_get_varint(p, end, id)) == nullptr || (p = binlog_get_varint(p, end, delta)) == nullptr)
+                    break;
+                ticks += binlog_unzigzag(delta);
+                auto site = this->sites.find(static_cast<uint32_t>(id));
+                if(site == this->sites.end())
+                    break;      // cannot tell where its arguments end
+                const uint8_t *args = p;
+                uint64_t v;
+                std::string str;
+                for(size_t i = 0; p != nullptr && i < site->second.types.size(); i++)
+                    p = unpack_arg(site->second.types[i], p, end, v, str);
+                if(p == nullptr || site->second.level < this->cfg.minLevel)
+                    continue;
+                site->second.count++;
+                DecodedEntry d = { ticks, r.threadId, site->first, args, p };
+                if(print)
+                    this->print(d);
+                if(collect)
+                    this->entries.push_back(d);
+            }
+        } else if(h.type == BINLOG_RECORD_DROPPED && h.length >= sizeof(BinLogDroppedRecord)) {
+            BinLogDroppedRecord d;
+            memcpy(&d, body, sizeof(d));
+            this->dropped[d.threadId] = d.count;
+        }
+    }
+    this->truncatedBytes = this->size - pos;
+    return pos == this->size;
+}
+
+void BinLogDecoder::print(const DecodedEntry &e) {
+    const DecodedSite &site = this->sites[e.site];
+    std::string text = this->format(site, e.args, e.end);
+
+    char stamp[48];
+    if(this->cfg.wallClock) {
+        uint64_t ns = this->toRealtimeNs(e.ticks);
+        time_t sec = static_cast<time_t>(ns / 1000000000ULL);
+        struct tm tm;
+        localtime_r(&sec, &tm);
+        size_t n = strftime(stamp, sizeof(stamp), "%F %T", &tm);
+        snprintf(stamp + n, sizeof(stamp) - n, ".%06llu", (unsigned long long)(ns % 1000000000ULL / 1000));
+    } else {
+        int64_t ns = static_cast<int64_t>(this->toMonotonicNs(e.ticks) - this->header.createdMonotonicNs);
+        snprintf(stamp, sizeof(stamp), "%12.6f", ns / 1e9);
+    }
+    const char *level = site.level < BINLOG_LEVEL_OFF ? LEVEL_NAMES[site.level] : "?    ";
+    if(this->cfg.sourceLines)
+        printf("%s %s [%u] %s:%u: %s\n", stamp, level, e.threadId, site.file.c_str(), site.line, text.c_str());
+    else
+        printf("%s %s [%u] %s\n", stamp, level, e.threadId, text.c_str());
+}
+
+void BinLogDecoder::printInfo() const {
+    time_t created = static_cast<time_t>(this->header.createdRealtimeNs / 1000000000ULL);
+    uint64_t total = 0;
+    for(const auto &s : this->sites)
+        total += s.second.count;
+    printf("created  %s", ctime(&created));
+    printf("entries  %llu from %zu statements\n", (unsigned long long)total, this->sites.size());
+    if(this->clocks.size() >= 2) {
+        const BinLogClockRecord &a = this->clocks.front(), &b = this->clocks.back();
+        printf("span     %.3f s, tick rate %.3f MHz\n", (b.monotonicNs - a.monotonicNs) / 1e9,
+               (b.ticks - a.ticks) * 1e3 / (b.monotonicNs - a.monotonicNs));
+    }
+    for(const auto &d : this->dropped)
+        printf("dropped  %llu in thread %u\n", (unsigned long long)d.second, d.first);
+    for(const auto &s : this->sites)
+        if(s.second.count > 0)
+            printf("%10llu  %s:%u  %s\n", (unsigned long long)s.second.count, s.second.file.c_str(),
+                   s.second.line, s.second.format.c_str());
+}
+
+/**
+ * @brief printf the stored arguments through the site's format, one
+ *        conversion at a time, with the length modifier the stored type needs.
+ *
+ */
+std::string BinLogDecoder::format(const DecodedSite &site, const uint8_t *args, const uint8_t *end) const {
+    std::string out;
+    size_t arg = 0;
+    char buf[BINLOG_MAX_STRING + 64];
+
+    auto next = [&](uint64_t &value, std::string &str) -> char {
+        if(arg >= site.types.size())
+            return 0;
+        char type = site.types[arg++];
+        args = unpack_arg(type, args, end, value, str);
+        return args != nullptr ? type : 0;
+    };
+
+    const std::string &f = site.format;
+    for(size_t i = 0; i < f.size(); i++) {
+        if(f[i] != '%') {
+            out += f[i];
+            continue;
+        }
+        if(i + 1 < f.size() && f[i + 1] == '%') {
+            out += '%';
+            i++;
+            continue;
+        }
+        /* flags, width, precision; '*' takes the next int argument */
+        std::string spec = "%";
+        size_t j = i + 1;
+        for(; j < f.size() && strchr("-+ #0123456789.*", f[j]); j++) {
+            if(f[j] == '*') {
+                uint64_t v = 0;
+                std::string s;
+                if(next(v, s) == 0)
+                    return out + " <missing argument>";
+                spec += std::to_string(static_cast<int32_t>(v));
+            } else {
+                spec += f[j];
+            }
+        }
+        while(j < f.size() && strchr("hlLqjzt", f[j]))
+            j++;
+        if(j >= f.size())
+            break;
+        char conv = f[j];
+        i = j;
+
+        uint64_t v = 0;
+        std::string s;
+        char type = next(v, s);
+        if(type == 0)
+            return out + " <missing argument>";
+        switch(type) {
+            case BINLOG_ARG_STRING:
+                snprintf(buf, sizeof(buf), (spec + 's').c_str(), s.c_str());
+                break;
+            case BINLOG_ARG_DOUBLE: {
+                double d;
+                memcpy(&d, &v, sizeof(d));
+                snprintf(buf, sizeof(buf), (spec + conv).c_str(), d);
+                break;
+            }
+            case BINLOG_ARG_POINTER:
+                snprintf(buf, sizeof(buf), (spec + 'p').c_str(), reinterpret_cast<void *>(static_cast<uintptr_t>(v)));
+                break;
+            case BINLOG_ARG_I32:
+                snprintf(buf, sizeof(buf), (spec + conv).c_str(), static_cast<int32_t>(v));
+                break;
+            case BINLOG_ARG_U32:
+                snprintf(buf, sizeof(buf), (spec + conv).c_str(), static_cast<uint32_t>(v));
+                break;
+            default:
+                snprintf(buf, sizeof(buf), (spec + "ll" + conv).c_str(), static_cast<long long>(v));
+                break;
+        }
+        out += buf;
+    }
+    return out;
+}
+
+/**
+ * @brief interpolate between the clock records either side of ticks,
+ *        extrapolating from the nearest pair outside them.
+ *
+ */
+uint64_t BinLogDecoder::toMonotonicNs(uint64_t ticks) const {
+    const std::vector<BinLogClockRecord> &c = this->clocks;
+    if(c.empty())
+        return this->header.createdMonotonicNs;
+    if(c.size() == 1) {
+        double rate = this->header.ticksPerSecond ? this->header.ticksPerSecond / 1e9 : 1.0;
+        return c[0].monotonicNs + static_cast<int64_t>((static_cast<double>(ticks) - c[0].ticks) / rate);
+    }
+    auto it = std::upper_bound(c.begin(), c.end(), ticks,
+                               [](uint64_t t, const BinLogClockRecord &r) { return t < r.ticks; });
+    size_t hi = std::min<size_t>(std::max<size_t>(it - c.begin(), 1), c.size() - 1);
+    const BinLogClockRecord &a = c[hi - 1], &b = c[hi];
+    double nsPerTick = static_cast<double>(b.monotonicNs - a.monotonicNs) / (b.ticks - a.ticks);
+    return a.monotonicNs + static_cast<int64_t>((static_cast<double>(ticks) - a.ticks) * nsPerTick);
+}
+
+uint64_t BinLogDecoder::toRealtimeNs(uint64_t ticks) const {
+    uint64_t mono = this->toMonotonicNs(ticks);
+    if(this->clocks.empty())
+        return this->header.createdRealtimeNs + (mono - this->header.createdMonotonicNs);
+    /* the latest pairing below mono, so wall clock steps show up where they happened */
+    auto it = std::upper_bound(this->clocks.begin(), this->clocks.end(), mono,
+                               [](uint64_t m, const BinLogClockRecord &r) { return m < r.monotonicNs; });
+    const BinLogClockRecord &r = it == this->clocks.begin() ? *it : *(it - 1);
+    return r.realtimeNs + (mono - r.monotonicNs);
+}
+
+/**
+ * @brief Destroy the BinLogDecoder object
+ *
+ */
+BinLogDecoder::~BinLogDecoder() {
+    if(this->map != nullptr)
+        munmap(const_cast<uint8_t *>(this->map), this->size);
+    if(this->fd >= 0)
+        close(this->fd);
+}
+
+static int parse_level(const char *name) {
+    for(int i = 0; i < BINLOG_LEVEL_OFF; i++)
+        if(strncasecmp(name, LEVEL_NAMES[i], strlen(name)) == 0)
+            return i;
+    return -1;
+}
+
+static void print_usage(const char *program_name) {
+    printf("Usage: %s [options] <log>\n", program_name);
+    printf("Options:\n");
+    printf("  -m <level>   Lowest level to print: debug, info, warn, error (default debug)\n");
+    printf("  -w           Wall clock timestamps instead of seconds since the log was opened\n");
+    printf("  -s           Show the source file and line of each statement\n");
+    printf("  -u           Print in file order instead of merging threads by time\n");
+    printf("  -i           Print a summary of the log and exit\n");
+    printf("  -h           Show this help\n");
+}
+
+int main(int argc, char *argv[]) {
+    DecodeConfig cfg;
+    int opt;
+    while((opt = getopt(argc, argv, "m:wsuih")) != -1) {
+        switch(opt) {
+            case 'm': {
+                int level = parse_level(optarg);
+                if(level < 0) {
+                    print_usage(argv[0]);
+                    return 1;
+                }
+                cfg.minLevel = static_cast<uint8_t>(level);
+                break;
+            }
+            case 'w': cfg.wallClock = true; break;
+            case 's': cfg.sourceLines = true; break;
+            case 'u': cfg.unsorted = true; break;
+            case 'i': cfg.infoOnly = true; break;
+            case 'h':
+                print_usage(argv[0]);
+                return 0;
+            default:
+                print_usage(argv[0]);
+                return 1;
+        }
+    }
+    if(optind >= argc) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    cfg.path = argv[optind];
+
+    try {
+        BinLogDecoder decoder(cfg);
+        decoder.run();
+    } catch(const std::exception &e) {
+        fprintf(stderr, "binlog_decode: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,328 @@
+/**
+ * @file control_loop.cpp
+ * @author Ziad Fathy
+ * @brief fixed-rate wheel speed loop: read telemetry, run a PI controller
+ *        per motor, send the commands, on a PeriodicExecutor tick.
+ * @version 0.1
+ * @date 2025-09-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Owns the board link itself (stop robotd first), asks for compact
+ * telemetry at the loop rate (or what the link carries, if less) and holds
+ * every wheel at the target encoder speed. Exits with the executor's jitter / overrun / stage report.
+ *
+ *   control_loop -f 500 -v 1500 -t 10
+ *   control_loop -p pty:///tmp/ttySTM32 -f 1000 -P 80 -C 3
+ */
+
+#include "frame_codec.h"
+#include "periodic_executor.hpp"
+#include "robot_protocol.h"
+#include "telemetry_codec.h"
+#include "transport.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <unistd.h>
+
+/* --------- Config --------- */
+struct ControlConfig {
+    std::string port = "/dev/serial0";
+    PeriodicExecutorConfig loop = DEFAULT_PERIODIC_EXECUTOR_CONFIG;
+    double seconds = 0.0;           // 0 = until SIGINT
+    uint16_t telemetryHz = 0;       // 0 = loop rate, at most DEFAULT_TELEMETRY_LIMIT_HZ
+    double targetSpeed = 1500.0;    // encoder counts/s, negative = reverse
+    double kp = 0.02;               // duty % per count/s
+    double ki = 0.5;                // duty % per count
+};
+
+/* encoder counts are integers: at 1 kHz one sample apart is too coarse a
+ * speed, so speeds span at least this much board time */
+static constexpr uint32_t SPEED_WINDOW_US = 10000;
+
+/* what 115200 baud carries in compact single-sample frames, with headroom:
+ * asking for more only queues telemetry up and delays the loop's input */
+static constexpr uint16_t DEFAULT_TELEMETRY_LIMIT_HZ = 250;
+
+static PeriodicExecutor *loop_executor = nullptr;
+
+static void signal_handler(int) {
+    if(loop_executor != nullptr)
+        loop_executor->stop();
+}
+
+/* --------- Class --------- */
+class ControlLoop {
+    public:
+        explicit ControlLoop(const ControlConfig &cfg);
+        void run();
+        void printStats() const;
+        ~ControlLoop();
+    private:
+        struct Wheel {
+            double speed = 0.0;     // counts/s over the last SPEED_WINDOW_US
+            double integral = 0.0;  // duty %
+            uint8_t duty = 0;
+            uint8_t dir = robot_protocol::stop;
+            uint8_t sentDuty = 0xFF;
+            uint8_t sentDir = 0xFF;
+        };
+
+        void readTelemetry(const TickInfo &tick);
+        void onMessage(const uint8_t *msg, size_t len);
+        void onSample(const robot_protocol::telemetry &t);
+        void control(const TickInfo &tick);
+        void sendCommands(const TickInfo &tick);
+        void sendMessage(const uint8_t *msg, size_t len);
+
+        ControlConfig cfg;
+        std::unique_ptr<Transport> link;
+        PeriodicExecutor executor;
+        frame_codec::frame_decoder<robot_protocol::max_message> frames;
+        telemetry_codec::decoder telemetryDecoder;
+        robot_protocol::telemetry reference{};     // start of the speed window
+        bool haveSample = false;
+        bool freshSample = false;
+        uint64_t lastControlNs = 0;
+        Wheel wheels[robot_protocol::motor_count];
+
+        uint64_t samples = 0;
+        uint64_t staleTicks = 0;        // ticks with no new speed to act on
+        uint64_t commandsSent = 0;
+        uint64_t writesShort = 0;       // TX buffer full, commands resent next tick
+        uint64_t crcErrors = 0;
+};
+
+/**
+ * @brief Construct a new ControlLoop object: open the link and set up the
+ *        read -> control -> send stages.
+ *
+ */
+ControlLoop::ControlLoop(const ControlConfig &cfg) :
+            cfg(cfg),
+            link(Transport::fromUri(cfg.port)),
+            executor(cfg.loop) {
+    this->link->openPort();
+    this->link->setNonBlocking(true);
+
+    this->executor.addStage("read", [this](const TickInfo &t) { this->readTelemetry(t); });
+    this->executor.addStage("control", [this](const TickInfo &t) { this->control(t); });
+    this->executor.addStage("send", [this](const TickInfo &t) { this->sendCommands(t); });
+}
+
+void ControlLoop::run() {
+    /* one compact sample per frame: batching would add up to a period of latency */
+    uint8_t msg[robot_protocol::format_size];
+    uint16_t hz = this->cfg.telemetryHz;
+    if(hz == 0)
+        hz = static_cast<uint16_t>(std::min<uint32_t>(this->cfg.loop.rateHz, DEFAULT_TELEMETRY_LIMIT_HZ));
+    this->sendMessage(msg, robot_protocol::encode_telemetry_format(msg, robot_protocol::format_compact, 1, hz));
+    this->sendMessage(msg, robot_protocol::encode_telemetry_rate(msg, hz));
+
+    uint64_t ticks = static_cast<uint64_t>(this->cfg.seconds * this->cfg.loop.rateHz);
+    loop_executor = &this->executor;
+    try {
+        this->executor.run(ticks);
+    } catch(...) {
+        loop_executor = nullptr;
+        throw;
+    }
+    loop_executor = nullptr;
+}
+
+/**
+ * @brief stage 1: drain whatever the link holds and keep the newest sample.
+ *
+ */
+void ControlLoop::readTelemetry(const TickInfo &) {
+    uint8_t buf[512];
+    size_t n;
+    while((n = this->link->readInto(buf, sizeof(buf))) > 0) {
+        for(size_t i = 0; i < n; i++) {
+            frame_codec::decode_status st = this->frames.push(buf[i]);
+            if(st == frame_codec::decode_status::frame)
+                this->onMessage(this->frames.data(), this->frames.size());
+            else if(st != frame_codec::decode_status::pending)
+                this->crcErrors++;
+        }
+    }
+}
+
+void ControlLoop::onMessage(const uint8_t *msg, size_t len) {
+    robot_protocol::telemetry t[telemetry_codec::max_batch];
+    if(robot_protocol::decode_telemetry(msg, len, &t[0])) {
+        this->onSample(t[0]);
+        return;
+    }
+    int n = this->telemetryDecoder.decode(msg, len, t, telemetry_codec::max_batch);
+    for(int i = 0; i < n; i++)
+        this->onSample(t[i]);
+}
+
+void ControlLoop::onSample(const robot_protocol::telemetry &t) {
+    this->samples++;
+    if(!this->haveSample) {
+        this->reference = t;
+        this->haveSample = true;
+        return;
+    }
+    uint32_t span = t.timestamp_us - this->reference.timestamp_us;
+    if(span < SPEED_WINDOW_US)
+        return;
+    for(int i = 0; i < robot_protocol::motor_count; i++)
+        this->wheels[i].speed = (t.position[i] - this->reference.position[i]) / (span / 1e6);
+    this->reference = t;
+    this->freshSample = true;
+}
+
+/**
+ * @brief stage 2: PI on wheel speed. The integral is clamped to the duty
+ *        range so a stalled wheel does not wind it up.
+ *
+ */
+void ControlLoop::control(const TickInfo &tick) {
+    if(!this->freshSample) {
+        this->staleTicks++;
+        return;
+    }
+    this->freshSample = false;
+    double dt = this->lastControlNs ? (tick.deadlineNs - this->lastControlNs) / 1e9 : SPEED_WINDOW_US / 1e6;
+    this->lastControlNs = tick.deadlineNs;
+    for(Wheel &w : this->wheels) {
+        double error = this->cfg.targetSpeed - w.speed;
+        w.integral = std::max(-100.0, std::min(100.0, w.integral + this->cfg.ki * error * dt));
+        double u = std::max(-100.0, std::min(100.0, this->cfg.kp * error + w.integral));
+        w.dir = u >= 0.0 ? robot_protocol::forward : robot_protocol::reverse;
+        w.duty = static_cast<uint8_t>(std::lround(std::fabs(u)));
+    }
+}
+
+/**
+ * @brief stage 3: one cmd_motor per wheel whose output changed, in one
+ *        write.
+ *
+ */
+void ControlLoop::sendCommands(const TickInfo &) {
+    uint8_t out[robot_protocol::motor_count][frame_codec::max_encoded_size(robot_protocol::motor_cmd_size)];
+    struct iovec iov[robot_protocol::motor_count];
+    int count = 0;
+    size_t bytes = 0;
+    for(uint8_t i = 0; i < robot_protocol::motor_count; i++) {
+        Wheel &w = this->wheels[i];
+        if(w.duty == w.sentDuty && w.dir == w.sentDir)
+            continue;
+        uint8_t msg[robot_protocol::motor_cmd_size];
+        robot_protocol::encode_motor(msg, { i, w.dir, w.duty });
+        iov[count].iov_base = out[count];
+        iov[count].iov_len = frame_codec::encode_frame(msg, sizeof(msg), out[count], sizeof(out[count]));
+        bytes += iov[count].iov_len;
+        w.sentDuty = w.duty;
+        w.sentDir = w.dir;
+        count++;
+    }
+    if(count == 0)
+        return;
+    /* never block the loop on a full TX buffer: resend everything next tick
+     * instead (a cut frame is dropped by the board's CRC check) */
+    if(static_cast<size_t>(this->link->writeVector(iov, count)) < bytes) {
+        for(Wheel &w : this->wheels)
+            w.sentDuty = w.sentDir = 0xFF;
+        this->writesShort++;
+        return;
+    }
+    this->commandsSent += count;
+}
+
+void ControlLoop::sendMessage(const uint8_t *msg, size_t len) {
+    this->link->writeFrame(msg, len);
+}
+
+void ControlLoop::printStats() const {
+    this->executor.printReport(stderr);
+    fprintf(stderr, "control_loop: %llu samples, %llu ticks without a new speed, %llu commands "
+                    "(%llu short writes), %llu bad frames\n",
+            (unsigned long long)this->samples, (unsigned long long)this->staleTicks,
+            (unsigned long long)this->commandsSent, (unsigned long long)this->writesShort,
+            (unsigned long long)this->crcErrors);
+    fprintf(stderr, "control_loop: wheel speeds");
+    for(const Wheel &w : this->wheels)
+        fprintf(stderr, " %.0f", w.speed);
+    fprintf(stderr, " counts/s (target %.0f)\n", this->cfg.targetSpeed);
+}
+
+/**
+ * @brief Destroy the ControlLoop object: leave the robot standing still.
+ *
+ */
+ControlLoop::~ControlLoop() {
+    uint8_t msg[1];
+    try {
+        this->link->setNonBlocking(false);
+        this->sendMessage(msg, robot_protocol::encode_stop(msg));
+        this->link->closePort();
+    } catch(const std::exception &) {
+    }
+}
+
+static void print_usage(const char *program_name) {
+    printf("Usage: %s [options]\n", program_name);
+    printf("Options:\n");
+    printf("  -p <uri>     Board link, any Transport URI (default /dev/serial0)\n");
+    printf("  -f <hz>      Loop rate, 1..10000 (default %u)\n", DEFAULT_PERIODIC_EXECUTOR_CONFIG.rateHz);
+    printf("  -P <prio>    Run the loop SCHED_FIFO at this priority (needs CAP_SYS_NICE)\n");
+    printf("  -C <cpu>     Pin the loop to this CPU\n");
+    printf("  -r <hz>      Telemetry rate to ask for (default: loop rate, at most %u)\n", DEFAULT_TELEMETRY_LIMIT_HZ);
+    printf("  -t <sec>     Stop after this long (default: until Ctrl+C)\n");
+    printf("  -v <speed>   Target wheel speed, encoder counts/s (default 1500)\n");
+    printf("  -k <kp,ki>   Controller gains (default 0.02,0.5)\n");
+    printf("  -h           Show this help\n");
+}
+
+int main(int argc, char *argv[]) {
+    ControlConfig cfg;
+    int opt;
+    while((opt = getopt(argc, argv, "p:f:P:C:r:t:v:k:h")) != -1) {
+        switch(opt) {
+            case 'p': cfg.port = optarg; break;
+            case 'f': cfg.loop.rateHz = strtoul(optarg, nullptr, 10); break;
+            case 'P': cfg.loop.priority = atoi(optarg); break;
+            case 'C': cfg.loop.cpu = atoi(optarg); break;
+            case 'r': cfg.telemetryHz = static_cast<uint16_t>(strtoul(optarg, nullptr, 10)); break;
+            case 't': cfg.seconds = strtod(optarg, nullptr); break;
+            case 'v': cfg.targetSpeed = strtod(optarg, nullptr); break;
+            case 'k':
+                if(sscanf(optarg, "%lf,%lf", &cfg.kp, &cfg.ki) != 2) {
+                    print_usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                return 0;
+            default:
+                print_usage(argv[0]);
+                return 1;
+        }
+    }
+
+    struct sigaction sa{};
+    sa.sa_handler = signal_handler;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    try {
+        ControlLoop loop(cfg);
+        loop.run();
+        loop.printStats();
+    } catch(const std::exception &e) {
+        fprintf(stderr, "control_loop: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,663 @@
+/**
+ * @file frame_scan.cpp
+ * @author Ziad Fathy
+ * @brief offline analysis of raw UART captures: frame, CRC, loss and
+ *        timing statistics per robot_protocol message type.
+ * @version 0.1
+ * @date 2025-09-19
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * A capture is the byte stream of one direction of the link as a file
+ * (a logic analyser export, `cat /dev/serial0 > rx.bin`, ...). The file is
+ * mapped and split into one segment per thread; each thread finds frame
+ * delimiters with AVX2 (x86-64, picked at run time) or NEON 16/32 bytes at a
+ * time, decodes COBS (or SLIP with -m slip), checks the frame CRC and keeps
+ * its own counters, which are merged in file order at the end:
+ *
+ *   - frames, bytes and sequence gaps per message type (compact telemetry
+ *     frame seq, time sync tokens),
+ *   - telemetry sample intervals from the board timestamps (fixed and
+ *     compact format) and the samples they imply were lost,
+ *   - the board's time sync turnaround (tx - rx in msg_time_sync).
+ *
+ * A compact telemetry stream can only be decoded from a keyframe on: after
+ * a lost frame, and at the start of every segment but the first, deltas up
+ * to the next keyframe are reported as undecodable rather than lost (the
+ * frame sequence gaps count what was lost).
+ *
+ *   frame_scan rx.bin
+ *   frame_scan -j 8 -m slip other_link.bin
+ */
+
+#include "frame_codec.h"
+#include "robot_protocol.h"
+#include "telemetry_codec.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define FRAME_SCAN_HAVE_NEON 1
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+/* --------- Options --------- */
+enum class Framing { Cobs, Slip };
+
+struct ScanOptions {
+    Framing framing = Framing::Cobs;
+    unsigned threads = 0;               // 0 = one per CPU
+    size_t maxFrame = 256;              // longer runs between delimiters are oversize
+    bool scalar = false;                // no SIMD, for comparison
+};
+
+static constexpr uint8_t SLIP_END     = 0xC0;
+static constexpr uint8_t SLIP_ESC     = 0xDB;
+static constexpr uint8_t SLIP_ESC_END = 0xDC;
+static constexpr uint8_t SLIP_ESC_ESC = 0xDD;
+
+static constexpr size_t SCAN_BLOCK = 64 * 1024;
+static constexpr size_t MIN_SEGMENT = 1 << 20;
+static constexpr double LOSS_INTERVAL_RATIO = 1.5;   // a sample interval this much over nominal lost samples
+
+/* --------- Delimiter search --------- */
+/*
+ * Offsets of every delim byte in p[0..n), ascending; out holds n entries.
+ */
+using FindFn = size_t (*)(const uint8_t *p, size_t n, uint8_t delim, uint32_t *out);
+
+static size_t find_scalar(const uint8_t *p, size_t n, uint8_t delim, uint32_t *out) {
+    size_t count = 0;
+    const uint8_t *cur = p, *end = p + n;
+    while(cur < end) {
+        const uint8_t *hit = static_cast<const uint8_t *>(memchr(cur, delim, end - cur));
+        if(hit == nullptr)
+            break;
+        out[count++] = static_cast<uint32_t>(hit - p);
+        cur = hit + 1;
+    }
+    return count;
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define FRAME_SCAN_HAVE_AVX2 1
+
+/* compare 32 bytes at once; every set bit of the mask is one delimiter */
+__attribute__((target("avx2")))
+static size_t find_avx2(const uint8_t *p, size_t n, uint8_t delim, uint32_t *out) {
+    const __m256i d = _mm256_set1_epi8(static_cast<char>(delim));
+    size_t count = 0, i = 0;
+    for(; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, d)));
+        while(mask) {
+            out[count++] = static_cast<uint32_t>(i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+    for(; i < n; i++)
+        if(p[i] == delim)
+            out[count++] = static_cast<uint32_t>(i);
+    return count;
+}
+
+static bool have_avx2() {
+    return __builtin_cpu_supports("avx2");
+}
+#endif
+
+#ifdef FRAME_SCAN_HAVE_NEON
+/* NEON has no movemask: narrow the 0x00/0xFF compare to one nibble per byte */
+static size_t find_neon(const uint8_t *p, size_t n, uint8_t delim, uint32_t *out) {
+    const uint8x16_t d = vdupq_n_u8(delim);
+    size_t count = 0, i = 0;
+    for(; i + 16 <= n; i += 16) {
+        uint8x16_t eq = vceqq_u8(vld1q_u8(p + i), d);
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        while(mask) {
+            unsigned bit = __builtin_ctzll(mask);
+            out[count++] = static_cast<uint32_t>(i + bit / 4);
+            mask &= ~(0xFULL << bit);
+        }
+    }
+    for(; i < n; i++)
+        if(p[i] == delim)
+            out[count++] = static_cast<uint32_t>(i);
+    return count;
+}
+#endif
+
+static FindFn pick_find(bool scalar, const char **name) {
+#ifdef FRAME_SCAN_HAVE_AVX2
+    if(!scalar && have_avx2()) {
+        *name = "avx2";
+        return find_avx2;
+    }
+#endif
+#ifdef FRAME_SCAN_HAVE_NEON
+    if(!scalar) {
+        *name = "neon";
+        return find_neon;
+    }
+#endif
+    *name = "scalar";
+    return find_scalar;
+}
+
+/* --------- Statistics --------- */
+/**
+ * @brief log-linear histogram of microsecond values, 16 sub-buckets per
+ *        power of two (~6 % resolution); mergeable across threads.
+ *
+ */
+class Histogram {
+    public:
+        void record(uint32_t us) {
+            this->buckets[index(us)]++;
+            this->total++;
+            this->maxValue = std::max(this->maxValue, us);
+        }
+
+        void merge(const Histogram &o) {
+            for(size_t i = 0; i < BUCKETS; i++)
+                this->buckets[i] += o.buckets[i];
+            this->total += o.total;
+            this->maxValue = std::max(this->maxValue, o.maxValue);
+        }
+
+        uint64_t count() const { return this->total; }
+        uint32_t max() const { return this->maxValue; }
+
+        double percentile(double p) const {
+            uint64_t want = static_cast<uint64_t>(std::ceil(p * this->total));
+            uint64_t seen = 0;
+            for(size_t i = 0; i < BUCKETS; i++) {
+                seen += this->buckets[i];
+                if(seen >= want && this->buckets[i] > 0)
+                    return middle(i);
+            }
+            return this->maxValue;
+        }
+
+        /* samples missing from intervals over ratio x nominal */
+        uint64_t missing(double nominal, double ratio) const {
+            double lost = 0.0;
+            for(size_t i = 0; i < BUCKETS; i++)
+                if(this->buckets[i] > 0 && middle(i) > ratio * nominal)
+                    lost += this->buckets[i] * (std::round(middle(i) / nominal) - 1.0);
+            return static_cast<uint64_t>(lost);
+        }
+
+    private:
+        static constexpr size_t SUB = 16;
+        static constexpr size_t BUCKETS = SUB + 28 * SUB;
+
+        static size_t index(uint32_t v) {
+            if(v < SUB)
+                return v;
+            unsigned e = 31 - __builtin_clz(v);
+            return SUB + (e - 4) * SUB + ((v >> (e - 4)) & (SUB - 1));
+        }
+
+        static double middle(size_t i) {
+            if(i < SUB)
+                return static_cast<double>(i);
+            size_t e = (i - SUB) / SUB + 4;
+            double low = static_cast<double>((SUB + (i - SUB) % SUB) << (e - 4));
+            return low + static_cast<double>(1u << (e - 4)) / 2.0;
+        }
+
+        uint64_t buckets[BUCKETS] = {};
+        uint64_t total = 0;
+        uint32_t maxValue = 0;
+};
+
+/* a sequence number carried by a message type, checked for gaps */
+struct SeqTrack {
+    bool have = false;
+    uint32_t first = 0;
+    uint32_t last = 0;
+    uint64_t lost = 0;
+
+    void see(uint32_t seq, uint32_t mask) {
+        if(!this->have) {
+            this->first = seq;
+            this->have = true;
+        } else {
+            this->lost += (seq - this->last - 1) & mask;
+        }
+        this->last = seq;
+    }
+
+    /* this segment followed by the next one */
+    void append(const SeqTrack &next, uint32_t mask) {
+        if(!next.have)
+            return;
+        if(this->have)
+            this->lost += (next.first - this->last - 1) & mask;
+        else
+            this->first = next.first;
+        this->lost += next.lost;
+        this->last = next.last;
+        this->have = true;
+    }
+};
+
+struct TypeStats {
+    uint64_t frames = 0;
+    uint64_t bytes = 0;                 // payload
+    SeqTrack seq;
+};
+
+/* board timestamps of telemetry samples, fixed and compact */
+struct SampleStats {
+    uint64_t samples = 0;
+    uint64_t skipped = 0;               // compact deltas that could not be decoded (no keyframe yet)
+    uint64_t skippedBeforeFirst = 0;
+    uint64_t resets = 0;                // the board clock went backwards
+    bool have = false;
+    bool broken = false;                // samples skipped since lastUs: no interval across them
+    uint32_t firstUs = 0;
+    uint32_t lastUs = 0;
+    Histogram interval;
+
+    void skip(uint64_t n) {
+        this->skipped += n;
+        if(this->have)
+            this->broken = true;
+        else
+            this->skippedBeforeFirst += n;
+    }
+
+    void see(uint32_t us) {
+        if(this->broken) {
+            this->broken = false;
+        } else if(this->have) {
+            int32_t dt = static_cast<int32_t>(us - this->lastUs);
+            if(dt < 0)
+                this->resets++;
+            else
+                this->interval.record(static_cast<uint32_t>(dt));
+        } else {
+            this->firstUs = us;
+            this->have = true;
+        }
+        this->lastUs = us;
+        this->samples++;
+    }
+
+    void append(const SampleStats &next) {
+        if(this->have && next.have && !this->broken && next.skippedBeforeFirst == 0) {
+            int32_t dt = static_cast<int32_t>(next.firstUs - this->lastUs);
+            if(dt < 0)
+                this->resets++;
+            else
+                this->interval.record(static_cast<uint32_t>(dt));
+        }
+        if(!this->have) {
+            this->firstUs = next.firstUs;
+            this->have = next.have;
+        }
+        if(next.have) {
+            this->lastUs = next.lastUs;
+            this->broken = next.broken;
+        } else if(next.skipped > 0) {
+            this->broken = true;
+        }
+        this->samples += next.samples;
+        this->skipped += next.skipped;
+        this->resets += next.resets;
+        this->interval.merge(next.interval);
+    }
+};
+
+struct SegmentResult {
+    uint64_t frames = 0;
+    uint64_t crcErrors = 0;
+    uint64_t malformed = 0;
+    uint64_t oversize = 0;
+    uint64_t idle = 0;                  // back to back delimiters
+    uint64_t trailing = 0;              // bytes after the last delimiter
+    TypeStats types[256];
+    SeqTrack compactSeq;                // msg_telemetry_key and _delta share one
+    SampleStats samples;
+    Histogram turnaround;               // msg_time_sync tx - rx
+};
+
+/* --------- Scanner --------- */
+class FrameScanner {
+    public:
+        FrameScanner(const uint8_t *data, size_t size, const ScanOptions &opt, FindFn find);
+        void scan(size_t begin, size_t end, bool last, SegmentResult &r);
+    private:
+        void onFrame(const uint8_t *raw, size_t len, SegmentResult &r);
+        void onPayload(const uint8_t *p, size_t len, SegmentResult &r);
+        long unslip(const uint8_t *in, size_t len, uint8_t *out) const;
+
+        const uint8_t *data;
+        size_t size;
+        ScanOptions opt;
+        FindFn find;
+        uint8_t delim;
+        telemetry_codec::decoder compact;
+        std::vector<uint8_t> work;
+};
+
+FrameScanner::FrameScanner(const uint8_t *data, size_t size, const ScanOptions &opt, FindFn find) :
+            data(data),
+            size(size),
+            opt(opt),
+            find(find),
+            delim(opt.framing == Framing::Cobs ? frame_codec::delimiter : SLIP_END),
+            work(opt.maxFrame) {
+}
+
+/**
+ * @brief every frame starting in [begin, end); the last one may run past
+ *        end to its delimiter.
+ *
+ */
+void FrameScanner::scan(size_t begin, size_t end, bool last, SegmentResult &r) {
+    std::vector<uint32_t> hits(SCAN_BLOCK);
+    size_t frameStart = begin;
+    /* later segments start after their first delimiter at or past begin - 1,
+       the one the previous segment stops at */
+    bool synced = begin == 0;
+    size_t from = synced ? 0 : begin - 1;
+
+    for(size_t block = from; block < this->size; block += SCAN_BLOCK) {
+        size_t n = std::min(SCAN_BLOCK, this->size - block);
+        size_t found = this->find(this->data + block, n, this->delim, hits.data());
+        for(size_t k = 0; k < found; k++) {
+            size_t pos = block + hits[k];
+            if(!synced) {
+                synced = true;
+            } else if(pos == frameStart) {
+                r.idle++;
+            } else {
+                this->onFrame(this->data + frameStart, pos - frameStart, r);
+            }
+            frameStart = pos + 1;
+            if(frameStart >= end)
+                return;
+        }
+    }
+    if(last && synced)
+        r.trailing = this->size - frameStart;
+}
+
+void FrameScanner::onFrame(const uint8_t *raw, size_t len, SegmentResult &r) {
+    if(len > this->opt.maxFrame) {
+        r.oversize++;
+        return;
+    }
+    long n;
+    if(this->opt.framing == Framing::Cobs) {
+        memcpy(this->work.data(), raw, len);
+        n = frame_codec::cobs_decode_in_place(this->work.data(), len);
+    } else {
+        n = this->unslip(raw, len, this->work.data());
+    }
+    if(n < 0) {
+        r.malformed++;
+        return;
+    }
+    long payload = frame_codec::check_frame(this->work.data(), static_cast<size_t>(n));
+    if(payload < 0) {
+        r.crcErrors++;
+        return;
+    }
+    r.frames++;
+    if(payload == 0)
+        return;
+    this->onPayload(this->work.data(), static_cast<size_t>(payload), r);
+}
+
+void FrameScanner::onPayload(const uint8_t *p, size_t len, SegmentResult &r) {
+    TypeStats &t = r.types[p[0]];
+    t.frames++;
+    t.bytes += len;
+
+    switch(p[0]) {
+        case robot_protocol::msg_telemetry: {
+            robot_protocol::telemetry s;
+            if(robot_protocol::decode_telemetry(p, len, &s))
+                r.samples.see(s.timestamp_us);
+            break;
+        }
+        case robot_protocol::msg_telemetry_key:
+        case robot_protocol::msg_telemetry_delta: {
+            if(len >= 2)
+                r.compactSeq.see(p[1], 0xFF);
+            robot_protocol::telemetry s[telemetry_codec::max_batch];
+            int n = this->compact.decode(p, len, s, telemetry_codec::max_batch);
+            if(n == 0 && p[0] == robot_protocol::msg_telemetry_delta && len >= 3)
+                r.samples.skip(p[2]);
+            for(int i = 0; i < n; i++)
+                r.samples.see(s[i].timestamp_us);
+            break;
+        }
+        case robot_protocol::msg_time_sync: {
+            uint32_t token, rx, tx;
+            if(robot_protocol::decode_time_sync_reply(p, len, &token, &rx, &tx)) {
+                t.seq.see(token, 0xFFFFFFFF);
+                r.turnaround.record(tx - rx);
+            }
+            break;
+        }
+        case robot_protocol::cmd_time_sync:
+            if(len >= 5)
+                t.seq.see(robot_protocol::get_u32(p + 1), 0xFFFFFFFF);
+            break;
+        default:
+            break;
+    }
+}
+
+/* @return decoded length, -1 on a bad escape */
+long FrameScanner::unslip(const uint8_t *in, size_t len, uint8_t *out) const {
+    size_t o = 0;
+    for(size_t i = 0; i < len; i++) {
+        uint8_t b = in[i];
+        if(b == SLIP_ESC) {
+            if(++i >= len)
+                return -1;
+            if(in[i] == SLIP_ESC_END)
+                b = SLIP_END;
+            else if(in[i] == SLIP_ESC_ESC)
+                b = SLIP_ESC;
+            else
+                return -1;
+        }
+        out[o++] = b;
+    }
+    return static_cast<long>(o);
+}
+
+/* --------- Report --------- */
+static const char *type_name(uint8_t id) {
+    switch(id) {
+        case robot_protocol::cmd_motor:            return "cmd_motor";
+        case robot_protocol::cmd_stop:             return "cmd_stop";
+        case robot_protocol::cmd_telemetry_rate:   return "cmd_telemetry_rate";
+        case robot_protocol::cmd_ping:             return "cmd_ping";
+        case robot_protocol::cmd_time_sync:        return "cmd_time_sync";
+        case robot_protocol::cmd_baud_propose:     return "cmd_baud_propose";
+        case robot_protocol::cmd_link_test:        return "cmd_link_test";
+        case robot_protocol::cmd_baud_commit:      return "cmd_baud_commit";
+        case robot_protocol::cmd_telemetry_format: return "cmd_telemetry_format";
+        case robot_protocol::msg_telemetry:        return "msg_telemetry";
+        case robot_protocol::msg_telemetry_key:    return "msg_telemetry_key";
+        case robot_protocol::msg_telemetry_delta:  return "msg_telemetry_delta";
+        case robot_protocol::msg_pong:             return "msg_pong";
+        case robot_protocol::msg_time_sync:        return "msg_time_sync";
+        case robot_protocol::msg_baud_ack:         return "msg_baud_ack";
+        case robot_protocol::msg_link_test:        return "msg_link_test";
+        default:                                   return "?";
+    }
+}
+
+static void print_report(const std::string &path, size_t size, double seconds, const char *isa,
+                         unsigned threads, const SegmentResult &r) {
+    printf("%s: %.1f MiB in %.3f s (%.0f MiB/s, %s, %u threads)\n", path.c_str(), size / 1048576.0,
+           seconds, seconds > 0 ? size / 1048576.0 / seconds : 0.0, isa, threads);
+    printf("  frames %llu  crc errors %llu  malformed %llu  oversize %llu  idle delimiters %llu  trailing bytes %llu\n",
+           (unsigned long long)r.frames, (unsigned long long)r.crcErrors, (unsigned long long)r.malformed,
+           (unsigned long long)r.oversize, (unsigned long long)r.idle, (unsigned long long)r.trailing);
+    printf("  %-4s %-22s %12s %14s %10s\n", "id", "type", "frames", "payload bytes", "seq lost");
+    for(int id = 0; id < 256; id++) {
+        const TypeStats &t = r.types[id];
+        if(t.frames == 0)
+            continue;
+        char lost[24] = "-";
+        if(t.seq.have)
+            snprintf(lost, sizeof(lost), "%llu", (unsigned long long)t.seq.lost);
+        printf("  0x%02X %-22s %12llu %14llu %10s\n", id, type_name(static_cast<uint8_t>(id)),
+               (unsigned long long)t.frames, (unsigned long long)t.bytes, lost);
+    }
+
+    const SampleStats &s = r.samples;
+    if(s.interval.count() > 0) {
+        double nominal = s.interval.percentile(0.5);
+        printf("  telemetry samples %llu, interval p50 %.0f us p99 %.0f us max %u us, "
+               "est. lost %llu, board resets %llu, undecodable %llu\n",
+               (unsigned long long)s.samples, nominal, s.interval.percentile(0.99), s.interval.max(),
+               (unsigned long long)s.interval.missing(nominal, LOSS_INTERVAL_RATIO),
+               (unsigned long long)s.resets, (unsigned long long)s.skipped);
+    }
+    if(r.compactSeq.have)
+        printf("  compact telemetry frames lost (seq gaps) %llu\n", (unsigned long long)r.compactSeq.lost);
+    if(r.turnaround.count() > 0)
+        printf("  time sync turnaround p50 %.0f us p99 %.0f us max %u us\n",
+               r.turnaround.percentile(0.5), r.turnaround.percentile(0.99), r.turnaround.max());
+}
+
+static bool scan_file(const std::string &path, const ScanOptions &opt) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if(fd < 0 || fstat(fd, &st) != 0) {
+        perror(path.c_str());
+        if(fd >= 0)
+            close(fd);
+        return false;
+    }
+    size_t size = st.st_size;
+    const uint8_t *data = nullptr;
+    if(size > 0) {
+        void *map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if(map == MAP_FAILED) {
+            perror("mmap");
+            close(fd);
+            return false;
+        }
+        madvise(map, size, MADV_SEQUENTIAL);
+        data = static_cast<const uint8_t *>(map);
+    }
+    close(fd);
+
+    const char *isa = "scalar";
+    FindFn find = pick_find(opt.scalar, &isa);
+    unsigned threads = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threads, size / MIN_SEGMENT)));
+
+    Clock::time_point t0 = Clock::now();
+    std::vector<SegmentResult> results(threads);
+    std::vector<std::thread> workers;
+    for(unsigned i = 0; i < threads; i++) {
+        size_t begin = size * i / threads;
+        size_t end = size * (i + 1) / threads;
+        workers.emplace_back([&, i, begin, end] {
+            FrameScanner scanner(data, size, opt, find);
+            scanner.scan(begin, end, i + 1 == threads, results[i]);
+        });
+    }
+    for(std::thread &w : workers)
+        w.join();
+
+    SegmentResult &total = results[0];
+    for(unsigned i = 1; i < threads; i++) {
+        const SegmentResult &r = results[i];
+        total.frames += r.frames;
+        total.crcErrors += r.crcErrors;
+        total.malformed += r.malformed;
+        total.oversize += r.oversize;
+        total.idle += r.idle;
+        total.trailing += r.trailing;
+        for(int id = 0; id < 256; id++) {
+            total.types[id].frames += r.types[id].frames;
+            total.types[id].bytes += r.types[id].bytes;
+            total.types[id].seq.append(r.types[id].seq, 0xFFFFFFFF);
+        }
+        total.compactSeq.append(r.compactSeq, 0xFF);
+        total.samples.append(r.samples);
+        total.turnaround.merge(r.turnaround);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    print_report(path, size, seconds, isa, threads, total);
+    if(data != nullptr)
+        munmap(const_cast<uint8_t *>(data), size);
+    return true;
+}
+
+static void print_usage(const char *program_name) {
+    printf("Usage: %s [options] <capture>...\n", program_name);
+    printf("Options:\n");
+    printf("  -m <framing> cobs (robot_protocol, default) or slip\n");
+    printf("  -j <n>       Worker threads (default one per CPU)\n");
+    printf("  -x <bytes>   Longest plausible frame on the wire (default 256)\n");
+    printf("  -S           Scalar delimiter search (compare against SIMD)\n");
+    printf("  -h           Show this help\n");
+}
+
+int main(int argc, char *argv[]) {
+    ScanOptions opt;
+    int c;
+    while((c = getopt(argc, argv, "m:j:x:Sh")) != -1) {
+        switch(c) {
+            case 'm':
+                if(strcmp(optarg, "slip") == 0)
+                    opt.framing = Framing::Slip;
+                else if(strcmp(optarg, "cobs") != 0) {
+                    print_usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'j': opt.threads = strtoul(optarg, nullptr, 10); break;
+            case 'x': opt.maxFrame = strtoul(optarg, nullptr, 10); break;
+            case 'S': opt.scalar = true; break;
+            case 'h':
+                print_usage(argv[0]);
+                return 0;
+            default:
+                print_usage(argv[0]);
+                return 1;
+        }
+    }
+    if(optind >= argc) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    int status = 0;
+    for(int i = optind; i < argc; i++)
+        if(!scan_file(argv[i], opt))
+            status = 1;
+    return status;
+}
@@ -0,0 +1,300 @@
+/**
+ * @file log_replay.cpp
+ * @author Ziad Fathy
+ * @brief plays a robotd traffic log (telemetry_log.hpp) back into a pty.
+ * @version 0.1
+ * @date 2025-09-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Opens a pseudo terminal like stm32_emu and writes the recorded board
+ * messages into it, framed as on the wire, either with their original
+ * spacing (scaled by -s) or as fast as the reader drains them. Point robotd
+ * or any UART client at the slave to re-run a session without the robot.
+ * Whatever the reader sends is read and discarded.
+ *
+ *   log_replay -L /tmp/ttySTM32 run.rlog
+ *   log_replay -s 0 -t 120 run.rlog         from 2 minutes in, max speed
+ *   log_replay -i run.rlog                  summary only
+ */
+
+#include "frame_codec.h"
+#include "telemetry_log.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <string>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+/* --------- Config --------- */
+struct ReplayConfig {
+    std::string logPath;
+    std::string link;
+    double speed = 1.0;             // 1 = as recorded, 0 = as fast as the pty drains
+    double startSec = 0.0;          // offset from the start of the log
+    bool rx = true;                 // board -> Pi messages
+    bool tx = false;                // Pi -> board messages
+    bool waitForPeer = false;
+    bool infoOnly = false;
+};
+
+static constexpr uint64_t LATE_NS = 1000000ULL;
+
+static volatile sig_atomic_t running = 1;
+
+static void signal_handler(int) {
+    running = 0;
+}
+
+static uint64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* --------- Class --------- */
+class LogReplay {
+    public:
+        explicit LogReplay(const ReplayConfig &cfg);
+        void run();
+        void printStats() const;
+        ~LogReplay();
+    private:
+        bool waitUntil(uint64_t deadlineNs, bool writable);
+        bool writeAll(const uint8_t *data, size_t len);
+        void drain();
+
+        ReplayConfig cfg;
+        TelemetryLogReader log;
+        int master;
+        int slaveKeepAlive;
+        std::string slaveName;
+
+        uint64_t frames = 0;
+        uint64_t bytes = 0;
+        uint64_t late = 0;
+        uint64_t maxLagNs = 0;
+        uint64_t peerBytes = 0;
+};
+
+/**
+ * @brief Construct a new LogReplay object: open the log and the pty.
+ *
+ */
+LogReplay::LogReplay(const ReplayConfig &cfg) :
+            cfg(cfg),
+            log(cfg.logPath),
+            master(-1),
+            slaveKeepAlive(-1) {
+    this->master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if(this->master < 0 || grantpt(this->master) != 0 || unlockpt(this->master) != 0)
+        throw std::runtime_error("posix_openpt failed");
+    this->slaveName = ptsname(this->master);
+
+    /* hold the slave open so the master never sees EIO between clients */
+    this->slaveKeepAlive = open(this->slaveName.c_str(), O_RDWR | O_NOCTTY);
+    termios tty{};
+    if(this->slaveKeepAlive < 0 || tcgetattr(this->slaveKeepAlive, &tty) != 0)
+        throw std::runtime_error("cannot open pty slave");
+    cfmakeraw(&tty);
+    tcsetattr(this->slaveKeepAlive, TCSANOW, &tty);
+
+    if(!this->cfg.link.empty()) {
+        unlink(this->cfg.link.c_str());
+        if(symlink(this->slaveName.c_str(), this->cfg.link.c_str()) != 0)
+            perror("symlink");
+    }
+    printf("%s\n", this->slaveName.c_str());
+    fflush(stdout);
+}
+
+void LogReplay::run() {
+    uint64_t base = this->log.firstTimeNs() + static_cast<uint64_t>(this->cfg.startSec * 1e9);
+    if(!this->log.seek(base))
+        return;
+
+    if(this->cfg.waitForPeer)
+        while(running && this->peerBytes == 0)
+            this->waitUntil(monotonic_ns() + 100000000ULL, false);
+
+    uint64_t startNs = monotonic_ns();
+    TelemetryLogEntry e;
+    uint8_t frame[frame_codec::max_encoded_size(UINT16_MAX)];
+    while(running && this->log.next(e)) {
+        if(!(e.type == TELEMETRY_LOG_BOARD_RX ? this->cfg.rx : e.type == TELEMETRY_LOG_BOARD_TX && this->cfg.tx))
+            continue;
+        if(this->cfg.speed > 0.0) {
+            uint64_t due = startNs + static_cast<uint64_t>((e.timeNs - base) / this->cfg.speed);
+            if(!this->waitUntil(due, false))
+                break;
+            uint64_t lag = monotonic_ns() - due;
+            if(lag > LATE_NS)
+                this->late++;
+            if(lag > this->maxLagNs)
+                this->maxLagNs = lag;
+        }
+        size_t n = frame_codec::encode_frame(e.payload, e.length, frame, sizeof(frame));
+        if(n == 0 || !this->writeAll(frame, n))
+            break;
+        this->frames++;
+        this->bytes += n;
+    }
+}
+
+void LogReplay::printStats() const {
+    fprintf(stderr, "log_replay: %llu frames %llu bytes, %llu more than 1 ms late (max %.3f ms), "
+                    "%llu bytes from the reader, %llu corrupt chunks skipped\n",
+            (unsigned long long)this->frames, (unsigned long long)this->bytes,
+            (unsigned long long)this->late, this->maxLagNs / 1e6,
+            (unsigned long long)this->peerBytes, (unsigned long long)this->log.corruptChunks());
+}
+
+/**
+ * @brief Destroy the LogReplay object
+ *
+ */
+LogReplay::~LogReplay() {
+    if(!this->cfg.link.empty())
+        unlink(this->cfg.link.c_str());
+    if(this->slaveKeepAlive >= 0)
+        close(this->slaveKeepAlive);
+    if(this->master >= 0)
+        close(this->master);
+}
+
+/**
+ * @brief sleep until deadlineNs (or until the master is writable), reading
+ *        whatever the reader sends meanwhile.
+ *
+ * @return false if interrupted by a signal.
+ */
+bool LogReplay::waitUntil(uint64_t deadlineNs, bool writable) {
+    while(running) {
+        uint64_t now = monotonic_ns();
+        if(!writable && now >= deadlineNs)
+            return true;
+        struct pollfd pfd = { this->master, static_cast<short>(POLLIN | (writable ? POLLOUT : 0)), 0 };
+        uint64_t waitNs = deadlineNs > now ? deadlineNs - now : 0;
+        struct timespec ts = { static_cast<time_t>(waitNs / 1000000000ULL), static_cast<long>(waitNs % 1000000000ULL) };
+        int r = ppoll(&pfd, 1, &ts, nullptr);
+        if(r < 0 && errno != EINTR)
+            return false;
+        if(r > 0 && (pfd.revents & POLLIN))
+            this->drain();
+        if(writable && (r == 0 || (pfd.revents & POLLOUT)))
+            return true;
+    }
+    return false;
+}
+
+bool LogReplay::writeAll(const uint8_t *data, size_t len) {
+    while(len > 0) {
+        ssize_t n = write(this->master, data, len);
+        if(n > 0) {
+            data += n;
+            len -= n;
+            continue;
+        }
+        if(n < 0 && errno != EAGAIN && errno != EINTR) {
+            perror("pty write");
+            return false;
+        }
+        /* the reader is behind: wait for room, at most 100 ms per try */
+        if(!this->waitUntil(monotonic_ns() + 100000000ULL, true))
+            return false;
+    }
+    return true;
+}
+
+void LogReplay::drain() {
+    uint8_t buf[256];
+    ssize_t n;
+    while((n = read(this->master, buf, sizeof(buf))) > 0)
+        this->peerBytes += n;
+}
+
+static int print_info(const std::string &path) {
+    TelemetryLogReader log(path);
+    uint64_t counts[3] = {0, 0, 0};
+    TelemetryLogEntry e;
+    while(log.next(e))
+        counts[e.type <= TELEMETRY_LOG_BOARD_TX ? e.type : 0]++;
+
+    time_t created = static_cast<time_t>(log.fileHeader().createdRealtimeNs / 1000000000ULL);
+    uint64_t createdMono = log.fileHeader().createdMonotonicNs;
+    uint64_t first = log.firstTimeNs(), last = log.lastTimeNs();
+    printf("created  %s", ctime(&created));
+    printf("chunks   %zu x %u KiB\n", log.chunkCount(), log.fileHeader().chunkSize / 1024);
+    printf("records  %llu from board, %llu to board, %llu other\n", (unsigned long long)counts[TELEMETRY_LOG_BOARD_RX],
+           (unsigned long long)counts[TELEMETRY_LOG_BOARD_TX], (unsigned long long)counts[0]);
+    if(last >= first && first > 0)
+        printf("span     %.3f s .. %.3f s after creation (%.3f s)\n", (first - createdMono) / 1e9,
+               (last - createdMono) / 1e9, (last - first) / 1e9);
+    printf("corrupt  %llu chunks\n", (unsigned long long)log.corruptChunks());
+    return 0;
+}
+
+static void print_usage(const char *program_name) {
+    printf("Usage: %s [options] <log>\n", program_name);
+    printf("Options:\n");
+    printf("  -L <path>    Also expose the pty slave as this symlink\n");
+    printf("  -s <factor>  Playback speed, 1 = as recorded, 0 = as fast as the reader drains (default 1)\n");
+    printf("  -t <sec>     Start this far into the log\n");
+    printf("  -d <dir>     Messages to replay: rx (from the board), tx (to the board), both (default rx)\n");
+    printf("  -w           Wait for the reader to send something before starting\n");
+    printf("  -i           Print a summary of the log and exit\n");
+    printf("  -h           Show this help\n");
+}
+
+int main(int argc, char *argv[]) {
+    ReplayConfig cfg;
+    int opt;
+    while((opt = getopt(argc, argv, "L:s:t:d:wih")) != -1) {
+        switch(opt) {
+            case 'L': cfg.link = optarg; break;
+            case 's': cfg.speed = strtod(optarg, nullptr); break;
+            case 't': cfg.startSec = strtod(optarg, nullptr); break;
+            case 'd':
+                cfg.rx = strcmp(optarg, "tx") != 0;
+                cfg.tx = strcmp(optarg, "rx") != 0;
+                break;
+            case 'w': cfg.waitForPeer = true; break;
+            case 'i': cfg.infoOnly = true; break;
+            case 'h':
+                print_usage(argv[0]);
+                return 0;
+            default:
+                print_usage(argv[0]);
+                return 1;
+        }
+    }
+    if(optind >= argc) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    cfg.logPath = argv[optind];
+
+    struct sigaction sa{};
+    sa.sa_handler = signal_handler;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    try {
+        if(cfg.infoOnly)
+            return print_info(cfg.logPath);
+        LogReplay replay(cfg);
+        replay.run();
+        replay.printStats();
+    } catch(const std::exception &e) {
+        fprintf(stderr, "log_replay: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
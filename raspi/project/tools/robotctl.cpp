@@ -0,0 +1,131 @@
+/**
+ * @file robotctl.cpp
+ * @author Ziad Fathy
+ * @brief command line client of robotd.
+ * @version 0.1
+ * @date 2025-09-14
+ *
+ * @copyright Copyright (c) 2025
+ *
+ *   robotctl motor all fwd 40
+ *   robotctl stop
+ *   robotctl ping
+ *   robotctl watch 100
+ */
+
+#include "robot_protocol.h"
+#include "robotd_ipc.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+
+static const char *status_name(RobotdStatus s) {
+    switch(s) {
+        case ROBOTD_OK:          return "ok";
+        case ROBOTD_PORT_DOWN:   return "board not connected";
+        case ROBOTD_QUEUE_FULL:  return "queue full";
+        default:                 return "bad request";
+    }
+}
+
+static void print_usage(const char *program_name) {
+    printf("Usage: %s [-s socket] <command>\n", program_name);
+    printf("Commands:\n");
+    printf("  motor <0-3|all> <fwd|rev|stop> <duty>\n");
+    printf("  stop\n");
+    printf("  rate <hz>\n");
+    printf("  ping\n");
+    printf("  watch [count]    Print telemetry from the shared ring\n");
+}
+
+static int watch(RobotdClient &client, long count) {
+    std::unique_ptr<TelemetryRingReader> ring = client.attach();
+    TelemetrySample s;
+    for(long seen = 0; count <= 0 || seen < count; ) {
+        if(!ring->next(s)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            continue;
+        }
+        printf("mcu %10u us  host %14.6f s%c  pos %8d %8d %8d %8d  dist %6.1f cm  lost %llu\n",
+               s.mcuTimeUs, s.hostTimeNs / 1e9, (s.flags & TELEMETRY_TIME_SYNCED) ? ' ' : '?',
+               s.position[0], s.position[1], s.position[2], s.position[3],
+               s.distanceCm, (unsigned long long)ring->lost());
+        seen++;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    const char *socketPath = ROBOTD_DEFAULT_SOCKET;
+    int opt;
+    while((opt = getopt(argc, argv, "s:h")) != -1) {
+        switch(opt) {
+            case 's': socketPath = optarg; break;
+            default:
+                print_usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if(optind >= argc) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    try {
+        RobotdClient client(socketPath);
+        const char *cmd = argv[optind];
+        uint8_t msg[robot_protocol::max_message];
+        size_t len = 0;
+
+        if(strcmp(cmd, "watch") == 0)
+            return watch(client, optind + 1 < argc ? strtol(argv[optind + 1], nullptr, 10) : 0);
+
+        if(strcmp(cmd, "motor") == 0 && optind + 3 < argc) {
+            robot_protocol::motor_cmd m;
+            const char *id = argv[optind + 1];
+            const char *dir = argv[optind + 2];
+            m.motor = strcmp(id, "all") == 0 ? robot_protocol::all_motors : static_cast<uint8_t>(atoi(id));
+            m.dir = strcmp(dir, "fwd") == 0 ? robot_protocol::forward :
+                    strcmp(dir, "rev") == 0 ? robot_protocol::reverse : robot_protocol::stop;
+            m.duty = static_cast<uint8_t>(atoi(argv[optind + 3]));
+            len = robot_protocol::encode_motor(msg, m);
+        } else if(strcmp(cmd, "stop") == 0) {
+            len = robot_protocol::encode_stop(msg);
+        } else if(strcmp(cmd, "rate") == 0 && optind + 1 < argc) {
+            len = robot_protocol::encode_telemetry_rate(msg, static_cast<uint16_t>(atoi(argv[optind + 1])));
+        } else if(strcmp(cmd, "ping") == 0) {
+            len = robot_protocol::encode_token(msg, robot_protocol::cmd_ping, static_cast<uint32_t>(time(nullptr)));
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        RobotdStatus st = client.command(msg, len);
+        if(st != ROBOTD_OK) {
+            fprintf(stderr, "robotctl: %s\n", status_name(st));
+            return 1;
+        }
+        if(strcmp(cmd, "ping") == 0) {
+            std::vector<uint8_t> ev;
+            while(client.nextEvent(ev, 1000)) {
+                if(ev.size() >= robot_protocol::ping_size && ev[0] == robot_protocol::msg_pong) {
+                    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                    printf("pong %.3f ms\n", ms);
+                    return 0;
+                }
+            }
+            fprintf(stderr, "robotctl: no pong\n");
+            return 1;
+        }
+    } catch(const std::exception &e) {
+        fprintf(stderr, "robotctl: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,567 @@
+/**
+ * @file robotd.cpp
+ * @author Ziad Fathy
+ * @brief robot daemon: sole owner of the board link, shared by local clients.
+ * @version 0.1
+ * @date 2025-09-14
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * The logger, teleop UI and planner no longer open /dev/serial0
+ * themselves. robotd owns the link (any Transport URI, reconnecting through
+ * UARTPortManager) and
+ *   - accepts robot_protocol commands from any number of local clients on
+ *     a SOCK_SEQPACKET Unix socket (robotd_ipc.hpp),
+ *   - publishes every decoded telemetry frame into a seqlock ring in a
+ *     sealed memfd; clients receive a read-only fd for it via SCM_RIGHTS
+ *     and poll it without syscalls,
+ *   - fans other board messages (pong, ...) out to every client,
+ *   - keeps a ClockSync with the board so telemetry carries the time it was
+ *     sampled, not the time it happened to arrive,
+ *   - negotiates the fastest line rate the cable carries (BaudNegotiator),
+ *     holding client commands for the moment a switch is in progress,
+ *   - asks for compact telemetry (telemetry_codec.h) and expands it back
+ *     into one ring entry per sample,
+ *   - optionally records every message in both directions to an
+ *     append-only log (telemetry_log.hpp) for tools/log_replay,
+ *   - optionally traces link and client events to a binary log (binlog.hpp)
+ *     at a few tens of ns per event; read it with tools/binlog_decode.
+ *
+ *   robotd -p /dev/serial0 -s /run/robotd.sock -r 100
+ *   robotd -p pty:///tmp/ttySTM32 -s /tmp/robotd.sock -l /var/log/robot/run.rlog
+ *   robotd -g /var/log/robot/robotd.blog
+ */
+
+#include "baud_negotiator.hpp"
+#include "binlog.hpp"
+#include "clock_sync.hpp"
+#include "port_manager.hpp"
+#include "robot_protocol.h"
+#include "robotd_ipc.hpp"
+#include "telemetry_codec.h"
+#include "telemetry_log.hpp"
+#include "telemetry_ring.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <set>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+/* --------- Config --------- */
+struct RobotdConfig {
+    std::string port = "/dev/serial0";
+    std::string socketPath = ROBOTD_DEFAULT_SOCKET;
+    uint32_t slots = 4096;
+    uint16_t telemetryHz = 50;
+    long maxBaud = DEFAULT_BAUD_NEGOTIATOR_CONFIG.maxBaud;    // 0 = stay at safe_baud
+    int telemetryBatch = -1;        // compact samples per frame, 0 = fixed format, -1 = rate / 50
+    std::string logPath;            // traffic log, empty = none
+    std::string tracePath;          // binary event log, empty = none
+};
+
+/* latency budget for a compact batch: the oldest sample waits at most this */
+static constexpr unsigned BATCH_WINDOW_HZ = 50;
+static constexpr uint64_t KEYFRAME_REQUEST_INTERVAL_NS = 100000000ULL;
+
+static constexpr size_t HELD_COMMAND_LIMIT = 64;
+
+static volatile sig_atomic_t running = 1;
+
+static void signal_handler(int) {
+    running = 0;
+}
+
+static BaudNegotiatorConfig negotiator_config(const RobotdConfig &cfg) {
+    BaudNegotiatorConfig n = DEFAULT_BAUD_NEGOTIATOR_CONFIG;
+    n.maxBaud = cfg.maxBaud;
+    return n;
+}
+
+static uint64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* --------- Class --------- */
+class Robotd {
+    public:
+        explicit Robotd(const RobotdConfig &cfg);
+        void run();
+        void printStats() const;
+        ~Robotd();
+    private:
+        void watch(int fd);
+        void acceptClients();
+        void serviceClient(int fd);
+        void dropClient(int fd);
+        bool sendTo(int fd, const uint8_t *msg, size_t len, int passFd = -1);
+        void onBoardFrame(const uint8_t *payload, size_t len);
+        void onBoardState(bool connected);
+        void syncClock();
+        void serviceLink();
+        void sendTelemetryFormat();
+        bool sendBoard(const uint8_t *msg, size_t len);
+        void publishTelemetry(const robot_protocol::telemetry &t, uint64_t now);
+
+        RobotdConfig cfg;
+        UARTPortManager board;
+        TelemetryRingWriter ring;
+        int ringReadOnlyFd;
+        int epollFd;
+        int listenFd;
+        std::set<int> clients;
+        ClockSync clock;
+        uint64_t nextSyncNs = 0;
+        BaudNegotiator negotiator;
+        long linkBaud = 0;
+        std::deque<std::string> held;       // client commands during a rate switch
+        telemetry_codec::decoder telemetryDecoder;
+        uint64_t lastKeyframeRequestNs = 0;
+        std::unique_ptr<TelemetryLogWriter> log;
+
+        uint64_t telemetryFrames = 0;
+        uint64_t commandsForwarded = 0;
+        uint64_t commandsRefused = 0;
+        uint64_t eventsDropped = 0;
+};
+
+/**
+ * @brief Construct a new Robotd object: ring, listening socket, board link.
+ *
+ */
+Robotd::Robotd(const RobotdConfig &cfg) :
+            cfg(cfg),
+            board([this](UARTPortManager::PortId, const uint8_t *p, size_t n) { this->onBoardFrame(p, n); },
+                  [this](UARTPortManager::PortId, bool up) { this->onBoardState(up); }),
+            ring(cfg.slots),
+            ringReadOnlyFd(-1),
+            epollFd(-1),
+            listenFd(-1),
+            negotiator([this](const uint8_t *m, size_t n) { return this->sendBoard(m, n); },
+                       [this](long baud) { return this->board.setBaud(0, baud); },
+                       negotiator_config(cfg)) {
+    if(!cfg.logPath.empty())
+        this->log.reset(new TelemetryLogWriter(cfg.logPath));
+    this->ringReadOnlyFd = this->ring.openReadOnlyFd();
+    if(this->ringReadOnlyFd < 0)
+        throw std::runtime_error("cannot reopen ring read-only");
+
+    this->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if(this->epollFd < 0)
+        throw std::runtime_error("epoll_create1 failed");
+
+    struct sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if(cfg.socketPath.size() >= sizeof(addr.sun_path))
+        throw std::invalid_argument("socket path too long");
+    memcpy(addr.sun_path, cfg.socketPath.c_str(), cfg.socketPath.size() + 1);
+    this->listenFd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    unlink(cfg.socketPath.c_str());
+    if(this->listenFd < 0 ||
+       bind(this->listenFd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0 ||
+       listen(this->listenFd, 16) != 0)
+        throw std::runtime_error("cannot listen on " + cfg.socketPath);
+    /* access control is the file mode: owner and group (e.g. "robot") */
+    chmod(cfg.socketPath.c_str(), 0660);
+
+    this->watch(this->listenFd);
+    this->watch(this->board.getFd());
+    this->board.addPort(cfg.port);
+}
+
+void Robotd::watch(int fd) {
+    struct epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if(epoll_ctl(this->epollFd, EPOLL_CTL_ADD, fd, &ev) != 0)
+        throw std::runtime_error("epoll_ctl failed");
+}
+
+void Robotd::run() {
+    while(running) {
+        struct epoll_event events[32];
+        int n = epoll_wait(this->epollFd, events, 32, 100);
+        for(int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            if(fd == this->listenFd)
+                this->acceptClients();
+            else if(fd != this->board.getFd())
+                this->serviceClient(fd);
+        }
+        /* board I/O and reconnect timers */
+        this->board.run(0);
+        this->serviceLink();
+        this->syncClock();
+    }
+
+    /* leave the robot standing still */
+    uint8_t stop[1];
+    if(this->sendBoard(stop, robot_protocol::encode_stop(stop))) {
+        uint64_t deadline = monotonic_ns() + 200000000ULL;
+        while(this->board.stats(0).txQueuedBytes > 0 && monotonic_ns() < deadline)
+            this->board.run(10);
+    }
+}
+
+void Robotd::acceptClients() {
+    for(;;) {
+        int fd = accept4(this->listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if(fd < 0)
+            return;
+        this->watch(fd);
+        this->clients.insert(fd);
+        BINLOG_INFO("client %d connected", fd);
+    }
+}
+
+void Robotd::serviceClient(int fd) {
+    uint8_t buf[ROBOTD_MAX_MESSAGE];
+    for(;;) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+        if(n <= 0) {
+            this->dropClient(fd);
+            return;
+        }
+
+        uint8_t reply[16] = {0};
+        if(buf[0] == ROBOTD_ATTACH) {
+            uint32_t slots = this->ring.slotCount();
+            uint64_t size = this->ring.mapSize();
+            reply[0] = ROBOTD_ATTACH;
+            reply[1] = ROBOTD_OK;
+            memcpy(reply + 4, &slots, sizeof(slots));
+            memcpy(reply + 8, &size, sizeof(size));
+            this->sendTo(fd, reply, 16, this->ringReadOnlyFd);
+        } else if(buf[0] == ROBOTD_COMMAND && n >= 2) {
+            reply[0] = ROBOTD_RESULT;
+            if(this->negotiator.busy() && this->board.stats(0).connected) {
+                if(this->held.size() < HELD_COMMAND_LIMIT) {
+                    this->held.emplace_back(reinterpret_cast<const char *>(buf + 1), n - 1);
+                    reply[1] = ROBOTD_OK;
+                    this->commandsForwarded++;
+                } else {
+                    reply[1] = ROBOTD_QUEUE_FULL;
+                    this->commandsRefused++;
+                    BINLOG_WARN("client %d command 0x%02x refused, %zu held", fd, buf[1], this->held.size());
+                }
+            } else if(this->sendBoard(buf + 1, n - 1)) {
+                reply[1] = ROBOTD_OK;
+                this->commandsForwarded++;
+            } else {
+                reply[1] = this->board.stats(0).connected ? ROBOTD_QUEUE_FULL : ROBOTD_PORT_DOWN;
+                this->commandsRefused++;
+                BINLOG_WARN("client %d command 0x%02x refused (%u)", fd, buf[1], reply[1]);
+            }
+            this->sendTo(fd, reply, 2);
+        } else {
+            reply[0] = ROBOTD_RESULT;
+            reply[1] = ROBOTD_BAD_REQUEST;
+            this->sendTo(fd, reply, 2);
+        }
+    }
+}
+
+void Robotd::dropClient(int fd) {
+    BINLOG_INFO("client %d disconnected", fd);
+    epoll_ctl(this->epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    this->clients.erase(fd);
+}
+
+/**
+ * @brief non-blocking send; a client that does not drain its socket loses
+ *        messages instead of stalling the daemon.
+ *
+ */
+bool Robotd::sendTo(int fd, const uint8_t *msg, size_t len, int passFd) {
+    struct iovec iov = { const_cast<uint8_t *>(msg), len };
+    union {
+        struct cmsghdr align;
+        char data[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct msghdr hdr{};
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+    if(passFd >= 0) {
+        memset(&control, 0, sizeof(control));
+        hdr.msg_control = control.data;
+        hdr.msg_controllen = sizeof(control.data);
+        struct cmsghdr *c = CMSG_FIRSTHDR(&hdr);
+        c->cmsg_level = SOL_SOCKET;
+        c->cmsg_type = SCM_RIGHTS;
+        c->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(c), &passFd, sizeof(int));
+    }
+    return sendmsg(fd, &hdr, MSG_DONTWAIT | MSG_NOSIGNAL) == static_cast<ssize_t>(len);
+}
+
+/**
+ * @brief one time sync exchange per ClockSync::pollIntervalMs(), sent only
+ *        behind an empty TX queue and flushed at once so t1 is the time the
+ *        bytes actually left.
+ *
+ */
+void Robotd::syncClock() {
+    uint64_t now = monotonic_ns();
+    if(now < this->nextSyncNs || this->negotiator.busy())
+        return;
+    PortStats st = this->board.stats(0);
+    if(!st.connected || st.txQueuedBytes > 0)
+        return;
+    uint8_t msg[robot_protocol::time_sync_size];
+    size_t len = this->clock.makeRequest(msg, monotonic_ns());
+    if(this->sendBoard(msg, len))
+        this->board.run(0);
+    this->nextSyncNs = now + this->clock.pollIntervalMs() * 1000000ULL;
+}
+
+/**
+ * @brief drive baud negotiation, report rate changes and release commands
+ *        held while it was switching.
+ *
+ */
+void Robotd::serviceLink() {
+    PortStats st = this->board.stats(0);
+    if(!st.connected)
+        return;
+    this->negotiator.poll(monotonic_ns(), st);
+    if(this->negotiator.busy())
+        return;
+    if(this->negotiator.baud() != this->linkBaud) {
+        this->linkBaud = this->negotiator.baud();
+        fprintf(stderr, "robotd: link at %ld baud\n", this->linkBaud);
+        BINLOG_INFO("link at %ld baud", this->linkBaud);
+    }
+    while(!this->held.empty()) {
+        const std::string &cmd = this->held.front();
+        if(!this->sendBoard(reinterpret_cast<const uint8_t *>(cmd.data()), cmd.size()))
+            break;
+        this->held.pop_front();
+    }
+}
+
+/**
+ * @brief queue a message for the board, recording it if logging.
+ *
+ */
+bool Robotd::sendBoard(const uint8_t *msg, size_t len) {
+    if(!this->board.send(0, msg, len)) {
+        BINLOG_WARN("board tx 0x%02x len %zu refused", msg[0], len);
+        return false;
+    }
+    BINLOG_DEBUG("board tx 0x%02x len %zu", msg[0], len);
+    if(this->log)
+        this->log->append(TELEMETRY_LOG_BOARD_TX, msg, len, monotonic_ns());
+    return true;
+}
+
+void Robotd::onBoardFrame(const uint8_t *payload, size_t len) {
+    uint64_t now = monotonic_ns();
+    BINLOG_DEBUG("board rx 0x%02x len %zu", len > 0 ? payload[0] : 0, len);
+    if(this->log)
+        this->log->append(TELEMETRY_LOG_BOARD_RX, payload, len, now);
+    if(this->negotiator.onFrame(payload, len, now))
+        return;
+    if(this->clock.onReply(payload, len, now))
+        return;
+
+    robot_protocol::telemetry t[telemetry_codec::max_batch];
+    if(robot_protocol::decode_telemetry(payload, len, &t[0])) {
+        this->publishTelemetry(t[0], now);
+        return;
+    }
+    int n = this->telemetryDecoder.decode(payload, len, t, telemetry_codec::max_batch);
+    if(n >= 0) {
+        for(int i = 0; i < n; i++)
+            this->publishTelemetry(t[i], now);
+        /* a frame went missing: ask for a keyframe rather than wait for one */
+        if(this->telemetryDecoder.waiting_for_keyframe() && !this->negotiator.busy() &&
+           now - this->lastKeyframeRequestNs > KEYFRAME_REQUEST_INTERVAL_NS) {
+            this->lastKeyframeRequestNs = now;
+            BINLOG_INFO("compact telemetry gap %u, keyframe requested", this->telemetryDecoder.gap_count());
+            this->sendTelemetryFormat();
+        }
+        return;
+    }
+
+    uint8_t event[ROBOTD_MAX_MESSAGE];
+    if(len + 1 > sizeof(event))
+        return;
+    event[0] = ROBOTD_EVENT;
+    memcpy(event + 1, payload, len);
+    for(int fd : this->clients)
+        if(!this->sendTo(fd, event, len + 1))
+            this->eventsDropped++;
+}
+
+void Robotd::publishTelemetry(const robot_protocol::telemetry &t, uint64_t now) {
+    TelemetrySample s{};
+    s.hostTimeNs = now;
+    if(this->clock.synced()) {
+        s.hostTimeNs = this->clock.toMonotonicNs(t.timestamp_us);
+        s.flags = TELEMETRY_TIME_SYNCED;
+    }
+    s.mcuTimeUs = t.timestamp_us;
+    for(int i = 0; i < robot_protocol::motor_count; i++)
+        s.position[i] = t.position[i];
+    s.distanceCm = t.distance_cm;
+    this->ring.publish(s);
+    this->telemetryFrames++;
+}
+
+/**
+ * @brief select fixed or compact telemetry; batches are sized so the oldest
+ *        sample in one waits at most 1 / BATCH_WINDOW_HZ, one keyframe a
+ *        second. Resending it forces a keyframe.
+ *
+ */
+void Robotd::sendTelemetryFormat() {
+    int batch = this->cfg.telemetryBatch;
+    if(batch < 0)
+        batch = this->cfg.telemetryHz / BATCH_WINDOW_HZ;
+    batch = std::max(1, std::min<int>(batch, telemetry_codec::max_batch));
+    uint8_t format = this->cfg.telemetryBatch == 0 ? robot_protocol::format_fixed : robot_protocol::format_compact;
+    uint16_t keyframe = std::max<uint16_t>(1, this->cfg.telemetryHz);
+    uint8_t msg[robot_protocol::format_size];
+    this->sendBoard(msg, robot_protocol::encode_telemetry_format(msg, format, static_cast<uint8_t>(batch), keyframe));
+}
+
+void Robotd::onBoardState(bool connected) {
+    fprintf(stderr, "robotd: %s %s\n", this->board.device(0).c_str(), connected ? "connected" : "disconnected");
+    BINLOG_INFO("board %s %s", this->board.device(0).c_str(), connected ? "connected" : "disconnected");
+    if(connected) {
+        /* the board may have been reset: its clock starts over */
+        this->clock.reset();
+        this->nextSyncNs = 0;
+        uint8_t msg[robot_protocol::rate_size];
+        this->telemetryDecoder.reset();
+        this->sendTelemetryFormat();
+        this->sendBoard(msg, robot_protocol::encode_telemetry_rate(msg, this->cfg.telemetryHz));
+        this->linkBaud = 0;
+        if(this->cfg.maxBaud > 0)
+            this->negotiator.start(monotonic_ns());
+    } else {
+        this->negotiator.stop();
+        this->held.clear();
+    }
+}
+
+void Robotd::printStats() const {
+    PortStats s = this->board.stats(0);
+    if(this->telemetryDecoder.gap_count() || this->telemetryDecoder.malformed_count())
+        fprintf(stderr, "robotd: compact telemetry gaps %u malformed %u\n",
+                this->telemetryDecoder.gap_count(), this->telemetryDecoder.malformed_count());
+    fprintf(stderr, "robotd: telemetry %llu commands %llu refused %llu events dropped %llu | "
+                    "port rx %llu tx %llu crc %llu truncated %llu reconnects %llu\n",
+            (unsigned long long)this->telemetryFrames, (unsigned long long)this->commandsForwarded,
+            (unsigned long long)this->commandsRefused, (unsigned long long)this->eventsDropped,
+            (unsigned long long)s.bytesRx, (unsigned long long)s.bytesTx,
+            (unsigned long long)s.crcErrors, (unsigned long long)s.rxTruncated,
+            (unsigned long long)s.reconnects);
+    if(this->log)
+        fprintf(stderr, "robotd: log %llu records in %llu chunks, %llu dropped\n",
+                (unsigned long long)this->log->records(), (unsigned long long)this->log->chunks(),
+                (unsigned long long)this->log->dropped());
+    if(!this->cfg.tracePath.empty()) {
+        BinLogStats b = BinLog::stats();
+        fprintf(stderr, "robotd: trace %llu events %llu bytes, %llu dropped\n",
+                (unsigned long long)b.entries, (unsigned long long)b.bytes, (unsigned long long)b.dropped);
+    }
+    ClockSyncStats c = this->clock.stats();
+    if(this->clock.synced())
+        fprintf(stderr, "robotd: clock offset %lld ns drift %.2f ppm error <= %llu ns | "
+                        "sync %llu/%llu timeouts %llu resets %llu\n",
+                (long long)this->clock.offsetNs(), this->clock.driftPpm(),
+                (unsigned long long)this->clock.errorBoundNs(),
+                (unsigned long long)c.replies, (unsigned long long)c.requests,
+                (unsigned long long)c.timeouts, (unsigned long long)c.resets);
+}
+
+/**
+ * @brief Destroy the Robotd object
+ *
+ */
+Robotd::~Robotd() {
+    for(int fd : this->clients)
+        close(fd);
+    if(this->listenFd >= 0) {
+        close(this->listenFd);
+        unlink(this->cfg.socketPath.c_str());
+    }
+    if(this->epollFd >= 0)
+        close(this->epollFd);
+    if(this->ringReadOnlyFd >= 0)
+        close(this->ringReadOnlyFd);
+}
+
+static void print_usage(const char *program_name) {
+    printf("Usage: %s [options]\n", program_name);
+    printf("Options:\n");
+    printf("  -p <uri>     Board link, any Transport URI (default /dev/serial0)\n");
+    printf("  -s <path>    Client socket (default %s)\n", ROBOTD_DEFAULT_SOCKET);
+    printf("  -n <slots>   Telemetry ring slots (default 4096)\n");
+    printf("  -r <hz>      Telemetry rate requested from the board (default 50)\n");
+    printf("  -c <n>       Compact telemetry, n samples per frame, 0 = fixed 25 byte frames\n");
+    printf("               (default rate / %u)\n", BATCH_WINDOW_HZ);
+    printf("  -B <baud>    Highest line rate to negotiate, 0 = stay at %u (default %ld)\n",
+           robot_protocol::safe_baud, DEFAULT_BAUD_NEGOTIATOR_CONFIG.maxBaud);
+    printf("  -l <path>    Record all board traffic to this log (see log_replay)\n");
+    printf("  -g <path>    Trace link and client events to this binary log (see binlog_decode)\n");
+    printf("  -h           Show this help\n");
+}
+
+int main(int argc, char *argv[]) {
+    RobotdConfig cfg;
+    int opt;
+    while((opt = getopt(argc, argv, "p:s:n:r:c:B:l:g:h")) != -1) {
+        switch(opt) {
+            case 'p': cfg.port = optarg; break;
+            case 's': cfg.socketPath = optarg; break;
+            case 'n': cfg.slots = strtoul(optarg, nullptr, 10); break;
+            case 'r': cfg.telemetryHz = static_cast<uint16_t>(strtoul(optarg, nullptr, 10)); break;
+            case 'c': cfg.telemetryBatch = atoi(optarg); break;
+            case 'B': cfg.maxBaud = strtol(optarg, nullptr, 10); break;
+            case 'l': cfg.logPath = optarg; break;
+            case 'g': cfg.tracePath = optarg; break;
+            case 'h':
+                print_usage(argv[0]);
+                return 0;
+            default:
+                print_usage(argv[0]);
+                return 1;
+        }
+    }
+
+    struct sigaction sa{};
+    sa.sa_handler = signal_handler;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    try {
+        if(!cfg.tracePath.empty())
+            BinLog::open(cfg.tracePath, BINLOG_LEVEL_DEBUG);
+        Robotd daemon(cfg);
+        daemon.run();
+        BinLog::close();
+        daemon.printStats();
+    } catch(const std::exception &e) {
+        BinLog::close();
+        fprintf(stderr, "robotd: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
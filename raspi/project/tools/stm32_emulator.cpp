@@ -0,0 +1,650 @@
+/**
+ * @file stm32_emulator.cpp
+ * @author Ziad Fathy
+ * @brief pty stand-in for the STM32 motor board (robot_protocol.h).
+ * @version 0.1
+ * @date 2025-09-10
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Opens a pseudo terminal, prints the slave path and then behaves like the
+ * firmware's robot_link: four motors with encoders, an ultrasonic sensor,
+ * ping/pong, time sync, baud negotiation and periodic telemetry. Line rate,
+ * command processing delay, byte loss and board clock drift are configurable
+ * so UART("/dev/pts/N", ...) can be load tested on any Linux box.
+ *
+ * With -S the pty's termios speed stands in for the Pi's line rate: bytes
+ * are garbled while it differs from the board's, and -M sets the fastest
+ * rate the emulated cable carries cleanly.
+ *
+ *   stm32_emu -b 115200 -d 200 -l 0.0001 -D 40 -L /tmp/ttySTM32
+ *   stm32_emu -S -M 921600 -L /tmp/ttySTM32
+ */
+
+#include "frame_codec.h"
+#include "robot_protocol.h"
+#include "telemetry_codec.h"
+
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <poll.h>
+#include <random>
+#include <string>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+/* --------- Config --------- */
+struct EmuConfig {
+    long baud = 115200;             // boot rate and pacing, 0 = as fast as the pty allows
+    uint32_t delayUs = 200;         // command handling latency
+    double loss = 0.0;              // per-byte drop probability, both directions
+    uint16_t telemetryHz = 0;
+    uint32_t countsPerSec = 3000;   // encoder counts/s at 100 % duty
+    std::string link;
+    unsigned seed = 1;
+    double driftPpm = 0.0;          // board crystal error vs the host clock
+    bool strictRate = false;        // garble bytes while the pty speed differs
+    long cableBaud = 0;             // above this 1 % of bytes are corrupted, 0 = no limit
+};
+
+static constexpr double CABLE_ERROR_RATE = 0.01;
+
+static long speed_to_baud(speed_t speed) {
+    switch(speed) {
+        case B9600:    return 9600;
+        case B19200:   return 19200;
+        case B38400:   return 38400;
+        case B57600:   return 57600;
+        case B115200:  return 115200;
+        case B230400:  return 230400;
+        case B460800:  return 460800;
+        case B500000:  return 500000;
+        case B576000:  return 576000;
+        case B921600:  return 921600;
+        case B1000000: return 1000000;
+        case B1500000: return 1500000;
+        case B2000000: return 2000000;
+        default:       return 0;
+    }
+}
+
+static bool baud_supported(long baud) {
+    static const long rates[] = { 9600, 19200, 38400, 57600, 115200, 230400, 460800, 500000,
+                                  576000, 921600, 1000000, 1500000, 2000000 };
+    for(long r : rates)
+        if(r == baud)
+            return true;
+    return false;
+}
+
+static volatile sig_atomic_t running = 1;
+
+static void signal_handler(int) {
+    running = 0;
+}
+
+static uint64_t monotonic_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/* --------- Class --------- */
+class Stm32Emulator {
+    public:
+        explicit Stm32Emulator(const EmuConfig &cfg);
+        const char *slavePath() const;
+        void run();
+        void printStats() const;
+        ~Stm32Emulator();
+    private:
+        struct Motor {
+            uint8_t dir = robot_protocol::stop;
+            uint8_t duty = 0;
+            double position = 0.0;
+        };
+
+        struct Pending {
+            uint64_t due;
+            uint32_t rxMcuUs;           // board clock when the delimiter arrived
+            std::vector<uint8_t> msg;
+        };
+
+        /* token bucket pacing one direction of the wire at baud/10 bytes/s */
+        struct Pacer {
+            double credit = 0.0;
+            uint64_t last = 0;
+        };
+
+        size_t allowance(Pacer &p, uint64_t now, size_t want);
+        void receive(uint64_t now);
+        void transmit(uint64_t now);
+        void handleMessage(const Pending &p, uint64_t now);
+        void sendMessage(const uint8_t *msg, size_t len);
+        void updateModel(uint64_t now);
+        float sonarDistance(uint64_t now);
+        int nextTimeoutUs(uint64_t now) const;
+        uint32_t mcuTimeUs(uint64_t now) const;
+        void serviceBaud(uint64_t now);
+        void setLineBaud(long baud);
+        bool lineMatches() const;
+        bool noisy(bool mismatched);
+
+        EmuConfig cfg;
+        int master;
+        int slaveKeepAlive;
+        std::string slaveName;
+        std::mt19937 rng;
+        std::bernoulli_distribution drop;
+        std::normal_distribution<float> noise;
+
+        Motor motors[robot_protocol::motor_count];
+        uint64_t start;
+        uint64_t lastModel;
+        uint64_t telemetryPeriod;
+        uint64_t nextTelemetry;
+        uint8_t telemetryFormat = robot_protocol::format_fixed;
+        telemetry_codec::encoder telemetryEncoder;
+
+        frame_codec::frame_decoder<robot_protocol::max_message> decoder;
+        std::deque<Pending> pending;
+        std::vector<uint8_t> txBuf;
+        size_t txHead;
+        Pacer rxPace;
+        Pacer txPace;
+
+        /* baud negotiation, as in robot_link */
+        long lineBaud;
+        long paceBaud;                      // 0 = unpaced
+        long pendingBaud = 0;
+        long trialPrevBaud = 0;
+        bool trialActive = false;
+        uint64_t trialUs = 0;
+        uint64_t trialDeadline = 0;
+        uint64_t lastValidRx;
+
+        uint64_t bytesIn = 0, bytesOut = 0, bytesDropped = 0;
+        uint64_t framesIn = 0, crcErrors = 0, telemetrySent = 0, txOverflow = 0;
+        uint64_t bytesGarbled = 0, rateChanges = 0;
+};
+
+static constexpr size_t TX_LIMIT = 64 * 1024;
+
+/**
+ * @brief create the pty pair and put the slave in raw mode.
+ *
+ */
+Stm32Emulator::Stm32Emulator(const EmuConfig &cfg) :
+            cfg(cfg),
+            master(-1),
+            slaveKeepAlive(-1),
+            rng(cfg.seed),
+            drop(cfg.loss),
+            noise(0.0f, 0.5f),
+            start(monotonic_us()),
+            lastModel(start),
+            telemetryPeriod(cfg.telemetryHz ? 1000000ULL / cfg.telemetryHz : 0),
+            nextTelemetry(start),
+            txHead(0),
+            lineBaud(cfg.baud > 0 ? cfg.baud : robot_protocol::safe_baud),
+            paceBaud(cfg.baud),
+            lastValidRx(start) {
+    this->master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if(this->master < 0 || grantpt(this->master) != 0 || unlockpt(this->master) != 0) {
+        perror("posix_openpt");
+        exit(1);
+    }
+    this->slaveName = ptsname(this->master);
+
+    /* hold the slave open so the master never sees EIO between clients */
+    this->slaveKeepAlive = open(this->slaveName.c_str(), O_RDWR | O_NOCTTY);
+    termios tty{};
+    if(this->slaveKeepAlive < 0 || tcgetattr(this->slaveKeepAlive, &tty) != 0) {
+        perror("pty slave");
+        exit(1);
+    }
+    cfmakeraw(&tty);
+    tcsetattr(this->slaveKeepAlive, TCSANOW, &tty);
+
+    if(!this->cfg.link.empty()) {
+        unlink(this->cfg.link.c_str());
+        if(symlink(this->slaveName.c_str(), this->cfg.link.c_str()) != 0)
+            perror("symlink");
+    }
+    this->rxPace.last = this->txPace.last = this->start;
+}
+
+const char *Stm32Emulator::slavePath() const {
+    return this->slaveName.c_str();
+}
+
+/**
+ * @brief bytes the emulated wire may carry now (all of want when unpaced).
+ *
+ */
+size_t Stm32Emulator::allowance(Pacer &p, uint64_t now, size_t want) {
+    if(this->paceBaud <= 0)
+        return want;
+    double rate = this->paceBaud / 10.0;             // 8N1
+    p.credit += (now - p.last) * rate / 1e6;
+    p.last = now;
+    if(p.credit > 64.0)                               // a UART FIFO's worth of burst
+        p.credit = 64.0;
+    size_t n = static_cast<size_t>(p.credit);
+    if(n > want)
+        n = want;
+    p.credit -= n;
+    return n;
+}
+
+void Stm32Emulator::receive(uint64_t now) {
+    uint8_t buf[4096];
+    size_t room = this->allowance(this->rxPace, now, sizeof(buf));
+    if(room == 0)
+        return;
+    ssize_t n = read(this->master, buf, room);
+    if(n <= 0) {
+        /* nothing read: give the unused credit back */
+        if(this->paceBaud > 0)
+            this->rxPace.credit += room;
+        return;
+    }
+    if(this->paceBaud > 0 && static_cast<size_t>(n) < room)
+        this->rxPace.credit += room - n;
+
+    this->bytesIn += n;
+    bool mismatched = !this->lineMatches();
+    for(ssize_t i = 0; i < n; i++) {
+        if(this->cfg.loss > 0.0 && this->drop(this->rng)) {
+            this->bytesDropped++;
+            continue;
+        }
+        if(this->noisy(mismatched))
+            continue;
+        frame_codec::decode_status st = this->decoder.push(buf[i]);
+        if(st == frame_codec::decode_status::frame) {
+            this->framesIn++;
+            this->lastValidRx = now;
+            const uint8_t *msg = this->decoder.data();
+            this->pending.push_back({now + this->cfg.delayUs, this->mcuTimeUs(now),
+                                     std::vector<uint8_t>(msg, msg + this->decoder.size())});
+        } else if(st != frame_codec::decode_status::pending) {
+            this->crcErrors++;
+        }
+    }
+}
+
+void Stm32Emulator::transmit(uint64_t now) {
+    size_t queued = this->txBuf.size() - this->txHead;
+    size_t n = this->allowance(this->txPace, now, queued);
+    if(n == 0)
+        return;
+    if(this->cfg.strictRate) {
+        bool mismatched = !this->lineMatches();
+        for(size_t i = 0; i < n; i++)
+            if(this->noisy(mismatched))
+                this->txBuf[this->txHead + i] ^= 0x5A;     // framing errors read as some other byte
+    }
+    ssize_t w = write(this->master, this->txBuf.data() + this->txHead, n);
+    if(w < 0) {
+        if(this->paceBaud > 0)
+            this->txPace.credit += n;
+        return;
+    }
+    if(this->paceBaud > 0 && static_cast<size_t>(w) < n)
+        this->txPace.credit += n - w;
+    this->txHead += w;
+    this->bytesOut += w;
+    if(this->txHead == this->txBuf.size()) {
+        this->txBuf.clear();
+        this->txHead = 0;
+    }
+}
+
+void Stm32Emulator::sendMessage(const uint8_t *msg, size_t len) {
+    uint8_t wire[frame_codec::max_encoded_size(robot_protocol::max_message)];
+    size_t n = frame_codec::encode_frame(msg, len, wire, sizeof(wire));
+    if(this->txBuf.size() - this->txHead + n > TX_LIMIT) {
+        this->txOverflow++;               // like the firmware: no room, no frame
+        return;
+    }
+    for(size_t i = 0; i < n; i++) {
+        if(this->cfg.loss > 0.0 && this->drop(this->rng)) {
+            this->bytesDropped++;
+            continue;
+        }
+        this->txBuf.push_back(wire[i]);
+    }
+}
+
+void Stm32Emulator::handleMessage(const Pending &p, uint64_t now) {
+    const uint8_t *msg = p.msg.data();
+    size_t len = p.msg.size();
+    robot_protocol::motor_cmd cmd;
+    uint8_t reply[robot_protocol::max_message];
+    uint64_t drainUs;
+    long baud;
+
+    this->updateModel(now);
+    switch(msg[0]) {
+        case robot_protocol::cmd_motor:
+            if(!robot_protocol::decode_motor(msg, len, &cmd))
+                break;
+            for(uint8_t i = 0; i < robot_protocol::motor_count; i++) {
+                if(cmd.motor == i || cmd.motor == robot_protocol::all_motors) {
+                    this->motors[i].dir = cmd.dir;
+                    this->motors[i].duty = cmd.duty;
+                }
+            }
+            break;
+        case robot_protocol::cmd_stop:
+            for(Motor &m : this->motors) {
+                m.dir = robot_protocol::stop;
+                m.duty = 0;
+            }
+            break;
+        case robot_protocol::cmd_telemetry_rate:
+            if(len >= robot_protocol::rate_size) {
+                uint16_t hz = robot_protocol::get_u16(msg + 1);
+                this->telemetryPeriod = hz ? 1000000ULL / hz : 0;
+                this->nextTelemetry = now;
+                if(!hz)
+                    this->telemetryEncoder.flush([this](const uint8_t *m, size_t n) { this->sendMessage(m, n); });
+            }
+            break;
+        case robot_protocol::cmd_telemetry_format:
+            if(len >= robot_protocol::format_size && msg[1] <= robot_protocol::format_compact) {
+                this->telemetryEncoder.flush([this](const uint8_t *m, size_t n) { this->sendMessage(m, n); });
+                this->telemetryFormat = msg[1];
+                this->telemetryEncoder.configure(msg[2], robot_protocol::get_u16(msg + 3));
+            }
+            break;
+        case robot_protocol::cmd_ping:
+            if(len >= robot_protocol::ping_size)
+                this->sendMessage(reply, robot_protocol::encode_token(reply, robot_protocol::msg_pong,
+                                                                      robot_protocol::get_u32(msg + 1)));
+            break;
+        case robot_protocol::cmd_time_sync:
+            /* like robot_link: t3 is when the reply starts on the wire */
+            if(len < robot_protocol::time_sync_size)
+                break;
+            drainUs = this->paceBaud > 0 ? (this->txBuf.size() - this->txHead) * 10000000ULL / this->paceBaud : 0;
+            this->sendMessage(reply, robot_protocol::encode_time_sync_reply(reply, robot_protocol::get_u32(msg + 1),
+                                                                           p.rxMcuUs, this->mcuTimeUs(now + drainUs)));
+            break;
+        case robot_protocol::cmd_baud_propose:
+            if(len < robot_protocol::propose_size)
+                break;
+            baud = robot_protocol::get_u32(msg + 1);
+            if(!baud_supported(baud)) {
+                this->sendMessage(reply, robot_protocol::encode_baud_ack(reply, baud, robot_protocol::baud_rejected));
+                break;
+            }
+            if(!this->trialActive)
+                this->trialPrevBaud = this->lineBaud;
+            this->trialUs = robot_protocol::get_u16(msg + 5) * 1000ULL;
+            this->pendingBaud = baud;
+            this->sendMessage(reply, robot_protocol::encode_baud_ack(reply, baud, robot_protocol::baud_accepted));
+            break;
+        case robot_protocol::cmd_link_test:
+            memcpy(reply, msg, len);
+            reply[0] = robot_protocol::msg_link_test;
+            this->sendMessage(reply, len);
+            break;
+        case robot_protocol::cmd_baud_commit:
+            if(len < robot_protocol::commit_size)
+                break;
+            baud = robot_protocol::get_u32(msg + 1);
+            if(baud == this->lineBaud && !this->pendingBaud) {
+                this->trialActive = false;
+                this->sendMessage(reply, robot_protocol::encode_baud_ack(reply, baud, robot_protocol::baud_committed));
+            } else {
+                this->sendMessage(reply, robot_protocol::encode_baud_ack(reply, baud, robot_protocol::baud_rejected));
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief the board's systime: starts at 0 and runs driftPpm fast.
+ *
+ */
+uint32_t Stm32Emulator::mcuTimeUs(uint64_t now) const {
+    double elapsed = static_cast<double>(now - this->start);
+    return static_cast<uint32_t>(static_cast<uint64_t>(elapsed * (1.0 + this->cfg.driftPpm * 1e-6)));
+}
+
+/**
+ * @brief robot_link::service_baud: switch once the ack is out, revert an
+ *        uncommitted trial, fall back to safe_baud on silence.
+ *
+ */
+void Stm32Emulator::serviceBaud(uint64_t now) {
+    if(this->pendingBaud && this->txHead == this->txBuf.size()) {
+        this->setLineBaud(this->pendingBaud);
+        this->pendingBaud = 0;
+        this->trialActive = true;
+        this->trialDeadline = now + this->trialUs;
+        this->lastValidRx = now;
+    }
+    if(this->trialActive && now >= this->trialDeadline) {
+        this->setLineBaud(this->trialPrevBaud);
+        this->trialActive = false;
+        this->lastValidRx = now;
+    }
+    if(this->lineBaud != static_cast<long>(robot_protocol::safe_baud) && !this->pendingBaud &&
+       now - this->lastValidRx >= robot_protocol::link_silence_ms * 1000ULL) {
+        this->setLineBaud(robot_protocol::safe_baud);
+        this->trialActive = false;
+        this->lastValidRx = now;
+    }
+}
+
+void Stm32Emulator::setLineBaud(long baud) {
+    if(baud != this->lineBaud)
+        this->rateChanges++;
+    this->lineBaud = baud;
+    if(this->cfg.baud > 0)
+        this->paceBaud = baud;
+}
+
+/**
+ * @brief -S: does the Pi's side (the pty's termios speed) run at our rate?
+ *
+ */
+bool Stm32Emulator::lineMatches() const {
+    if(!this->cfg.strictRate)
+        return true;
+    termios tty{};
+    if(tcgetattr(this->slaveKeepAlive, &tty) != 0)
+        return true;
+    return speed_to_baud(cfgetospeed(&tty)) == this->lineBaud;
+}
+
+/**
+ * @brief line noise on the next byte: always while the rates differ,
+ *        CABLE_ERROR_RATE of the time above the cable limit.
+ *
+ */
+bool Stm32Emulator::noisy(bool mismatched) {
+    bool hit = mismatched;
+    if(!hit && this->cfg.cableBaud > 0 && this->lineBaud > this->cfg.cableBaud)
+        hit = std::uniform_real_distribution<double>(0.0, 1.0)(this->rng) < CABLE_ERROR_RATE;
+    if(hit)
+        this->bytesGarbled++;
+    return hit;
+}
+
+/**
+ * @brief integrate encoder positions since the last update.
+ *
+ */
+void Stm32Emulator::updateModel(uint64_t now) {
+    double dt = (now - this->lastModel) / 1e6;
+    this->lastModel = now;
+    for(Motor &m : this->motors) {
+        if(m.dir == robot_protocol::stop)
+            continue;
+        double speed = m.duty / 100.0 * this->cfg.countsPerSec;
+        m.position += (m.dir == robot_protocol::forward ? speed : -speed) * dt;
+    }
+}
+
+/**
+ * @brief obstacle sweeping 20..180 cm every 5 s plus sensor noise; like the
+ *        firmware, out-of-range echoes read as 0.
+ *
+ */
+float Stm32Emulator::sonarDistance(uint64_t now) {
+    double t = (now - this->start) / 1e6;
+    float d = static_cast<float>(100.0 + 80.0 * std::sin(2.0 * M_PI * t / 5.0)) + this->noise(this->rng);
+    return (d < 2.0f || d > 400.0f) ? 0.0f : d;
+}
+
+int Stm32Emulator::nextTimeoutUs(uint64_t now) const {
+    int64_t best = 100000;
+    if(this->telemetryPeriod && !this->pendingBaud && !this->trialActive)
+        best = std::min<int64_t>(best, static_cast<int64_t>(this->nextTelemetry - now));
+    if(this->trialActive)
+        best = std::min<int64_t>(best, static_cast<int64_t>(this->trialDeadline - now));
+    if(!this->pending.empty())
+        best = std::min<int64_t>(best, static_cast<int64_t>(this->pending.front().due - now));
+    if(this->txHead < this->txBuf.size() && this->paceBaud > 0)
+        best = std::min<int64_t>(best, static_cast<int64_t>(10e6 / this->paceBaud) + 1);
+    return best < 0 ? 0 : static_cast<int>(best);
+}
+
+void Stm32Emulator::run() {
+    while(running) {
+        uint64_t now = monotonic_us();
+        int waitUs = this->nextTimeoutUs(now);
+        struct pollfd pfd = { this->master, POLLIN, 0 };
+        if(this->txHead < this->txBuf.size())
+            pfd.events |= POLLOUT;
+        struct timespec ts = { waitUs / 1000000, (waitUs % 1000000) * 1000L };
+        if(ppoll(&pfd, 1, &ts, nullptr) < 0 && errno != EINTR) {
+            perror("ppoll");
+            break;
+        }
+
+        now = monotonic_us();
+        /* before reading: the real board switches the moment the ack's stop
+           bit is out, long before the Pi can answer at the new rate */
+        this->serviceBaud(now);
+        if(pfd.revents & POLLIN)
+            this->receive(now);
+
+        while(!this->pending.empty() && this->pending.front().due <= now) {
+            Pending p = std::move(this->pending.front());
+            this->pending.pop_front();
+            this->handleMessage(p, now);
+        }
+
+        /* robot_link holds telemetry while a rate switch is pending or on trial */
+        if(this->telemetryPeriod && now >= this->nextTelemetry && !this->pendingBaud && !this->trialActive) {
+            this->updateModel(now);
+            robot_protocol::telemetry t;
+            t.timestamp_us = this->mcuTimeUs(now);
+            for(uint8_t i = 0; i < robot_protocol::motor_count; i++)
+                t.position[i] = static_cast<int32_t>(this->motors[i].position);
+            t.distance_cm = this->sonarDistance(now);
+            if(this->telemetryFormat == robot_protocol::format_compact) {
+                this->telemetryEncoder.add(t, [this](const uint8_t *m, size_t n) { this->sendMessage(m, n); });
+            } else {
+                uint8_t msg[robot_protocol::telemetry_size];
+                this->sendMessage(msg, robot_protocol::encode_telemetry(msg, t));
+            }
+            this->telemetrySent++;
+            this->nextTelemetry += this->telemetryPeriod;
+            if(this->nextTelemetry < now)                 // don't burst after a stall
+                this->nextTelemetry = now + this->telemetryPeriod;
+        }
+
+        if(this->txHead < this->txBuf.size())
+            this->transmit(now);
+    }
+}
+
+void Stm32Emulator::printStats() const {
+    fprintf(stderr,
+            "bytes in %llu out %llu dropped %llu garbled %llu | frames %llu crc errors %llu | "
+            "telemetry %llu tx overflow %llu | %ld baud after %llu changes\n",
+            (unsigned long long)this->bytesIn, (unsigned long long)this->bytesOut,
+            (unsigned long long)this->bytesDropped, (unsigned long long)this->bytesGarbled,
+            (unsigned long long)this->framesIn, (unsigned long long)this->crcErrors,
+            (unsigned long long)this->telemetrySent, (unsigned long long)this->txOverflow,
+            this->lineBaud, (unsigned long long)this->rateChanges);
+}
+
+Stm32Emulator::~Stm32Emulator() {
+    if(!this->cfg.link.empty())
+        unlink(this->cfg.link.c_str());
+    if(this->slaveKeepAlive >= 0)
+        close(this->slaveKeepAlive);
+    if(this->master >= 0)
+        close(this->master);
+}
+
+static void print_usage(const char *program_name) {
+    printf("Usage: %s [options]\n", program_name);
+    printf("Options:\n");
+    printf("  -b <baud>    Emulated line rate, 0 = unpaced (default 115200)\n");
+    printf("  -d <us>      Command processing delay (default 200)\n");
+    printf("  -l <prob>    Per-byte loss probability (default 0)\n");
+    printf("  -t <hz>      Telemetry rate at start (default 0, set by cmd_telemetry_rate)\n");
+    printf("  -c <n>       Encoder counts/s at 100%% duty (default 3000)\n");
+    printf("  -L <path>    Also expose the pty slave as this symlink\n");
+    printf("  -s <seed>    Random seed for loss and sensor noise\n");
+    printf("  -D <ppm>     Board clock drift vs the host (default 0)\n");
+    printf("  -S           Garble bytes while the pty's termios speed differs from the board's\n");
+    printf("  -M <baud>    With -S: fastest clean rate of the emulated cable (default no limit)\n");
+    printf("  -h           Show this help\n");
+}
+
+int main(int argc, char *argv[]) {
+    EmuConfig cfg;
+    int opt;
+    while((opt = getopt(argc, argv, "b:d:l:t:c:L:s:D:SM:h")) != -1) {
+        switch(opt) {
+            case 'b': cfg.baud = strtol(optarg, nullptr, 10); break;
+            case 'd': cfg.delayUs = strtoul(optarg, nullptr, 10); break;
+            case 'l': cfg.loss = strtod(optarg, nullptr); break;
+            case 't': cfg.telemetryHz = static_cast<uint16_t>(strtoul(optarg, nullptr, 10)); break;
+            case 'c': cfg.countsPerSec = strtoul(optarg, nullptr, 10); break;
+            case 'L': cfg.link = optarg; break;
+            case 's': cfg.seed = strtoul(optarg, nullptr, 10); break;
+            case 'D': cfg.driftPpm = strtod(optarg, nullptr); break;
+            case 'S': cfg.strictRate = true; break;
+            case 'M': cfg.cableBaud = strtol(optarg, nullptr, 10); break;
+            case 'h':
+                print_usage(argv[0]);
+                return 0;
+            default:
+                print_usage(argv[0]);
+                return 1;
+        }
+    }
+
+    struct sigaction sa{};
+    sa.sa_handler = signal_handler;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    Stm32Emulator emu(cfg);
+    printf("%s\n", emu.slavePath());
+    fflush(stdout);
+
+    emu.run();
+    emu.printStats();
+    return 0;
+}
@@ -0,0 +1,558 @@
+/**
+ * @file uart_bench.cpp
+ * @author Ziad Fathy
+ * @brief throughput / latency benchmark for the UART class, JSON output.
+ * @version 0.1
+ * @date 2025-09-11
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Every case opens a fresh link: a pty pair (the far side runs in a thread)
+ * or, with -d, a real port whose TX is wired to its RX.
+ *
+ *   throughput  chunk x threading x baud, driver termios. A sink drains the
+ *               far side; reports bytes/s, msgs/s and write/read syscalls
+ *               per message.
+ *   rtt         chunk x termios x baud, one message in flight. The pty peer
+ *               echoes (a loopback wire does it for free); reports
+ *               min/p50/p99/p999/max round trip in microseconds.
+ *
+ * Baud is only a setting on a pty, so by default ptys run at 115200 and
+ * real devices sweep 9600..921600. Results go to stdout (or -o) as one JSON
+ * document, progress to stderr.
+ *
+ *   uart_bench -c 16,256 -t 500 -o bench.json
+ *   uart_bench -N -d /dev/serial0 -B 115200,921600
+ */
+
+#include "usart.hpp"
+#include "tx_queue.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <poll.h>
+#include <sstream>
+#include <string>
+#include <sys/utsname.h>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+/* --------- Options --------- */
+struct BenchOptions {
+    std::string device;                 // real port with TX looped to RX
+    bool usePty = true;
+    std::vector<long> chunks = {1, 16, 64, 256, 1024, 4096};
+    std::vector<long> bauds;            // empty = per-transport default
+    std::vector<std::string> termiosModes = {"driver", "raw-vmin1", "raw-nonblock"};
+    std::vector<std::string> threading = {"direct", "queue", "queue-4"};
+    bool throughput = true;
+    bool rtt = true;
+    long durationMs = 300;              // per case
+    size_t maxSamples = 20000;          // per rtt case
+    std::string output;
+};
+
+static speed_t to_speed(long baud) {
+    switch(baud) {
+        case 9600:    return B9600;
+        case 19200:   return B19200;
+        case 38400:   return B38400;
+        case 57600:   return B57600;
+        case 115200:  return B115200;
+        case 230400:  return B230400;
+        case 460800:  return B460800;
+        case 500000:  return B500000;
+        case 576000:  return B576000;
+        case 921600:  return B921600;
+        case 1000000: return B1000000;
+        case 1500000: return B1500000;
+        case 2000000: return B2000000;
+        default:      throw std::runtime_error("unsupported baud rate");
+    }
+}
+
+/* --------- Link under test --------- */
+struct BenchLink {
+    std::unique_ptr<UART> uart;
+    int master = -1;        // pty master, -1 on a real device
+    int peer = -1;          // where the bytes the UART sends come out
+    bool echo = false;      // pty: a thread has to bounce bytes back
+
+    ~BenchLink() {
+        this->uart.reset();
+        if(this->master >= 0)
+            close(this->master);
+    }
+};
+
+/**
+ * @brief termios variants on top of what UART::openPort() configures.
+ *
+ *  driver        openPort() as is (VMIN 0 / VTIME 5, blocking fd)
+ *  raw-vmin1     cfmakeraw, read blocks for at least one byte
+ *  raw-nonblock  cfmakeraw, O_NONBLOCK, caller poll()s
+ */
+static void apply_termios(int fd, const std::string &mode) {
+    if(mode == "driver")
+        return;
+    termios tty{};
+    if(tcgetattr(fd, &tty) != 0)
+        throw std::runtime_error("tcgetattr failed");
+    cfmakeraw(&tty);
+    tty.c_cflag |= (CLOCAL | CREAD);
+    if(mode == "raw-vmin1") {
+        tty.c_cc[VMIN]  = 1;
+        tty.c_cc[VTIME] = 0;
+    } else if(mode == "raw-nonblock") {
+        tty.c_cc[VMIN]  = 0;
+        tty.c_cc[VTIME] = 0;
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    } else {
+        throw std::runtime_error("unknown termios mode " + mode);
+    }
+    if(tcsetattr(fd, TCSANOW, &tty) != 0)
+        throw std::runtime_error("tcsetattr failed");
+}
+
+static void open_link(BenchLink &link, const std::string &device, long baud, const std::string &mode) {
+    std::string path = device;
+    if(path.empty()) {
+        link.master = posix_openpt(O_RDWR | O_NOCTTY);
+        if(link.master < 0 || grantpt(link.master) != 0 || unlockpt(link.master) != 0)
+            throw std::runtime_error("posix_openpt failed");
+        path = ptsname(link.master);
+        link.echo = true;
+    }
+    link.uart.reset(new UART(path, to_speed(baud)));
+    link.uart->openPort();
+    apply_termios(link.uart->getFd(), mode);
+    link.peer = link.master >= 0 ? link.master : link.uart->getFd();
+    tcflush(link.uart->getFd(), TCIOFLUSH);
+}
+
+/* --------- Far side threads --------- */
+static void echo_loop(int fd, const std::atomic<bool> &stop) {
+    std::vector<uint8_t> buf(65536);
+    while(!stop.load(std::memory_order_relaxed)) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if(poll(&pfd, 1, 20) <= 0)
+            continue;
+        ssize_t n = read(fd, buf.data(), buf.size());
+        for(ssize_t off = 0; n > 0 && off < n; ) {
+            ssize_t w = write(fd, buf.data() + off, n - off);
+            if(w < 0) {
+                if(errno == EINTR)
+                    continue;
+                break;
+            }
+            off += w;
+        }
+    }
+}
+
+struct Sink {
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> reads{0};
+    std::atomic<bool> stop{false};
+};
+
+static void sink_loop(int fd, Sink &sink) {
+    std::vector<uint8_t> buf(65536);
+    while(!sink.stop.load(std::memory_order_relaxed)) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if(poll(&pfd, 1, 20) <= 0)
+            continue;
+        ssize_t n = read(fd, buf.data(), buf.size());
+        sink.reads.fetch_add(1, std::memory_order_relaxed);
+        if(n > 0)
+            sink.bytes.fetch_add(n, std::memory_order_relaxed);
+    }
+}
+
+/* --------- JSON --------- */
+class JsonObject {
+    public:
+        JsonObject() {
+            this->out.precision(10);
+        }
+        JsonObject &add(const char *key, const std::string &value) {
+            this->sep(key);
+            this->out << '"';
+            for(char c : value) {
+                if(c == '"' || c == '\\')
+                    this->out << '\\';
+                if(static_cast<unsigned char>(c) >= 0x20)
+                    this->out << c;
+            }
+            this->out << '"';
+            return *this;
+        }
+        JsonObject &add(const char *key, const char *value) {
+            return this->add(key, std::string(value));
+        }
+        JsonObject &add(const char *key, double value) {
+            this->sep(key);
+            if(std::isfinite(value))
+                this->out << value;
+            else
+                this->out << "null";
+            return *this;
+        }
+        JsonObject &add(const char *key, uint64_t value) {
+            this->sep(key);
+            this->out << value;
+            return *this;
+        }
+        JsonObject &add(const char *key, long value) {
+            this->sep(key);
+            this->out << value;
+            return *this;
+        }
+        JsonObject &raw(const char *key, const std::string &json) {
+            this->sep(key);
+            this->out << json;
+            return *this;
+        }
+        std::string str() const {
+            return "{" + this->out.str() + "}";
+        }
+    private:
+        void sep(const char *key) {
+            if(!this->first)
+                this->out << ", ";
+            this->first = false;
+            this->out << '"' << key << "\": ";
+        }
+        std::ostringstream out;
+        bool first = true;
+};
+
+static double elapsed_s(Clock::time_point from) {
+    return std::chrono::duration<double>(Clock::now() - from).count();
+}
+
+/**
+ * @brief nearest-rank percentile of sorted samples.
+ *
+ */
+static double percentile(const std::vector<double> &sorted, double p) {
+    if(sorted.empty())
+        return NAN;
+    size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+/* --------- Cases --------- */
+static JsonObject case_header(const char *test, const std::string &device, long baud,
+                              long chunk, const std::string &termiosMode, const std::string &threading) {
+    JsonObject o;
+    o.add("test", test)
+     .add("transport", device.empty() ? std::string("pty") : device)
+     .add("baud", baud)
+     .add("chunk", chunk)
+     .add("termios", termiosMode)
+     .add("threading", threading)
+     .add("line_rate_bytes_per_sec", device.empty() ? NAN : baud / 10.0);
+    return o;
+}
+
+static void run_throughput(JsonObject &o, const BenchOptions &opt, const std::string &device,
+                           long baud, long chunk, const std::string &threading) {
+    BenchLink link;
+    open_link(link, device, baud, "driver");
+    Sink sink;
+    std::thread reader(sink_loop, link.peer, std::ref(sink));
+
+    std::string payload(chunk, '\0');
+    for(long i = 0; i < chunk; i++)
+        payload[i] = static_cast<char>('A' + i % 26);
+
+    uint64_t messages = 0;
+    uint64_t txCalls = 0;
+    Clock::time_point start = Clock::now();
+    Clock::time_point deadline = start + std::chrono::milliseconds(opt.durationMs);
+    try {
+        if(threading == "direct") {
+            while(Clock::now() < deadline) {
+                link.uart->writeData(payload);
+                messages++;
+            }
+            txCalls = messages;
+        } else {
+            unsigned producers = threading == "queue-4" ? 4 : 1;
+            UARTTxQueue queue(*link.uart);
+            queue.start();
+            std::vector<std::thread> threads;
+            for(unsigned p = 0; p < producers; p++) {
+                threads.emplace_back([&] {
+                    /* keep a bounded backlog, the queue itself never pushes back */
+                    while(Clock::now() < deadline) {
+                        if(queue.stats().depth > 1024) {
+                            std::this_thread::yield();
+                            continue;
+                        }
+                        queue.submit(payload, TxPriority::Bulk);
+                    }
+                });
+            }
+            for(std::thread &t : threads)
+                t.join();
+            queue.stop();
+            TxQueueStats s = queue.stats();
+            messages = s.framesSent;
+            txCalls = s.writevCalls;
+            o.add("max_queue_depth", static_cast<uint64_t>(s.maxDepth))
+             .add("mean_queue_wait_us", s.framesSent ? s.totalWaitNs / 1e3 / s.framesSent : NAN);
+        }
+    } catch(...) {
+        sink.stop = true;
+        reader.join();
+        throw;
+    }
+
+    /* wait for the far side to see everything that was accepted */
+    uint64_t expected = messages * chunk;
+    double drainLimit = 2.0 + (device.empty() ? 0.0 : expected * 10.0 / baud);
+    while(sink.bytes.load() < expected && elapsed_s(deadline) < drainLimit)
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    double seconds = elapsed_s(start);
+    sink.stop = true;
+    reader.join();
+
+    uint64_t received = sink.bytes.load();
+    o.add("messages", messages)
+     .add("bytes", received)
+     .add("lost_bytes", expected > received ? expected - received : 0)
+     .add("seconds", seconds)
+     .add("bytes_per_sec", received / seconds)
+     .add("msgs_per_sec", messages / seconds)
+     .add("tx_syscalls_per_msg", messages ? double(txCalls) / messages : NAN)
+     .add("rx_syscalls_per_msg", messages ? double(sink.reads.load()) / messages : NAN);
+}
+
+/**
+ * @brief read back exactly len bytes; returns the number of read()/poll() calls.
+ *
+ */
+static uint64_t read_echo(UART &uart, size_t len, bool nonblock, double timeoutS) {
+    Clock::time_point start = Clock::now();
+    uint64_t calls = 0;
+    size_t got = 0;
+    while(got < len) {
+        if(nonblock) {
+            struct pollfd pfd = { uart.getFd(), POLLIN, 0 };
+            poll(&pfd, 1, 100);
+            calls++;
+        }
+        got += uart.readData(std::min<size_t>(len - got, 4096)).size();
+        calls++;
+        if(got < len && elapsed_s(start) > timeoutS)
+            throw std::runtime_error("echo timeout");
+    }
+    return calls;
+}
+
+static void run_rtt(JsonObject &o, const BenchOptions &opt, const std::string &device,
+                    long baud, long chunk, const std::string &termiosMode) {
+    BenchLink link;
+    open_link(link, device, baud, termiosMode);
+    std::atomic<bool> stop{false};
+    std::thread echo;
+    if(link.echo)
+        echo = std::thread(echo_loop, link.peer, std::cref(stop));
+
+    std::vector<uint8_t> msg(chunk);
+    for(long i = 0; i < chunk; i++)
+        msg[i] = static_cast<uint8_t>(i);
+    bool nonblock = termiosMode == "raw-nonblock";
+    double timeoutS = 1.0 + (device.empty() ? 0.0 : 2.0 * chunk * 10.0 / baud);
+
+    std::vector<double> samples;
+    uint64_t txCalls = 0;
+    uint64_t rxCalls = 0;
+    try {
+        Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(opt.durationMs);
+        for(int round = 0; samples.size() < opt.maxSamples; round++) {
+            Clock::time_point t0 = Clock::now();
+            if(t0 >= deadline && !samples.empty())
+                break;
+            for(size_t sent = 0; sent < msg.size(); txCalls++) {
+                struct iovec iov = { msg.data() + sent, msg.size() - sent };
+                if(nonblock) {
+                    struct pollfd pfd = { link.uart->getFd(), POLLOUT, 0 };
+                    poll(&pfd, 1, 100);
+                }
+                sent += link.uart->writeVector(&iov, 1);
+            }
+            rxCalls += read_echo(*link.uart, msg.size(), nonblock, timeoutS);
+            if(round >= 16)                              // warm-up rounds not recorded
+                samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+        }
+    } catch(...) {
+        stop = true;
+        if(echo.joinable())
+            echo.join();
+        throw;
+    }
+    stop = true;
+    if(echo.joinable())
+        echo.join();
+
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for(double s : samples)
+        sum += s;
+    JsonObject rtt;
+    rtt.add("min", samples.empty() ? NAN : samples.front())
+       .add("p50", percentile(samples, 0.50))
+       .add("p99", percentile(samples, 0.99))
+       .add("p999", percentile(samples, 0.999))
+       .add("max", samples.empty() ? NAN : samples.back())
+       .add("mean", samples.empty() ? NAN : sum / samples.size());
+    uint64_t rounds = samples.size() + 16;
+    o.add("samples", static_cast<uint64_t>(samples.size()))
+     .raw("rtt_us", rtt.str())
+     .add("tx_syscalls_per_msg", double(txCalls) / rounds)
+     .add("rx_syscalls_per_msg", double(rxCalls) / rounds);
+}
+
+/* --------- main --------- */
+static std::vector<std::string> split(const std::string &list) {
+    std::vector<std::string> out;
+    std::stringstream ss(list);
+    std::string item;
+    while(std::getline(ss, item, ','))
+        if(!item.empty())
+            out.push_back(item);
+    return out;
+}
+
+static std::vector<long> split_numbers(const std::string &list) {
+    std::vector<long> out;
+    for(const std::string &s : split(list))
+        out.push_back(strtol(s.c_str(), nullptr, 10));
+    return out;
+}
+
+static void print_usage(const char *program_name) {
+    printf("Usage: %s [options]\n", program_name);
+    printf("Options:\n");
+    printf("  -d <dev>     Also bench a real port (TX wired to RX)\n");
+    printf("  -N           Skip the pty runs\n");
+    printf("  -c <list>    Chunk sizes (default 1,16,64,256,1024,4096)\n");
+    printf("  -B <list>    Baud rates (default 115200 on pty, 9600..921600 on a device)\n");
+    printf("  -T <list>    termios modes: driver,raw-vmin1,raw-nonblock\n");
+    printf("  -m <list>    Threading modes: direct,queue,queue-4\n");
+    printf("  -x <test>    Only run throughput or rtt\n");
+    printf("  -t <ms>      Duration per case (default 300)\n");
+    printf("  -s <n>       Max RTT samples per case (default 20000)\n");
+    printf("  -o <file>    Write JSON here instead of stdout\n");
+    printf("  -h           Show this help\n");
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions opt;
+    int c;
+    while((c = getopt(argc, argv, "d:Nc:B:T:m:x:t:s:o:h")) != -1) {
+        switch(c) {
+            case 'd': opt.device = optarg; break;
+            case 'N': opt.usePty = false; break;
+            case 'c': opt.chunks = split_numbers(optarg); break;
+            case 'B': opt.bauds = split_numbers(optarg); break;
+            case 'T': opt.termiosModes = split(optarg); break;
+            case 'm': opt.threading = split(optarg); break;
+            case 'x':
+                opt.throughput = strcmp(optarg, "throughput") == 0;
+                opt.rtt = strcmp(optarg, "rtt") == 0;
+                break;
+            case 't': opt.durationMs = strtol(optarg, nullptr, 10); break;
+            case 's': opt.maxSamples = strtoul(optarg, nullptr, 10); break;
+            case 'o': opt.output = optarg; break;
+            case 'h':
+                print_usage(argv[0]);
+                return 0;
+            default:
+                print_usage(argv[0]);
+                return 1;
+        }
+    }
+
+    std::vector<std::string> transports;
+    if(opt.usePty)
+        transports.push_back("");
+    if(!opt.device.empty())
+        transports.push_back(opt.device);
+
+    std::vector<std::string> results;
+    for(const std::string &device : transports) {
+        std::vector<long> bauds = opt.bauds;
+        if(bauds.empty())
+            bauds = device.empty() ? std::vector<long>{115200} : std::vector<long>{9600, 115200, 460800, 921600};
+        for(long baud : bauds) {
+            for(long chunk : opt.chunks) {
+                if(opt.throughput) {
+                    for(const std::string &mode : opt.threading) {
+                        fprintf(stderr, "throughput %s baud %ld chunk %ld %s\n",
+                                device.empty() ? "pty" : device.c_str(), baud, chunk, mode.c_str());
+                        JsonObject o = case_header("throughput", device, baud, chunk, "driver", mode);
+                        try {
+                            run_throughput(o, opt, device, baud, chunk, mode);
+                        } catch(const std::exception &e) {
+                            o.add("error", e.what());
+                        }
+                        results.push_back(o.str());
+                    }
+                }
+                if(opt.rtt) {
+                    for(const std::string &mode : opt.termiosModes) {
+                        fprintf(stderr, "rtt %s baud %ld chunk %ld %s\n",
+                                device.empty() ? "pty" : device.c_str(), baud, chunk, mode.c_str());
+                        JsonObject o = case_header("rtt", device, baud, chunk, mode, "direct");
+                        try {
+                            run_rtt(o, opt, device, baud, chunk, mode);
+                        } catch(const std::exception &e) {
+                            o.add("error", e.what());
+                        }
+                        results.push_back(o.str());
+                    }
+                }
+            }
+        }
+    }
+
+    struct utsname un{};
+    uname(&un);
+    JsonObject doc;
+    doc.add("tool", "uart_bench")
+       .add("schema", 1L)
+       .add("unix_time", static_cast<long>(time(nullptr)))
+       .add("host", un.nodename)
+       .add("kernel", un.release)
+       .add("machine", un.machine)
+       .add("duration_ms", opt.durationMs);
+    std::string list = "[";
+    for(size_t i = 0; i < results.size(); i++)
+        list += (i ? ",\n    " : "\n    ") + results[i];
+    list += "\n  ]";
+    doc.raw("results", list);
+
+    FILE *out = opt.output.empty() ? stdout : fopen(opt.output.c_str(), "w");
+    if(out == nullptr) {
+        perror("fopen");
+        return 1;
+    }
+    fprintf(out, "%s\n", doc.str().c_str());
+    if(out != stdout)
+        fclose(out);
+    return 0;
+}
@@ -13,6 +13,7 @@
 #include <linux/of.h>
 #include <linux/of_device.h>
 #include <linux/platform_device.h>
+#include <linux/poll.h>
 
 #define DEVICE_NAME "rpi4_uart"
 #define CLASS_NAME "rpi4uart"
@@ -88,6 +89,7 @@ static int uart_open(struct inode *inode, struct file *file);
 static int uart_release(struct inode *inode, struct file *file);
 static ssize_t uart_read(struct file *file, char __user *buffer, size_t len, loff_t *pos);
 static ssize_t uart_write(struct file *file, const char __user *buffer, size_t len, loff_t *pos);
+static __poll_t uart_poll(struct file *file, poll_table *wait);
 static irqreturn_t uart_interrupt(int irq, void *dev_id);
 static int uart_hw_init(void);
 static void uart_hw_cleanup(void);
@@ -98,6 +100,7 @@ static struct file_operations uart_fops = {
     .release = uart_release,
     .read = uart_read,
     .write = uart_write,
+    .poll = uart_poll,
     .owner = THIS_MODULE,
 };
 
@@ -285,6 +288,8 @@ static ssize_t uart_read(struct file *file, char __user *buffer, size_t len, lof
         return 0;
     
     // Wait for data
+    if ((file->f_flags & O_NONBLOCK) && rx_head == rx_tail)
+        return -EAGAIN;
     if (wait_event_interruptible(rx_wait, rx_head != rx_tail))
         return -ERESTARTSYS;
     
@@ -327,7 +332,17 @@ static ssize_t uart_write(struct file *file, const char __user *buffer, size_t l
     if (copy_from_user(temp_buffer, buffer, len))
         return -EFAULT;
     
-    spin_lock_irqsave(&uart_lock, flags);
+    // Wait for room in the TX buffer unless non-blocking
+    while (1) {
+        spin_lock_irqsave(&uart_lock, flags);
+        if ((tx_head + 1) % BUFFER_SIZE != tx_tail)
+            break;
+        spin_unlock_irqrestore(&uart_lock, flags);
+        if (file->f_flags & O_NONBLOCK)
+            return -EAGAIN;
+        if (wait_event_interruptible(tx_wait, (tx_head + 1) % BUFFER_SIZE != tx_tail))
+            return -ERESTARTSYS;
+    }
     
     // Add data to TX buffer
     while (bytes_written < len) {
@@ -353,6 +368,25 @@ static ssize_t uart_write(struct file *file, const char __user *buffer, size_t l
     return bytes_written;
 }
 
+// Readable while RX data is buffered, writable while the TX buffer has room
+static __poll_t uart_poll(struct file *file, poll_table *wait)
+{
+    unsigned long flags;
+    __poll_t mask = 0;
+    
+    poll_wait(file, &rx_wait, wait);
+    poll_wait(file, &tx_wait, wait);
+    
+    spin_lock_irqsave(&uart_lock, flags);
+    if (rx_head != rx_tail)
+        mask |= EPOLLIN | EPOLLRDNORM;
+    if ((tx_head + 1) % BUFFER_SIZE != tx_tail)
+        mask |= EPOLLOUT | EPOLLWRNORM;
+    spin_unlock_irqrestore(&uart_lock, flags);
+    
+    return mask;
+}
+
 // Module initialization
 static int __init uart_module_init(void)
 {
@@ -4,27 +4,109 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
-#include <sys/select.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <poll.h>
 #include <signal.h>
+#include <time.h>
+#include <termios.h>
+
+#include "binlog.hpp"
+#include "periodic_executor.hpp"
+#include "frame_codec.h"
+#include "robot_protocol.h"
+#include "telemetry_codec.h"
 
 #define DEVICE_PATH "/dev/rpi4_uart"
 #define BUFFER_SIZE 256
+#define DEFAULT_CHUNK_SIZE 4096
+#define DEFAULT_LINE_RATE 115200    // what rpi4_uart programs (IBRD 26 / FBRD 3)
+#define BENCH_HEADER_SIZE 16
+#define BENCH_MAX_PAYLOAD 1024
+#define BENCH_SEQ_WINDOW 65536      // sequence numbers tracked for duplicates, power of two
+#define DEFAULT_BENCH_PAYLOAD 64
+#define DEFAULT_BENCH_SECONDS 10
+#define DEFAULT_BENCH_WINDOW 16     // packets sent past the newest echo
+#define BENCH_DRAIN_SEC 1.0         // how long to wait for echoes after the last send
+#define BENCH_STALL_MS 200          // full window and no echo this long: write the window off
+#define DEFAULT_MONITOR_HZ 60       // -m redraws, about one per display refresh
 
 static int uart_fd = -1;
+static const char *device_path = DEVICE_PATH;
 static int running = 1;
+static const char *log_path = NULL;     // -l: received data goes to a binary log, not stdout
+
+// SIGINT/SIGTERM are blocked and read from a signalfd in the event loops,
+// so shutdown runs in normal context where printf is safe
+static int signal_fd = -1;
+
+static int setup_signals() {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) < 0) {
+        perror("Error blocking signals");
+        return -1;
+    }
+    signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signal_fd < 0) {
+        perror("Error creating signalfd");
+        return -1;
+    }
+    return 0;
+}
+
+static void check_signals() {
+    struct signalfd_siginfo si;
+    while (read(signal_fd, &si, sizeof(si)) == sizeof(si)) {
+        if (running)
+            printf("\nShutting down...\n");
+        running = 0;
+    }
+}
 
-void signal_handler(int sig) {
-    running = 0;
-    printf("\nShutting down...\n");
+// For loops that never sleep on anything the signalfd could join
+static int keep_running() {
+    check_signals();
+    return running;
+}
+
+static int epoll_add(int epfd, int fd) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    return epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
 }
 
 void print_usage(const char *program_name) {
     printf("Usage: %s [options]\n", program_name);
     printf("Options:\n");
+    printf("  -d <device>  Device to open (default %s)\n", DEVICE_PATH);
     printf("  -t <text>    Send text and exit\n");
     printf("  -f <file>    Send file contents\n");
+    printf("  -S <file>    Stream a file (any binary) as fast as the line takes it\n");
+    printf("  -c <bytes>   Stream chunk size (default %d)\n", DEFAULT_CHUNK_SIZE);
+    printf("  -B <baud>    Line rate to compare the stream against (default %d)\n", DEFAULT_LINE_RATE);
     printf("  -i           Interactive mode (default)\n");
     printf("  -r           Read-only mode\n");
+    printf("  -b <B/s>     Loopback bench against an echoing far end, 0 = flat out\n");
+    printf("  -D <sec>     Bench duration (default %d)\n", DEFAULT_BENCH_SECONDS);
+    printf("  -P <bytes>   Bench packet size, %d .. %d (default %d)\n", BENCH_HEADER_SIZE,
+           BENCH_MAX_PAYLOAD, DEFAULT_BENCH_PAYLOAD);
+    printf("  -W <n>       Bench packets outstanding past the newest echo (default %d)\n",
+           DEFAULT_BENCH_WINDOW);
+    printf("  -E           Echo stand-in: create a pty and echo it back at -B baud\n");
+    printf("  -m           Protocol monitor: decode frames, live per-type rates\n");
+    printf("  -F <hz>      Monitor redraw rate (default %d)\n", DEFAULT_MONITOR_HZ);
+    printf("  -w <file>    Capture RX/TX to a pcapng file (read-only mode unless another is given)\n");
+    printf("  -C <MB>      Start a new capture file (<file>.1, .2, ...) every <MB> megabytes\n");
+    printf("  -l <file>    Record received data to a binary log instead of printing it\n");
+    printf("               (read it with binlog_decode)\n");
     printf("  -h           Show this help\n");
 }
 
@@ -35,6 +117,7 @@ int send_text(const char *text) {
         return -1;
     }
     printf("Sent %d bytes: %s\n", bytes_written, text);
+    BINLOG_INFO("sent %d bytes: %s", bytes_written, text);
     return bytes_written;
 }
 
@@ -48,13 +131,14 @@ int send_file(const char *filename) {
     char buffer[BUFFER_SIZE];
     int total_bytes = 0;
     
-    while (fgets(buffer, sizeof(buffer), file) && running) {
+    while (fgets(buffer, sizeof(buffer), file) && keep_running()) {
         int bytes_written = write(uart_fd, buffer, strlen(buffer));
         if (bytes_written < 0) {
             perror("Error writing to UART");
             break;
         }
         total_bytes += bytes_written;
+        BINLOG_DEBUG("sent %d bytes", bytes_written);
         usleep(1000); // Small delay between lines
     }
     
@@ -63,100 +147,938 @@ int send_file(const char *filename) {
     return total_bytes;
 }
 
+static double monotonic_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// ---- Capture (-w) ----
+//
+// pcapng, one interface with LINKTYPE_USER0 and nanosecond timestamps; each
+// read() or write() is one Enhanced Packet Block with the direction in
+// epb_flags, so Wireshark shows RX and TX apart. Timestamps come from
+// CLOCK_MONOTONIC offset to wall time once at open, so they never step.
+// Blocks collect in a buffer that goes out with one write() when full or
+// once a second.
+
+#define CAPTURE_BUFFER_SIZE (1 << 20)
+#define CAPTURE_READ_SIZE 65536
+#define CAPTURE_LINKTYPE 147        // LINKTYPE_USER0
+#define CAPTURE_RX 1                // epb_flags: inbound
+#define CAPTURE_TX 2                // epb_flags: outbound
+
+static int capture_fd = -1;
+static const char *capture_path = NULL;
+static unsigned long long capture_rotate_bytes = 0;    // -C: 0 = one file
+static unsigned capture_index = 0;                      // files opened so far
+static unsigned long long capture_file_bytes = 0;
+static unsigned long long capture_packets = 0, capture_bytes = 0, capture_write_errors = 0;
+static uint8_t *capture_buf = NULL;
+static size_t capture_used = 0;
+static double capture_last_flush = 0;
+static uint64_t capture_epoch_ns = 0;   // wall clock at monotonic zero
+
+static void capture_put(const void *data, size_t len) {
+    memcpy(capture_buf + capture_used, data, len);
+    capture_used += len;
+}
+
+static void capture_put16(uint16_t v) { capture_put(&v, 2); }
+static void capture_put32(uint32_t v) { capture_put(&v, 4); }
+
+// option: code, length, value padded to 32 bits
+static void capture_put_option(uint16_t code, const void *value, uint16_t len) {
+    static const uint8_t pad[4] = { 0 };
+    capture_put16(code);
+    capture_put16(len);
+    capture_put(value, len);
+    capture_put(pad, (4 - len % 4) % 4);
+}
+
+static void capture_flush() {
+    size_t off = 0;
+    while (off < capture_used) {
+        ssize_t w = write(capture_fd, capture_buf + off, capture_used - off);
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w <= 0) {
+            capture_write_errors++;
+            break;
+        }
+        off += w;
+    }
+    capture_file_bytes += capture_used;
+    capture_used = 0;
+    capture_last_flush = monotonic_sec();
+}
+
+// Section Header + Interface Description, the start of every file
+static void capture_put_headers() {
+    static const char app[] = "uart_test";
+    static const uint8_t tsresol = 9;   // 10^-9 s
+    uint16_t name_len = strlen(device_path);
+    uint32_t len;
+
+    len = 28 + 4 + ((sizeof(app) - 1 + 3) & ~3u) + 4;
+    capture_put32(0x0A0D0D0A);
+    capture_put32(len);
+    capture_put32(0x1A2B3C4D);          // byte-order magic
+    capture_put16(1);
+    capture_put16(0);
+    capture_put32(0xFFFFFFFF);          // section length unknown
+    capture_put32(0xFFFFFFFF);
+    capture_put_option(4, app, sizeof(app) - 1);        // shb_userappl
+    capture_put32(0);                   // opt_endofopt
+    capture_put32(len);
+
+    len = 20 + 4 + ((name_len + 3) & ~3u) + 8 + 4;
+    capture_put32(0x00000001);
+    capture_put32(len);
+    capture_put16(CAPTURE_LINKTYPE);
+    capture_put16(0);
+    capture_put32(0);                   // no snap length
+    capture_put_option(2, device_path, name_len);       // if_name
+    capture_put_option(9, &tsresol, 1);                 // if_tsresol
+    capture_put32(0);
+    capture_put32(len);
+}
+
+// Opens path, then path.1, path.2, ... on each rotation
+static int capture_open_file() {
+    char name[4096];
+    if (capture_index == 0)
+        snprintf(name, sizeof(name), "%s", capture_path);
+    else
+        snprintf(name, sizeof(name), "%s.%u", capture_path, capture_index);
+    capture_fd = open(name, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (capture_fd < 0) {
+        perror("Error opening capture file");
+        return -1;
+    }
+    capture_index++;
+    capture_file_bytes = 0;
+    capture_put_headers();
+    return 0;
+}
+
+int capture_open(const char *path, unsigned long long rotate_bytes) {
+    capture_buf = (uint8_t *)malloc(CAPTURE_BUFFER_SIZE);
+    if (!capture_buf) {
+        fprintf(stderr, "Error allocating capture buffer\n");
+        return -1;
+    }
+    struct timespec wall;
+    clock_gettime(CLOCK_REALTIME, &wall);
+    uint64_t mono = monotonic_ns();
+    capture_epoch_ns = wall.tv_sec * 1000000000ULL + wall.tv_nsec - mono;
+    capture_path = path;
+    capture_rotate_bytes = rotate_bytes;
+    capture_last_flush = monotonic_sec();
+    return capture_open_file();
+}
+
+void capture_record(int direction, const void *data, size_t len) {
+    if (capture_fd < 0 || len == 0)
+        return;
+    // a chunk that would not fit the buffer is split over several blocks
+    while (len > CAPTURE_BUFFER_SIZE / 2) {
+        capture_record(direction, data, CAPTURE_BUFFER_SIZE / 2);
+        data = (const uint8_t *)data + CAPTURE_BUFFER_SIZE / 2;
+        len -= CAPTURE_BUFFER_SIZE / 2;
+    }
+    uint32_t padded = (len + 3) & ~(size_t)3;
+    uint32_t block_len = 28 + padded + 8 + 4 + 4;
+    if (capture_used + block_len > CAPTURE_BUFFER_SIZE)
+        capture_flush();
+
+    static const uint8_t pad[4] = { 0 };
+    uint64_t ts = capture_epoch_ns + monotonic_ns();
+    uint32_t flags = direction;
+    capture_put32(0x00000006);
+    capture_put32(block_len);
+    capture_put32(0);                   // interface 0
+    capture_put32(ts >> 32);
+    capture_put32((uint32_t)ts);
+    capture_put32(len);
+    capture_put32(len);
+    capture_put(data, len);
+    capture_put(pad, padded - len);
+    capture_put_option(2, &flags, 4);   // epb_flags
+    capture_put32(0);
+    capture_put32(block_len);
+    capture_packets++;
+    capture_bytes += len;
+
+    if (capture_rotate_bytes && capture_file_bytes + capture_used >= capture_rotate_bytes) {
+        capture_flush();
+        close(capture_fd);
+        capture_open_file();
+    } else if (monotonic_sec() - capture_last_flush >= 1.0) {
+        capture_flush();
+    }
+}
+
+// For idle loops, so the file is never more than about a second behind
+void capture_tick() {
+    if (capture_fd >= 0 && capture_used && monotonic_sec() - capture_last_flush >= 1.0)
+        capture_flush();
+}
+
+void capture_close() {
+    if (capture_fd >= 0) {
+        capture_flush();
+        close(capture_fd);
+        capture_fd = -1;
+    }
+    free(capture_buf);
+    capture_buf = NULL;
+}
+
+// Streams the file as-is: no line splitting, no per-line sleep. Writes are
+// paced by poll() on the device instead, so they go out as fast as the
+// driver's TX buffer drains.
+int stream_file(const char *filename, size_t chunk_size, long line_rate) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror("Error opening file");
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        perror("Error reading file size");
+        close(fd);
+        return -1;
+    }
+    size_t size = st.st_size;
+    if (size == 0) {
+        printf("Nothing to send: %s is empty\n", filename);
+        close(fd);
+        return 0;
+    }
+    const unsigned char *data = (const unsigned char *)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        perror("Error mapping file");
+        return -1;
+    }
+    madvise((void *)data, size, MADV_SEQUENTIAL);
+
+    struct pollfd pfds[2] = { { uart_fd, POLLOUT, 0 }, { signal_fd, POLLIN, 0 } };
+    size_t sent = 0;
+    unsigned long writes = 0, waits = 0;
+    double start = monotonic_sec();
+    double next_report = start + 1.0;
+    double line_bytes_per_sec = line_rate / 10.0;   // 8N1: 10 bits per byte
+
+    while (sent < size && keep_running()) {
+        size_t n = size - sent < chunk_size ? size - sent : chunk_size;
+        ssize_t w = write(uart_fd, data + sent, n);
+        if (w > 0) {
+            capture_record(CAPTURE_TX, data + sent, w);
+            sent += w;
+            writes++;
+        } else if (w < 0 && errno != EAGAIN && errno != EINTR) {
+            perror("Error writing to UART");
+            break;
+        } else {
+            // TX buffer full: sleep until the driver says there is room
+            waits++;
+            if (poll(pfds, 2, 1000) < 0 && errno != EINTR) {
+                perror("poll error");
+                break;
+            }
+        }
+
+        double now = monotonic_sec();
+        if (now >= next_report) {
+            printf("\r%zu / %zu bytes, %.0f B/s   ", sent, size, sent / (now - start));
+            fflush(stdout);
+            next_report = now + 1.0;
+        }
+    }
+    double elapsed = monotonic_sec() - start;
+    munmap((void *)data, size);
+
+    // sent counts bytes the driver took; at most its TX buffer is still in flight
+    double rate = elapsed > 0 ? sent / elapsed : 0;
+    printf("\rStreamed %zu of %zu bytes from %s in %.3f s (%lu writes, %lu waits)\n",
+           sent, size, filename, elapsed, writes, waits);
+    printf("Throughput %.0f B/s, %.1f%% of %ld baud 8N1 (%.0f B/s)\n",
+           rate, 100.0 * rate / line_bytes_per_sec, line_rate, line_bytes_per_sec);
+    BINLOG_INFO("streamed %zu bytes in %.3f s, %.0f B/s", sent, elapsed, rate);
+    return sent == size ? (int)sent : -1;
+}
+
+// ---- Loopback bench (-b) ----
+//
+// Each packet is one COBS/CRC-32 frame (frame_codec.h) carrying
+//   u32 run id | u32 sequence | u64 send time (ns) | pattern bytes
+// so a lost delimiter costs at most two packets and the receiver
+// resyncs on the next one. The far end only has to echo bytes back
+// (serdev_echo, a wire loop, or uart_test -E on a pty).
+
+// Deterministic per packet, and walks every byte value (0x00 included, the
+// COBS delimiter) so escaping on the wire is exercised
+static uint8_t bench_pattern(uint32_t seq, size_t i) {
+    return (uint8_t)(seq * 151u + i * 13u);
+}
+
+static void bench_put32(uint8_t *p, uint32_t v) { memcpy(p, &v, 4); }
+static void bench_put64(uint8_t *p, uint64_t v) { memcpy(p, &v, 8); }
+static uint32_t bench_get32(const uint8_t *p) { uint32_t v; memcpy(&v, p, 4); return v; }
+static uint64_t bench_get64(const uint8_t *p) { uint64_t v; memcpy(&v, p, 8); return v; }
+
+struct bench_stats {
+    unsigned long long sent, sent_bytes;            // bytes on the wire, framing included
+    unsigned long long received, received_bytes;    // good, first-time echoes
+    unsigned long long reordered;                   // arrived after a later sequence number
+    unsigned long long duplicates;
+    unsigned long long crc_errors, malformed, overflows;
+    unsigned long long mismatched;                  // good CRC but wrong contents
+    unsigned long long stale;                       // from an earlier run
+    unsigned long long write_waits;
+    unsigned long long stalls;                      // windows written off as lost
+};
+
+static void bench_check_packet(const uint8_t *p, size_t len, uint32_t run_id, uint32_t next_seq,
+                               uint8_t *seen, long long *highest, LatencyHistogram &rtt,
+                               struct bench_stats *s, size_t frame_len) {
+    if (len < BENCH_HEADER_SIZE) {
+        s->mismatched++;
+        return;
+    }
+    if (bench_get32(p) != run_id) {
+        s->stale++;
+        return;
+    }
+    uint32_t seq = bench_get32(p + 4);
+    uint64_t sent_at = bench_get64(p + 8);
+    if (seq >= next_seq) {
+        s->mismatched++;                            // never sent
+        return;
+    }
+    for (size_t i = BENCH_HEADER_SIZE; i < len; i++) {
+        if (p[i] != bench_pattern(seq, i)) {
+            s->mismatched++;
+            return;
+        }
+    }
+    uint8_t bit = 1u << (seq & 7);
+    uint8_t *slot = &seen[(seq & (BENCH_SEQ_WINDOW - 1)) >> 3];
+    if (*slot & bit) {
+        s->duplicates++;
+        return;
+    }
+    *slot |= bit;
+    s->received++;
+    s->received_bytes += frame_len;
+    if ((long long)seq < *highest)
+        s->reordered++;
+    else
+        *highest = seq;
+    rtt.record(monotonic_ns() - sent_at);
+}
+
+static void print_rtt(const char *name, const LatencyHistogram &h) {
+    printf("  %-6s min %8.1f  p50 %8.1f  p90 %8.1f  p99 %8.1f  p99.9 %8.1f  max %8.1f us\n", name,
+           h.min() / 1e3, h.percentile(50) / 1e3, h.percentile(90) / 1e3, h.percentile(99) / 1e3,
+           h.percentile(99.9) / 1e3, h.max() / 1e3);
+}
+
+// Sends numbered packets at rate bytes/s (0 = as fast as the window allows)
+// for seconds, checks what comes back, then reports loss and RTT. Only
+// window packets may be outstanding past the newest echo, so a dead far
+// end stalls the sender instead of flooding the driver's buffers; after
+// BENCH_STALL_MS without an echo the window is written off and sending
+// resumes (echoes that still turn up count as reordered).
+int bench_mode(long rate, int seconds, size_t payload, unsigned window, long line_rate) {
+    static uint8_t seen[BENCH_SEQ_WINDOW / 8];
+    uint8_t packet[BENCH_MAX_PAYLOAD];
+    uint8_t tx[frame_codec::max_encoded_size(BENCH_MAX_PAYLOAD)];
+    uint8_t rx[4096];
+    frame_codec::frame_decoder<BENCH_MAX_PAYLOAD> decoder;
+    LatencyHistogram rtt;
+    struct bench_stats s;
+    memset(&s, 0, sizeof(s));
+
+    uint32_t run_id = (uint32_t)monotonic_ns() ^ ((uint32_t)getpid() << 16);
+    uint32_t next_seq = 0;
+    long long highest = -1;         // newest sequence number echoed
+    size_t tx_len = 0, tx_off = 0;  // frame being written
+    size_t frame_len = frame_codec::max_encoded_size(payload);
+
+    uint64_t start = monotonic_ns();
+    uint64_t stop_sending = start + (uint64_t)seconds * 1000000000ULL;
+    uint64_t stop_at = stop_sending + (uint64_t)(BENCH_DRAIN_SEC * 1e9);
+    uint64_t next_send = start;
+    uint64_t next_report = start + 1000000000ULL;
+    uint64_t last_echo = start;
+    uint64_t last_sent = start;
+
+    if (rate)
+        printf("Bench: %zu byte packets (up to %zu on the wire) at %ld B/s, window %u, %d s\n",
+               payload, frame_len, rate, window, seconds);
+    else
+        printf("Bench: %zu byte packets (up to %zu on the wire) flat out, window %u, %d s\n",
+               payload, frame_len, window, seconds);
+
+    while (running) {
+        uint64_t now = monotonic_ns();
+        if (now >= stop_at || (now >= stop_sending && tx_len == 0 && s.received >= next_seq))
+            break;
+
+        // Build the next packet when it is due and the window has room
+        bool window_full = (long long)next_seq - highest - 1 >= (long long)window;
+        if (window_full && tx_len == 0 && now - last_echo > BENCH_STALL_MS * 1000000ULL &&
+            now - last_sent > BENCH_STALL_MS * 1000000ULL) {
+            highest = (long long)next_seq - 1;
+            s.stalls++;
+            window_full = false;
+        }
+        if (tx_len == 0 && now < stop_sending && now >= next_send && !window_full) {
+            bench_put32(packet, run_id);
+            bench_put32(packet + 4, next_seq);
+            bench_put64(packet + 8, now);
+            for (size_t i = BENCH_HEADER_SIZE; i < payload; i++)
+                packet[i] = bench_pattern(next_seq, i);
+            tx_len = frame_codec::encode_frame(packet, payload, tx, sizeof(tx));
+            tx_off = 0;
+            seen[(next_seq & (BENCH_SEQ_WINDOW - 1)) >> 3] &= ~(1u << (next_seq & 7));
+            next_seq++;
+            s.sent++;
+            s.sent_bytes += tx_len;
+            last_sent = now;
+            if (rate)
+                next_send += tx_len * 1000000000ULL / rate;
+        }
+        if (tx_len) {
+            ssize_t w = write(uart_fd, tx + tx_off, tx_len - tx_off);
+            if (w > 0) {
+                capture_record(CAPTURE_TX, tx + tx_off, w);
+                tx_off += w;
+                if (tx_off == tx_len)
+                    tx_len = 0;
+            } else if (w < 0 && errno != EAGAIN && errno != EINTR) {
+                perror("Error writing to UART");
+                return -1;
+            } else {
+                s.write_waits++;
+            }
+        }
+
+        // Sleep until there is something to read, room to write, or the
+        // next packet is due
+        struct pollfd pfds[2] = {
+            { uart_fd, (short)(POLLIN | (tx_len ? POLLOUT : 0)), 0 },
+            { signal_fd, POLLIN, 0 },
+        };
+        int timeout_ms = 100;
+        if (!tx_len && !window_full && now < stop_sending && rate) {
+            long long wait_ns = (long long)(next_send - now);
+            timeout_ms = wait_ns > 0 ? (int)(wait_ns / 1000000) : 0;
+        } else if (!tx_len && !window_full && now < stop_sending) {
+            timeout_ms = 0;
+        }
+        if (poll(pfds, 2, timeout_ms) < 0 && errno != EINTR) {
+            perror("poll error");
+            return -1;
+        }
+        if (pfds[1].revents)
+            check_signals();
+
+        ssize_t n = read(uart_fd, rx, sizeof(rx));
+        if (n < 0 && errno != EAGAIN && errno != EINTR) {
+            perror("Error reading from UART");
+            return -1;
+        }
+        if (n > 0)
+            capture_record(CAPTURE_RX, rx, n);
+        for (ssize_t i = 0; i < n; i++) {
+            switch (decoder.push(rx[i])) {
+            case frame_codec::decode_status::frame:
+                last_echo = monotonic_ns();
+                bench_check_packet(decoder.data(), decoder.size(), run_id, next_seq, seen,
+                                   &highest, rtt, &s, frame_len);
+                break;
+            case frame_codec::decode_status::crc_error: s.crc_errors++; break;
+            case frame_codec::decode_status::malformed: s.malformed++; break;
+            case frame_codec::decode_status::overflow:  s.overflows++;  break;
+            case frame_codec::decode_status::pending:   break;
+            }
+        }
+
+        now = monotonic_ns();
+        if (now >= next_report) {
+            printf("\rsent %llu  received %llu  outstanding %llu  p50 %.1f us   ", s.sent, s.received,
+                   s.sent - s.received, rtt.percentile(50) / 1e3);
+            fflush(stdout);
+            next_report = now + 1000000000ULL;
+        }
+    }
+
+    double elapsed = (monotonic_ns() - start) / 1e9;
+    double send_time = elapsed < seconds ? elapsed : seconds;
+    unsigned long long lost = s.sent - s.received;
+    double line_bytes_per_sec = line_rate / 10.0;   // 8N1: 10 bits per byte
+    double tx_rate = send_time > 0 ? s.sent_bytes / send_time : 0;
+    double echo_time = (last_echo - start) / 1e9;
+    double rx_rate = echo_time > 0 ? s.received_bytes / echo_time : 0;
+
+    printf("\rSent %llu packets (%llu bytes), received %llu in %.3f s%20s\n", s.sent, s.sent_bytes,
+           s.received, elapsed, "");
+    printf("  lost %llu (%.3f%%), reordered %llu, duplicates %llu, stale %llu\n", lost,
+           s.sent ? 100.0 * lost / s.sent : 0.0, s.reordered, s.duplicates, s.stale);
+    printf("  corrupt: %llu crc errors, %llu malformed, %llu overflows, %llu bad contents\n",
+           s.crc_errors, s.malformed, s.overflows, s.mismatched);
+    printf("  tx %.0f B/s, echoed %.0f B/s (%.1f%% of %ld baud 8N1), %llu write waits, %llu stalls\n",
+           tx_rate, rx_rate, 100.0 * rx_rate / line_bytes_per_sec, line_rate, s.write_waits, s.stalls);
+    if (rtt.count())
+        print_rtt("rtt", rtt);
+    BINLOG_INFO("bench: sent %llu received %llu lost %llu corrupt %llu p99 %llu ns", s.sent, s.received,
+                lost, s.crc_errors + s.malformed + s.mismatched, (unsigned long long)rtt.percentile(99));
+    return lost || s.crc_errors || s.malformed || s.overflows || s.mismatched || s.duplicates ? 1 : 0;
+}
+
+// Stand-in for serdev_echo when there is no board: opens a pty, prints the
+// name to point -d at, and echoes everything back, paced to line_rate.
+int echo_mode(long line_rate) {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0) {
+        perror("Error creating pty");
+        return -1;
+    }
+    const char *name = ptsname(master);
+    // Hold the slave open (raw) so the master does not see a hangup
+    // between bench runs
+    int slave = open(name, O_RDWR | O_NOCTTY);
+    if (slave < 0) {
+        perror("Error opening pty slave");
+        close(master);
+        return -1;
+    }
+    struct termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+    fcntl(master, F_SETFL, O_NONBLOCK);
+
+    printf("Echoing on %s at %ld baud (Ctrl+C to exit)\n", name, line_rate);
+    fflush(stdout);
+
+    uint8_t buffer[4096];
+    size_t len = 0, off = 0;
+    unsigned long long echoed = 0;
+    double bytes_per_sec = line_rate / 10.0;
+    double credit = 0, last = monotonic_sec();
+
+    while (running) {
+        double now = monotonic_sec();
+        credit += (now - last) * bytes_per_sec;
+        last = now;
+        if (credit > bytes_per_sec / 100)           // at most 10 ms worth in one burst
+            credit = bytes_per_sec / 100;
+
+        if (len == off) {
+            ssize_t n = read(master, buffer, sizeof(buffer));
+            if (n < 0 && errno != EAGAIN && errno != EINTR) {
+                perror("Error reading pty");
+                break;
+            }
+            len = n > 0 ? n : 0;
+            off = 0;
+        }
+        size_t allowed = len - off < credit ? len - off : (size_t)credit;
+        if (allowed) {
+            ssize_t w = write(master, buffer + off, allowed);
+            if (w > 0) {
+                off += w;
+                credit -= w;
+                echoed += w;
+            }
+        }
+
+        struct pollfd pfds[2] = {
+            { master, (short)(len == off ? POLLIN : 0), 0 },
+            { signal_fd, POLLIN, 0 },
+        };
+        if (poll(pfds, 2, len == off ? 100 : 1) > 0 && pfds[1].revents)
+            check_signals();
+    }
+    printf("Echoed %llu bytes\n", echoed);
+    close(slave);
+    close(master);
+    return 0;
+}
+
+void print_received(const char *buffer, int bytes_read) {
+    // No formatting or flush per chunk when logging: the binary log just
+    // copies the bytes and a background thread writes them out
+    if (log_path) {
+        BINLOG_INFO("received %d bytes: %s", bytes_read, buffer);
+        return;
+    }
+    printf("Received: %s", buffer);
+    fflush(stdout);
+}
+
 void interactive_mode() {
     printf("Interactive UART Terminal (Press Ctrl+C to exit)\n");
     printf("Type messages to send via UART:\n");
     
-    fd_set readfds;
     char buffer[BUFFER_SIZE];
-    int max_fd = (uart_fd > STDIN_FILENO) ? uart_fd : STDIN_FILENO;
+    struct epoll_event events[3];
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0 || epoll_add(epfd, uart_fd) < 0 || epoll_add(epfd, signal_fd) < 0) {
+        perror("epoll error");
+        return;
+    }
+    // A regular file on stdin cannot be polled: just listen then
+    if (epoll_add(epfd, STDIN_FILENO) < 0) {
+        printf("stdin cannot be polled, listening only\n");
+    }
     
     while (running) {
-        FD_ZERO(&readfds);
-        FD_SET(STDIN_FILENO, &readfds);  // Monitor stdin
-        FD_SET(uart_fd, &readfds);       // Monitor UART
-        
-        struct timeval timeout = {1, 0}; // 1 second timeout
-        int activity = select(max_fd + 1, &readfds, NULL, NULL, &timeout);
-        
-        if (activity < 0) {
+        // The timeout only keeps a capture file from lagging behind
+        int n = epoll_wait(epfd, events, 3, 1000);
+        if (n < 0) {
             if (errno == EINTR) continue;
-            perror("select error");
+            perror("epoll error");
             break;
         }
+        capture_tick();
         
-        if (activity == 0) continue; // Timeout
-        
-        // Check for input from stdin
-        if (FD_ISSET(STDIN_FILENO, &readfds)) {
-            if (fgets(buffer, sizeof(buffer), stdin)) {
-                if (write(uart_fd, buffer, strlen(buffer)) < 0) {
+        for (int i = 0; i < n && running; i++) {
+            int fd = events[i].data.fd;
+            if (fd == signal_fd) {
+                check_signals();
+            } else if (fd == STDIN_FILENO) {
+                if (!fgets(buffer, sizeof(buffer), stdin)) {
+                    // EOF: keep showing what arrives
+                    epoll_ctl(epfd, EPOLL_CTL_DEL, STDIN_FILENO, NULL);
+                    continue;
+                }
+                ssize_t w = write(uart_fd, buffer, strlen(buffer));
+                if (w < 0) {
                     perror("Error writing to UART");
+                    running = 0;
                     break;
                 }
-            }
-        }
-        
-        // Check for data from UART
-        if (FD_ISSET(uart_fd, &readfds)) {
-            int bytes_read = read(uart_fd, buffer, sizeof(buffer) - 1);
-            if (bytes_read > 0) {
-                buffer[bytes_read] = '\0';
-                printf("Received: %s", buffer);
-                fflush(stdout);
-            } else if (bytes_read < 0 && errno != EAGAIN) {
-                perror("Error reading from UART");
-                break;
+                capture_record(CAPTURE_TX, buffer, w);
+                BINLOG_INFO("sent: %s", buffer);
+            } else if (fd == uart_fd) {
+                int bytes_read = read(uart_fd, buffer, sizeof(buffer) - 1);
+                if (bytes_read > 0) {
+                    capture_record(CAPTURE_RX, buffer, bytes_read);
+                    buffer[bytes_read] = '\0';
+                    print_received(buffer, bytes_read);
+                } else if (bytes_read < 0 && errno != EAGAIN) {
+                    perror("Error reading from UART");
+                    running = 0;
+                }
             }
         }
     }
+    close(epfd);
 }
 
 void read_only_mode() {
     printf("Read-only UART Monitor (Press Ctrl+C to exit)\n");
     
-    fd_set readfds;
-    char buffer[BUFFER_SIZE];
+    // Printing each chunk cannot keep up with a fast line; when capturing,
+    // read big chunks straight into the capture and print a count once a second
+    static char buffer[CAPTURE_READ_SIZE];
+    size_t read_size = capture_fd >= 0 ? sizeof(buffer) : BUFFER_SIZE;
+    unsigned long long received = 0, reported = 0;
+    double next_report = monotonic_sec() + 1.0;
+    struct epoll_event events[2];
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0 || epoll_add(epfd, uart_fd) < 0 || epoll_add(epfd, signal_fd) < 0) {
+        perror("epoll error");
+        return;
+    }
     
     while (running) {
-        FD_ZERO(&readfds);
-        FD_SET(uart_fd, &readfds);
-        
-        struct timeval timeout = {1, 0}; // 1 second timeout
-        int activity = select(uart_fd + 1, &readfds, NULL, NULL, &timeout);
-        
-        if (activity < 0) {
+        int n = epoll_wait(epfd, events, 2, 1000);
+        if (n < 0) {
             if (errno == EINTR) continue;
-            perror("select error");
+            perror("epoll error");
             break;
         }
         
-        if (activity == 0) continue; // Timeout
+        capture_tick();
+        if (capture_fd >= 0 && monotonic_sec() >= next_report) {
+            printf("\rCaptured %llu bytes, %llu B/s   ", received, received - reported);
+            fflush(stdout);
+            reported = received;
+            next_report += 1.0;
+        }
         
-        if (FD_ISSET(uart_fd, &readfds)) {
-            int bytes_read = read(uart_fd, buffer, sizeof(buffer) - 1);
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.fd == signal_fd) {
+                check_signals();
+                continue;
+            }
+            int bytes_read = read(uart_fd, buffer, read_size - 1);
             if (bytes_read > 0) {
+                received += bytes_read;
+                if (capture_fd >= 0) {
+                    capture_record(CAPTURE_RX, buffer, bytes_read);
+                    continue;
+                }
                 buffer[bytes_read] = '\0';
-                printf("Received: %s", buffer);
-                fflush(stdout);
+                print_received(buffer, bytes_read);
             } else if (bytes_read < 0 && errno != EAGAIN) {
                 perror("Error reading from UART");
-                break;
+                running = 0;
             }
         }
     }
+    if (capture_fd >= 0)
+        printf("\n");
+    close(epfd);
+}
+
+// ---- Protocol monitor (-m) ----
+//
+// Decodes robot_protocol frames as fast as they arrive and redraws a
+// summary from a timerfd at the refresh rate. Reading drains the device
+// completely before the next redraw, and a redraw costs the same however
+// many frames came in since the last one, so the screen can only ever
+// skip frames, never fall behind them.
+
+#define MONITOR_SCREEN_SIZE 16384
+
+struct monitor_type {
+    unsigned long long frames, bytes;
+    unsigned long long window_frames, window_bytes;     // at the last rate update
+    double frame_rate, byte_rate;
+    uint64_t last_ns;
+};
+
+struct monitor_state {
+    struct monitor_type types[256];
+    unsigned long long bytes, window_bytes, frames;
+    unsigned long long crc_errors, malformed, overflows;
+    double byte_rate;
+    uint64_t start_ns, rate_ns;
+    robot_protocol::telemetry last_sample;
+    uint64_t last_sample_ns;
+    telemetry_codec::decoder compact;
+};
+
+static const char *monitor_type_name(uint8_t id) {
+    switch (id) {
+    case robot_protocol::cmd_motor:            return "cmd_motor";
+    case robot_protocol::cmd_stop:             return "cmd_stop";
+    case robot_protocol::cmd_telemetry_rate:   return "cmd_telemetry_rate";
+    case robot_protocol::cmd_ping:             return "cmd_ping";
+    case robot_protocol::cmd_time_sync:        return "cmd_time_sync";
+    case robot_protocol::cmd_baud_propose:     return "cmd_baud_propose";
+    case robot_protocol::cmd_link_test:        return "cmd_link_test";
+    case robot_protocol::cmd_baud_commit:      return "cmd_baud_commit";
+    case robot_protocol::cmd_telemetry_format: return "cmd_telemetry_format";
+    case robot_protocol::msg_telemetry:        return "msg_telemetry";
+    case robot_protocol::msg_telemetry_key:    return "msg_telemetry_key";
+    case robot_protocol::msg_telemetry_delta:  return "msg_telemetry_delta";
+    case robot_protocol::msg_pong:             return "msg_pong";
+    case robot_protocol::msg_time_sync:        return "msg_time_sync";
+    case robot_protocol::msg_baud_ack:         return "msg_baud_ack";
+    case robot_protocol::msg_link_test:        return "msg_link_test";
+    default:                                   return "?";
+    }
+}
+
+static void monitor_frame(struct monitor_state *m, const uint8_t *p, size_t len, uint64_t now) {
+    m->frames++;
+    if (len == 0)
+        return;
+    struct monitor_type *t = &m->types[p[0]];
+    t->frames++;
+    t->bytes += len;
+    t->last_ns = now;
+
+    if (p[0] == robot_protocol::msg_telemetry) {
+        if (robot_protocol::decode_telemetry(p, len, &m->last_sample))
+            m->last_sample_ns = now;
+    } else if (p[0] == robot_protocol::msg_telemetry_key || p[0] == robot_protocol::msg_telemetry_delta) {
+        robot_protocol::telemetry s[telemetry_codec::max_batch];
+        int n = m->compact.decode(p, len, s, telemetry_codec::max_batch);
+        if (n > 0) {
+            m->last_sample = s[n - 1];
+            m->last_sample_ns = now;
+        }
+    }
+}
+
+static void monitor_update_rates(struct monitor_state *m, uint64_t now) {
+    double dt = (now - m->rate_ns) / 1e9;
+    if (dt < 1.0)
+        return;
+    m->byte_rate = (m->bytes - m->window_bytes) / dt;
+    m->window_bytes = m->bytes;
+    for (int i = 0; i < 256; i++) {
+        struct monitor_type *t = &m->types[i];
+        t->frame_rate = (t->frames - t->window_frames) / dt;
+        t->byte_rate = (t->bytes - t->window_bytes) / dt;
+        t->window_frames = t->frames;
+        t->window_bytes = t->bytes;
+    }
+    m->rate_ns = now;
+}
+
+// One write() per redraw: home, overwrite each line, clear the rest
+static void monitor_draw(const struct monitor_state *m, uint64_t now, unsigned hz) {
+    static char screen[MONITOR_SCREEN_SIZE];
+    size_t n = 0;
+#define SCREEN(...) n += snprintf(screen + n, n < sizeof(screen) ? sizeof(screen) - n : 0, __VA_ARGS__)
+    SCREEN("\033[H%s  up %.1f s  redraw %u Hz  (Ctrl+C to exit)\033[K\n", device_path,
+           (now - m->start_ns) / 1e9, hz);
+    SCREEN("bytes %llu  %.0f B/s  frames %llu  crc errors %llu  malformed %llu  overflows %llu\033[K\n",
+           m->bytes, m->byte_rate, m->frames, m->crc_errors, m->malformed, m->overflows);
+    SCREEN("\033[K\n%-22s %4s %12s %10s %10s %9s\033[K\n", "type", "id", "frames", "frames/s", "B/s", "last");
+    for (int i = 0; i < 256; i++) {
+        const struct monitor_type *t = &m->types[i];
+        if (!t->frames)
+            continue;
+        SCREEN("%-22s 0x%02x %12llu %10.1f %10.0f %7.1f s\033[K\n", monitor_type_name(i), i, t->frames,
+               t->frame_rate, t->byte_rate, (now - t->last_ns) / 1e9);
+    }
+    if (m->last_sample_ns) {
+        const robot_protocol::telemetry &s = m->last_sample;
+        SCREEN("\033[K\nlast telemetry %.1f s ago: t %u us  position %d %d %d %d  distance %.1f cm\033[K\n",
+               (now - m->last_sample_ns) / 1e9, s.timestamp_us, s.position[0], s.position[1],
+               s.position[2], s.position[3], s.distance_cm);
+    }
+    SCREEN("\033[J");
+#undef SCREEN
+    if (n > sizeof(screen))
+        n = sizeof(screen);
+    if (write(STDOUT_FILENO, screen, n) < 0) {
+        // a terminal that cannot keep up loses a frame, the link does not wait for it
+    }
+}
+
+int monitor_mode(unsigned refresh_hz) {
+    static struct monitor_state m;
+    static uint8_t buffer[CAPTURE_READ_SIZE];
+    frame_codec::frame_decoder<robot_protocol::max_message> decoder;
+    struct epoll_event events[3];
+
+    int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (timer_fd < 0 || epfd < 0 || epoll_add(epfd, uart_fd) < 0 || epoll_add(epfd, signal_fd) < 0 ||
+        epoll_add(epfd, timer_fd) < 0) {
+        perror("Error setting up monitor");
+        return -1;
+    }
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    uint64_t period_ns = 1000000000ULL / refresh_hz;
+    its.it_interval.tv_sec = period_ns / 1000000000ULL;
+    its.it_interval.tv_nsec = period_ns % 1000000000ULL;
+    its.it_value = its.it_interval;
+    if (timerfd_settime(timer_fd, 0, &its, NULL) < 0) {
+        perror("Error arming monitor timer");
+        return -1;
+    }
+
+    m.start_ns = m.rate_ns = monotonic_ns();
+    printf("\033[?1049h\033[?25l");     // alternate screen, hide cursor
+    fflush(stdout);
+
+    while (running) {
+        int n = epoll_wait(epfd, events, 3, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll error");
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            if (fd == signal_fd) {
+                check_signals();
+            } else if (fd == timer_fd) {
+                uint64_t expirations;
+                if (read(timer_fd, &expirations, sizeof(expirations)) < 0) {
+                    // spurious wake-up
+                }
+                uint64_t now = monotonic_ns();
+                monitor_update_rates(&m, now);
+                monitor_draw(&m, now, refresh_hz);
+                capture_tick();
+            } else if (fd == uart_fd) {
+                // Drain everything queued; what arrives meanwhile wakes us again
+                ssize_t r;
+                while ((r = read(uart_fd, buffer, sizeof(buffer))) > 0) {
+                    uint64_t now = monotonic_ns();
+                    capture_record(CAPTURE_RX, buffer, r);
+                    m.bytes += r;
+                    for (ssize_t j = 0; j < r; j++) {
+                        switch (decoder.push(buffer[j])) {
+                        case frame_codec::decode_status::frame:
+                            monitor_frame(&m, decoder.data(), decoder.size(), now);
+                            break;
+                        case frame_codec::decode_status::crc_error: m.crc_errors++; break;
+                        case frame_codec::decode_status::malformed: m.malformed++; break;
+                        case frame_codec::decode_status::overflow:  m.overflows++;  break;
+                        case frame_codec::decode_status::pending:   break;
+                        }
+                    }
+                }
+                if (r < 0 && errno != EAGAIN && errno != EINTR) {
+                    perror("Error reading from UART");
+                    running = 0;
+                }
+            }
+        }
+    }
+
+    printf("\033[?25h\033[?1049l");     // back to the normal screen
+    printf("Monitored %llu bytes in %.1f s: %llu frames, %llu crc errors, %llu malformed, %llu overflows\n",
+           m.bytes, (monotonic_ns() - m.start_ns) / 1e9, m.frames, m.crc_errors, m.malformed, m.overflows);
+    for (int i = 0; i < 256; i++) {
+        if (m.types[i].frames)
+            printf("  %-22s 0x%02x %12llu frames %12llu bytes\n", monitor_type_name(i), i,
+                   m.types[i].frames, m.types[i].bytes);
+    }
+    close(epfd);
+    close(timer_fd);
+    return 0;
 }
 
 int main(int argc, char *argv[]) {
     int opt;
     char *text_to_send = NULL;
     char *file_to_send = NULL;
+    char *file_to_stream = NULL;
+    size_t chunk_size = DEFAULT_CHUNK_SIZE;
+    long line_rate = DEFAULT_LINE_RATE;
     int interactive = 1;
     int read_only = 0;
+    long bench_rate = -1;
+    int bench_seconds = DEFAULT_BENCH_SECONDS;
+    size_t bench_payload = DEFAULT_BENCH_PAYLOAD;
+    unsigned bench_window = DEFAULT_BENCH_WINDOW;
+    int echo = 0;
+    int monitor = 0;
+    unsigned monitor_hz = DEFAULT_MONITOR_HZ;
+    int status = 0;
+    const char *capture_file = NULL;
+    unsigned long long capture_rotate = 0;
     
     // Parse command line arguments
-    while ((opt = getopt(argc, argv, "t:f:irh")) != -1) {
+    while ((opt = getopt(argc, argv, "d:t:f:S:c:B:b:D:P:W:EmF:w:C:irl:h")) != -1) {
         switch (opt) {
+            case 'd':
+                device_path = optarg;
+                break;
             case 't':
                 text_to_send = optarg;
                 interactive = 0;
@@ -165,6 +1087,67 @@ int main(int argc, char *argv[]) {
                 file_to_send = optarg;
                 interactive = 0;
                 break;
+            case 'S':
+                file_to_stream = optarg;
+                interactive = 0;
+                break;
+            case 'c':
+                chunk_size = strtoul(optarg, NULL, 10);
+                if (chunk_size == 0) {
+                    print_usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'B':
+                line_rate = strtol(optarg, NULL, 10);
+                if (line_rate <= 0) {
+                    print_usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'b':
+                bench_rate = strtol(optarg, NULL, 10);
+                if (bench_rate < 0) {
+                    print_usage(argv[0]);
+                    return 1;
+                }
+                interactive = 0;
+                break;
+            case 'D':
+                bench_seconds = atoi(optarg);
+                if (bench_seconds <= 0) {
+                    print_usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'P':
+                bench_payload = strtoul(optarg, NULL, 10);
+                if (bench_payload < BENCH_HEADER_SIZE || bench_payload > BENCH_MAX_PAYLOAD) {
+                    print_usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'W':
+                bench_window = strtoul(optarg, NULL, 10);
+                if (bench_window == 0 || bench_window >= BENCH_SEQ_WINDOW / 2) {
+                    print_usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'E':
+                echo = 1;
+                break;
+            case 'm':
+                monitor = 1;
+                interactive = 0;
+                break;
+            case 'F':
+                monitor_hz = strtoul(optarg, NULL, 10);
+                if (monitor_hz == 0 || monitor_hz > 1000) {
+                    print_usage(argv[0]);
+                    return 1;
+                }
+                break;
             case 'i':
                 interactive = 1;
                 break;
@@ -172,6 +1155,23 @@ int main(int argc, char *argv[]) {
                 read_only = 1;
                 interactive = 0;
                 break;
+            case 'l':
+                log_path = optarg;
+                break;
+            case 'w':
+                capture_file = optarg;
+                if (interactive) {
+                    read_only = 1;
+                    interactive = 0;
+                }
+                break;
+            case 'C':
+                capture_rotate = strtoull(optarg, NULL, 10) * 1000000ULL;
+                if (capture_rotate == 0) {
+                    print_usage(argv[0]);
+                    return 1;
+                }
+                break;
             case 'h':
                 print_usage(argv[0]);
                 return 0;
@@ -181,12 +1181,17 @@ int main(int argc, char *argv[]) {
         }
     }
     
-    // Install signal handler
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
+    if (setup_signals() < 0) {
+        return 1;
+    }
     
+    // The echo stand-in is the far end, it does not open the device
+    if (echo) {
+        return echo_mode(line_rate) < 0 ? 1 : 0;
+    }
+
     // Open UART device
-    uart_fd = open(DEVICE_PATH, O_RDWR | O_NONBLOCK);
+    uart_fd = open(device_path, O_RDWR | O_NONBLOCK);
     if (uart_fd < 0) {
         perror("Error opening UART device");
         printf("Make sure the kernel module is loaded and device exists\n");
@@ -194,12 +1199,37 @@ int main(int argc, char *argv[]) {
     }
     
     printf("UART device opened successfully\n");
+
+    if (log_path) {
+        try {
+            BinLog::open(log_path, BINLOG_LEVEL_DEBUG);
+        } catch (const std::exception &e) {
+            fprintf(stderr, "Error opening log: %s\n", e.what());
+            close(uart_fd);
+            return 1;
+        }
+        printf("Logging received data to %s\n", log_path);
+    }
+
+    if (capture_file) {
+        if (capture_open(capture_file, capture_rotate) < 0) {
+            close(uart_fd);
+            return 1;
+        }
+        printf("Capturing to %s\n", capture_file);
+    }
     
     // Execute requested operation
     if (text_to_send) {
         send_text(text_to_send);
     } else if (file_to_send) {
         send_file(file_to_send);
+    } else if (file_to_stream) {
+        stream_file(file_to_stream, chunk_size, line_rate);
+    } else if (bench_rate >= 0) {
+        status = bench_mode(bench_rate, bench_seconds, bench_payload, bench_window, line_rate) != 0;
+    } else if (monitor) {
+        status = monitor_mode(monitor_hz) != 0;
     } else if (read_only) {
         read_only_mode();
     } else if (interactive) {
@@ -210,8 +1240,21 @@ int main(int argc, char *argv[]) {
     if (uart_fd >= 0) {
         close(uart_fd);
     }
+    if (capture_file) {
+        capture_close();
+        printf("Captured %llu packets (%llu bytes) in %u file%s%s\n", capture_packets, capture_bytes,
+               capture_index, capture_index == 1 ? "" : "s",
+               capture_write_errors ? ", some writes FAILED" : "");
+    }
+    if (log_path) {
+        BinLog::close();
+        BinLogStats stats = BinLog::stats();
+        printf("Logged %llu entries (%llu bytes), %llu dropped\n", (unsigned long long)stats.entries,
+               (unsigned long long)stats.bytes, (unsigned long long)stats.dropped);
+    }
     
-    return 0;
+    return status;
 }
 
-// Compile with: gcc -o uart_test uart_test.c
\ No newline at end of file
+// Built as uart_test by project/CMakeLists.txt (needs project/src/binlog.cpp
+// and project/src/periodic_executor.cpp for LatencyHistogram)
\ No newline at end of file